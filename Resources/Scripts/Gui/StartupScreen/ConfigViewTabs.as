@@ -447,10 +447,12 @@ namespace spades {
 		StartupScreenHelper@ helper;
 
 		spades::ui::RadioButton@ driverOpenAL;
+		spades::ui::RadioButton@ driverSoftware;
 		spades::ui::RadioButton@ driverNull;
 
 		spades::ui::TextViewer@ helpView;
 		StartupScreenConfigView@ configViewOpenAL;
+		StartupScreenConfigView@ configViewSoftware;
 
 		StartupScreenAudioOpenALEditor@ editOpenAL;
 
@@ -491,54 +493,76 @@ namespace spades {
 				AddChild(e);
 				@driverOpenAL = e;
 			}
+			{
+				spades::ui::RadioButton e(Manager);
+				//! The name of audio driver that mixes sounds on the CPU.
+				e.Caption = _Tr("StartupScreen", "Software");
+				e.Bounds = AABB2(210.0F, 0.0F, 100.0F, 24.0F);
+				e.GroupName = "driver";
+				HelpHandler(
+					helpView,
+					_Tr("StartupScreen",
+						"Mixes sounds on the CPU without OpenAL. Lighter than OpenAL's "
+						"software emulation, but doesn't support EAX."))
+					.Watch(e);
+				@e.Activated = spades::ui::EventHandler(this.OnDriverSoftware);
+				AddChild(e);
+				@driverSoftware = e;
+			}
 			{
 				spades::ui::RadioButton e(Manager);
 				//! The name of audio driver that outputs no audio.
 				e.Caption = _Tr("StartupScreen", "Null");
-				e.Bounds = AABB2(210.0F, 0.0F, 100.0F, 24.0F);
+				e.Bounds = AABB2(320.0F, 0.0F, 100.0F, 24.0F);
 				e.GroupName = "driver";
 				HelpHandler(helpView, _Tr("StartupScreen", "Disables audio output.")).Watch(e);
 				@e.Activated = spades::ui::EventHandler(this.OnDriverNull);
 				AddChild(e);
 				@driverNull = e;
 			}
+			@configViewOpenAL = CreateConfigView(mainWidth, size.y, true);
+			// the software mixer has no EAX
+			@configViewSoftware = CreateConfigView(mainWidth, size.y, false);
+
+			AddLabel(0.0F, 120.0F, 24.0F, _Tr("StartupScreen", "Output Device"));
 			{
-				StartupScreenConfigView cfg(Manager);
+				StartupScreenAudioOpenALEditor e(ui);
+				AddChild(e);
+				e.Bounds = AABB2(160.0F, 120.0F, 354.0F, 24.0F);
+				@editOpenAL = e;
+			}
+		}
 
-				cfg.AddRow(StartupScreenConfigSliderItemEditor(
-					ui, StartupScreenConfig(ui, "s_volume"), 0, 100, 1,
-					_Tr("StartupScreen", "Volume"), "",
-					ConfigNumberFormatter(0, "%")));
+		private StartupScreenConfigView@ CreateConfigView(float width, float height, bool openAL) {
+			StartupScreenConfigView cfg(Manager);
 
-				cfg.AddRow(StartupScreenConfigSliderItemEditor(
-					ui, StartupScreenConfig(ui, "s_maxPolyphonics"), 16.0, 256.0, 8.0,
-					_Tr("StartupScreen", "Polyphonics"),
-					_Tr("StartupScreen",
-						"Specifies how many sounds can be played simultaneously. "
-						"Higher value needs more processing power, so setting this too high might "
-						"cause an overload (especially with a software emulation)."),
-					ConfigNumberFormatter(0, " poly")));
+			cfg.AddRow(StartupScreenConfigSliderItemEditor(
+				ui, StartupScreenConfig(ui, "s_volume"), 0, 100, 1,
+				_Tr("StartupScreen", "Volume"), "",
+				ConfigNumberFormatter(0, "%")));
+
+			cfg.AddRow(StartupScreenConfigSliderItemEditor(
+				ui, StartupScreenConfig(ui, "s_maxPolyphonics"), 16.0, 256.0, 8.0,
+				_Tr("StartupScreen", "Polyphonics"),
+				_Tr("StartupScreen",
+					"Specifies how many sounds can be played simultaneously. "
+					"Higher value needs more processing power, so setting this too high might "
+					"cause an overload (especially with a software emulation)."),
+				ConfigNumberFormatter(0, " poly")));
 
+			if (openAL) {
 				cfg.AddRow(StartupScreenConfigCheckItemEditor(
 					ui, StartupScreenConfig(ui, "s_eax"), "0", "1", _Tr("StartupScreen", "EAX"),
 					_Tr("StartupScreen",
 						"Enables extended features provided by the OpenAL driver to create "
 						"more ambience.")));
-						
-				cfg.Finalize();
-				cfg.SetHelpTextHandler(HelpTextHandler(this.HandleHelpText));
-				cfg.Bounds = AABB2(0.0F, 30.0F, mainWidth, size.y - 30.0F);
-				AddChild(cfg);
-				@configViewOpenAL = cfg;
 			}
 
-			AddLabel(0.0F, 120.0F, 24.0F, _Tr("StartupScreen", "Output Device"));
-			{
-				StartupScreenAudioOpenALEditor e(ui);
-				AddChild(e);
-				e.Bounds = AABB2(160.0F, 120.0F, 354.0F, 24.0F);
-				@editOpenAL = e;
-			}
+			cfg.Finalize();
+			cfg.SetHelpTextHandler(HelpTextHandler(this.HandleHelpText));
+			cfg.Bounds = AABB2(0.0F, 30.0F, width, height - 30.0F);
+			AddChild(cfg);
+			return cfg;
 		}
 
 		private void HandleHelpText(string text) { helpView.Text = text; }
@@ -547,6 +571,10 @@ namespace spades {
 			s_audioDriver.StringValue = "openal";
 			LoadConfig();
 		}
+		private void OnDriverSoftware(spades::ui::UIElement@) {
+			s_audioDriver.StringValue = "software";
+			LoadConfig();
+		}
 		private void OnDriverNull(spades::ui::UIElement@) {
 			s_audioDriver.StringValue = "null";
 			LoadConfig();
@@ -556,13 +584,23 @@ namespace spades {
 			if (s_audioDriver.StringValue == "openal") {
 				driverOpenAL.Check();
 				configViewOpenAL.Visible = true;
+				configViewSoftware.Visible = false;
+			} else if (s_audioDriver.StringValue == "software") {
+				driverSoftware.Check();
+				configViewOpenAL.Visible = false;
+				configViewSoftware.Visible = true;
 			} else if (s_audioDriver.StringValue == "null") {
 				driverNull.Check();
 				configViewOpenAL.Visible = false;
+				configViewSoftware.Visible = false;
 			}
+			// the output device is chosen from OpenAL's list
+			editOpenAL.Enable = s_audioDriver.StringValue == "openal";
 			driverOpenAL.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "openal").length == 0;
+			driverSoftware.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "software").length == 0;
 			driverNull.Enable = ui.helper.CheckConfigCapability("s_audioDriver", "null").length == 0;
 			configViewOpenAL.LoadConfig();
+			configViewSoftware.LoadConfig();
 			editOpenAL.LoadConfig();
 
 			s_openalDevice.StringValue = editOpenAL.openal.StringValue;
@@ -62,6 +62,13 @@ namespace spades {
         float pitch;
 
         float referenceDistance;
+
+        /**
+         * Relative importance of the sound. When more sounds are playing than
+         * the device can mix, the ones with the lowest priority times loudness
+         * are muted first.
+         */
+        float priority;
     }
 
 }
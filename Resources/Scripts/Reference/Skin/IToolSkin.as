@@ -48,4 +48,42 @@ namespace spades {
         void AddToScene();
     }
 
+    /** Per-frame parameters of a tool skin. */
+    class SkinState {
+        // IToolSkin
+        float sprintState;
+        float raiseState;
+        Vector3 teamColor;
+        bool muted;
+
+        // ISpadeSkin
+        SpadeActionType actionType;
+        float actionProgress;
+
+        // IBlockSkin, IGrenadeSkin, IWeaponSkin
+        float readyState;
+
+        // IBlockSkin
+        Vector3 blockColor;
+
+        // IGrenadeSkin
+        float cookTime;
+
+        // IWeaponSkin
+        float aimDownSightState;
+        int ammo;
+        int clipSize;
+        bool reloading;
+        float reloadProgress;
+    }
+
+    /**
+     * Optional interface of tool skins. When implemented, the skin receives
+     * all parameters at once every frame instead of through the property
+     * setters of `IToolSkin` and the tool-specific interfaces.
+     */
+    interface IToolSkin2 {
+        void Update(const SkinState& in state);
+    }
+
 }
@@ -76,7 +76,7 @@ namespace spades {
 		}
 	}
 
-	class BasicViewWeapon : IToolSkin, IViewToolSkin, IWeaponSkin, IWeaponSkin2, IWeaponSkin3 {
+	class BasicViewWeapon : IToolSkin, IToolSkin2, IViewToolSkin, IWeaponSkin, IWeaponSkin2, IWeaponSkin3 {
 		protected float time;
 
 		// IToolSkin
@@ -379,6 +379,20 @@ namespace spades {
 			return mat;
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			AimDownSightState = state.aimDownSightState;
+			IsReloading = state.reloading;
+			ReloadProgress = state.reloadProgress;
+			Ammo = state.ammo;
+			ClipSize = state.clipSize;
+			ReadyState = state.readyState;
+		}
+
 		void Update(float dt) {
 			if (time < 0.0F)
 				time = 0.0F;
@@ -19,7 +19,7 @@
  */
 
  namespace spades {
-	class ThirdPersonBlockSkin : IToolSkin, IThirdPersonToolSkin, IBlockSkin {
+	class ThirdPersonBlockSkin : IToolSkin, IToolSkin2, IThirdPersonToolSkin, IBlockSkin {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -45,6 +45,16 @@
 			@model = renderer.RegisterModel("Models/Weapons/Block/Block.kv6");
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			BlockColor = state.blockColor;
+			ReadyState = state.readyState;
+		}
+
 		void Update(float dt) {}
 
 		void AddToScene() {
@@ -19,7 +19,7 @@
  */
 
  namespace spades {
-	class ThirdPersonGrenadeSkin : IToolSkin, IThirdPersonToolSkin, IGrenadeSkin {
+	class ThirdPersonGrenadeSkin : IToolSkin, IToolSkin2, IThirdPersonToolSkin, IGrenadeSkin {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -45,6 +45,16 @@
 			@model = renderer.RegisterModel("Models/Weapons/Grenade/Grenade.kv6");
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			CookTime = state.cookTime;
+			ReadyState = state.readyState;
+		}
+
 		void Update(float dt) {}
 
 		void AddToScene() {
@@ -19,7 +19,7 @@
  */
 
  namespace spades {
-	class ViewGrenadeSkin : IToolSkin, IViewToolSkin, IGrenadeSkin {
+	class ViewGrenadeSkin : IToolSkin, IToolSkin2, IViewToolSkin, IGrenadeSkin {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -59,6 +59,16 @@
 			@sightImage = renderer.RegisterImage("Gfx/Sight.tga");
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			CookTime = state.cookTime;
+			ReadyState = state.readyState;
+		}
+
 		void Update(float dt) {
 			float sprintStateSS = sprintState * sprintState;
 			if (sprintStateSS > sprintStateSmooth)
@@ -19,7 +19,7 @@
  */
 
 namespace spades {
-	class ThirdPersonRifleSkin : IToolSkin, IThirdPersonToolSkin, IWeaponSkin, IWeaponSkin2,  IWeaponSkin3 {
+	class ThirdPersonRifleSkin : IToolSkin, IToolSkin2, IThirdPersonToolSkin, IWeaponSkin, IWeaponSkin2,  IWeaponSkin3 {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -81,6 +81,20 @@ namespace spades {
 			@reloadSound = dev.RegisterSound("Sounds/Weapons/Rifle/Reload.opus");
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			AimDownSightState = state.aimDownSightState;
+			IsReloading = state.reloading;
+			ReloadProgress = state.reloadProgress;
+			Ammo = state.ammo;
+			ClipSize = state.clipSize;
+			ReadyState = state.readyState;
+		}
+
 		void Update(float dt) {}
 
 		void WeaponFired() {
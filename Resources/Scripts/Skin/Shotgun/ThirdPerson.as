@@ -19,7 +19,7 @@
  */
 
 namespace spades {
-	class ThirdPersonShotgunSkin : IToolSkin, IThirdPersonToolSkin, IWeaponSkin, IWeaponSkin2, IWeaponSkin3 {
+	class ThirdPersonShotgunSkin : IToolSkin, IToolSkin2, IThirdPersonToolSkin, IWeaponSkin, IWeaponSkin2, IWeaponSkin3 {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -81,6 +81,20 @@ namespace spades {
 			@cockSound = dev.RegisterSound("Sounds/Weapons/Shotgun/Cock.opus");
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			AimDownSightState = state.aimDownSightState;
+			IsReloading = state.reloading;
+			ReloadProgress = state.reloadProgress;
+			Ammo = state.ammo;
+			ClipSize = state.clipSize;
+			ReadyState = state.readyState;
+		}
+
 		void Update(float dt) {}
 
 		void WeaponFired() {
@@ -19,7 +19,7 @@
  */
 
  namespace spades {
-	class ThirdPersonSpadeSkin : IToolSkin, IThirdPersonToolSkin, ISpadeSkin {
+	class ThirdPersonSpadeSkin : IToolSkin, IToolSkin2, IThirdPersonToolSkin, ISpadeSkin {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -49,6 +49,16 @@
 			@model = @spadeModel;
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			ActionType = state.actionType;
+			ActionProgress = state.actionProgress;
+		}
+
 		void Update(float dt) {}
 
 		void AddToScene() {
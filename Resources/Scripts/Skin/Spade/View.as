@@ -19,7 +19,7 @@
  */
 
  namespace spades {
-	class ViewSpadeSkin : IToolSkin, IViewToolSkin, ISpadeSkin {
+	class ViewSpadeSkin : IToolSkin, IToolSkin2, IViewToolSkin, ISpadeSkin {
 		private float sprintState;
 		private float raiseState;
 		private Vector3 teamColor;
@@ -63,6 +63,16 @@
 			@sightImage = renderer.RegisterImage("Gfx/Sight.tga");
 		}
 
+		// IToolSkin2
+		void Update(const SkinState&in state) {
+			SprintState = state.sprintState;
+			RaiseState = state.raiseState;
+			TeamColor = state.teamColor;
+			IsMuted = state.muted;
+			ActionType = state.actionType;
+			ActionProgress = state.actionProgress;
+		}
+
 		void Update(float dt) {
 			float sprintStateSS = sprintState * sprintState;
 			if (sprintStateSS > sprintStateSmooth)
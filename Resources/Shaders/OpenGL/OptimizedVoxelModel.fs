@@ -22,11 +22,12 @@ varying vec4 textureCoord;
 varying vec3 fogDensity;
 varying float flatShading;
 
+// [customColor, opacity]
+varying vec4 modelTint;
+
 uniform sampler2D ambientOcclusionTexture;
 uniform sampler2D modelTexture;
 uniform vec3 fogColor;
-uniform vec3 customColor;
-uniform float modelOpacity;
 
 vec3 EvaluateSunLight();
 vec3 EvaluateAmbientLight(float detailAmbientOcclusion);
@@ -40,7 +41,7 @@ void main() {
 	// model color
 	gl_FragColor = vec4(texData.xyz, 1.0);
 	if (dot(gl_FragColor.xyz, vec3(1.0)) < 0.0001)
-		gl_FragColor.xyz = customColor;
+		gl_FragColor.xyz = modelTint.xyz;
 
 	// linearize
 	gl_FragColor.xyz *= gl_FragColor.xyz;
@@ -72,5 +73,5 @@ void main() {
 #endif
 
 	// Only valid in the ghost pass - Blending is disabled for most models
-	gl_FragColor.w = modelOpacity;
+	gl_FragColor.w = modelTint.w;
 }
\ No newline at end of file
@@ -25,6 +25,8 @@ uniform vec3 modelOrigin;
 uniform vec3 sunLightDirection;
 uniform vec3 viewOriginVector;
 uniform vec2 texScale;
+uniform vec3 customColor;
+uniform float modelOpacity;
 
 // [x, y, z]
 attribute vec3 positionAttribute;
@@ -38,6 +40,7 @@ attribute vec3 normalAttribute;
 varying vec4 textureCoord;
 varying vec3 fogDensity;
 varying float flatShading;
+varying vec4 modelTint;
 
 void PrepareShadow(vec3 worldOrigin, vec3 normal);
 vec4 ComputeFogDensity(float poweredLength);
@@ -47,6 +50,8 @@ void main() {
 
 	gl_Position = projectionViewModelMatrix * vertexPos;
 
+	modelTint = vec4(customColor, modelOpacity);
+
 	textureCoord = textureCoordAttribute.xyxy * vec4(texScale, vec2(1.0));
 	
 	// lambert reflection
@@ -22,6 +22,9 @@ varying vec4 textureCoord;
 varying vec3 fogDensity;
 varying float flatShading;
 
+// [customColor, opacity]
+varying vec4 modelTint;
+
 varying vec3 viewSpaceCoord;
 varying vec3 viewSpaceNormal;
 varying vec3 reflectionDir;
@@ -31,8 +34,6 @@ uniform vec3 viewSpaceLight;
 uniform sampler2D ambientOcclusionTexture;
 uniform sampler2D modelTexture;
 uniform vec3 fogColor;
-uniform vec3 customColor;
-uniform float modelOpacity;
 
 float VisibilityOfSunLight();
 vec3 EvaluateAmbientLight(float detailAmbientOcclusion);
@@ -50,7 +51,7 @@ void main() {
 	// model color
 	gl_FragColor = vec4(texData.xyz, 1.0);
 	if (dot(gl_FragColor.xyz, vec3(1.0)) < 0.0001)
-		gl_FragColor.xyz = customColor;
+		gl_FragColor.xyz = modelTint.xyz;
 
 	// linearize
 	gl_FragColor.xyz *= gl_FragColor.xyz;
@@ -115,5 +116,5 @@ void main() {
 #endif
 
 	// Only valid in the ghost pass - Blending is disabled for most models
-	gl_FragColor.w = modelOpacity;
+	gl_FragColor.w = modelTint.w;
 }
\ No newline at end of file
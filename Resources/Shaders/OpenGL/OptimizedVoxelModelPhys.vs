@@ -26,6 +26,8 @@ uniform vec3 modelOrigin;
 uniform vec3 sunLightDirection;
 uniform vec3 viewOriginVector;
 uniform vec2 texScale;
+uniform vec3 customColor;
+uniform float modelOpacity;
 
 // [x, y, z]
 attribute vec3 positionAttribute;
@@ -39,6 +41,7 @@ attribute vec3 normalAttribute;
 varying vec4 textureCoord;
 varying vec3 fogDensity;
 varying float flatShading;
+varying vec4 modelTint;
 
 varying vec3 viewSpaceCoord;
 varying vec3 viewSpaceNormal;
@@ -52,6 +55,8 @@ void main() {
 	
 	gl_Position = projectionViewModelMatrix * vertexPos;
 
+	modelTint = vec4(customColor, modelOpacity);
+
 	textureCoord = textureCoordAttribute.xyxy * vec4(texScale, vec2(1.0));
 	
 	// lambert reflection
@@ -0,0 +1,83 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.	 If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+uniform mat4 projectionViewMatrix;
+uniform mat4 viewMatrix;
+uniform vec3 modelOrigin;
+uniform vec3 sunLightDirection;
+uniform vec3 viewOriginVector;
+uniform vec2 texScale;
+
+// [x, y, z]
+attribute vec3 positionAttribute;
+
+// [u, v]
+attribute vec2 textureCoordAttribute;
+
+// [x, y, z]
+attribute vec3 normalAttribute;
+
+// per-instance attributes
+attribute mat4 modelMatrixAttribute;
+// [customColor, opacity]
+attribute vec4 modelTintAttribute;
+
+varying vec4 textureCoord;
+varying vec3 fogDensity;
+varying float flatShading;
+varying vec4 modelTint;
+
+varying vec3 viewSpaceCoord;
+varying vec3 viewSpaceNormal;
+varying vec3 reflectionDir;
+
+void PrepareShadow(vec3 worldOrigin, vec3 normal);
+vec4 ComputeFogDensity(float poweredLength);
+
+void main() {
+	vec4 vertexPos = vec4(modelOrigin + positionAttribute, 1.0);
+	vec4 worldPos = modelMatrixAttribute * vertexPos;
+
+	gl_Position = projectionViewMatrix * worldPos;
+
+	modelTint = modelTintAttribute;
+
+	textureCoord = textureCoordAttribute.xyxy * vec4(texScale, vec2(1.0));
+
+	// lambert reflection
+	vec3 normal = normalize((modelMatrixAttribute * vec4(normalAttribute, 0.0)).xyz);
+	flatShading = max(dot(normal, sunLightDirection), 0.0);
+
+	vec3 worldPosition = worldPos.xyz;
+	vec3 viewDirection = worldPosition - viewOriginVector;
+
+	// used for diffuse lighting
+	viewSpaceCoord = (viewMatrix * worldPos).xyz;
+	viewSpaceNormal = (viewMatrix * vec4(normal, 0.0)).xyz;
+
+	// reflection vector (used for specular lighting)
+	reflectionDir = reflect(viewDirection, normal);
+
+	vec2 horzRelativePos = viewDirection.xy;
+	float horzDistance = dot(horzRelativePos, horzRelativePos);
+	fogDensity = ComputeFogDensity(horzDistance).xyz;
+
+	PrepareShadow(worldPosition, normal);
+}
@@ -18,28 +18,43 @@
 
  */
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <list>
+#include <memory>
 #include <utility>
 #include <vector>
 
 #include "ALDevice.h"
 #include "ALFuncs.h"
+#include "AcousticsEstimator.h"
+#include "VoiceManager.h"
 #include <Client/GameMap.h>
 #include <Client/IAudioChunk.h>
 #include <Core/AudioStream.h>
+#include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
 #include <Core/Exception.h>
 #include <Core/FileManager.h>
 #include <Core/IAudioStream.h>
+#include <Core/MemoryStream.h>
+#include <Core/ParallelLoad.h>
 #include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Core/TMPUtils.h>
 
 DEFINE_SPADES_SETTING(s_volume, "100");
 DEFINE_SPADES_SETTING(s_maxPolyphonics, "96");
 DEFINE_SPADES_SETTING(s_eax, "1");
 DEFINE_SPADES_SETTING(s_alPreciseErrorCheck, "1");
 DEFINE_SPADES_SETTING(s_openalDevice, "");
+DEFINE_SPADES_SETTING(s_backgroundDecode, "1");
+DEFINE_SPADES_SETTING(s_soundCache, "1");
+DEFINE_SPADES_SETTING(s_debugVoices, "0");
 
 // keep track of the "previous" volume so the dB isn't recomputed when unnecessary
 int s_volumePrevious = 100;
@@ -73,47 +88,53 @@ namespace spades {
 
 				return ret;
 			}
-		} // namespace
-
-		class ALAudioChunk : public client::IAudioChunk {
-			ALuint handle;
-			ALuint format;
 
-		protected:
-			virtual ~ALAudioChunk() {
-				SPADES_MARK_FUNCTION();
+			const uint32_t SoundCacheMagic = 0x44535053; // "SPSD"
+			/** Must be bumped whenever the decoded output changes. */
+			const uint32_t SoundCacheFormatVersion = 1;
 
-				al::qalDeleteBuffers(1, &handle);
-				ALCheckErrorPrecise();
+			/** 64-bit FNV-1a hash. */
+			void HashBytes(uint64_t& hash, const void* data, std::size_t size) {
+				const unsigned char* bytes = static_cast<const unsigned char*>(data);
+				for (std::size_t i = 0; i < size; i++) {
+					hash ^= bytes[i];
+					hash *= 1099511628211ULL;
+				}
 			}
 
-		public:
-			ALuint GetHandle() { return handle; }
-			ALAudioChunk(IAudioStream* audioStream) {
+			/** PCM data ready to be uploaded to an AL buffer. */
+			struct DecodedSound {
+				std::vector<uint8_t> bytes;
+				ALuint format;
+				int samplingFrequency;
+			};
+
+			std::unique_ptr<DecodedSound> DecodeSoundStream(IAudioStream& audioStream) {
 				SPADES_MARK_FUNCTION();
 
-				std::vector<uint8_t> bytes;
-				if (audioStream->GetLength() > 128 * 1024 * 1024)
+				auto sound = stmp::make_unique<DecodedSound>();
+				std::vector<uint8_t>& bytes = sound->bytes;
+				if (audioStream.GetLength() > 128 * 1024 * 1024)
 					SPRaise("Audio stream too long");
 
-				size_t len = (size_t)audioStream->GetLength();
+				size_t len = (size_t)audioStream.GetLength();
 				bytes.resize(len);
 
-				audioStream->SetPosition(0);
-				if (audioStream->Read(bytes.data(), len) < len)
+				audioStream.SetPosition(0);
+				if (audioStream.Read(bytes.data(), len) < len)
 					SPRaise("Failed to read audio data");
 
 				ALuint alFormat;
-				switch (audioStream->GetSampleFormat()) {
+				switch (audioStream.GetSampleFormat()) {
 					case IAudioStream::UnsignedByte:
-						switch (audioStream->GetNumChannels()) {
+						switch (audioStream.GetNumChannels()) {
 							case 1: alFormat = AL_FORMAT_MONO8; break;
 							case 2: alFormat = AL_FORMAT_STEREO8; break;
 							default: SPRaise("Unsupported audio format");
 						}
 						break;
 					case IAudioStream::SignedShort:
-						switch (audioStream->GetNumChannels()) {
+						switch (audioStream.GetNumChannels()) {
 							case 1: alFormat = AL_FORMAT_MONO16; break;
 							case 2: alFormat = AL_FORMAT_STEREO16; break;
 							default: SPRaise("Unsupported audio format");
@@ -121,7 +142,7 @@ namespace spades {
 						break;
 					case IAudioStream::SingleFloat:
 						bytes = ConvertFloatBufferToSignedShort(bytes);
-						switch (audioStream->GetNumChannels()) {
+						switch (audioStream.GetNumChannels()) {
 							case 1: alFormat = AL_FORMAT_MONO16; break;
 							case 2: alFormat = AL_FORMAT_STEREO16; break;
 							default: SPRaise("Unsupported audio format");
@@ -130,16 +151,199 @@ namespace spades {
 					default: SPRaise("Unsupported audio format");
 				}
 
-				format = alFormat;
+				sound->format = alFormat;
+				sound->samplingFrequency = audioStream.GetSamplingFrequency();
+				return sound;
+			}
+
+			std::unique_ptr<DecodedSound> LoadCachedSound(const std::string& path) {
+				SPADES_MARK_FUNCTION();
+
+				if (!FileManager::FileExists(path.c_str()))
+					return nullptr;
+
+				try {
+					auto stream = FileManager::OpenForReading(path.c_str());
+					// magic, version, format, sampling frequency, byte count
+					uint32_t header[5];
+					if (stream->Read(header, sizeof(header)) < sizeof(header) ||
+					    header[0] != SoundCacheMagic || header[1] != SoundCacheFormatVersion ||
+					    (header[2] != AL_FORMAT_MONO16 && header[2] != AL_FORMAT_STEREO16) ||
+					    header[3] == 0 || header[4] > 128 * 1024 * 1024)
+						return nullptr;
+
+					auto sound = stmp::make_unique<DecodedSound>();
+					sound->format = header[2];
+					sound->samplingFrequency = static_cast<int>(header[3]);
+					sound->bytes.resize(header[4]);
+					if (stream->Read(sound->bytes.data(), header[4]) < header[4])
+						return nullptr;
+					return sound;
+				} catch (const std::exception& ex) {
+					SPLog("Failed to read the cached sound '%s': %s", path.c_str(), ex.what());
+					return nullptr;
+				}
+			}
+
+			void SaveCachedSound(const DecodedSound& sound, const std::string& path) {
+				SPADES_MARK_FUNCTION();
+
+				try {
+					auto stream = FileManager::OpenForWriting(path.c_str());
+					uint32_t header[5] = {SoundCacheMagic, SoundCacheFormatVersion,
+					                      static_cast<uint32_t>(sound.format),
+					                      static_cast<uint32_t>(sound.samplingFrequency),
+					                      static_cast<uint32_t>(sound.bytes.size())};
+					stream->Write(header, sizeof(header));
+					stream->Write(sound.bytes.data(), sound.bytes.size());
+				} catch (const std::exception& ex) {
+					SPLog("Failed to save the decoded sound '%s': %s", path.c_str(), ex.what());
+				}
+			}
+
+			/**
+			 * Decodes a sound file. Safe to call from any thread.
+			 *
+			 * If `useCache` is set, the decoded PCM of compressed sounds is stored in
+			 * `Cache/Sounds` keyed by the file contents so later launches can skip decoding.
+			 */
+			std::unique_ptr<DecodedSound> DecodeSound(const std::string& name, bool useCache) {
+				SPADES_MARK_FUNCTION();
+
+				if (!useCache) {
+					std::unique_ptr<IAudioStream> stream{OpenAudioStream(name)};
+					return DecodeSoundStream(*stream);
+				}
+
+				// Read the file once; it's both hashed and decoded from memory
+				std::string fileBytes = FileManager::ReadAllBytes(name.c_str());
+				std::unique_ptr<IAudioStream> stream{OpenAudioStream(
+				  new MemoryStream(fileBytes.data(), fileBytes.size()), name, true)};
+
+				// Uncompressed formats are cheaper to read than the cache
+				if (stream->GetSampleFormat() != IAudioStream::SingleFloat)
+					return DecodeSoundStream(*stream);
+
+				uint64_t hash = 14695981039346656037ULL;
+				HashBytes(hash, &SoundCacheFormatVersion, sizeof(SoundCacheFormatVersion));
+				HashBytes(hash, fileBytes.data(), fileBytes.size());
+
+				char buf[64];
+				std::snprintf(buf, sizeof(buf), "Cache/Sounds/%016llx.bin",
+				              static_cast<unsigned long long>(hash));
+				std::string cachePath = buf;
+
+				std::unique_ptr<DecodedSound> sound = LoadCachedSound(cachePath);
+				if (!sound) {
+					sound = DecodeSoundStream(*stream);
+					SaveCachedSound(*sound, cachePath);
+				}
+				return sound;
+			}
+		} // namespace
+
+		class ALAudioChunk : public client::IAudioChunk {
+			ALuint handle;
+			ALuint format;
+			double duration;
+
+			std::string name;
+			std::unique_ptr<ConcurrentDispatch> decodeDispatch;
+			stmp::atomic_unique_ptr<DecodedSound> decodedSound;
+			std::atomic<bool> decodeFailed;
+
+			void Upload(const DecodedSound& sound) {
+				SPADES_MARK_FUNCTION();
+
+				format = sound.format;
+
+				int bytesPerFrame;
+				switch (sound.format) {
+					case AL_FORMAT_MONO8: bytesPerFrame = 1; break;
+					case AL_FORMAT_STEREO8:
+					case AL_FORMAT_MONO16: bytesPerFrame = 2; break;
+					default: bytesPerFrame = 4; break;
+				}
+				duration = static_cast<double>(sound.bytes.size()) /
+				           (bytesPerFrame * std::max(sound.samplingFrequency, 1));
 
 				al::qalGenBuffers(1, &handle);
 				ALCheckError();
-				al::qalBufferData(handle, alFormat, bytes.data(), (ALuint)bytes.size(),
-								  audioStream->GetSamplingFrequency());
+				al::qalBufferData(handle, sound.format, sound.bytes.data(),
+								  (ALuint)sound.bytes.size(), sound.samplingFrequency);
 				ALCheckError();
 			}
 
+		protected:
+			virtual ~ALAudioChunk() {
+				SPADES_MARK_FUNCTION();
+
+				// wait for the decoder, which refers to `this`
+				decodeDispatch.reset();
+
+				if (handle) {
+					al::qalDeleteBuffers(1, &handle);
+					ALCheckErrorPrecise();
+				}
+			}
+
+		public:
+			/** Creates a chunk from an already decoded sound. */
+			ALAudioChunk(const std::string& name, const DecodedSound& sound)
+			    : handle{0}, format{0}, duration{0.0}, name{name}, decodeFailed{false} {
+				SPADES_MARK_FUNCTION();
+
+				Upload(sound);
+			}
+
+			/**
+			 * Creates a chunk whose contents are decoded on a worker thread. The chunk
+			 * doesn't have an AL buffer until `Prepare` returns `true`.
+			 */
+			ALAudioChunk(const std::string& name, bool useCache)
+			    : handle{0}, format{0}, duration{0.0}, name{name}, decodeFailed{false} {
+				SPADES_MARK_FUNCTION();
+
+				auto decode = [this, useCache]() {
+					try {
+						decodedSound.store(DecodeSound(this->name, useCache));
+					} catch (const std::exception& ex) {
+						SPLog("Failed to decode sound '%s': %s", this->name.c_str(), ex.what());
+						decodeFailed = true;
+					}
+				};
+				decodeDispatch.reset(new FunctionDispatch<decltype(decode)>(decode));
+				decodeDispatch->Start();
+			}
+
+			/**
+			 * Uploads the decoded sound if it has become available. Must be called on the
+			 * thread owning the AL context.
+			 *
+			 * @return `true` if the chunk can be played.
+			 */
+			bool Prepare() {
+				if (handle)
+					return true;
+
+				std::unique_ptr<DecodedSound> sound = decodedSound.take();
+				if (!sound)
+					return false;
+
+				decodeDispatch.reset();
+				Upload(*sound);
+				return true;
+			}
+
+			bool IsFailed() const { return decodeFailed; }
+
+			const std::string& GetName() const { return name; }
+
+			ALuint GetHandle() { return handle; }
 			ALuint GetFormat() { return format; }
+
+			/** @return the length of the sound in seconds. */
+			double GetDuration() { return duration; }
 		};
 
 		class ALDevice::Internal {
@@ -154,16 +358,25 @@ namespace spades {
 			ALuint obstructionFilter;
 
 			client::GameMap* map;
+			AcousticsEstimator acoustics;
+			Vector3 listenerPosition;
 
 			struct ALSrc {
 				Internal* internal;
+				std::size_t index;
 				ALuint handle;
 				bool eaxSource;
 				bool stereo;
 				bool local;
+				Vector3 position;
 				client::AudioParam param;
 
-				ALSrc(Internal* i) : internal(i) {
+				/** The filters must be set up again by `UpdateObstruction`. */
+				bool filterDirty;
+				bool obstructed;
+
+				ALSrc(Internal* i, std::size_t index)
+				    : internal(i), index(index), filterDirty(true), obstructed(false) {
 					SPADES_MARK_FUNCTION();
 
 					al::qalGenSources(1, &handle);
@@ -249,6 +462,8 @@ namespace spades {
 					}
 					eaxSource = true;
 					this->local = local;
+					position = v;
+					filterDirty = true;
 					ALCheckError();
 				}
 
@@ -275,6 +490,15 @@ namespace spades {
 					ALCheckError();
 					eaxSource = false;
 					local = true;
+					position = MakeVector3(0.0F, 0.0F, 0.0F);
+					filterDirty = true;
+				}
+
+				// called when the source starts playing another sound
+				void ResetObstruction() {
+					internal->acoustics.ResetSource(index);
+					obstructed = false;
+					filterDirty = true;
 				}
 
 				// after calling Set2D/Set3D, must be called
@@ -284,15 +508,7 @@ namespace spades {
 					// update stereo source's volume (not spatialized by AL)
 					// FIXME: move to another function?
 					if (stereo && !local) {
-						ALfloat v3[3];
-						al::qalGetListenerfv(AL_POSITION, v3);
-						Vector3 eye = {v3[0], v3[1], v3[2]};
-						ALCheckErrorPrecise();
-						al::qalGetSourcefv(handle, AL_POSITION, v3);
-						Vector3 pos = {v3[0], v3[1], v3[2]};
-						ALCheckErrorPrecise();
-
-						float dist = (pos - eye).GetLength();
+						float dist = (position - internal->listenerPosition).GetLength();
 						dist /= param.referenceDistance;
 						if (dist < 1.0F)
 							dist = 1.0F;
@@ -304,38 +520,15 @@ namespace spades {
 					if (!internal->useEAX)
 						return;
 
-					ALint value;
-
-					al::qalGetSourcei(handle, AL_SOURCE_RELATIVE, &value);
-					ALCheckErrorPrecise();
-
-					bool enableObstruction = true;
-					if (value)
-						enableObstruction = false;
+					// the estimate is computed in background and may be a few frames old
+					bool enableObstruction = false;
+					if (internal->map && !local)
+						enableObstruction = internal->acoustics.IsObstructed(index, position);
 
-					// raytrace
-					client::GameMap* map = internal->map;
-					if (map && enableObstruction) {
-						ALfloat v3[3];
-						al::qalGetListenerfv(AL_POSITION, v3);
-						Vector3 eye = {v3[0], v3[1], v3[2]};
-						ALCheckErrorPrecise();
-						al::qalGetSourcefv(handle, AL_POSITION, v3);
-						Vector3 pos = {v3[0], v3[1], v3[2]};
-						ALCheckErrorPrecise();
-						Vector3 checkPos;
-						for (int x = -1; x <= 1; x++)
-						for (int y = -1; y <= 1; y++)
-						for (int z = -1; z <= 1; z++) {
-							IntVector3 hitPos;
-							checkPos = pos + MakeVector3((float)x, (float)y, (float)z) * 0.2F;
-							if (!map->CastRay(eye, (checkPos - eye).Normalize(),
-								(checkPos - eye).GetLength(), hitPos))
-								enableObstruction = false;
-						}
-					} else {
-						enableObstruction = false;
-					}
+					if (!filterDirty && enableObstruction == obstructed)
+						return;
+					filterDirty = false;
+					obstructed = enableObstruction;
 
 					ALuint fx = AL_EFFECTSLOT_NULL;
 					ALuint flt = AL_FILTER_NULL;
@@ -351,14 +544,18 @@ namespace spades {
 					ALCheckError();
 				}
 
-				void PlayBufferOneShot(ALuint buffer) {
+				/** Plays `buffer` once, starting `offset` seconds into it. */
+				void PlayBufferOneShot(ALuint buffer, double offset = 0.0) {
 					SPADES_MARK_FUNCTION();
 
 					al::qalSourcei(handle, AL_LOOPING, AL_FALSE);
 					ALCheckErrorPrecise();
 					al::qalSourcei(handle, AL_BUFFER, buffer);
 					ALCheckErrorPrecise();
-					al::qalSourcei(handle, AL_SAMPLE_OFFSET, 0);
+					if (offset > 0.0)
+						al::qalSourcef(handle, AL_SEC_OFFSET, static_cast<ALfloat>(offset));
+					else
+						al::qalSourcei(handle, AL_SAMPLE_OFFSET, 0);
 					ALCheckErrorPrecise();
 
 					// Clear any pending errors before alSourcePlay
@@ -378,10 +575,46 @@ namespace spades {
 
 			std::vector<ALSrc*> srcs;
 
-			// reverb simulator
-			int roomHistoryPos;
-			std::vector<float> roomHistory;
-			std::vector<float> roomFeedbackHistory;
+			/** Plays requested while the chunk was still being decoded. */
+			enum class PlayKind { World, Local, Local2D };
+			struct PendingPlay {
+				Handle<ALAudioChunk> chunk;
+				PlayKind kind;
+				Vector3 origin;
+				client::AudioParam param;
+				double requestTime;
+			};
+			std::list<PendingPlay> pendingPlays;
+			Stopwatch clock;
+
+			/** Pending plays older than this (in seconds) are dropped, as the sound would be
+			 * noticeably out of sync. */
+			static constexpr double maxPendingPlayDelay = 0.3;
+
+			/** What a voice plays. The voice's slot is an index into `srcs`. */
+			struct ALVoice {
+				Handle<ALAudioChunk> chunk;
+				PlayKind kind;
+				client::AudioParam param;
+			};
+			using ALVoiceManager = VoiceManager<ALVoice>;
+
+			class VoiceBackend : public ALVoiceManager::Backend {
+				Internal& internal;
+
+			public:
+				VoiceBackend(Internal& internal) : internal(internal) {}
+
+				void StartVoice(int slot, const ALVoiceManager::Voice& voice,
+								double offset) override {
+					internal.StartSource(*internal.srcs[slot], voice.payload, voice.origin, offset);
+				}
+				void StopVoice(int slot) override { internal.srcs[slot]->Terminate(); }
+				bool IsVoicePlaying(int slot) override { return internal.srcs[slot]->IsPlaying(); }
+			};
+			VoiceBackend voiceBackend;
+			std::unique_ptr<ALVoiceManager> voiceManager;
+			double lastVoiceStatsTime;
 
 			void updateEFXReverb(LPEFXEAXREVERBPROPERTIES reverb) {
 				SPADES_MARK_FUNCTION_DEBUG();
@@ -437,7 +670,7 @@ namespace spades {
 				ALCheckErrorPrecise();
 			}
 
-			Internal() {
+			Internal() : voiceBackend(*this), lastVoiceStatsTime(0.0) {
 				SPADES_MARK_FUNCTION();
 				const char *alExt, *alcExt, *dev;
 
@@ -491,7 +724,7 @@ namespace spades {
 				}
 
 				map = NULL;
-				roomHistoryPos = 0;
+				listenerPosition = MakeVector3(0.0F, 0.0F, 0.0F);
 
 				if (s_eax) {
 					try {
@@ -516,10 +749,12 @@ namespace spades {
 				ALCheckError();
 
 				for (int i = 0; i < (int)s_maxPolyphonics; i++)
-					srcs.push_back(new ALSrc(this));
+					srcs.push_back(new ALSrc(this, srcs.size()));
 
 				SPLog("%d source(s) initialized", (int)s_maxPolyphonics);
 
+				voiceManager.reset(new ALVoiceManager(voiceBackend, (int)srcs.size()));
+
 				al::qalDistanceModel(AL_INVERSE_DISTANCE_CLAMPED);
 				ALCheckErrorPrecise();
 
@@ -547,75 +782,125 @@ namespace spades {
 					ALCheckErrorPrecise();
 					al::qalFilterf(obstructionFilter, AL_LOWPASS_GAINHF, 0.1F);
 					ALCheckErrorPrecise();
-
-					for (int i = 0; i < 128; i++) {
-						roomHistory.push_back(20000.0F);
-						roomFeedbackHistory.push_back(0.0F);
-					}
 				}
 			}
 			~Internal() {
 				SPADES_MARK_FUNCTION();
 
+				pendingPlays.clear();
+
+				// detach the buffers before the chunks are released
+				voiceManager->Clear();
+				voiceManager.reset();
+
 				for (size_t i = 0; i < srcs.size(); i++)
 					delete srcs[i];
 			}
 
-			ALSrc* AllocChunk() {
+			void StartSource(ALSrc& src, const ALVoice& voice, const Vector3& origin,
+							 double offset) {
 				SPADES_MARK_FUNCTION();
 
-				size_t start = SampleRandomInt<std::size_t>(0, srcs.size() - 1);
-				for (size_t i = 0; i < srcs.size(); i++) {
-					ALSrc* src = srcs[(i + start) % srcs.size()];
-					if (src->IsPlaying())
-						continue;
-					return src;
+				ALAudioChunk* chunk = voice.chunk.GetPointerOrNull();
+				src.stereo = chunk->GetFormat() == AL_FORMAT_STEREO16;
+				src.SetParam(voice.param);
+				src.ResetObstruction();
+				switch (voice.kind) {
+					case PlayKind::World: src.Set3D(origin); break;
+					case PlayKind::Local: src.Set3D(origin, true); break;
+					case PlayKind::Local2D: src.Set2D(); break;
 				}
+				src.UpdateObstruction();
+				src.PlayBufferOneShot(chunk->GetHandle(), offset);
+			}
 
-				ALSrc* src = SampleRandomElement(srcs);
-				src->Terminate();
-				return src;
+			void AddVoice(ALAudioChunk* chunk, PlayKind kind, const Vector3& origin,
+						  const client::AudioParam& param) {
+				SPADES_MARK_FUNCTION();
+
+				ALVoiceManager::Voice voice;
+				voice.payload.chunk = Handle<ALAudioChunk>{*chunk};
+				voice.payload.kind = kind;
+				voice.payload.param = param;
+				voice.origin = origin;
+				voice.relative = kind != PlayKind::World;
+				voice.volume = param.volume;
+				voice.referenceDistance = param.referenceDistance;
+				voice.priority = param.priority;
+				voice.pitch = param.pitch;
+				voice.duration = chunk->GetDuration();
+				voiceManager->Add(std::move(voice), clock.GetTime());
+			}
+
+			/** @return `true` if the play was deferred because the chunk isn't ready yet. */
+			bool DeferIfPending(ALAudioChunk* chunk, PlayKind kind, const Vector3& origin,
+								const client::AudioParam& param) {
+				if (chunk->Prepare())
+					return false;
+
+				if (!chunk->IsFailed()) {
+					PendingPlay play;
+					play.chunk = Handle<ALAudioChunk>{*chunk};
+					play.kind = kind;
+					play.origin = origin;
+					play.param = param;
+					play.requestTime = clock.GetTime();
+					pendingPlays.push_back(std::move(play));
+				}
+				return true;
+			}
+
+			void ProcessPendingPlays() {
+				SPADES_MARK_FUNCTION();
+
+				double now = clock.GetTime();
+				for (auto it = pendingPlays.begin(); it != pendingPlays.end();) {
+					PendingPlay& play = *it;
+					ALAudioChunk* chunk = play.chunk.GetPointerOrNull();
+
+					if (chunk->Prepare()) {
+						if (now - play.requestTime <= maxPendingPlayDelay) {
+							switch (play.kind) {
+								case PlayKind::World: Play(chunk, play.origin, play.param); break;
+								case PlayKind::Local:
+									PlayLocal(chunk, play.origin, play.param);
+									break;
+								case PlayKind::Local2D: PlayLocal(chunk, play.param); break;
+							}
+						}
+						it = pendingPlays.erase(it);
+					} else if (chunk->IsFailed() || now - play.requestTime > maxPendingPlayDelay) {
+						it = pendingPlays.erase(it);
+					} else {
+						++it;
+					}
+				}
 			}
 
 			void Play(ALAudioChunk* chunk, const Vector3& origin, const client::AudioParam& param) {
 				SPADES_MARK_FUNCTION();
 
-				ALSrc* src = AllocChunk();
-				if (UNLIKELY(!src))
+				if (DeferIfPending(chunk, PlayKind::World, origin, param))
 					return;
 
-				src->stereo = chunk->GetFormat() == AL_FORMAT_STEREO16;
-				src->SetParam(param);
-				src->Set3D(origin);
-				src->UpdateObstruction();
-				src->PlayBufferOneShot(chunk->GetHandle());
+				AddVoice(chunk, PlayKind::World, origin, param);
 			}
 			void PlayLocal(ALAudioChunk* chunk, const Vector3& origin,
 						   const client::AudioParam& param) {
 				SPADES_MARK_FUNCTION();
 
-				ALSrc* src = AllocChunk();
-				if (!src)
+				if (DeferIfPending(chunk, PlayKind::Local, origin, param))
 					return;
 
-				src->stereo = chunk->GetFormat() == AL_FORMAT_STEREO16;
-				src->SetParam(param);
-				src->Set3D(origin, true);
-				src->UpdateObstruction();
-				src->PlayBufferOneShot(chunk->GetHandle());
+				AddVoice(chunk, PlayKind::Local, origin, param);
 			}
 			void PlayLocal(ALAudioChunk* chunk, const client::AudioParam& param) {
 				SPADES_MARK_FUNCTION();
 
-				ALSrc* src = AllocChunk();
-				if (!src)
+				if (DeferIfPending(chunk, PlayKind::Local2D, Vector3(), param))
 					return;
 
-				src->stereo = chunk->GetFormat() == AL_FORMAT_STEREO16;
-				src->SetParam(param);
-				src->Set2D();
-				src->UpdateObstruction();
-				src->PlayBufferOneShot(chunk->GetHandle());
+				AddVoice(chunk, PlayKind::Local2D, Vector3(), param);
 			}
 
 			void Respatialize(const Vector3& eye, const Vector3& front, const Vector3& up) {
@@ -627,77 +912,33 @@ namespace spades {
 
 				al::qalListenerfv(AL_POSITION, pos);
 				ALCheckError();
+				listenerPosition = eye;
 				al::qalListenerfv(AL_VELOCITY, vel);
 				ALCheckError();
 				al::qalListenerfv(AL_ORIENTATION, orient);
 				ALCheckError();
 
-				// do reverb simulation
-				if (useEAX) {
-					float maxDistance = 40.0F;
-					float reflections = 0.0F;
-					float roomVolume = 1.0F;
-					float roomArea = 1.0F;
-					float roomSize = 10.0F;
-					float feedbackness = 0.0F;
-
-					if (map) {
-						// do raycast
-						Vector3 rayFrom = eye;
-						Vector3 rayTo;
-
-						for (int rays = 0; rays < 4; rays++) {
-							rayTo = RandomUnitVector();
-
-							IntVector3 hitPos;
-							if (map->CastRay(rayFrom, rayTo, maxDistance, hitPos)) {
-								roomHistory[roomHistoryPos] =
-								  (MakeVector3(hitPos) - rayFrom).GetLength();
-								roomFeedbackHistory[roomHistoryPos] =
-								  map->CastRay(rayFrom, -rayTo, maxDistance, hitPos) ? 1.0F : 0.0F;
-							} else {
-								roomHistory[roomHistoryPos] = maxDistance * 2.0F;
-							}
-
-							roomHistoryPos++;
-							if (roomHistoryPos == (int)roomHistory.size())
-								roomHistoryPos = 0;
-						}
+				double now = clock.GetTime();
+				voiceManager->Update(eye, now);
+				if (s_debugVoices && now - lastVoiceStatsTime >= 1.0) {
+					const VoiceStats& stats = voiceManager->GetStats();
+					SPLog("Voices: %d real, %d virtual, %d stolen, %d dropped", stats.numReal,
+						  stats.numVirtual, stats.numStolen, stats.numDropped);
+					lastVoiceStatsTime = now;
+				}
 
-						// monte-carlo integration
-						unsigned int rayHitCount = 0;
-						roomVolume = 0.0F;
-						roomArea = 0.0F;
-						roomSize = 0.0F;
-						feedbackness = 0.0F;
-						for (size_t i = 0; i < roomHistory.size(); i++) {
-							float dist = roomHistory[i];
-							if (dist < maxDistance) {
-								rayHitCount++;
-								roomVolume += dist * dist;
-								roomArea += dist;
-								roomSize += dist;
-							}
+				ProcessPendingPlays();
 
-							feedbackness += roomFeedbackHistory[i];
-						}
-
-						if (rayHitCount > roomHistory.size() / 4) {
-							roomVolume /= (float)rayHitCount;
-							roomVolume *= 4.0F / 3.0F * M_PI_F;
-							roomArea /= (float)rayHitCount;
-							roomArea *= 4.0F * M_PI_F;
-							roomSize /= (float)rayHitCount;
-							reflections = (float)rayHitCount / (float)roomHistory.size();
-						} else {
-							roomVolume = 8.0F;
-							reflections = 0.2F;
-							roomArea = 100.0F;
-							roomSize = 100.0F;
-						}
+				if (useEAX) {
+					// obstruction and reverb are estimated in background
+					acoustics.Update(eye);
 
-						feedbackness /= (float)roomHistory.size();
-					}
+					const ReverbEstimate& est = acoustics.GetReverb();
+					float reflections = est.reflections;
+					float roomVolume = est.roomVolume;
+					float roomArea = est.roomArea;
+					float roomSize = est.roomSize;
+					float feedbackness = est.feedbackness;
 
 					// printf("room size: %f, ref: %f, fb: %f\n", roomSize, reflections,
 					// feedbackness);
@@ -727,10 +968,10 @@ namespace spades {
 					ALCheckError();
 				}
 
-				for (size_t i = 0; i < srcs.size(); i++) {
-					ALSrc* s = srcs[i];
-					if ((SampleRandomInt(0, 7) == 0) && s->IsPlaying())
-						s->UpdateObstruction();
+				// only cache lookups; the AL state is changed when the estimate does
+				for (const ALVoiceManager::Voice& voice : voiceManager->GetVoices()) {
+					if (voice.slot >= 0)
+						srcs[voice.slot]->UpdateObstruction();
 				}
 			}
 		};
@@ -778,16 +1019,15 @@ namespace spades {
 		ALAudioChunk* ALDevice::CreateChunk(const char* name) {
 			SPADES_MARK_FUNCTION();
 
-			IAudioStream* as = OpenAudioStream(name);
-
-			try {
-				ALAudioChunk* ch = new ALAudioChunk(as);
-				delete as;
-				return ch;
-			} catch (...) {
-				delete as;
-				throw;
+			if (s_backgroundDecode) {
+				// Report missing files right away, as the synchronous path does
+				if (!FileManager::FileExists(name))
+					SPRaise("Sound file not found: %s", name);
+				return new ALAudioChunk(name, (bool)s_soundCache);
 			}
+
+			std::unique_ptr<DecodedSound> sound = DecodeSound(name, s_soundCache);
+			return new ALAudioChunk(name, *sound);
 		}
 
 		client::IAudioChunk* ALDevice::RegisterSound(const char* name) {
@@ -804,6 +1044,32 @@ namespace spades {
 			return it->second;
 		}
 
+		void ALDevice::PreloadSounds(const std::vector<std::string>& names) {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<std::string> missingNames;
+			for (const std::string& name : names) {
+				if (chunks.find(name) == chunks.end() &&
+				    std::find(missingNames.begin(), missingNames.end(), name) ==
+				      missingNames.end())
+					missingNames.push_back(name);
+			}
+
+			Stopwatch sw;
+			bool useCache = s_soundCache;
+			ParallelLoad<std::unique_ptr<DecodedSound>>(
+			  missingNames.size(),
+			  [&](std::size_t i) { return DecodeSound(missingNames[i], useCache); },
+			  [&](std::size_t i, std::unique_ptr<DecodedSound> sound) {
+				  // Failed ones are retried (and reported) by `RegisterSound`
+				  if (sound)
+					  chunks[missingNames[i]] = new ALAudioChunk(missingNames[i], *sound);
+			  });
+
+			SPLog("Preloaded %d sound(s) in %.3f seconds", static_cast<int>(missingNames.size()),
+			      sw.GetTime());
+		}
+
 		void ALDevice::ClearCache() {
 			SPADES_MARK_FUNCTION();
 
@@ -844,6 +1110,7 @@ namespace spades {
 			SPADES_MARK_FUNCTION_DEBUG();
 			client::GameMap* oldMap = d->map;
 			d->map = mp;
+			d->acoustics.SetGameMap(mp);
 			if (mp)
 				mp->AddRef();
 			if (oldMap)
@@ -46,6 +46,8 @@ namespace spades {
 
 			static std::vector<std::string> DeviceList();
 
+			void PreloadSounds(const std::vector<std::string>& names) override;
+
 			void ClearCache() override;
 
 			void SetGameMap(client::GameMap*) override;
@@ -0,0 +1,321 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+
+#include "AcousticsEstimator.h"
+#include <Client/GameMap.h>
+#include <Core/ConcurrentDispatch.h>
+#include <Core/Debug.h>
+#include <Core/Settings.h>
+
+DEFINE_SPADES_SETTING(s_acousticsRayBudget, "256");
+
+namespace spades {
+	namespace audio {
+
+		namespace {
+			/** Cached obstruction is reused while neither end moves farther than this. */
+			constexpr float movementThreshold = 0.5F;
+
+			/** A block change invalidates the sources whose line of sight passes within
+			 * this distance of it. */
+			constexpr float invalidationEnvelope = 1.5F;
+
+			constexpr float reverbMaxDistance = 40.0F;
+			constexpr int reverbRaysPerJob = 4;
+			/** The number of rays cast by `CastObstructionRays` in the worst case. */
+			constexpr int obstructionRaysPerSource = 27;
+			constexpr std::size_t reverbHistorySize = 128;
+
+			float DistanceToSegment(const Vector3& p, const Vector3& a, const Vector3& b) {
+				Vector3 ab = b - a;
+				float lengthSq = Vector3::Dot(ab, ab);
+				float t = lengthSq > 0.0F ? Vector3::Dot(p - a, ab) / lengthSq : 0.0F;
+				t = std::max(std::min(t, 1.0F), 0.0F);
+				return (a + ab * t - p).GetLength();
+			}
+		} // namespace
+
+		AcousticsEstimator::AcousticsEstimator()
+		    : eye{0.0F, 0.0F, 0.0F}, job{new Job()}, mapVersion{0} {
+			job->roomHistoryPos = 0;
+			job->roomHistory.resize(reverbHistorySize, 20000.0F);
+			job->roomFeedbackHistory.resize(reverbHistorySize, 0.0F);
+		}
+
+		AcousticsEstimator::~AcousticsEstimator() {
+			SPADES_MARK_FUNCTION();
+
+			// wait for the job, which refers to the map
+			dispatch.reset();
+			SetGameMap(nullptr);
+		}
+
+		void AcousticsEstimator::SetGameMap(client::GameMap* newMap) {
+			SPADES_MARK_FUNCTION();
+
+			if (newMap == map.GetPointerOrNull())
+				return;
+
+			if (map)
+				map->RemoveListener(this);
+			map = Handle<client::GameMap>(newMap);
+			if (map)
+				map->AddListener(this);
+
+			// results of the running job are for the old map
+			mapVersion++;
+			for (SourceEntry& entry : sources)
+				entry = SourceEntry();
+		}
+
+		void AcousticsEstimator::Update(const Vector3& eye) {
+			SPADES_MARK_FUNCTION();
+
+			this->eye = eye;
+
+			if (dispatch) {
+				if (!job->done)
+					return;
+				FinishJob();
+			}
+
+			if (!map) {
+				reverb = ReverbEstimate();
+				return;
+			}
+
+			StartJob();
+		}
+
+		bool AcousticsEstimator::IsObstructed(std::size_t id, const Vector3& position) {
+			if (id >= sources.size())
+				sources.resize(id + 1);
+
+			SourceEntry& entry = sources[id];
+			bool stale = !entry.valid ||
+			             (entry.position - position).GetLength() > movementThreshold ||
+			             (entry.eye - eye).GetLength() > movementThreshold;
+			if (stale && !entry.pending) {
+				entry.requested = true;
+				entry.position = position;
+				entry.eye = eye;
+			}
+			return entry.obstructed;
+		}
+
+		void AcousticsEstimator::ResetSource(std::size_t id) {
+			if (id >= sources.size())
+				return;
+
+			// the running job might still be computing a result for the previous sound
+			SourceEntry& entry = sources[id];
+			std::uint32_t version = entry.version + 1;
+			bool pending = entry.pending;
+			entry = SourceEntry();
+			entry.version = version;
+			entry.pending = pending;
+		}
+
+		void AcousticsEstimator::GameMapChanged(int x, int y, int z, client::GameMap* changedMap) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			if (changedMap != map.GetPointerOrNull())
+				return;
+
+			Vector3 block = MakeVector3((float)x + 0.5F, (float)y + 0.5F, (float)z + 0.5F);
+			for (SourceEntry& entry : sources) {
+				if (!entry.valid && !entry.pending)
+					continue;
+				if (DistanceToSegment(block, entry.eye, entry.position) > invalidationEnvelope)
+					continue;
+				entry.valid = false;
+				entry.version++;
+			}
+		}
+
+		void AcousticsEstimator::FinishJob() {
+			SPADES_MARK_FUNCTION();
+
+			dispatch.reset();
+
+			bool current = job->mapVersion == mapVersion;
+			if (current)
+				reverb = job->reverb;
+
+			for (std::size_t i = 0; i < job->queries.size(); i++) {
+				const Job::Query& query = job->queries[i];
+				if (!current)
+					break;
+
+				SourceEntry& entry = sources[query.id];
+				entry.pending = false;
+				if (query.version != entry.version) {
+					// invalidated in the meantime; `IsObstructed` requests it again with
+					// the current position
+					continue;
+				}
+				if (i >= job->numAnswered) {
+					// ran out of budget, or the job failed
+					entry.requested = true;
+					continue;
+				}
+
+				entry.valid = true;
+				entry.obstructed = query.obstructed;
+			}
+
+			job->queries.clear();
+			job->map = Handle<client::GameMap>();
+		}
+
+		void AcousticsEstimator::StartJob() {
+			SPADES_MARK_FUNCTION();
+
+			job->map = map;
+			job->mapVersion = mapVersion;
+			job->eye = eye;
+			job->rayBudget = std::max((int)s_acousticsRayBudget,
+			                          reverbRaysPerJob * 2 + obstructionRaysPerSource);
+			job->done = false;
+
+			// sources without any result go first
+			for (int pass = 0; pass < 2; pass++) {
+				for (std::size_t id = 0; id < sources.size(); id++) {
+					SourceEntry& entry = sources[id];
+					if (!entry.requested || entry.valid != (pass == 1))
+						continue;
+
+					Job::Query query;
+					query.id = id;
+					query.version = entry.version;
+					query.position = entry.position;
+					query.obstructed = false;
+					job->queries.push_back(query);
+
+					entry.requested = false;
+					entry.pending = true;
+				}
+			}
+
+			Job* j = job.get();
+			auto run = [j]() { j->Run(); };
+			dispatch.reset(new FunctionDispatch<decltype(run)>(run));
+			dispatch->Start();
+		}
+
+		void AcousticsEstimator::Job::Run() {
+			SPADES_MARK_FUNCTION();
+
+			int budget = rayBudget;
+			numAnswered = 0;
+
+			try {
+				CastReverbRays(reverbRaysPerJob);
+				budget -= reverbRaysPerJob * 2;
+				IntegrateReverb();
+
+				// check before each source, so the budget is never exceeded
+				for (Query& query : queries) {
+					if (budget < obstructionRaysPerSource)
+						break;
+					query.obstructed = CastObstructionRays(query, budget);
+					numAnswered++;
+				}
+			} catch (const std::exception& ex) {
+				// the unanswered queries are requested again by `FinishJob`
+				SPLog("Acoustics estimation failed: %s", ex.what());
+			}
+
+			done = true;
+		}
+
+		bool AcousticsEstimator::Job::CastObstructionRays(const Query& query,
+		                                                  int& rayBudget) const {
+			// the source is obstructed if every ray to the points around it is blocked
+			for (int x = -1; x <= 1; x++)
+				for (int y = -1; y <= 1; y++)
+					for (int z = -1; z <= 1; z++) {
+						IntVector3 hitPos;
+						Vector3 checkPos =
+						  query.position + MakeVector3((float)x, (float)y, (float)z) * 0.2F;
+						rayBudget--;
+						if (!map->CastRay(eye, (checkPos - eye).Normalize(),
+						                  (checkPos - eye).GetLength(), hitPos))
+							return false;
+					}
+			return true;
+		}
+
+		void AcousticsEstimator::Job::CastReverbRays(int numRays) {
+			for (int rays = 0; rays < numRays; rays++) {
+				Vector3 rayTo = RandomUnitVector();
+
+				IntVector3 hitPos;
+				if (map->CastRay(eye, rayTo, reverbMaxDistance, hitPos)) {
+					roomHistory[roomHistoryPos] = (MakeVector3(hitPos) - eye).GetLength();
+					roomFeedbackHistory[roomHistoryPos] =
+					  map->CastRay(eye, -rayTo, reverbMaxDistance, hitPos) ? 1.0F : 0.0F;
+				} else {
+					roomHistory[roomHistoryPos] = reverbMaxDistance * 2.0F;
+				}
+
+				roomHistoryPos++;
+				if (roomHistoryPos == (int)roomHistory.size())
+					roomHistoryPos = 0;
+			}
+		}
+
+		void AcousticsEstimator::Job::IntegrateReverb() {
+			// monte-carlo integration
+			unsigned int rayHitCount = 0;
+			float roomVolume = 0.0F;
+			float roomArea = 0.0F;
+			float roomSize = 0.0F;
+			float feedbackness = 0.0F;
+			for (size_t i = 0; i < roomHistory.size(); i++) {
+				float dist = roomHistory[i];
+				if (dist < reverbMaxDistance) {
+					rayHitCount++;
+					roomVolume += dist * dist;
+					roomArea += dist;
+					roomSize += dist;
+				}
+
+				feedbackness += roomFeedbackHistory[i];
+			}
+
+			if (rayHitCount > roomHistory.size() / 4) {
+				reverb.roomVolume = roomVolume / (float)rayHitCount * 4.0F / 3.0F * M_PI_F;
+				reverb.roomArea = roomArea / (float)rayHitCount * 4.0F * M_PI_F;
+				reverb.roomSize = roomSize / (float)rayHitCount;
+				reverb.reflections = (float)rayHitCount / (float)roomHistory.size();
+			} else {
+				reverb.roomVolume = 8.0F;
+				reverb.reflections = 0.2F;
+				reverb.roomArea = 100.0F;
+				reverb.roomSize = 100.0F;
+			}
+
+			reverb.feedbackness = feedbackness / (float)roomHistory.size();
+		}
+	} // namespace audio
+} // namespace spades
@@ -0,0 +1,150 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <Client/IGameMapListener.h>
+#include <Core/Math.h>
+#include <Core/RefCountedObject.h>
+
+namespace spades {
+	class ConcurrentDispatch;
+
+	namespace client {
+		class GameMap;
+	}
+
+	namespace audio {
+
+		/** Room acoustics around the listener, estimated by casting random rays. */
+		struct ReverbEstimate {
+			float roomVolume = 1.0F;
+			float roomArea = 1.0F;
+			float roomSize = 10.0F;
+			float reflections = 0.0F;
+			float feedbackness = 0.0F;
+		};
+
+		/**
+		 * Estimates sound obstruction and reverb on a worker thread.
+		 *
+		 * Each `Update` hands a snapshot of the listener position and the sources that need
+		 * fresh results to a background job, which casts at most `s_acousticsRayBudget`
+		 * rays. Obstruction results are cached per source and reused until the source or the
+		 * listener moves, or a block near the line between them changes.
+		 *
+		 * All methods must be called on the same thread.
+		 */
+		class AcousticsEstimator : public client::IGameMapListener {
+		public:
+			AcousticsEstimator();
+			~AcousticsEstimator();
+
+			void SetGameMap(client::GameMap*);
+
+			/**
+			 * Starts a new job if the previous one has finished. Should be called once per
+			 * frame.
+			 */
+			void Update(const Vector3& eye);
+
+			/**
+			 * Returns the cached obstruction state of the source `id` at `position`, and
+			 * requests a new estimate if it's missing or stale. Unknown sources are reported
+			 * as unobstructed.
+			 */
+			bool IsObstructed(std::size_t id, const Vector3& position);
+
+			/**
+			 * Forgets the cached obstruction state of the source `id`. Should be called
+			 * when the source starts playing another sound.
+			 */
+			void ResetSource(std::size_t id);
+
+			const ReverbEstimate& GetReverb() const { return reverb; }
+
+			void GameMapChanged(int x, int y, int z, client::GameMap*) override;
+
+		private:
+			struct SourceEntry {
+				Vector3 position;
+				Vector3 eye;
+				bool valid = false;
+				bool obstructed = false;
+				/** The entry should be included in the next job. */
+				bool requested = false;
+				/** The entry is included in the running job. */
+				bool pending = false;
+				/** Incremented when the entry is invalidated, so that results computed
+				 * before that are discarded. */
+				std::uint32_t version = 0;
+			};
+
+			struct Job {
+				Handle<client::GameMap> map;
+				std::uint32_t mapVersion;
+				Vector3 eye;
+				int rayBudget;
+
+				struct Query {
+					std::size_t id;
+					std::uint32_t version;
+					Vector3 position;
+					bool obstructed;
+				};
+				std::vector<Query> queries;
+				/** Number of queries answered before the ray budget ran out. */
+				std::size_t numAnswered;
+
+				/** Owned by the job while it's running. */
+				int roomHistoryPos;
+				std::vector<float> roomHistory;
+				std::vector<float> roomFeedbackHistory;
+				ReverbEstimate reverb;
+
+				std::atomic<bool> done{false};
+
+				void Run();
+				bool CastObstructionRays(const Query&, int& rayBudget) const;
+				void CastReverbRays(int numRays);
+				void IntegrateReverb();
+			};
+
+			Handle<client::GameMap> map;
+			std::vector<SourceEntry> sources;
+			Vector3 eye;
+			ReverbEstimate reverb;
+
+			/** Kept between runs because it holds the reverb ray history. */
+			std::unique_ptr<Job> job;
+			/** Non-null while `job` is running. */
+			std::unique_ptr<ConcurrentDispatch> dispatch;
+			std::uint32_t mapVersion;
+
+			void FinishJob();
+			void StartJob();
+		};
+	} // namespace audio
+} // namespace spades
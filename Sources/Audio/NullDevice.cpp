@@ -18,14 +18,38 @@
 
  */
 
+#include <algorithm>
+
 #include "NullDevice.h"
 #include <Client/IAudioChunk.h>
+#include <Core/Settings.h>
+
+SPADES_SETTING(s_maxPolyphonics);
 
 namespace spades {
 	namespace audio {
 		class NullChunk : public client::IAudioChunk {};
 
-		NullDevice::NullDevice() {}
+		namespace {
+			/** `NullChunk` has no data; every sound is assumed to last this long. */
+			constexpr double nominalSoundDuration = 1.0;
+		} // namespace
+
+		void NullDevice::SlotBackend::StartVoice(int slot, const NullVoiceManager::Voice& voice,
+		                                         double offset) {
+			device.slotEndTimes[slot] =
+			  device.clock.GetTime() + (voice.duration - offset) / voice.pitch;
+		}
+		void NullDevice::SlotBackend::StopVoice(int slot) { device.slotEndTimes[slot] = 0.0; }
+		bool NullDevice::SlotBackend::IsVoicePlaying(int slot) {
+			return device.clock.GetTime() < device.slotEndTimes[slot];
+		}
+
+		NullDevice::NullDevice() : NullDevice((int)s_maxPolyphonics) {}
+		NullDevice::NullDevice(int numSlots)
+		    : slotEndTimes(std::max(numSlots, 1), 0.0), slotBackend(*this) {
+			voiceManager.reset(new NullVoiceManager(slotBackend, (int)slotEndTimes.size()));
+		}
 		NullDevice::~NullDevice() {}
 
 		static NullChunk nullChunkInstance;
@@ -34,12 +58,33 @@ namespace spades {
 
 		void NullDevice::SetGameMap(client::GameMap*) {}
 
-		void NullDevice::Play(client::IAudioChunk*, const spades::Vector3&,
-		                      const client::AudioParam&) {}
-		void NullDevice::PlayLocal(client::IAudioChunk*, const spades::Vector3&,
-		                           const client::AudioParam&) {}
-		void NullDevice::PlayLocal(client::IAudioChunk*, const client::AudioParam&) {}
-		void NullDevice::Respatialize(const spades::Vector3&, const spades::Vector3&,
-		                              const spades::Vector3&) {}
+		void NullDevice::AddVoice(const Vector3& origin, bool relative,
+		                          const client::AudioParam& param) {
+			NullVoiceManager::Voice voice;
+			voice.origin = origin;
+			voice.relative = relative;
+			voice.volume = param.volume;
+			voice.referenceDistance = param.referenceDistance;
+			voice.priority = param.priority;
+			voice.pitch = std::max(param.pitch, 0.01F);
+			voice.duration = nominalSoundDuration;
+			voiceManager->Add(voice, clock.GetTime());
+		}
+
+		void NullDevice::Play(client::IAudioChunk*, const spades::Vector3& origin,
+		                      const client::AudioParam& param) {
+			AddVoice(origin, false, param);
+		}
+		void NullDevice::PlayLocal(client::IAudioChunk*, const spades::Vector3& origin,
+		                           const client::AudioParam& param) {
+			AddVoice(origin, true, param);
+		}
+		void NullDevice::PlayLocal(client::IAudioChunk*, const client::AudioParam& param) {
+			AddVoice(Vector3(), true, param);
+		}
+		void NullDevice::Respatialize(const spades::Vector3& eye, const spades::Vector3&,
+		                              const spades::Vector3&) {
+			voiceManager->Update(eye, clock.GetTime());
+		}
 	} // namespace audio
-} // namespace spades
\ No newline at end of file
+} // namespace spades
@@ -23,18 +23,50 @@
 #include <array>
 #include <map>
 #include <memory>
+#include <vector>
 
+#include "VoiceManager.h"
 #include <Client/IAudioDevice.h>
+#include <Core/Stopwatch.h>
 
 namespace spades {
 	namespace audio {
 
+		/**
+		 * An audio device that doesn't output anything. Plays still go through
+		 * `VoiceManager` with simulated slots, so voice management can be exercised
+		 * without an audio backend.
+		 */
 		class NullDevice : public client::IAudioDevice {
+			struct NullVoice {};
+			using NullVoiceManager = VoiceManager<NullVoice>;
+
+			/** A simulated slot is busy until its sound would have finished. */
+			class SlotBackend : public NullVoiceManager::Backend {
+				NullDevice& device;
+
+			public:
+				SlotBackend(NullDevice& device) : device(device) {}
+				void StartVoice(int slot, const NullVoiceManager::Voice&, double offset) override;
+				void StopVoice(int slot) override;
+				bool IsVoicePlaying(int slot) override;
+			};
+
+			Stopwatch clock;
+			std::vector<double> slotEndTimes;
+			SlotBackend slotBackend;
+			std::unique_ptr<NullVoiceManager> voiceManager;
+
+			void AddVoice(const Vector3& origin, bool relative, const client::AudioParam&);
+
 		protected:
 			virtual ~NullDevice();
 
 		public:
 			NullDevice();
+			NullDevice(int numSlots);
+
+			const VoiceStats& GetVoiceStats() const { return voiceManager->GetStats(); }
 
 			client::IAudioChunk* RegisterSound(const char* name) override;
 
@@ -0,0 +1,602 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include "SWAudioDevice.h"
+#include "SWMixer.h"
+#include "VoiceManager.h"
+#include <Client/IAudioChunk.h>
+#include <Core/AudioStream.h>
+#include <Core/Debug.h>
+#include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/IAudioStream.h>
+#include <Core/ParallelLoad.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Imports/SDL.h>
+
+DEFINE_SPADES_SETTING(s_swAudioFrequency, "44100");
+DEFINE_SPADES_SETTING(s_swAudioWavOutput, "");
+SPADES_SETTING(s_volume);
+SPADES_SETTING(s_maxPolyphonics);
+SPADES_SETTING(s_debugVoices);
+
+namespace spades {
+	namespace audio {
+
+		class SWAudioChunk : public client::IAudioChunk {
+			std::shared_ptr<const SWSound> sound;
+
+		protected:
+			~SWAudioChunk() {}
+
+		public:
+			SWAudioChunk(std::shared_ptr<const SWSound> sound) : sound(std::move(sound)) {}
+
+			const std::shared_ptr<const SWSound>& GetSound() const { return sound; }
+		};
+
+		namespace {
+			std::shared_ptr<SWSound> DecodeSound(const std::string& name) {
+				SPADES_MARK_FUNCTION();
+
+				std::unique_ptr<IAudioStream> stream{OpenAudioStream(name)};
+				if (stream->GetLength() > 128 * 1024 * 1024)
+					SPRaise("Audio stream too long");
+
+				auto sound = std::make_shared<SWSound>();
+				sound->numChannels = stream->GetNumChannels();
+				sound->samplingFrequency = stream->GetSamplingFrequency();
+				if (sound->numChannels != 1 && sound->numChannels != 2)
+					SPRaise("Unsupported audio format");
+				if (sound->samplingFrequency <= 0)
+					SPRaise("Invalid sampling frequency");
+
+				std::vector<uint8_t> bytes(static_cast<std::size_t>(stream->GetLength()));
+				stream->SetPosition(0);
+				if (stream->Read(bytes.data(), bytes.size()) < bytes.size())
+					SPRaise("Failed to read audio data");
+
+				std::vector<float>& samples = sound->samples;
+				switch (stream->GetSampleFormat()) {
+					case IAudioStream::UnsignedByte:
+						samples.resize(bytes.size());
+						for (std::size_t i = 0; i < samples.size(); i++)
+							samples[i] = (static_cast<float>(bytes[i]) - 128.0F) / 128.0F;
+						break;
+					case IAudioStream::SignedShort:
+						samples.resize(bytes.size() / 2);
+						for (std::size_t i = 0; i < samples.size(); i++) {
+							int16_t v;
+							std::memcpy(&v, bytes.data() + i * 2, 2);
+							samples[i] = static_cast<float>(v) / 32768.0F;
+						}
+						break;
+					case IAudioStream::SingleFloat:
+						samples.resize(bytes.size() / 4);
+						std::memcpy(samples.data(), bytes.data(), samples.size() * 4);
+						break;
+					default: SPRaise("Unsupported audio format");
+				}
+				samples.resize(samples.size() - samples.size() % sound->numChannels);
+				return sound;
+			}
+
+			/** Writes 16-bit stereo PCM to a WAV file, whose header is completed on
+			 * destruction. */
+			class WavWriter {
+				std::unique_ptr<IStream> stream;
+				int samplingFrequency;
+				uint32_t numBytes;
+				std::vector<int16_t> buffer;
+
+				void WriteHeader() {
+					auto u32 = [this](uint32_t v) { stream->Write(&v, 4); }; // little endian
+					auto u16 = [this](uint16_t v) { stream->Write(&v, 2); };
+					stream->SetPosition(0);
+					stream->Write("RIFF", 4);
+					u32(36 + numBytes);
+					stream->Write("WAVEfmt ", 8);
+					u32(16);
+					u16(1); // PCM
+					u16(2);
+					u32(static_cast<uint32_t>(samplingFrequency));
+					u32(static_cast<uint32_t>(samplingFrequency) * 4);
+					u16(4);
+					u16(16);
+					stream->Write("data", 4);
+					u32(numBytes);
+				}
+
+			public:
+				WavWriter(const std::string& path, int samplingFrequency)
+				    : stream(FileManager::OpenForWriting(path.c_str())),
+				      samplingFrequency(samplingFrequency),
+				      numBytes(0) {
+					WriteHeader();
+				}
+
+				~WavWriter() {
+					try {
+						WriteHeader();
+						stream->Flush();
+					} catch (const std::exception& ex) {
+						SPLog("Failed to finish the WAV file: %s", ex.what());
+					}
+				}
+
+				void Write(const float* samples, std::size_t numFrames) {
+					buffer.resize(numFrames * 2);
+					for (std::size_t i = 0; i < buffer.size(); i++)
+						buffer[i] = static_cast<int16_t>(std::lround(samples[i] * 32767.0F));
+					stream->SetPosition(44 + numBytes);
+					stream->Write(buffer.data(), buffer.size() * 2);
+					numBytes += static_cast<uint32_t>(buffer.size() * 2);
+				}
+			};
+
+			/** Same curve as `ALDevice` so both backends sound equally loud. */
+			float MasterGainForVolume(int volume) {
+				if (volume <= 0)
+					return 0.0F;
+				return powf(27.71373379F, std::log(static_cast<float>(volume) / 100.0F));
+			}
+		} // namespace
+
+		class SWAudioDevice::Internal {
+		public:
+			enum class PlayKind { World, Local, Local2D };
+			struct SWVoice {
+				std::shared_ptr<const SWSound> sound;
+				PlayKind kind;
+				client::AudioParam param;
+			};
+			using SWVoiceManager = VoiceManager<SWVoice>;
+
+			class VoiceBackend : public SWVoiceManager::Backend {
+				Internal& internal;
+
+			public:
+				VoiceBackend(Internal& internal) : internal(internal) {}
+
+				void StartVoice(int slot, const SWVoiceManager::Voice& voice,
+				                double offset) override {
+					internal.mixer.Start(slot, voice.payload.sound, offset,
+					                     voice.payload.param.pitch, internal.ComputeGains(voice));
+				}
+				void StopVoice(int slot) override { internal.mixer.Stop(slot); }
+				bool IsVoicePlaying(int slot) override { return internal.mixer.IsPlaying(slot); }
+			};
+
+			/** Guards `mixer` and `voiceManager`, which are also used by the SDL audio
+			 * thread. */
+			std::mutex mutex;
+			SWMixer mixer;
+			VoiceBackend voiceBackend;
+			SWVoiceManager voiceManager;
+			/** Times voices when there's an output. */
+			Stopwatch clock;
+
+			Vector3 eye{0.0F, 0.0F, 0.0F};
+			Vector3 right{1.0F, 0.0F, 0.0F};
+
+			SDL_AudioDeviceID sdlDevice;
+			std::unique_ptr<WavWriter> wavWriter;
+			double wavRenderedTime;
+			std::vector<float> wavBuffer;
+
+			double mixTime;
+			uint64_t numMixedFrames;
+			double lastStatsTime;
+
+			Internal(int samplingFrequency)
+			    : mixer(samplingFrequency, (int)s_maxPolyphonics),
+			      voiceBackend(*this),
+			      voiceManager(voiceBackend, mixer.GetNumVoices()),
+			      sdlDevice(0),
+			      wavRenderedTime(0.0),
+			      mixTime(0.0),
+			      numMixedFrames(0),
+			      lastStatsTime(0.0) {
+				mixer.SetMasterGain(MasterGainForVolume(s_volume));
+			}
+
+			~Internal() {
+				SPADES_MARK_FUNCTION();
+
+				if (sdlDevice) {
+					// waits for the callback to return
+					SDL_CloseAudioDevice(sdlDevice);
+					SDL_QuitSubSystem(SDL_INIT_AUDIO);
+				}
+
+				if (numMixedFrames > 0) {
+					double audioTime =
+					  static_cast<double>(numMixedFrames) / mixer.GetSamplingFrequency();
+					SPLog("Software mixer rendered %.1f second(s) of audio in %.3f second(s) "
+					      "(%.2f%% of real time)",
+					      audioTime, mixTime, mixTime / audioTime * 100.0);
+				}
+			}
+
+			void OpenSDLOutput() {
+				SPADES_MARK_FUNCTION();
+
+				if (SDL_InitSubSystem(SDL_INIT_AUDIO) < 0)
+					SPRaise("Failed to initialize SDL audio: %s", SDL_GetError());
+
+				SDL_AudioSpec desired;
+				std::memset(&desired, 0, sizeof(desired));
+				desired.freq = mixer.GetSamplingFrequency();
+				desired.format = AUDIO_F32SYS;
+				desired.channels = 2;
+				desired.samples = 1024;
+				desired.callback = SDLCallback;
+				desired.userdata = this;
+
+				// SDL converts the format if the device doesn't support it
+				SDL_AudioSpec obtained;
+				sdlDevice = SDL_OpenAudioDevice(nullptr, 0, &desired, &obtained, 0);
+				if (!sdlDevice) {
+					SDL_QuitSubSystem(SDL_INIT_AUDIO);
+					SPRaise("Failed to open SDL audio device: %s", SDL_GetError());
+				}
+				SDL_PauseAudioDevice(sdlDevice, 0);
+				SPLog("Software mixer is outputting to SDL audio at %dHz",
+				      mixer.GetSamplingFrequency());
+			}
+
+			static void SDLCallback(void* userdata, Uint8* stream, int len) {
+				auto& self = *static_cast<Internal*>(userdata);
+				self.Render(reinterpret_cast<float*>(stream),
+				            static_cast<std::size_t>(len) / (sizeof(float) * 2));
+			}
+
+			void Render(float* out, std::size_t numFrames) {
+				std::lock_guard<std::mutex> lock(mutex);
+				Stopwatch sw;
+				mixer.Mix(out, numFrames);
+				mixTime += sw.GetTime();
+				numMixedFrames += numFrames;
+			}
+
+			/**
+			 * Returns the time the voice manager works in. Without an output, it's the
+			 * amount of audio rendered, so the result doesn't depend on how fast `Render`
+			 * is called. `mutex` must be held.
+			 */
+			double GetTime() {
+				if (!sdlDevice && !wavWriter)
+					return static_cast<double>(numMixedFrames) / mixer.GetSamplingFrequency();
+				return clock.GetTime();
+			}
+
+			SWMixer::Gains ComputeGains(const SWVoiceManager::Voice& voice) {
+				const SWVoice& v = voice.payload;
+				SWMixer::Gains gains;
+				float gain = v.param.volume;
+				float pan = 0.0F;
+
+				if (v.kind != PlayKind::Local2D) {
+					// `origin` is relative to the listener (x = right) for local sounds
+					Vector3 rel = v.kind == PlayKind::World ? voice.origin - eye : voice.origin;
+					float dist = rel.GetLength();
+					if (v.kind == PlayKind::World) {
+						float refDist = std::max(v.param.referenceDistance, 0.0001F);
+						gain *= refDist / std::max(dist, refDist);
+					}
+					if (dist > 0.001F) {
+						float x = v.kind == PlayKind::World ? Vector3::Dot(rel, right) : rel.x;
+						pan = std::max(std::min(x / dist, 1.0F), -1.0F);
+					}
+					gains.reverb = gain * 0.3F;
+				}
+
+				if (v.sound->numChannels == 2) {
+					// stereo sounds aren't spatialized
+					gains.left = gains.right = gain;
+				} else {
+					// equal-power panning
+					float angle = (pan + 1.0F) * (M_PI_F * 0.25F);
+					gains.left = gain * std::cos(angle);
+					gains.right = gain * std::sin(angle);
+				}
+				return gains;
+			}
+
+			void AddVoice(SWAudioChunk* chunk, PlayKind kind, const Vector3& origin,
+			              const client::AudioParam& param) {
+				SPADES_MARK_FUNCTION();
+
+				const std::shared_ptr<const SWSound>& sound = chunk->GetSound();
+
+				SWVoiceManager::Voice voice;
+				voice.payload.sound = sound;
+				voice.payload.kind = kind;
+				voice.payload.param = param;
+				voice.origin = origin;
+				voice.relative = kind != PlayKind::World;
+				voice.volume = param.volume;
+				voice.referenceDistance = param.referenceDistance;
+				voice.priority = param.priority;
+				voice.pitch = param.pitch;
+				voice.duration =
+				  static_cast<double>(sound->GetNumFrames()) / sound->samplingFrequency;
+
+				std::lock_guard<std::mutex> lock(mutex);
+				voiceManager.Add(std::move(voice), GetTime());
+			}
+
+			void Respatialize(const Vector3& eye, const Vector3& front, const Vector3& up) {
+				SPADES_MARK_FUNCTION();
+
+				double now;
+				{
+					std::lock_guard<std::mutex> lock(mutex);
+					now = GetTime();
+					this->eye = eye;
+					right = Vector3::Cross(front, up).Normalize();
+
+					voiceManager.Update(eye, now);
+					for (const SWVoiceManager::Voice& voice : voiceManager.GetVoices()) {
+						if (voice.slot >= 0)
+							mixer.SetGains(voice.slot, ComputeGains(voice));
+					}
+					mixer.SetMasterGain(MasterGainForVolume(s_volume));
+				}
+
+				if (wavWriter) {
+					// render what has been played in real time since the last frame
+					int freq = mixer.GetSamplingFrequency();
+					auto numFrames = static_cast<std::size_t>((now - wavRenderedTime) * freq);
+					if (numFrames > 0) {
+						wavBuffer.resize(numFrames * 2);
+						Render(wavBuffer.data(), numFrames);
+						wavWriter->Write(wavBuffer.data(), numFrames);
+						wavRenderedTime += static_cast<double>(numFrames) / freq;
+					}
+				}
+
+				if (s_debugVoices && now - lastStatsTime >= 1.0) {
+					std::lock_guard<std::mutex> lock(mutex);
+					const VoiceStats& stats = voiceManager.GetStats();
+					double audioTime =
+					  static_cast<double>(numMixedFrames) / mixer.GetSamplingFrequency();
+					SPLog("Voices: %d real, %d virtual, %d stolen, %d dropped; mixing takes "
+					      "%.2f%% of real time",
+					      stats.numReal, stats.numVirtual, stats.numStolen, stats.numDropped,
+					      audioTime > 0.0 ? mixTime / audioTime * 100.0 : 0.0);
+					lastStatsTime = now;
+				}
+			}
+		};
+
+		SWAudioDevice::SWAudioDevice() {
+			SPADES_MARK_FUNCTION();
+
+			int freq = std::max(std::min((int)s_swAudioFrequency, 192000), 8000);
+			d.reset(new Internal(freq));
+
+			std::string wavPath = s_swAudioWavOutput;
+			if (!wavPath.empty()) {
+				d->wavWriter.reset(new WavWriter(wavPath, freq));
+				SPLog("Software mixer is writing to '%s' at %dHz", wavPath.c_str(), freq);
+			} else {
+				d->OpenSDLOutput();
+			}
+		}
+
+		SWAudioDevice::SWAudioDevice(int samplingFrequency) {
+			SPADES_MARK_FUNCTION();
+
+			d.reset(new Internal(samplingFrequency));
+		}
+
+		SWAudioDevice::~SWAudioDevice() {
+			SPADES_MARK_FUNCTION();
+
+			// stop the output before the chunks are gone
+			d.reset();
+			ClearCache();
+		}
+
+		int SWAudioDevice::GetSamplingFrequency() { return d->mixer.GetSamplingFrequency(); }
+
+		void SWAudioDevice::Render(float* out, std::size_t numFrames) {
+			SPAssert(!d->sdlDevice && !d->wavWriter);
+			d->Render(out, numFrames);
+		}
+
+		client::IAudioChunk* SWAudioDevice::RegisterSound(const char* name) {
+			SPADES_MARK_FUNCTION();
+
+			auto it = chunks.find(name);
+			if (it == chunks.end()) {
+				SWAudioChunk* c = new SWAudioChunk(DecodeSound(name));
+				chunks[name] = c;
+				c->AddRef();
+				return c;
+			}
+			it->second->AddRef();
+			return it->second;
+		}
+
+		void SWAudioDevice::PreloadSounds(const std::vector<std::string>& names) {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<std::string> missingNames;
+			for (const std::string& name : names) {
+				if (chunks.find(name) == chunks.end() &&
+				    std::find(missingNames.begin(), missingNames.end(), name) ==
+				      missingNames.end())
+					missingNames.push_back(name);
+			}
+
+			Stopwatch sw;
+			ParallelLoad<std::shared_ptr<SWSound>>(
+			  missingNames.size(), [&](std::size_t i) { return DecodeSound(missingNames[i]); },
+			  [&](std::size_t i, std::shared_ptr<SWSound> sound) {
+				  // Failed ones are retried (and reported) by `RegisterSound`
+				  if (sound)
+					  chunks[missingNames[i]] = new SWAudioChunk(std::move(sound));
+			  });
+
+			SPLog("Preloaded %d sound(s) in %.3f seconds", static_cast<int>(missingNames.size()),
+			      sw.GetTime());
+		}
+
+		void SWAudioDevice::ClearCache() {
+			SPADES_MARK_FUNCTION();
+
+			for (const auto& chunk : chunks)
+				chunk.second->Release();
+
+			chunks.clear();
+		}
+
+		void SWAudioDevice::SetGameMap(client::GameMap*) {}
+
+		void SWAudioDevice::Play(client::IAudioChunk* chunk, const spades::Vector3& origin,
+		                         const client::AudioParam& param) {
+			d->AddVoice(static_cast<SWAudioChunk*>(chunk), Internal::PlayKind::World, origin,
+			            param);
+		}
+
+		void SWAudioDevice::PlayLocal(client::IAudioChunk* chunk, const spades::Vector3& origin,
+		                              const client::AudioParam& param) {
+			d->AddVoice(static_cast<SWAudioChunk*>(chunk), Internal::PlayKind::Local, origin,
+			            param);
+		}
+
+		void SWAudioDevice::PlayLocal(client::IAudioChunk* chunk, const client::AudioParam& param) {
+			d->AddVoice(static_cast<SWAudioChunk*>(chunk), Internal::PlayKind::Local2D,
+			            MakeVector3(0.0F, 0.0F, 0.0F), param);
+		}
+
+		void SWAudioDevice::Respatialize(const spades::Vector3& eye, const spades::Vector3& front,
+		                                 const spades::Vector3& up) {
+			d->Respatialize(eye, front, up);
+		}
+
+		bool SWAudioDevice::VerifyMixer() {
+			SPADES_MARK_FUNCTION();
+
+			constexpr int samplingFrequency = 44100;
+			constexpr std::size_t numFrames = samplingFrequency * 4;
+			// not a multiple of the mixer's block size
+			constexpr std::size_t framesPerUpdate = 735;
+			constexpr float tolerance = 1.0e-4F;
+
+			// tones covering the copy, mono resampling and stereo paths
+			auto makeSound = [](int numChannels, int freq, float duration, float pitch) {
+				auto sound = std::make_shared<SWSound>();
+				sound->numChannels = numChannels;
+				sound->samplingFrequency = freq;
+				auto length = static_cast<std::size_t>(duration * freq);
+				for (std::size_t i = 0; i < length; i++) {
+					float t = static_cast<float>(i) / static_cast<float>(freq);
+					float envelope = 1.0F - static_cast<float>(i) / static_cast<float>(length);
+					for (int ch = 0; ch < numChannels; ch++) {
+						float phase = t * pitch * static_cast<float>(ch + 1) * 2.0F * M_PI_F;
+						sound->samples.push_back(std::sin(phase) * envelope);
+					}
+				}
+				return std::shared_ptr<const SWSound>(std::move(sound));
+			};
+			const std::shared_ptr<const SWSound> sounds[] = {
+			  makeSound(1, samplingFrequency, 0.7F, 440.0F),
+			  makeSound(1, 22050, 1.3F, 185.0F),
+			  makeSound(2, 48000, 0.9F, 330.0F),
+			};
+
+			auto render = [&](bool simd, std::vector<float>& out) {
+				auto device = Handle<SWAudioDevice>::New(samplingFrequency);
+				device->d->mixer.SetSIMDEnabled(simd);
+
+				std::vector<Handle<SWAudioChunk>> chunks;
+				for (const auto& sound : sounds)
+					chunks.push_back(Handle<SWAudioChunk>::New(sound));
+
+				std::uint32_t seed = 0x12345678;
+				auto nextFloat = [&seed](float lo, float hi) {
+					seed ^= seed << 13;
+					seed ^= seed >> 17;
+					seed ^= seed << 5;
+					return lo + (hi - lo) * static_cast<float>(seed & 0xffff) / 65535.0F;
+				};
+
+				out.resize(numFrames * 2);
+				double time = 0.0;
+				for (std::size_t pos = 0, update = 0; pos < numFrames;
+				     pos += framesPerUpdate, update++) {
+					// the listener circles around the origin
+					float angle = static_cast<float>(update) * 0.05F;
+					Vector3 eye = MakeVector3(std::cos(angle), std::sin(angle), 0.0F) * 8.0F;
+					Vector3 front = MakeVector3(-std::sin(angle), std::cos(angle), 0.0F);
+					device->Respatialize(eye, front, MakeVector3(0.0F, 0.0F, -1.0F));
+					// don't depend on `s_volume`
+					device->d->mixer.SetMasterGain(1.0F);
+
+					if (update % 4 == 0) {
+						client::AudioParam param;
+						param.volume = nextFloat(0.2F, 1.0F);
+						param.pitch = nextFloat(0.5F, 2.0F);
+						SWAudioChunk* chunk =
+						  chunks[static_cast<std::size_t>(nextFloat(0.0F, 2.99F))]
+						    .GetPointerOrNull();
+						Vector3 origin = MakeVector3(nextFloat(-16.0F, 16.0F),
+						                             nextFloat(-16.0F, 16.0F), 0.0F);
+						switch (update / 4 % 3) {
+							case 0: device->Play(chunk, origin, param); break;
+							case 1: device->PlayLocal(chunk, origin * 0.1F, param); break;
+							default: device->PlayLocal(chunk, param); break;
+						}
+					}
+
+					std::size_t n = std::min(framesPerUpdate, numFrames - pos);
+					Stopwatch sw;
+					device->Render(out.data() + pos * 2, n);
+					time += sw.GetTime();
+				}
+				return time;
+			};
+
+			std::vector<float> simdOut, scalarOut;
+			double simdTime = render(true, simdOut);
+			double scalarTime = render(false, scalarOut);
+
+			float maxDifference = 0.0F;
+			for (std::size_t i = 0; i < simdOut.size(); i++)
+				maxDifference = std::max(maxDifference, std::fabs(simdOut[i] - scalarOut[i]));
+
+			SPLog("Software mixer rendered %.1f second(s) of audio in %.3fms (SIMD) and %.3fms "
+			      "(scalar); maximum difference: %g",
+			      static_cast<double>(numFrames) / samplingFrequency, simdTime * 1000.0,
+			      scalarTime * 1000.0, maxDifference);
+			return maxDifference <= tolerance;
+		}
+	} // namespace audio
+} // namespace spades
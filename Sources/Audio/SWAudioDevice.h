@@ -0,0 +1,90 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include <Client/IAudioDevice.h>
+
+namespace spades {
+	namespace audio {
+
+		class SWAudioChunk;
+
+		/**
+		 * An audio device that mixes sounds on the CPU with `SWMixer`, without OpenAL.
+		 *
+		 * The output goes to SDL audio, or to a WAV file if `s_swAudioWavOutput` is set.
+		 * A device created with a sampling frequency has no output; the owner pulls the
+		 * samples with `Render` instead. Such a device times voices by the number of
+		 * rendered frames rather than the wall clock, so its output only depends on the
+		 * sequence of calls.
+		 */
+		class SWAudioDevice : public client::IAudioDevice {
+			class Internal;
+			std::unique_ptr<Internal> d;
+
+			std::map<std::string, SWAudioChunk*> chunks;
+
+		protected:
+			~SWAudioDevice();
+
+		public:
+			/** Creates a device that outputs in real time. */
+			SWAudioDevice();
+			/** Creates a device without output. */
+			SWAudioDevice(int samplingFrequency);
+
+			int GetSamplingFrequency();
+
+			/**
+			 * Renders `numFrames` interleaved stereo frames. Can be called from any
+			 * thread. Must not be used if the device has an output.
+			 */
+			void Render(float* out, std::size_t numFrames);
+
+			/**
+			 * Renders a fixed scene with two devices without output, one of which uses the
+			 * scalar mixing paths, and logs how long each took.
+			 * @return `true` if the outputs match to float rounding.
+			 */
+			static bool VerifyMixer();
+
+			client::IAudioChunk* RegisterSound(const char* name) override;
+
+			void PreloadSounds(const std::vector<std::string>& names) override;
+
+			void ClearCache() override;
+
+			void SetGameMap(client::GameMap*) override;
+
+			void Play(client::IAudioChunk*, const Vector3& origin,
+			          const client::AudioParam&) override;
+			void PlayLocal(client::IAudioChunk*, const Vector3& origin,
+			               const client::AudioParam&) override;
+			void PlayLocal(client::IAudioChunk*, const client::AudioParam&) override;
+
+			void Respatialize(const Vector3& eye, const Vector3& front, const Vector3& up) override;
+		};
+	} // namespace audio
+} // namespace spades
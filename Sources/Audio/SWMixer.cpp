@@ -0,0 +1,308 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "SWMixer.h"
+#include <Core/Debug.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENABLE_SSE2 1
+#include <emmintrin.h>
+#else
+#define ENABLE_SSE2 0
+#endif
+
+namespace spades {
+	namespace audio {
+
+		namespace {
+			constexpr std::size_t blockSize = 256;
+
+			// Freeverb's tunings (for 44100Hz)
+			constexpr int combLengths[] = {1116, 1188, 1277, 1356};
+			constexpr int allpassLengths[] = {556, 441};
+			constexpr float combFeedback = 0.84F;
+			constexpr float combDamping = 0.2F;
+			constexpr float allpassFeedback = 0.5F;
+			constexpr float reverbWetGain = 0.25F;
+
+			constexpr double fixedOne = 4294967296.0;
+		} // namespace
+
+		SWMixer::SWMixer(int samplingFrequency, int numVoices)
+		    : samplingFrequency(samplingFrequency), masterGain(1.0F), useSIMD(true) {
+			SPADES_MARK_FUNCTION();
+
+			SPAssert(samplingFrequency > 0);
+			voices.resize(std::max(numVoices, 1));
+
+			resampleBuffer.resize(blockSize * 2);
+			reverbInput.resize(blockSize);
+
+			float scale = static_cast<float>(samplingFrequency) / 44100.0F;
+			for (int i = 0; i < 4; i++)
+				combs[i].buffer.resize(std::max(static_cast<int>(combLengths[i] * scale), 1));
+			for (int i = 0; i < 2; i++)
+				allpasses[i].buffer.resize(
+				  std::max(static_cast<int>(allpassLengths[i] * scale), 1));
+		}
+
+		SWMixer::~SWMixer() {}
+
+		void SWMixer::Start(int slot, std::shared_ptr<const SWSound> sound, double offset,
+		                    float pitch, const Gains& gains) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			Voice& voice = voices.at(slot);
+			double rate = static_cast<double>(sound->samplingFrequency) / samplingFrequency;
+			voice.step = static_cast<std::uint64_t>(rate * std::max(pitch, 0.01F) * fixedOne);
+			voice.position =
+			  static_cast<std::uint64_t>(std::max(offset, 0.0) * sound->samplingFrequency) << 32;
+			voice.sound = std::move(sound);
+			voice.current = gains;
+			voice.target = gains;
+		}
+
+		void SWMixer::SetGains(int slot, const Gains& gains) { voices.at(slot).target = gains; }
+
+		void SWMixer::Stop(int slot) { voices.at(slot).sound.reset(); }
+
+		bool SWMixer::IsPlaying(int slot) const { return voices.at(slot).sound != nullptr; }
+
+		void SWMixer::Mix(float* out, std::size_t numFrames) {
+			SPADES_MARK_FUNCTION();
+
+			while (numFrames > 0) {
+				std::size_t n = std::min(numFrames, blockSize);
+
+				std::fill(out, out + n * 2, 0.0F);
+				std::fill(reverbInput.begin(), reverbInput.begin() + n, 0.0F);
+
+				for (Voice& voice : voices) {
+					if (voice.sound)
+						MixVoice(voice, out, n);
+				}
+
+				ProcessReverb(out, n);
+
+				// apply the master gain and clip
+				std::size_t i = 0;
+#if ENABLE_SSE2
+				__m128 gain = _mm_set1_ps(masterGain);
+				__m128 minValue = _mm_set1_ps(-1.0F);
+				__m128 maxValue = _mm_set1_ps(1.0F);
+				for (; useSIMD && i + 4 <= n * 2; i += 4) {
+					__m128 v = _mm_mul_ps(_mm_loadu_ps(out + i), gain);
+					v = _mm_min_ps(_mm_max_ps(v, minValue), maxValue);
+					_mm_storeu_ps(out + i, v);
+				}
+#endif
+				for (; i < n * 2; i++)
+					out[i] = std::max(std::min(out[i] * masterGain, 1.0F), -1.0F);
+
+				out += n * 2;
+				numFrames -= n;
+			}
+		}
+
+		/**
+		 * Resamples the next `numFrames` frames of the voice into `resampleBuffer`.
+		 * @return the number of frames produced, which is less than `numFrames` if the
+		 *         sound has ended.
+		 */
+		std::size_t SWMixer::Resample(Voice& voice, std::size_t numFrames) {
+			const SWSound& sound = *voice.sound;
+			const float* src = sound.samples.data();
+			const std::size_t srcFrames = sound.GetNumFrames();
+			float* dest = resampleBuffer.data();
+
+			std::uint64_t pos = voice.position;
+			const std::uint64_t step = voice.step;
+			std::size_t i = 0;
+
+			if (sound.numChannels == 1) {
+				if (step == (1ULL << 32) && (pos & 0xffffffffULL) == 0) {
+					// no resampling needed
+					std::size_t start = static_cast<std::size_t>(pos >> 32);
+					i = std::min(numFrames, srcFrames - std::min(start, srcFrames));
+					std::memcpy(dest, src + start, i * sizeof(float));
+					pos += static_cast<std::uint64_t>(i) << 32;
+				} else {
+#if ENABLE_SSE2
+					const __m128 fracScale = _mm_set1_ps(1.0F / 4294967296.0F);
+					for (; useSIMD && i + 4 <= numFrames; i += 4) {
+						std::uint64_t last = pos + step * 3;
+						if ((last >> 32) + 1 >= srcFrames)
+							break;
+
+						float a[4], b[4];
+						float frac[4];
+						for (int k = 0; k < 4; k++) {
+							std::size_t idx = static_cast<std::size_t>(pos >> 32);
+							a[k] = src[idx];
+							b[k] = src[idx + 1];
+							frac[k] = static_cast<float>(pos & 0xffffffffULL);
+							pos += step;
+						}
+						__m128 va = _mm_loadu_ps(a);
+						__m128 vb = _mm_loadu_ps(b);
+						__m128 vf = _mm_mul_ps(_mm_loadu_ps(frac), fracScale);
+						_mm_storeu_ps(dest + i,
+						              _mm_add_ps(va, _mm_mul_ps(_mm_sub_ps(vb, va), vf)));
+					}
+#endif
+					for (; i < numFrames; i++) {
+						std::size_t idx = static_cast<std::size_t>(pos >> 32);
+						if (idx >= srcFrames)
+							break;
+						float a = src[idx];
+						float b = idx + 1 < srcFrames ? src[idx + 1] : a;
+						float frac = static_cast<float>(pos & 0xffffffffULL) *
+						             static_cast<float>(1.0 / fixedOne);
+						dest[i] = a + (b - a) * frac;
+						pos += step;
+					}
+				}
+			} else {
+				for (; i < numFrames; i++) {
+					std::size_t idx = static_cast<std::size_t>(pos >> 32);
+					if (idx >= srcFrames)
+						break;
+					std::size_t next = idx + 1 < srcFrames ? idx + 1 : idx;
+					float frac = static_cast<float>(pos & 0xffffffffULL) *
+					             static_cast<float>(1.0 / fixedOne);
+					const float* a = src + idx * 2;
+					const float* b = src + next * 2;
+					dest[i * 2] = a[0] + (b[0] - a[0]) * frac;
+					dest[i * 2 + 1] = a[1] + (b[1] - a[1]) * frac;
+					pos += step;
+				}
+			}
+
+			voice.position = pos;
+			return i;
+		}
+
+		void SWMixer::MixVoice(Voice& voice, float* out, std::size_t numFrames) {
+			std::size_t n = Resample(voice, numFrames);
+			const float* src = resampleBuffer.data();
+			float* reverb = reverbInput.data();
+
+			// ramp the gains over the block
+			float invN = n > 0 ? 1.0F / static_cast<float>(n) : 0.0F;
+			float gainL = voice.current.left;
+			float gainR = voice.current.right;
+			float gainRev = voice.current.reverb;
+			float deltaL = (voice.target.left - gainL) * invN;
+			float deltaR = (voice.target.right - gainR) * invN;
+			float deltaRev = (voice.target.reverb - gainRev) * invN;
+			bool stereo = voice.sound->numChannels == 2;
+
+			std::size_t i = 0;
+#if ENABLE_SSE2
+			__m128 gains = _mm_setr_ps(gainL, gainR, gainL + deltaL, gainR + deltaR);
+			__m128 gainStep = _mm_setr_ps(deltaL * 2.0F, deltaR * 2.0F, deltaL * 2.0F,
+			                              deltaR * 2.0F);
+			for (; useSIMD && i + 2 <= n; i += 2) {
+				__m128 s;
+				if (stereo) {
+					s = _mm_loadu_ps(src + i * 2);
+				} else {
+					// (s0, s0, s1, s1)
+					s = _mm_castsi128_ps(
+					  _mm_loadl_epi64(reinterpret_cast<const __m128i*>(src + i)));
+					s = _mm_unpacklo_ps(s, s);
+				}
+				__m128 o = _mm_loadu_ps(out + i * 2);
+				_mm_storeu_ps(out + i * 2, _mm_add_ps(o, _mm_mul_ps(s, gains)));
+				gains = _mm_add_ps(gains, gainStep);
+			}
+			gainL += deltaL * static_cast<float>(i);
+			gainR += deltaR * static_cast<float>(i);
+#endif
+			for (; i < n; i++) {
+				float l = stereo ? src[i * 2] : src[i];
+				float r = stereo ? src[i * 2 + 1] : src[i];
+				out[i * 2] += l * gainL;
+				out[i * 2 + 1] += r * gainR;
+				gainL += deltaL;
+				gainR += deltaR;
+			}
+
+			if (voice.current.reverb > 0.0F || voice.target.reverb > 0.0F) {
+				i = 0;
+#if ENABLE_SSE2
+				if (useSIMD && !stereo) {
+					__m128 g = _mm_setr_ps(gainRev, gainRev + deltaRev, gainRev + deltaRev * 2.0F,
+					                       gainRev + deltaRev * 3.0F);
+					__m128 gStep = _mm_set1_ps(deltaRev * 4.0F);
+					for (; i + 4 <= n; i += 4) {
+						__m128 s = _mm_loadu_ps(src + i);
+						__m128 r = _mm_loadu_ps(reverb + i);
+						_mm_storeu_ps(reverb + i, _mm_add_ps(r, _mm_mul_ps(s, g)));
+						g = _mm_add_ps(g, gStep);
+					}
+				}
+#endif
+				for (; i < n; i++) {
+					float s = stereo ? (src[i * 2] + src[i * 2 + 1]) * 0.5F : src[i];
+					reverb[i] += s * (gainRev + deltaRev * static_cast<float>(i));
+				}
+			}
+
+			voice.current = voice.target;
+			if (n < numFrames)
+				voice.sound.reset();
+		}
+
+		void SWMixer::ProcessReverb(float* out, std::size_t numFrames) {
+			for (std::size_t i = 0; i < numFrames; i++) {
+				float input = reverbInput[i];
+				float wet = 0.0F;
+
+				for (CombFilter& comb : combs) {
+					float y = comb.buffer[comb.pos];
+					comb.store = y * (1.0F - combDamping) + comb.store * combDamping;
+					if (std::fabs(comb.store) < 1.0e-15F)
+						comb.store = 0.0F; // avoid denormals
+					comb.buffer[comb.pos] = input + comb.store * combFeedback;
+					if (++comb.pos == comb.buffer.size())
+						comb.pos = 0;
+					wet += y;
+				}
+
+				for (AllpassFilter& allpass : allpasses) {
+					float b = allpass.buffer[allpass.pos];
+					allpass.buffer[allpass.pos] = wet + b * allpassFeedback;
+					if (++allpass.pos == allpass.buffer.size())
+						allpass.pos = 0;
+					wet = b - wet;
+				}
+
+				wet *= reverbWetGain;
+				out[i * 2] += wet;
+				out[i * 2 + 1] += wet;
+			}
+		}
+	} // namespace audio
+} // namespace spades
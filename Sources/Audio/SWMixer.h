@@ -0,0 +1,117 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace spades {
+	namespace audio {
+
+		/** PCM data played by `SWMixer`. Immutable once it's handed to the mixer. */
+		struct SWSound {
+			/** Interleaved samples in `[-1, 1]`. */
+			std::vector<float> samples;
+			int numChannels;
+			int samplingFrequency;
+
+			std::size_t GetNumFrames() const { return samples.size() / numChannels; }
+		};
+
+		/**
+		 * Mixes a fixed number of voices into an interleaved stereo float buffer.
+		 *
+		 * Each voice is resampled with linear interpolation, scaled by per-channel gains
+		 * (which are ramped over a block when changed, so there's no zipper noise) and sent
+		 * to a mono Schroeder reverb. Output samples are clamped to `[-1, 1]`.
+		 *
+		 * The mixer isn't thread-safe.
+		 */
+		class SWMixer {
+		public:
+			struct Gains {
+				float left = 0.0F;
+				float right = 0.0F;
+				float reverb = 0.0F;
+			};
+
+			SWMixer(int samplingFrequency, int numVoices);
+			~SWMixer();
+
+			int GetSamplingFrequency() const { return samplingFrequency; }
+			int GetNumVoices() const { return static_cast<int>(voices.size()); }
+
+			/** Starts playing `sound` on `slot`, `offset` seconds into it. */
+			void Start(int slot, std::shared_ptr<const SWSound> sound, double offset, float pitch,
+			           const Gains& gains);
+			void SetGains(int slot, const Gains& gains);
+			void Stop(int slot);
+			bool IsPlaying(int slot) const;
+
+			void SetMasterGain(float gain) { masterGain = gain; }
+
+			/**
+			 * Selects the scalar code paths even if SSE2 is available. Used to check the
+			 * SIMD paths against them.
+			 */
+			void SetSIMDEnabled(bool enabled) { useSIMD = enabled; }
+
+			/** Renders `numFrames` stereo frames to `out`. */
+			void Mix(float* out, std::size_t numFrames);
+
+		private:
+			struct Voice {
+				std::shared_ptr<const SWSound> sound;
+				/** Playback position in source frames, 32.32 fixed point. */
+				std::uint64_t position;
+				std::uint64_t step;
+				Gains current;
+				Gains target;
+			};
+
+			struct CombFilter {
+				std::vector<float> buffer;
+				std::size_t pos = 0;
+				float store = 0.0F;
+			};
+			struct AllpassFilter {
+				std::vector<float> buffer;
+				std::size_t pos = 0;
+			};
+
+			int samplingFrequency;
+			float masterGain;
+			bool useSIMD;
+			std::vector<Voice> voices;
+
+			std::vector<float> resampleBuffer;
+			std::vector<float> reverbInput;
+			CombFilter combs[4];
+			AllpassFilter allpasses[2];
+
+			std::size_t Resample(Voice&, std::size_t numFrames);
+			void MixVoice(Voice&, float* out, std::size_t numFrames);
+			void ProcessReverb(float* out, std::size_t numFrames);
+		};
+	} // namespace audio
+} // namespace spades
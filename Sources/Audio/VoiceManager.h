@@ -0,0 +1,299 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <Core/Debug.h>
+#include <Core/Math.h>
+
+namespace spades {
+	namespace audio {
+
+		/** Statistics reported by `VoiceManager`. */
+		struct VoiceStats {
+			/** Number of voices currently bound to a backend slot. */
+			int numReal = 0;
+			/** Number of voices tracked without a backend slot. */
+			int numVirtual = 0;
+			/** Number of times a real voice lost its slot to a higher-scoring voice. */
+			int numStolen = 0;
+			/** Number of virtual voices dropped because too many were tracked. */
+			int numDropped = 0;
+		};
+
+		/**
+		 * Distributes a fixed number of backend voice slots (e.g. AL sources) among the sounds
+		 * being played.
+		 *
+		 * Every sound is a voice scored by `priority * audibility`, where audibility is the
+		 * gain the listener would perceive with the inverse clamped distance model. The
+		 * highest-scoring voices are real and own a slot; the rest are virtual and only have
+		 * their playback position tracked, so they can be resumed at the right offset when they
+		 * become relevant again.
+		 *
+		 * The manager doesn't know anything about the backend, which is accessed through
+		 * `Backend`. `T` is the backend's description of what to play.
+		 */
+		template <class T> class VoiceManager {
+		public:
+			struct Voice {
+				T payload;
+				/** Position in world coordinates, or relative to the listener. */
+				Vector3 origin;
+				bool relative;
+				float volume;
+				float referenceDistance;
+				float priority;
+				float pitch;
+				/** Length of the sound in seconds, at the normal pitch. */
+				double duration;
+
+				double startTime;
+				double endTime;
+				float score;
+				float audibility;
+				/** The backend slot, or `-1` if the voice is virtual. */
+				int slot;
+			};
+
+			class Backend {
+			public:
+				virtual ~Backend() {}
+				/** Starts playing `voice` on `slot`, `offset` seconds into the sound. */
+				virtual void StartVoice(int slot, const Voice& voice, double offset) = 0;
+				virtual void StopVoice(int slot) = 0;
+				virtual bool IsVoicePlaying(int slot) = 0;
+			};
+
+			/** Voices quieter than this never get a slot. */
+			static constexpr float inaudibleThreshold = 0.001F;
+
+			/** Voices positioned relative to the listener (the local player's own sounds)
+			 * have their priority multiplied by this. */
+			static constexpr float relativePriorityBoost = 4.0F;
+
+			/** Real voices keep their slot unless a virtual voice outscores them by this
+			 * factor, which avoids restarting sounds every frame. */
+			static constexpr float hysteresis = 1.25F;
+
+			/** Virtual voices that would resume less than this many seconds before their end
+			 * are left virtual. */
+			static constexpr double minRemainingTime = 0.05;
+
+			VoiceManager(Backend& backend, int numSlots, std::size_t maxVirtualVoices = 256)
+			    : backend(backend), maxVirtualVoices(maxVirtualVoices) {
+				for (int i = numSlots - 1; i >= 0; i--)
+					freeSlots.push_back(i);
+			}
+
+			/**
+			 * Adds a voice and starts it right away if it scores high enough.
+			 * `startTime`, `endTime`, `score`, `audibility` and `slot` are computed.
+			 */
+			void Add(Voice voice, double now) {
+				SPADES_MARK_FUNCTION();
+
+				voice.startTime = now;
+				voice.endTime = now + voice.duration / std::max(voice.pitch, 0.01F);
+				voice.slot = -1;
+				ComputeScore(voice);
+
+				if (voice.audibility >= inaudibleThreshold) {
+					if (!freeSlots.empty()) {
+						voice.slot = freeSlots.back();
+						freeSlots.pop_back();
+					} else {
+						Voice* victim = nullptr;
+						for (Voice& v : voices) {
+							if (v.slot >= 0 && (!victim || v.score < victim->score))
+								victim = &v;
+						}
+						if (victim && voice.score > victim->score) {
+							backend.StopVoice(victim->slot);
+							voice.slot = victim->slot;
+							victim->slot = -1;
+							stats.numStolen++;
+						}
+					}
+				}
+
+				if (voice.slot >= 0)
+					backend.StartVoice(voice.slot, voice, 0.0);
+
+				voices.push_back(std::move(voice));
+				LimitVirtualVoices();
+				UpdateCounts();
+			}
+
+			/**
+			 * Removes finished voices, rescores the rest for the new listener position and
+			 * redistributes the slots. Should be called every frame.
+			 */
+			void Update(const Vector3& listener, double now) {
+				SPADES_MARK_FUNCTION();
+
+				listenerPosition = listener;
+
+				for (std::size_t i = 0; i < voices.size();) {
+					Voice& v = voices[i];
+					bool finished;
+					if (v.slot >= 0) {
+						finished = !backend.IsVoicePlaying(v.slot);
+						if (finished)
+							freeSlots.push_back(v.slot);
+					} else {
+						finished = now + minRemainingTime >= v.endTime;
+					}
+
+					if (finished) {
+						if (i + 1 != voices.size())
+							v = std::move(voices.back());
+						voices.pop_back();
+					} else {
+						ComputeScore(v);
+						i++;
+					}
+				}
+
+				Rebalance(now);
+				UpdateCounts();
+			}
+
+			/** Stops all voices. */
+			void Clear() {
+				for (Voice& v : voices) {
+					if (v.slot >= 0) {
+						backend.StopVoice(v.slot);
+						freeSlots.push_back(v.slot);
+					}
+				}
+				voices.clear();
+				UpdateCounts();
+			}
+
+			const VoiceStats& GetStats() const { return stats; }
+			const std::vector<Voice>& GetVoices() const { return voices; }
+
+		private:
+			Backend& backend;
+			std::size_t maxVirtualVoices;
+			std::vector<Voice> voices;
+			std::vector<int> freeSlots;
+			std::vector<std::size_t> order;
+			Vector3 listenerPosition{0.0F, 0.0F, 0.0F};
+			VoiceStats stats;
+
+			void ComputeScore(Voice& v) const {
+				float dist = v.relative ? v.origin.GetLength()
+				                        : (v.origin - listenerPosition).GetLength();
+				float refDist = std::max(v.referenceDistance, 0.0001F);
+				v.audibility = v.volume * refDist / std::max(dist, refDist);
+
+				float priority = v.priority;
+				if (v.relative)
+					priority *= relativePriorityBoost;
+				v.score = priority * v.audibility;
+			}
+
+			float RankingScore(const Voice& v) const {
+				return v.slot >= 0 ? v.score * hysteresis : v.score;
+			}
+
+			void Rebalance(double now) {
+				std::size_t numSlots = freeSlots.size();
+				for (const Voice& v : voices)
+					if (v.slot >= 0)
+						numSlots++;
+
+				order.resize(voices.size());
+				for (std::size_t i = 0; i < order.size(); i++)
+					order[i] = i;
+
+				std::size_t numWanted = std::min(numSlots, order.size());
+				std::partial_sort(order.begin(), order.begin() + numWanted, order.end(),
+				                  [this](std::size_t a, std::size_t b) {
+					                  return RankingScore(voices[a]) > RankingScore(voices[b]);
+				                  });
+
+				// demote the real voices that didn't make it
+				for (std::size_t i = numWanted; i < order.size(); i++) {
+					Voice& v = voices[order[i]];
+					if (v.slot >= 0) {
+						backend.StopVoice(v.slot);
+						freeSlots.push_back(v.slot);
+						v.slot = -1;
+					}
+				}
+
+				// promote the virtual voices that did
+				for (std::size_t i = 0; i < numWanted; i++) {
+					Voice& v = voices[order[i]];
+					if (v.slot >= 0)
+						continue;
+					if (v.audibility < inaudibleThreshold || now + minRemainingTime >= v.endTime)
+						continue;
+
+					SPAssert(!freeSlots.empty());
+					v.slot = freeSlots.back();
+					freeSlots.pop_back();
+
+					double offset = (now - v.startTime) * v.pitch;
+					backend.StartVoice(v.slot, v, std::max(offset, 0.0));
+				}
+			}
+
+			void LimitVirtualVoices() {
+				std::size_t numVirtual = 0;
+				for (const Voice& v : voices)
+					if (v.slot < 0)
+						numVirtual++;
+
+				while (numVirtual > maxVirtualVoices) {
+					std::size_t victim = voices.size();
+					for (std::size_t i = 0; i < voices.size(); i++) {
+						if (voices[i].slot >= 0)
+							continue;
+						if (victim == voices.size() || voices[i].score < voices[victim].score)
+							victim = i;
+					}
+					voices.erase(voices.begin() + victim);
+					numVirtual--;
+					stats.numDropped++;
+				}
+			}
+
+			void UpdateCounts() {
+				stats.numReal = 0;
+				stats.numVirtual = 0;
+				for (const Voice& v : voices) {
+					if (v.slot >= 0)
+						stats.numReal++;
+					else
+						stats.numVirtual++;
+				}
+			}
+		};
+	} // namespace audio
+} // namespace spades
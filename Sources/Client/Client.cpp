@@ -42,6 +42,7 @@
 #include "MapView.h"
 #include "PaletteView.h"
 #include "ScoreboardView.h"
+#include "ScreenshotWriter.h"
 #include "TCProgressView.h"
 
 #include "BloodMarks.h"
@@ -124,6 +125,9 @@ namespace spades {
 			  lastLocalCorpse(nullptr),
 			  nextScreenShotIndex(0),
 			  nextMapShotIndex(0),
+			  screenShotBurstFramesLeft(0),
+			  screenShotBurstFrame(0),
+			  screenShotBurstIndex(0),
 			  staffSpectating(false),
 			  spectatorPlayerNames(true) {
 			SPADES_MARK_FUNCTION();
@@ -231,6 +235,13 @@ namespace spades {
 
 			NetLog("Disconnecting");
 
+			if (screenshotWriter) {
+				// Finish writing the queued screenshots. Their callbacks refer
+				// to `this`, so they are discarded.
+				SPLog("Waiting for pending screenshots");
+				screenshotWriter.reset();
+			}
+
 			if (logStream) {
 				SPLog("Closing netlog");
 				logStream.reset();
@@ -272,243 +283,249 @@ namespace spades {
 			// load images
 			SmokeSpriteEntity::Preload(renderer.GetPointerOrNull());
 
-			renderer->RegisterImage("Gfx/Bullet/7.62mm.png");
-			renderer->RegisterImage("Gfx/Bullet/9mm.png");
-			renderer->RegisterImage("Gfx/Bullet/12gauge.png");
-			renderer->RegisterImage("Gfx/Hotbar/Block.png");
-			renderer->RegisterImage("Gfx/Hotbar/Grenade.png");
-			renderer->RegisterImage("Gfx/Hotbar/Spade.png");
-			renderer->RegisterImage("Gfx/Hotbar/Rifle.png");
-			renderer->RegisterImage("Gfx/Hotbar/SMG.png");
-			renderer->RegisterImage("Gfx/Hotbar/Shotgun.png");
-			renderer->RegisterImage("Gfx/Killfeed/a-Rifle.png");
-			renderer->RegisterImage("Gfx/Killfeed/b-SMG.png");
-			renderer->RegisterImage("Gfx/Killfeed/c-Shotgun.png");
-			renderer->RegisterImage("Gfx/Killfeed/d-Headshot.png");
-			renderer->RegisterImage("Gfx/Killfeed/e-Melee.png");
-			renderer->RegisterImage("Gfx/Killfeed/f-Grenade.png");
-			renderer->RegisterImage("Gfx/Killfeed/g-Falling.png");
-			renderer->RegisterImage("Gfx/Killfeed/h-Teamchange.png");
-			renderer->RegisterImage("Gfx/Killfeed/i-Classchange.png");
-			renderer->RegisterImage("Gfx/Killfeed/j-Airborne.png");
-			renderer->RegisterImage("Gfx/Killfeed/k-Noscope.png");
-			renderer->RegisterImage("Gfx/Killfeed/l-Domination.png");
-			renderer->RegisterImage("Gfx/Killfeed/m-Revenge.png");
-			renderer->RegisterImage("Gfx/Ball.png");
-			renderer->RegisterImage("Gfx/HurtRing.png");
-			renderer->RegisterImage("Gfx/HurtSprite.png");
-			renderer->RegisterImage("Gfx/ReflexSight.png");
-			renderer->RegisterImage("Gfx/Spotlight.jpg");
-			renderer->RegisterImage("Gfx/White.tga");
-			renderer->RegisterImage("Textures/Fluid.png");
-			renderer->RegisterImage("Textures/WaterExpl.png");
+			renderer->PreloadImages({
+			  "Gfx/Bullet/7.62mm.png",
+			  "Gfx/Bullet/9mm.png",
+			  "Gfx/Bullet/12gauge.png",
+			  "Gfx/Hotbar/Block.png",
+			  "Gfx/Hotbar/Grenade.png",
+			  "Gfx/Hotbar/Spade.png",
+			  "Gfx/Hotbar/Rifle.png",
+			  "Gfx/Hotbar/SMG.png",
+			  "Gfx/Hotbar/Shotgun.png",
+			  "Gfx/Killfeed/a-Rifle.png",
+			  "Gfx/Killfeed/b-SMG.png",
+			  "Gfx/Killfeed/c-Shotgun.png",
+			  "Gfx/Killfeed/d-Headshot.png",
+			  "Gfx/Killfeed/e-Melee.png",
+			  "Gfx/Killfeed/f-Grenade.png",
+			  "Gfx/Killfeed/g-Falling.png",
+			  "Gfx/Killfeed/h-Teamchange.png",
+			  "Gfx/Killfeed/i-Classchange.png",
+			  "Gfx/Killfeed/j-Airborne.png",
+			  "Gfx/Killfeed/k-Noscope.png",
+			  "Gfx/Killfeed/l-Domination.png",
+			  "Gfx/Killfeed/m-Revenge.png",
+			  "Gfx/Ball.png",
+			  "Gfx/HurtRing.png",
+			  "Gfx/HurtSprite.png",
+			  "Gfx/ReflexSight.png",
+			  "Gfx/Spotlight.jpg",
+			  "Gfx/White.tga",
+			  "Textures/Fluid.png",
+			  "Textures/WaterExpl.png",
+			});
 
 			// load sounds
 			LoadKillSounds();
 
-			audioDevice->RegisterSound("Sounds/Feedback/CTF/EnemyCaptured.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/CTF/PickedUp.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/CTF/YourTeamCaptured.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/TC/EnemyCaptured.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/TC/YourTeamCaptured.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/Alert.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/Beep1.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/Beep2.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/Chat.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/HeadshotFeedback.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/HitFeedback.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/Lose.opus");
-			audioDevice->RegisterSound("Sounds/Feedback/Win.opus");
-			audioDevice->RegisterSound("Sounds/Misc/BlockBounce.opus");
-			audioDevice->RegisterSound("Sounds/Misc/BlockDestroy.opus");
-			audioDevice->RegisterSound("Sounds/Misc/BlockFall.opus");
-			audioDevice->RegisterSound("Sounds/Misc/CloseMap.opus");
-			audioDevice->RegisterSound("Sounds/Misc/OpenMap.opus");
-			audioDevice->RegisterSound("Sounds/Misc/SwitchMapZoom.opus");
-			audioDevice->RegisterSound("Sounds/Player/Death.opus");
-			audioDevice->RegisterSound("Sounds/Player/FallHurt.opus");
-			audioDevice->RegisterSound("Sounds/Player/Flashlight.opus");
-			audioDevice->RegisterSound("Sounds/Player/Footstep1.opus");
-			audioDevice->RegisterSound("Sounds/Player/Footstep2.opus");
-			audioDevice->RegisterSound("Sounds/Player/Footstep3.opus");
-			audioDevice->RegisterSound("Sounds/Player/Footstep4.opus");
-			audioDevice->RegisterSound("Sounds/Player/Jump.opus");
-			audioDevice->RegisterSound("Sounds/Player/Land.opus");
-			audioDevice->RegisterSound("Sounds/Player/Run1.opus");
-			audioDevice->RegisterSound("Sounds/Player/Run2.opus");
-			audioDevice->RegisterSound("Sounds/Player/Run3.opus");
-			audioDevice->RegisterSound("Sounds/Player/Run4.opus");
-			audioDevice->RegisterSound("Sounds/Player/Run5.opus");
-			audioDevice->RegisterSound("Sounds/Player/Run6.opus");
-			audioDevice->RegisterSound("Sounds/Player/Wade1.opus");
-			audioDevice->RegisterSound("Sounds/Player/Wade2.opus");
-			audioDevice->RegisterSound("Sounds/Player/Wade3.opus");
-			audioDevice->RegisterSound("Sounds/Player/Wade4.opus");
-			audioDevice->RegisterSound("Sounds/Player/WaterJump.opus");
-			audioDevice->RegisterSound("Sounds/Player/WaterLand.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Block/Build.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Block/RaiseLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/Bounce.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/Debris.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/DropWater.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/Explode1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/Explode2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/ExplodeFar.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/ExplodeFarStereo.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/ExplodeStereo1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/ExplodeStereo2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/Fire.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/RaiseLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/Throw.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/WaterExplode.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/WaterExplodeFar.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Grenade/WaterExplodeStereo.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Block.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Flesh1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Flesh2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Flesh3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/FleshLocal1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/FleshLocal2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/FleshLocal3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/FleshLocal4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Ricochet1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Ricochet2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Ricochet3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Ricochet4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Water1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Water2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Water3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Impacts/Water4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/Fire1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/Fire2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/Fire3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/FireFar.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/FireLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/FireStereo.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/RaiseLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/Reload.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/ReloadLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/ShellDrop1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/ShellDrop2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/ShellWater.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/V2AmbienceLarge.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Rifle/V2AmbienceSmall.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/Cock.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/CockLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/Fire.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/FireFar.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/FireLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/FireStereo.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/RaiseLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/Reload.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/ReloadLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/V2AmbienceLarge.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Shotgun/V2AmbienceSmall.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/FireFar.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/FireStereo.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/RaiseLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/Reload.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/ReloadLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/ShellDrop1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/ShellDrop2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/ShellWater.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceLarge1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceLarge2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceLarge2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceLarge3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceLarge4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceSmall1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceSmall2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceSmall2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceSmall3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2AmbienceSmall4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Local1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Local2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Local3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Local4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Third1.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Third2.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Third3.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SMG/V2Third4.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Spade/HitBlock.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Spade/HitPlayer.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Spade/Miss.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Spade/RaiseLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/AimDownSightLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/DryFire.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Restock.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/RestockLocal.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/Switch.opus");
-			audioDevice->RegisterSound("Sounds/Weapons/SwitchLocal.opus");
+			audioDevice->PreloadSounds({
+			  "Sounds/Feedback/CTF/EnemyCaptured.opus",
+			  "Sounds/Feedback/CTF/PickedUp.opus",
+			  "Sounds/Feedback/CTF/YourTeamCaptured.opus",
+			  "Sounds/Feedback/TC/EnemyCaptured.opus",
+			  "Sounds/Feedback/TC/YourTeamCaptured.opus",
+			  "Sounds/Feedback/Alert.opus",
+			  "Sounds/Feedback/Beep1.opus",
+			  "Sounds/Feedback/Beep2.opus",
+			  "Sounds/Feedback/Chat.opus",
+			  "Sounds/Feedback/HeadshotFeedback.opus",
+			  "Sounds/Feedback/HitFeedback.opus",
+			  "Sounds/Feedback/Lose.opus",
+			  "Sounds/Feedback/Win.opus",
+			  "Sounds/Misc/BlockBounce.opus",
+			  "Sounds/Misc/BlockDestroy.opus",
+			  "Sounds/Misc/BlockFall.opus",
+			  "Sounds/Misc/CloseMap.opus",
+			  "Sounds/Misc/OpenMap.opus",
+			  "Sounds/Misc/SwitchMapZoom.opus",
+			  "Sounds/Player/Death.opus",
+			  "Sounds/Player/FallHurt.opus",
+			  "Sounds/Player/Flashlight.opus",
+			  "Sounds/Player/Footstep1.opus",
+			  "Sounds/Player/Footstep2.opus",
+			  "Sounds/Player/Footstep3.opus",
+			  "Sounds/Player/Footstep4.opus",
+			  "Sounds/Player/Jump.opus",
+			  "Sounds/Player/Land.opus",
+			  "Sounds/Player/Run1.opus",
+			  "Sounds/Player/Run2.opus",
+			  "Sounds/Player/Run3.opus",
+			  "Sounds/Player/Run4.opus",
+			  "Sounds/Player/Run5.opus",
+			  "Sounds/Player/Run6.opus",
+			  "Sounds/Player/Wade1.opus",
+			  "Sounds/Player/Wade2.opus",
+			  "Sounds/Player/Wade3.opus",
+			  "Sounds/Player/Wade4.opus",
+			  "Sounds/Player/WaterJump.opus",
+			  "Sounds/Player/WaterLand.opus",
+			  "Sounds/Weapons/Block/Build.opus",
+			  "Sounds/Weapons/Block/RaiseLocal.opus",
+			  "Sounds/Weapons/Grenade/Bounce.opus",
+			  "Sounds/Weapons/Grenade/Debris.opus",
+			  "Sounds/Weapons/Grenade/DropWater.opus",
+			  "Sounds/Weapons/Grenade/Explode1.opus",
+			  "Sounds/Weapons/Grenade/Explode2.opus",
+			  "Sounds/Weapons/Grenade/ExplodeFar.opus",
+			  "Sounds/Weapons/Grenade/ExplodeFarStereo.opus",
+			  "Sounds/Weapons/Grenade/ExplodeStereo1.opus",
+			  "Sounds/Weapons/Grenade/ExplodeStereo2.opus",
+			  "Sounds/Weapons/Grenade/Fire.opus",
+			  "Sounds/Weapons/Grenade/RaiseLocal.opus",
+			  "Sounds/Weapons/Grenade/Throw.opus",
+			  "Sounds/Weapons/Grenade/WaterExplode.opus",
+			  "Sounds/Weapons/Grenade/WaterExplodeFar.opus",
+			  "Sounds/Weapons/Grenade/WaterExplodeStereo.opus",
+			  "Sounds/Weapons/Impacts/Block.opus",
+			  "Sounds/Weapons/Impacts/Flesh1.opus",
+			  "Sounds/Weapons/Impacts/Flesh2.opus",
+			  "Sounds/Weapons/Impacts/Flesh3.opus",
+			  "Sounds/Weapons/Impacts/FleshLocal1.opus",
+			  "Sounds/Weapons/Impacts/FleshLocal2.opus",
+			  "Sounds/Weapons/Impacts/FleshLocal3.opus",
+			  "Sounds/Weapons/Impacts/FleshLocal4.opus",
+			  "Sounds/Weapons/Impacts/Ricochet1.opus",
+			  "Sounds/Weapons/Impacts/Ricochet2.opus",
+			  "Sounds/Weapons/Impacts/Ricochet3.opus",
+			  "Sounds/Weapons/Impacts/Ricochet4.opus",
+			  "Sounds/Weapons/Impacts/Water1.opus",
+			  "Sounds/Weapons/Impacts/Water2.opus",
+			  "Sounds/Weapons/Impacts/Water3.opus",
+			  "Sounds/Weapons/Impacts/Water4.opus",
+			  "Sounds/Weapons/Rifle/Fire1.opus",
+			  "Sounds/Weapons/Rifle/Fire2.opus",
+			  "Sounds/Weapons/Rifle/Fire3.opus",
+			  "Sounds/Weapons/Rifle/FireFar.opus",
+			  "Sounds/Weapons/Rifle/FireLocal.opus",
+			  "Sounds/Weapons/Rifle/FireStereo.opus",
+			  "Sounds/Weapons/Rifle/RaiseLocal.opus",
+			  "Sounds/Weapons/Rifle/Reload.opus",
+			  "Sounds/Weapons/Rifle/ReloadLocal.opus",
+			  "Sounds/Weapons/Rifle/ShellDrop1.opus",
+			  "Sounds/Weapons/Rifle/ShellDrop2.opus",
+			  "Sounds/Weapons/Rifle/ShellWater.opus",
+			  "Sounds/Weapons/Rifle/V2AmbienceLarge.opus",
+			  "Sounds/Weapons/Rifle/V2AmbienceSmall.opus",
+			  "Sounds/Weapons/Shotgun/Cock.opus",
+			  "Sounds/Weapons/Shotgun/CockLocal.opus",
+			  "Sounds/Weapons/Shotgun/Fire.opus",
+			  "Sounds/Weapons/Shotgun/FireFar.opus",
+			  "Sounds/Weapons/Shotgun/FireLocal.opus",
+			  "Sounds/Weapons/Shotgun/FireStereo.opus",
+			  "Sounds/Weapons/Shotgun/RaiseLocal.opus",
+			  "Sounds/Weapons/Shotgun/Reload.opus",
+			  "Sounds/Weapons/Shotgun/ReloadLocal.opus",
+			  "Sounds/Weapons/Shotgun/V2AmbienceLarge.opus",
+			  "Sounds/Weapons/Shotgun/V2AmbienceSmall.opus",
+			  "Sounds/Weapons/SMG/FireFar.opus",
+			  "Sounds/Weapons/SMG/FireStereo.opus",
+			  "Sounds/Weapons/SMG/RaiseLocal.opus",
+			  "Sounds/Weapons/SMG/Reload.opus",
+			  "Sounds/Weapons/SMG/ReloadLocal.opus",
+			  "Sounds/Weapons/SMG/ShellDrop1.opus",
+			  "Sounds/Weapons/SMG/ShellDrop2.opus",
+			  "Sounds/Weapons/SMG/ShellWater.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceLarge1.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceLarge2.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceLarge2.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceLarge3.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceLarge4.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceSmall1.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceSmall2.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceSmall2.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceSmall3.opus",
+			  "Sounds/Weapons/SMG/V2AmbienceSmall4.opus",
+			  "Sounds/Weapons/SMG/V2Local1.opus",
+			  "Sounds/Weapons/SMG/V2Local2.opus",
+			  "Sounds/Weapons/SMG/V2Local3.opus",
+			  "Sounds/Weapons/SMG/V2Local4.opus",
+			  "Sounds/Weapons/SMG/V2Third1.opus",
+			  "Sounds/Weapons/SMG/V2Third2.opus",
+			  "Sounds/Weapons/SMG/V2Third3.opus",
+			  "Sounds/Weapons/SMG/V2Third4.opus",
+			  "Sounds/Weapons/Spade/HitBlock.opus",
+			  "Sounds/Weapons/Spade/HitPlayer.opus",
+			  "Sounds/Weapons/Spade/Miss.opus",
+			  "Sounds/Weapons/Spade/RaiseLocal.opus",
+			  "Sounds/Weapons/AimDownSightLocal.opus",
+			  "Sounds/Weapons/DryFire.opus",
+			  "Sounds/Weapons/Restock.opus",
+			  "Sounds/Weapons/RestockLocal.opus",
+			  "Sounds/Weapons/Switch.opus",
+			  "Sounds/Weapons/SwitchLocal.opus",
+			});
 
 			// load models
-			renderer->RegisterModel("Models/MapObjects/BlockCursorLine.kv6");
-			renderer->RegisterModel("Models/MapObjects/CheckPoint.kv6");
-			renderer->RegisterModel("Models/MapObjects/Intel.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/Arm.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/Arms.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/Leg.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/LegCrouch.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/Torso.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/TorsoCrouch.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/Dead.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/Head.kv6");
-			renderer->RegisterModel("Models/Player/Rifle/UpperArm.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/Arm.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/Arms.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/Dead.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/Head.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/Leg.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/LegCrouch.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/Torso.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/TorsoCrouch.kv6");
-			renderer->RegisterModel("Models/Player/Shotgun/UpperArm.kv6");
-			renderer->RegisterModel("Models/Player/SMG/Arm.kv6");
-			renderer->RegisterModel("Models/Player/SMG/Arms.kv6");
-			renderer->RegisterModel("Models/Player/SMG/Dead.kv6");
-			renderer->RegisterModel("Models/Player/SMG/Head.kv6");
-			renderer->RegisterModel("Models/Player/SMG/Leg.kv6");
-			renderer->RegisterModel("Models/Player/SMG/LegCrouch.kv6");
-			renderer->RegisterModel("Models/Player/SMG/Torso.kv6");
-			renderer->RegisterModel("Models/Player/SMG/TorsoCrouch.kv6");
-			renderer->RegisterModel("Models/Player/SMG/UpperArm.kv6");
-			renderer->RegisterModel("Models/Player/Arm.kv6");
-			renderer->RegisterModel("Models/Player/Arms.kv6");
-			renderer->RegisterModel("Models/Player/Dead.kv6");
-			renderer->RegisterModel("Models/Player/Head.kv6");
-			renderer->RegisterModel("Models/Player/Leg.kv6");
-			renderer->RegisterModel("Models/Player/LegCrouch.kv6");
-			renderer->RegisterModel("Models/Player/Torso.kv6");
-			renderer->RegisterModel("Models/Player/TorsoCrouch.kv6");
-			renderer->RegisterModel("Models/Player/UpperArm.kv6");
-			renderer->RegisterModel("Models/Weapons/Spade/Pickaxe.kv6");
-			renderer->RegisterModel("Models/Weapons/Spade/Spade.kv6");
-			renderer->RegisterModel("Models/Weapons/Block/Block.kv6");
-			renderer->RegisterModel("Models/Weapons/Grenade/Grenade.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/Casing.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/Magazine.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/SightFront.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/SightRear.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/SightReflex.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/Weapon.kv6");
-			renderer->RegisterModel("Models/Weapons/Rifle/WeaponNoMagazine.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/Casing.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/Pump.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/SightFront.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/SightRear.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/SightReflex.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/Weapon.kv6");
-			renderer->RegisterModel("Models/Weapons/Shotgun/WeaponNoPump.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/Casing.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/Magazine.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/SightFrontPin.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/SightFront.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/SightRear.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/SightReflex.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/Weapon.kv6");
-			renderer->RegisterModel("Models/Weapons/SMG/WeaponNoMagazine.kv6");
-			renderer->RegisterModel("Models/Weapons/Charms/Charm.kv6");
-			renderer->RegisterModel("Models/Weapons/Charms/CharmBase.kv6");
+			renderer->PreloadModels({
+			  "Models/MapObjects/BlockCursorLine.kv6",
+			  "Models/MapObjects/CheckPoint.kv6",
+			  "Models/MapObjects/Intel.kv6",
+			  "Models/Player/Rifle/Arm.kv6",
+			  "Models/Player/Rifle/Arms.kv6",
+			  "Models/Player/Rifle/Leg.kv6",
+			  "Models/Player/Rifle/LegCrouch.kv6",
+			  "Models/Player/Rifle/Torso.kv6",
+			  "Models/Player/Rifle/TorsoCrouch.kv6",
+			  "Models/Player/Rifle/Dead.kv6",
+			  "Models/Player/Rifle/Head.kv6",
+			  "Models/Player/Rifle/UpperArm.kv6",
+			  "Models/Player/Shotgun/Arm.kv6",
+			  "Models/Player/Shotgun/Arms.kv6",
+			  "Models/Player/Shotgun/Dead.kv6",
+			  "Models/Player/Shotgun/Head.kv6",
+			  "Models/Player/Shotgun/Leg.kv6",
+			  "Models/Player/Shotgun/LegCrouch.kv6",
+			  "Models/Player/Shotgun/Torso.kv6",
+			  "Models/Player/Shotgun/TorsoCrouch.kv6",
+			  "Models/Player/Shotgun/UpperArm.kv6",
+			  "Models/Player/SMG/Arm.kv6",
+			  "Models/Player/SMG/Arms.kv6",
+			  "Models/Player/SMG/Dead.kv6",
+			  "Models/Player/SMG/Head.kv6",
+			  "Models/Player/SMG/Leg.kv6",
+			  "Models/Player/SMG/LegCrouch.kv6",
+			  "Models/Player/SMG/Torso.kv6",
+			  "Models/Player/SMG/TorsoCrouch.kv6",
+			  "Models/Player/SMG/UpperArm.kv6",
+			  "Models/Player/Arm.kv6",
+			  "Models/Player/Arms.kv6",
+			  "Models/Player/Dead.kv6",
+			  "Models/Player/Head.kv6",
+			  "Models/Player/Leg.kv6",
+			  "Models/Player/LegCrouch.kv6",
+			  "Models/Player/Torso.kv6",
+			  "Models/Player/TorsoCrouch.kv6",
+			  "Models/Player/UpperArm.kv6",
+			  "Models/Weapons/Spade/Pickaxe.kv6",
+			  "Models/Weapons/Spade/Spade.kv6",
+			  "Models/Weapons/Block/Block.kv6",
+			  "Models/Weapons/Grenade/Grenade.kv6",
+			  "Models/Weapons/Rifle/Casing.kv6",
+			  "Models/Weapons/Rifle/Magazine.kv6",
+			  "Models/Weapons/Rifle/SightFront.kv6",
+			  "Models/Weapons/Rifle/SightRear.kv6",
+			  "Models/Weapons/Rifle/SightReflex.kv6",
+			  "Models/Weapons/Rifle/Weapon.kv6",
+			  "Models/Weapons/Rifle/WeaponNoMagazine.kv6",
+			  "Models/Weapons/Shotgun/Casing.kv6",
+			  "Models/Weapons/Shotgun/Pump.kv6",
+			  "Models/Weapons/Shotgun/SightFront.kv6",
+			  "Models/Weapons/Shotgun/SightRear.kv6",
+			  "Models/Weapons/Shotgun/SightReflex.kv6",
+			  "Models/Weapons/Shotgun/Weapon.kv6",
+			  "Models/Weapons/Shotgun/WeaponNoPump.kv6",
+			  "Models/Weapons/SMG/Casing.kv6",
+			  "Models/Weapons/SMG/Magazine.kv6",
+			  "Models/Weapons/SMG/SightFrontPin.kv6",
+			  "Models/Weapons/SMG/SightFront.kv6",
+			  "Models/Weapons/SMG/SightRear.kv6",
+			  "Models/Weapons/SMG/SightReflex.kv6",
+			  "Models/Weapons/SMG/Weapon.kv6",
+			  "Models/Weapons/SMG/WeaponNoMagazine.kv6",
+			  "Models/Weapons/Charms/Charm.kv6",
+			  "Models/Weapons/Charms/CharmBase.kv6",
+			});
 
 			// detect seasonal events & load assets
 			time_t t;
@@ -570,6 +587,10 @@ namespace spades {
 
 			fpsCounter.MarkFrame();
 
+			if (screenshotWriter) {
+				screenshotWriter->ProcessCompleted();
+			}
+
 			// waiting for renderer initialization
 			if (frameToRendererInit > 0) {
 				DrawStartupScreen();
@@ -666,6 +687,11 @@ namespace spades {
 
 			// Well done!
 			renderer->FrameDone();
+
+			if (screenShotBurstFramesLeft > 0) {
+				CaptureScreenShotBurstFrame();
+			}
+
 			renderer->Flip();
 		}
 
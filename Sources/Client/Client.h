@@ -70,6 +70,7 @@ namespace spades {
 		class ClientPlayer;
 		class BloodMarks;
 		class ClientUI;
+		class ScreenshotWriter;
 
 		class Client : public IWorldListener, public gui::View {
 			friend class ScoreboardView;
@@ -400,6 +401,16 @@ namespace spades {
 			int nextScreenShotIndex;
 			int nextMapShotIndex;
 
+			std::unique_ptr<ScreenshotWriter> screenshotWriter;
+			/** Screenshot indices known to be taken. Scanned once on the first
+			 * screenshot so that picking a file name doesn't hit the disk. */
+			std::vector<bool> usedScreenShotIndices;
+
+			/** The number of frames remaining in the current screenshot burst. */
+			int screenShotBurstFramesLeft;
+			int screenShotBurstFrame;
+			int screenShotBurstIndex;
+
 			/** Project the specified world-space position to a screen space. */
 			bool Project(const Vector3&, Vector2&);
 
@@ -478,8 +489,12 @@ namespace spades {
 
 			SceneDefinition CreateSceneDefinition();
 
+			ScreenshotWriter& GetScreenshotWriter();
+			int AllocateScreenShotIndex();
 			std::string ScreenShotPath();
 			void TakeScreenShot(bool sceneOnly, bool scoreboardOnly = false);
+			void StartScreenShotBurst();
+			void CaptureScreenShotBurstFrame();
 
 			std::string MapShotPath();
 			void TakeMapShot();
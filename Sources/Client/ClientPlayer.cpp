@@ -39,6 +39,7 @@
 #include "NetClient.h"
 #include <Core/Bitmap.h>
 #include <Core/Settings.h>
+#include <Core/Stopwatch.h>
 #include <ScriptBindings/IBlockSkin.h>
 #include <ScriptBindings/IGrenadeSkin.h>
 #include <ScriptBindings/ISpadeSkin.h>
@@ -66,6 +67,7 @@ DEFINE_SPADES_SETTING(cg_hideArms, "0");
 DEFINE_SPADES_SETTING(cg_debugToolSkinAnchors, "0");
 DEFINE_SPADES_SETTING(cg_trueAimDownSight, "1");
 DEFINE_SPADES_SETTING(cg_muzzleFire, "0");
+DEFINE_SPADES_SETTING(cg_debugSkinStateTiming, "0");
 
 SPADES_SETTING(cg_orientationSmoothing);
 
@@ -185,6 +187,11 @@ namespace spades {
 			/** Sets color for image drawing. Always alpha premultiplied. */
 			void SetColorAlphaPremultiplied(Vector4 col) { base->SetColorAlphaPremultiplied(col); }
 
+			bool SupportsImageDistanceField() { return base->SupportsImageDistanceField(); }
+			void SetImageDistanceField(stmp::optional<ImageDistanceField> field) {
+				base->SetImageDistanceField(field);
+			}
+
 			void DrawImage(stmp::optional<IImage&> img, const Vector2& outTopLeft) {
 				if (allowDepthHack)
 					base->DrawImage(img, outTopLeft);
@@ -530,9 +537,23 @@ namespace spades {
 			return Matrix4::FromAxis(-player.GetRight(), player.GetFront(), -player.GetUp(), eye);
 		}
 
-		void ClientPlayer::SetSkinParameterForTool(Player::ToolType type, asIScriptObject* skin) {
+		SkinState ClientPlayer::GetSkinState(Player::ToolType type, asIScriptObject* skin) {
 			Player& p = player;
 			Weapon& w = p.GetWeapon();
+			SkinState state;
+
+			// IToolSkin
+			asIScriptObject* curSkin = GetCurrentSkin(!ShouldRenderInThirdPersonView());
+
+			float putdown = 1.0F - toolRaiseState;
+			putdown *= putdown;
+			putdown = std::min(1.0F, putdown * 1.5F);
+			float raiseState = (skin == curSkin) ? (1.0F - putdown) : 0.0F;
+
+			state.teamColor = ConvertColorRGB(p.GetColor());
+			state.raiseState = p.IsLocalPlayer() ? raiseState : 1.0F;
+			state.sprintState = SmoothStep(sprintState);
+			state.muted = client.IsMuted();
 
 			WeaponInput actualWeapInput = p.GetWeaponInput();
 
@@ -541,39 +562,110 @@ namespace spades {
 
 			switch (type) {
 				case Player::ToolSpade: {
-					ScriptISpadeSkin interface(skin);
-
 					const float nextSpadeTime = p.GetTimeToNextSpade();
 					if (nextSpadeTime > 0.0F) {
-						interface.SetActionType(SpadeActionTypeBash);
-						interface.SetActionProgress(1.0F - (nextSpadeTime / primaryDelay));
+						state.actionType = SpadeActionTypeBash;
+						state.actionProgress = 1.0F - (nextSpadeTime / primaryDelay);
 					} else if (actualWeapInput.secondary) {
-						interface.SetActionType(p.IsFirstDig()
-							? SpadeActionTypeDigStart : SpadeActionTypeDig);
-						interface.SetActionProgress(1.0F - (p.GetTimeToNextDig() / secondaryDelay));
+						state.actionType = p.IsFirstDig()
+							? SpadeActionTypeDigStart : SpadeActionTypeDig;
+						state.actionProgress = 1.0F - (p.GetTimeToNextDig() / secondaryDelay);
 					} else {
-						interface.SetActionType(SpadeActionTypeIdle);
-						interface.SetActionProgress(0.0F);
+						state.actionType = SpadeActionTypeIdle;
+						state.actionProgress = 0.0F;
 					}
 				} break;
+				case Player::ToolBlock:
+					state.readyState = 1.0F - (p.GetTimeToNextBlock() / primaryDelay);
+					state.blockColor = ConvertColorRGB(p.GetBlockColor());
+					break;
+				case Player::ToolGrenade:
+					state.readyState = 1.0F - (p.GetTimeToNextGrenade() / primaryDelay);
+					state.cookTime = p.IsCookingGrenade() ? p.GetGrenadeCookTime() : 0.0F;
+					break;
+				case Player::ToolWeapon:
+					state.readyState = 1.0F - (w.GetTimeToNextFire() / primaryDelay);
+					state.aimDownSightState =
+						cg_trueAimDownSight ? aimDownState : aimDownState * 0.5F;
+					state.ammo = w.GetAmmo();
+					state.clipSize = w.GetClipSize();
+					state.reloading = w.IsReloading();
+					state.reloadProgress = w.GetReloadProgress();
+					break;
+				default: SPInvalidEnum("currentTool", type);
+			}
+
+			return state;
+		}
+
+		void ClientPlayer::SetSkinParameters(Player::ToolType type, asIScriptObject* skin) {
+			Stopwatch sw;
+
+			SkinState state = GetSkinState(type, skin);
+
+			ScriptIToolSkin2 interface(skin);
+			bool bulk = interface.ImplementsInterface();
+			if (bulk) {
+				interface.Update(state);
+			} else {
+				// compatibility path for skins only implementing the property setters
+				SetSkinParameterForTool(type, skin, state);
+				SetCommonSkinParameter(skin, state);
+			}
+
+			if (cg_debugSkinStateTiming) {
+				static Stopwatch reportTimer;
+				static double totalTime = 0.0;
+				static int numUpdates = 0, numBulkUpdates = 0, numFrames = 0;
+				static float lastFrameTime = -1.0F;
+
+				totalTime += sw.GetTime();
+				numUpdates++;
+				if (bulk)
+					numBulkUpdates++;
+				if (client.time != lastFrameTime) {
+					lastFrameTime = client.time;
+					numFrames++;
+				}
+
+				if (reportTimer.GetTime() >= 1.0) {
+					SPLog("Skin parameters: %.3fms/frame, %.1f updates/frame (%d%% bulk)",
+					      totalTime * 1000.0 / numFrames,
+					      static_cast<double>(numUpdates) / numFrames,
+					      numBulkUpdates * 100 / numUpdates);
+					reportTimer.Reset();
+					totalTime = 0.0;
+					numUpdates = numBulkUpdates = numFrames = 0;
+				}
+			}
+		}
+
+		void ClientPlayer::SetSkinParameterForTool(Player::ToolType type, asIScriptObject* skin,
+		                                           const SkinState& state) {
+			switch (type) {
+				case Player::ToolSpade: {
+					ScriptISpadeSkin interface(skin);
+					interface.SetActionType(state.actionType);
+					interface.SetActionProgress(state.actionProgress);
+				} break;
 				case Player::ToolBlock: {
 					ScriptIBlockSkin interface(skin);
-					interface.SetReadyState(1.0F - (p.GetTimeToNextBlock() / primaryDelay));
-					interface.SetBlockColor(ConvertColorRGB(p.GetBlockColor()));
+					interface.SetReadyState(state.readyState);
+					interface.SetBlockColor(state.blockColor);
 				} break;
 				case Player::ToolGrenade: {
 					ScriptIGrenadeSkin interface(skin);
-					interface.SetReadyState(1.0F - (p.GetTimeToNextGrenade() / primaryDelay));
-					interface.SetCookTime(p.IsCookingGrenade() ? p.GetGrenadeCookTime() : 0.0F);
+					interface.SetReadyState(state.readyState);
+					interface.SetCookTime(state.cookTime);
 				} break;
 				case Player::ToolWeapon: {
 					ScriptIWeaponSkin interface(skin);
-					interface.SetReadyState(1.0F - (w.GetTimeToNextFire() / primaryDelay));
-					interface.SetAimDownSightState(cg_trueAimDownSight ? aimDownState : aimDownState * 0.5F);
-					interface.SetAmmo(w.GetAmmo());
-					interface.SetClipSize(w.GetClipSize());
-					interface.SetReloading(w.IsReloading());
-					interface.SetReloadProgress(w.GetReloadProgress());
+					interface.SetReadyState(state.readyState);
+					interface.SetAimDownSightState(state.aimDownSightState);
+					interface.SetAmmo(state.ammo);
+					interface.SetClipSize(state.clipSize);
+					interface.SetReloading(state.reloading);
+					interface.SetReloadProgress(state.reloadProgress);
 				} break;
 				default: SPInvalidEnum("currentTool", type);
 			}
@@ -589,22 +681,12 @@ namespace spades {
 			}
 		}
 
-		void ClientPlayer::SetCommonSkinParameter(asIScriptObject* skin) {
-			asIScriptObject* curSkin = GetCurrentSkin(!ShouldRenderInThirdPersonView());
-
-			float sprint = SmoothStep(sprintState);
-			float putdown = 1.0F - toolRaiseState;
-			putdown *= putdown;
-			putdown = std::min(1.0F, putdown * 1.5F);
-			float raiseState = (skin == curSkin) ? (1.0F - putdown) : 0.0F;
-
-			{
-				ScriptIToolSkin interface(skin);
-				interface.SetTeamColor(ConvertColorRGB(player.GetColor()));
-				interface.SetRaiseState(player.IsLocalPlayer() ? raiseState : 1.0F);
-				interface.SetSprintState(sprint);
-				interface.SetMuted(client.IsMuted());
-			}
+		void ClientPlayer::SetCommonSkinParameter(asIScriptObject* skin, const SkinState& state) {
+			ScriptIToolSkin interface(skin);
+			interface.SetTeamColor(state.teamColor);
+			interface.SetRaiseState(state.raiseState);
+			interface.SetSprintState(state.sprintState);
+			interface.SetMuted(state.muted);
 		}
 
 		std::array<Vector3, 3> ClientPlayer::GetFlashlightAxes() {
@@ -678,8 +760,7 @@ namespace spades {
 			}
 
 			asIScriptObject* curSkin = GetCurrentSkin(true);
-			SetSkinParameterForTool(currentTool, curSkin);
-			SetCommonSkinParameter(curSkin);
+			SetSkinParameters(currentTool, curSkin);
 
 			float weapSide = Clamp((float)cg_viewWeaponSide, -1.0F, 1.0F);
 			bool leftHanded = weapSide < 0.0F;
@@ -1058,8 +1139,7 @@ namespace spades {
 
 			// ready for tool rendering
 			asIScriptObject* curSkin = GetCurrentSkin(false);
-			SetSkinParameterForTool(currentTool, curSkin);
-			SetCommonSkinParameter(curSkin);
+			SetSkinParameters(currentTool, curSkin);
 
 			float yaw = atan2f(o.y, o.x) + M_PI_F * 0.5F;
 			float pitch = -atan2f(o.z, o.GetLength2D());
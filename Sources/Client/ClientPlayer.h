@@ -35,6 +35,7 @@ namespace spades {
 		class IRenderer;
 		class IAudioDevice;
 		class SandboxedRenderer;
+		struct SkinState;
 
 		// TODO: Use `shared_ptr` instead of `RefCountedObject`
 		/** Representation of player which is used by
@@ -78,8 +79,11 @@ namespace spades {
 			void AddToSceneThirdPersonView();
 			void AddToSceneFirstPersonView();
 
-			void SetSkinParameterForTool(Player::ToolType, asIScriptObject*);
-			void SetCommonSkinParameter(asIScriptObject*);
+			SkinState GetSkinState(Player::ToolType, asIScriptObject*);
+			/** Passes the current `SkinState` to the skin, in bulk if it supports `IToolSkin2`. */
+			void SetSkinParameters(Player::ToolType, asIScriptObject*);
+			void SetSkinParameterForTool(Player::ToolType, asIScriptObject*, const SkinState&);
+			void SetCommonSkinParameter(asIScriptObject*, const SkinState&);
 
 			struct AmbienceInfo;
 			AmbienceInfo ComputeAmbience();
@@ -46,6 +46,7 @@
 #include "MapView.h"
 #include "PaletteView.h"
 #include "ScoreboardView.h"
+#include "ScreenshotWriter.h"
 #include "TCProgressView.h"
 
 #include "GameMap.h"
@@ -64,6 +65,8 @@ SPADES_SETTING(cg_keyCrouch);
 SPADES_SETTING(cg_keyLimbo);
 SPADES_SETTING(cg_keyToggleSpectatorNames);
 DEFINE_SPADES_SETTING(cg_screenshotFormat, "jpeg");
+DEFINE_SPADES_SETTING(cg_screenshotQueueSize, "256");
+DEFINE_SPADES_SETTING(cg_screenshotBurstFrames, "0");
 DEFINE_SPADES_SETTING(cg_stats, "0");
 DEFINE_SPADES_SETTING(cg_statsSmallFont, "0");
 DEFINE_SPADES_SETTING(cg_playerStats, "0");
@@ -129,6 +132,16 @@ namespace spades {
 				}
 			}
 
+			const char* GetScreenshotExtension(ScreenshotFormat format) {
+				switch (format) {
+					case ScreenshotFormat::JPG: return "jpg";
+					case ScreenshotFormat::TGA: return "tga";
+					case ScreenshotFormat::PNG: return "png";
+				}
+				SPAssert(false);
+				return nullptr;
+			}
+
 			std::string TrKey(const std::string& name) {
 				if (name.empty()) {
 					return _Tr("Client", "Unbound");
@@ -142,7 +155,21 @@ namespace spades {
 			}
 		} // namespace
 
+		ScreenshotWriter& Client::GetScreenshotWriter() {
+			if (!screenshotWriter) {
+				std::size_t budget =
+				  static_cast<std::size_t>(std::max((int)cg_screenshotQueueSize, 1)) << 20;
+				screenshotWriter = stmp::make_unique<ScreenshotWriter>(budget);
+			}
+			return *screenshotWriter;
+		}
+
 		void Client::TakeScreenShot(bool sceneOnly, bool scoreboardOnly) {
+			if (!sceneOnly && !scoreboardOnly && (int)cg_screenshotBurstFrames > 0) {
+				StartScreenShotBurst();
+				return;
+			}
+
 			SceneDefinition sceneDef = CreateSceneDefinition();
 			lastSceneDef = sceneDef;
 			UpdateMatrices();
@@ -165,14 +192,34 @@ namespace spades {
 
 			try {
 				auto name = ScreenShotPath();
-				bmp->Save(name);
-
-				std::string msg = sceneOnly
-					? _Tr("Client", "Sceneshot saved: {0}", name)
-					: _Tr("Client", "Screenshot saved: {0}", name);
-				ShowAlert(msg, AlertType::Notice);
 
-				PlayScreenshotSound();
+				// Encoding is done by the background thread. The result is
+				// reported by `ProcessCompleted` in a later frame.
+				GetScreenshotWriter().Enqueue(
+				  std::move(bmp), name, [this, name, sceneOnly](std::exception_ptr error) {
+					  try {
+						  if (error) {
+							  std::rethrow_exception(error);
+						  }
+
+						  std::string msg = sceneOnly
+						                      ? _Tr("Client", "Sceneshot saved: {0}", name)
+						                      : _Tr("Client", "Screenshot saved: {0}", name);
+						  ShowAlert(msg, AlertType::Notice);
+
+						  PlayScreenshotSound();
+					  } catch (const Exception& ex) {
+						  auto msg = _Tr("Client", "Screenshot failed: ");
+						  msg += ex.GetShortMessage();
+						  ShowAlert(msg, AlertType::Error);
+						  SPLog("Screenshot failed: %s", ex.what());
+					  } catch (const std::exception& ex) {
+						  auto msg = _Tr("Client", "Screenshot failed: ");
+						  msg += ex.what();
+						  ShowAlert(msg, AlertType::Error);
+						  SPLog("Screenshot failed: %s", ex.what());
+					  }
+				  });
 			} catch (const Exception& ex) {
 				auto msg = _Tr("Client", "Screenshot failed: ");
 				msg += ex.GetShortMessage();
@@ -186,33 +233,100 @@ namespace spades {
 			}
 		}
 
-		std::string Client::ScreenShotPath() {
-			char bufJpg[32], bufTga[32], bufPng[32];
+		void Client::StartScreenShotBurst() {
+			if (screenShotBurstFramesLeft > 0) {
+				// Already capturing
+				return;
+			}
+
+			try {
+				screenShotBurstIndex = AllocateScreenShotIndex();
+			} catch (const Exception& ex) {
+				auto msg = _Tr("Client", "Screenshot failed: ");
+				msg += ex.GetShortMessage();
+				ShowAlert(msg, AlertType::Error);
+				SPLog("Screenshot failed: %s", ex.what());
+				return;
+			}
+
+			screenShotBurstFramesLeft = std::min((int)cg_screenshotBurstFrames, 1000);
+			screenShotBurstFrame = 0;
+			SPLog("Capturing %d frames as screenshot #%04d", screenShotBurstFramesLeft,
+			      screenShotBurstIndex);
+		}
+
+		void Client::CaptureScreenShotBurstFrame() {
+			SPADES_MARK_FUNCTION();
+
+			char buf[64];
+			snprintf(buf, sizeof(buf), "Screenshots/shot%04d-%03d.%s", screenShotBurstIndex,
+			         screenShotBurstFrame,
+			         GetScreenshotExtension(GetScreenshotFormat(cg_screenshotFormat)));
+			std::string name = buf;
+
+			bool isLast = screenShotBurstFramesLeft == 1;
+			int numFrames = screenShotBurstFrame + 1;
+			screenShotBurstFrame++;
+			screenShotBurstFramesLeft--;
+
+			// Only the last frame reports the result so that a burst produces
+			// a single alert.
+			ScreenshotWriter::Callback callback;
+			if (isLast) {
+				callback = [this, name, numFrames](std::exception_ptr error) {
+					if (error) {
+						ShowAlert(_Tr("Client", "Screenshot failed: {0}", name), AlertType::Error);
+						return;
+					}
+					ShowAlert(_Tr("Client", "Captured {0} frames: {1}", numFrames, name),
+					          AlertType::Notice);
+					PlayScreenshotSound();
+				};
+			}
+
+			GetScreenshotWriter().Enqueue(renderer->ReadBitmap(), name, std::move(callback));
+		}
+
+		int Client::AllocateScreenShotIndex() {
 			const int maxShotIndex = 10000;
-			for (int i = 0; i < maxShotIndex; i++) {
-				snprintf(bufJpg, sizeof(bufJpg), "Screenshots/shot%04d.jpg", nextScreenShotIndex);
-				snprintf(bufTga, sizeof(bufTga), "Screenshots/shot%04d.tga", nextScreenShotIndex);
-				snprintf(bufPng, sizeof(bufPng), "Screenshots/shot%04d.png", nextScreenShotIndex);
-				if (FileManager::FileExists(bufJpg) ||
-					FileManager::FileExists(bufTga) ||
-					FileManager::FileExists(bufPng)) {
-					nextScreenShotIndex++;
-					if (nextScreenShotIndex >= maxShotIndex)
-						nextScreenShotIndex = 0;
-					continue;
+
+			if (usedScreenShotIndices.empty()) {
+				// Scan the existing screenshots once instead of probing each
+				// candidate file name every time.
+				usedScreenShotIndices.resize(maxShotIndex, false);
+				for (const std::string& fileName : FileManager::EnumFiles("Screenshots")) {
+					int index;
+					if (sscanf(fileName.c_str(), "shot%4d", &index) == 1 && index >= 0 &&
+					    index < maxShotIndex) {
+						usedScreenShotIndices[index] = true;
+					}
 				}
+			}
 
-				switch (GetScreenshotFormat(cg_screenshotFormat)) {
-					case ScreenshotFormat::JPG: return bufJpg;
-					case ScreenshotFormat::TGA: return bufTga;
-					case ScreenshotFormat::PNG: return bufPng;
+			for (int i = 0; i < maxShotIndex; i++) {
+				int index = nextScreenShotIndex;
+				nextScreenShotIndex++;
+				if (nextScreenShotIndex >= maxShotIndex)
+					nextScreenShotIndex = 0;
+
+				if (!usedScreenShotIndices[index]) {
+					usedScreenShotIndices[index] = true;
+					return index;
 				}
-				SPAssert(false);
 			}
 
 			SPRaise("No free file name");
 		}
 
+		std::string Client::ScreenShotPath() {
+			int index = AllocateScreenShotIndex();
+
+			char buf[32];
+			snprintf(buf, sizeof(buf), "Screenshots/shot%04d.%s", index,
+			         GetScreenshotExtension(GetScreenshotFormat(cg_screenshotFormat)));
+			return buf;
+		}
+
 #pragma mark - HUD Drawings
 
 		void Client::DrawSplash() {
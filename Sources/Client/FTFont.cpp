@@ -29,6 +29,7 @@
 #include <Client/IImage.h>
 #include <Client/IRenderer.h>
 #include <Core/Bitmap.h>
+#include <Core/ConcurrentDispatch.h>
 #include <Core/FileManager.h>
 #include <Core/ThreadLocalStorage.h>
 #include <Draw/SW/SWRenderer.h>
@@ -68,8 +69,167 @@ namespace spades {
 			FT_Bitmap* operator->() { return &b; }
 		};
 
-		FTFontSet::FTFontSet() { SPADES_MARK_FUNCTION(); }
-		FTFontSet::~FTFontSet() { SPADES_MARK_FUNCTION(); }
+		/** The signed distance field of a glyph. */
+		struct FTDistanceField {
+			/** Distances encoded in `[0, 255]`; see `distanceFieldSpread`. */
+			std::vector<uint8_t> texels;
+			int width, height;
+			/** The position of the top-left texel relative to the origin, in texels. */
+			int left, top;
+		};
+
+		namespace {
+			/** The size of an em in distance field texels. */
+			constexpr int distanceFieldEmSize = 48;
+			/** The distance (in texels) mapped to the both ends of the encoded range. */
+			constexpr int distanceFieldSpread = 6;
+			/** Glyphs are rasterized at this multiple of the distance field resolution. */
+			constexpr int distanceFieldOversampling = 4;
+
+			constexpr float distanceInfinity = 1.0e20F;
+
+			int FloorDiv(int a, int b) { return a >= 0 ? a / b : -((-a + b - 1) / b); }
+
+			/**
+			 * Computes the squared Euclidean distance transform of a 1D function sampled at
+			 * `stride` intervals (Felzenszwalb and Huttenlocher).
+			 */
+			void DistanceTransform(float *f, int n, int stride, std::vector<float> &d,
+			                       std::vector<int> &v, std::vector<float> &z) {
+				d.resize(n);
+				v.resize(n);
+				z.resize(n + 1);
+
+				int k = 0;
+				v[0] = 0;
+				z[0] = -distanceInfinity;
+				z[1] = distanceInfinity;
+				for (int q = 1; q < n; q++) {
+					float fq = f[q * stride] + static_cast<float>(q * q);
+					float s;
+					while (true) {
+						int p = v[k];
+						s = (fq - (f[p * stride] + static_cast<float>(p * p))) /
+						    static_cast<float>(2 * (q - p));
+						if (s > z[k] || k == 0)
+							break;
+						k--;
+					}
+					k++;
+					v[k] = q;
+					z[k] = s;
+					z[k + 1] = distanceInfinity;
+				}
+
+				k = 0;
+				for (int q = 0; q < n; q++) {
+					while (z[k + 1] < static_cast<float>(q))
+						k++;
+					float dx = static_cast<float>(q - v[k]);
+					d[q] = dx * dx + f[v[k] * stride];
+				}
+				for (int q = 0; q < n; q++)
+					f[q * stride] = d[q];
+			}
+
+			/** Replaces the seeds (zeros) in `grid` with the squared distances to them. */
+			void DistanceTransform(std::vector<float> &grid, int w, int h) {
+				std::vector<float> d, z;
+				std::vector<int> v;
+				for (int x = 0; x < w; x++)
+					DistanceTransform(grid.data() + x, h, w, d, v, z);
+				for (int y = 0; y < h; y++)
+					DistanceTransform(grid.data() + y * w, w, 1, d, v, z);
+			}
+
+			/**
+			 * Rasterizes a glyph at a high resolution and computes its signed distance
+			 * field. `face` must not be used by other threads during the call.
+			 */
+			std::shared_ptr<FTDistanceField> GenerateDistanceField(FT_Face face,
+			                                                       uint32_t charIndex) {
+				const int scale = distanceFieldOversampling;
+				FT_Set_Char_Size(face, 0,
+				                 static_cast<FT_F26Dot6>(distanceFieldEmSize * scale * 64), 72, 72);
+				FT_Load_Glyph(face, charIndex, FT_LOAD_NO_HINTING);
+				FT_Render_Glyph(face->glyph, FT_RENDER_MODE_NORMAL);
+
+				FTBitmapWrapper bmp;
+				FT_Bitmap_Convert(GetFreeType(), &face->glyph->bitmap, bmp, 1);
+
+				auto field = std::make_shared<FTDistanceField>();
+				field->width = field->height = 0;
+				field->left = field->top = 0;
+
+				int const bmpW = static_cast<int>(bmp->width);
+				int const bmpH = static_cast<int>(bmp->rows);
+				if (bmpW == 0 || bmpH == 0)
+					return field;
+
+				// align the high resolution grid with the texels
+				int const pad = distanceFieldSpread * scale;
+				int const bmpLeft = face->glyph->bitmap_left;
+				int const bmpTop = -face->glyph->bitmap_top;
+				field->left = FloorDiv(bmpLeft - pad, scale);
+				field->top = FloorDiv(bmpTop - pad, scale);
+				field->width = FloorDiv(bmpLeft + bmpW + pad + scale - 1, scale) - field->left;
+				field->height = FloorDiv(bmpTop + bmpH + pad + scale - 1, scale) - field->top;
+
+				int const gridW = field->width * scale;
+				int const gridH = field->height * scale;
+				int const originX = bmpLeft - field->left * scale;
+				int const originY = bmpTop - field->top * scale;
+
+				std::vector<bool> inside(gridW * gridH, false);
+				for (int y = 0; y < bmpH; y++) {
+					const uint8_t *row = bmp->buffer + y * bmp->pitch;
+					for (int x = 0; x < bmpW; x++)
+						inside[(y + originY) * gridW + x + originX] = row[x] >= 128;
+				}
+
+				// squared distances to the nearest inside/outside pixel
+				std::vector<float> toInside(gridW * gridH), toOutside(gridW * gridH);
+				for (std::size_t i = 0; i < inside.size(); i++) {
+					toInside[i] = inside[i] ? 0.0F : distanceInfinity;
+					toOutside[i] = inside[i] ? distanceInfinity : 0.0F;
+				}
+				DistanceTransform(toInside, gridW, gridH);
+				DistanceTransform(toOutside, gridW, gridH);
+
+				// downsample to texels; distances are measured from the pixel edges
+				field->texels.resize(field->width * field->height);
+				float const encodeScale = 1.0F / static_cast<float>(2 * distanceFieldSpread * scale *
+				                                                    scale * scale);
+				for (int ty = 0; ty < field->height; ty++) {
+					for (int tx = 0; tx < field->width; tx++) {
+						float sum = 0.0F;
+						for (int y = ty * scale; y < (ty + 1) * scale; y++) {
+							for (int x = tx * scale; x < (tx + 1) * scale; x++) {
+								std::size_t i = y * gridW + x;
+								sum += inside[i] ? std::sqrt(toOutside[i]) - 0.5F
+								                 : 0.5F - std::sqrt(toInside[i]);
+							}
+						}
+						float value = 0.5F + sum * encodeScale;
+						value = std::max(std::min(value, 1.0F), 0.0F);
+						field->texels[ty * field->width + tx] =
+						  static_cast<uint8_t>(value * 255.0F + 0.5F);
+					}
+				}
+
+				return field;
+			}
+		} // namespace
+
+		FTFontSet::FTFontSet() : pregenerationCancelled(false), atlasRenderer(nullptr) {
+			SPADES_MARK_FUNCTION();
+		}
+		FTFontSet::~FTFontSet() {
+			SPADES_MARK_FUNCTION();
+
+			pregenerationCancelled = true;
+			pregenerationJobs.clear(); // joins the jobs
+		}
 
 		void FTFontSet::AddFace(const std::string& fileName) {
 			FT_Face face;
@@ -84,6 +244,77 @@ namespace spades {
 			auto wr = stmp::make_unique<FTFaceWrapper>(face);
 			wr->buffer = std::move(data);
 			faces.emplace_back(std::move(wr));
+
+			StartPregeneration(*faces.back());
+		}
+
+		void FTFontSet::StartPregeneration(FTFaceWrapper& wrapper) {
+			SPADES_MARK_FUNCTION();
+
+			// Latin-1 covers the most of the text shown in the UI
+			std::vector<uint32_t> codePoints;
+			for (uint32_t c = 0x20; c < 0x7f; c++)
+				codePoints.push_back(c);
+			for (uint32_t c = 0xa0; c < 0x100; c++)
+				codePoints.push_back(c);
+
+			int numJobs = std::max(std::min(ConcurrentDispatch::GetNumWorkerThreads(), 4), 1);
+			for (int job = 0; job < numJobs; job++) {
+				std::vector<uint32_t> chunk;
+				for (std::size_t i = job; i < codePoints.size(); i += numJobs)
+					chunk.push_back(codePoints[i]);
+
+				FTFaceWrapper* wr = &wrapper;
+				auto run = [this, wr, chunk]() {
+					// FT_Face isn't thread-safe, so open another one on the same data
+					FT_Face face;
+					if (FT_New_Memory_Face(GetFreeType(),
+					                       reinterpret_cast<const FT_Byte*>(wr->buffer.data()),
+					                       wr->buffer.size(), 0, &face))
+						return;
+					FTFaceWrapper localFace(face);
+
+					for (uint32_t code : chunk) {
+						if (pregenerationCancelled)
+							break;
+
+						auto charIndex = FT_Get_Char_Index(face, code);
+						if (charIndex == 0)
+							continue;
+
+						auto key = std::make_pair(wr->face, static_cast<uint32_t>(charIndex));
+						{
+							std::lock_guard<std::mutex> lock(distanceFieldsMutex);
+							if (distanceFields.find(key) != distanceFields.end())
+								continue;
+						}
+
+						auto field = GenerateDistanceField(face, charIndex);
+
+						std::lock_guard<std::mutex> lock(distanceFieldsMutex);
+						distanceFields.emplace(key, std::move(field));
+					}
+				};
+				pregenerationJobs.emplace_back(new FunctionDispatch<decltype(run)>(run));
+				pregenerationJobs.back()->Start();
+			}
+		}
+
+		std::shared_ptr<FTDistanceField> FTFontSet::GetDistanceField(FT_Face face,
+		                                                             uint32_t charIndex) {
+			auto key = std::make_pair(face, charIndex);
+			{
+				std::lock_guard<std::mutex> lock(distanceFieldsMutex);
+				auto it = distanceFields.find(key);
+				if (it != distanceFields.end())
+					return it->second;
+			}
+
+			// not generated yet (or not pregenerated at all)
+			auto field = GenerateDistanceField(face, charIndex);
+
+			std::lock_guard<std::mutex> lock(distanceFieldsMutex);
+			return distanceFields.emplace(key, std::move(field)).first->second;
 		}
 
 		struct BinPlaceResult {
@@ -93,13 +324,14 @@ namespace spades {
 			BinPlaceResult(client::IImage& image, int x, int y) : image(image), x(x), y(y) {}
 		};
 
-		struct FTFont::Bin {
+		struct FTGlyphBin {
 			int const width, height;
 
 			Handle<client::IImage> image;
 			std::list<std::pair<int, int>> skyline;
 
-			Bin(int width, int height, client::IRenderer& r) : width(width), height(height) {
+			FTGlyphBin(int width, int height, client::IRenderer& r)
+			    : width(width), height(height) {
 				auto tmpbmp = Handle<Bitmap>::New(width, height);
 				memset(tmpbmp->GetPixels(), 0, tmpbmp->GetWidth() * tmpbmp->GetHeight() * 4);
 				image = r.CreateImage(*tmpbmp);
@@ -190,6 +422,62 @@ namespace spades {
 			}
 		};
 
+		/** Distance fields of glyphs uploaded to the textures of a renderer. */
+		class FTDistanceFieldAtlas {
+			client::IRenderer& renderer;
+			std::list<FTGlyphBin> bins;
+			std::unordered_map<const FTDistanceField*, BinPlaceResult> placements;
+
+			enum { BinSize = 1024 };
+
+		public:
+			FTDistanceFieldAtlas(client::IRenderer& renderer) : renderer(renderer) {
+				bins.emplace_back(BinSize, BinSize, renderer);
+			}
+
+			client::IRenderer& GetRenderer() const { return renderer; }
+
+			/** Uploads `field` if it isn't in the atlas yet. */
+			BinPlaceResult Place(const FTDistanceField& field) {
+				auto it = placements.find(&field);
+				if (it != placements.end())
+					return it->second;
+
+				// one texel gap between glyphs for the bilinear filtering
+				auto bmp = Handle<Bitmap>::New(field.width + 1, field.height + 1);
+				int const bmpW = bmp->GetWidth();
+				memset(bmp->GetPixels(), 0, 4 * bmpW * bmp->GetHeight());
+				for (int y = 0; y < field.height; y++) {
+					const uint8_t* inp = field.texels.data() + y * field.width;
+					uint32_t* outp = bmp->GetPixels() + y * bmpW;
+					for (int x = 0; x < field.width; x++)
+						outp[x] = (static_cast<uint32_t>(inp[x]) << 24) | 0xFFFFFF;
+				}
+
+				auto result = bins.back().Place(*bmp);
+				if (!result) { // bin full
+					bins.emplace_back(BinSize, BinSize, renderer);
+					result = bins.back().Place(*bmp);
+					SPAssert(result);
+				}
+
+				placements.emplace(&field, *result);
+				return *result;
+			}
+		};
+
+		std::shared_ptr<FTDistanceFieldAtlas> FTFontSet::GetAtlas(client::IRenderer& renderer) {
+			// the fonts sharing the atlas keep the renderer alive, so the pointer comparison
+			// is safe
+			auto result = atlas.lock();
+			if (!result || atlasRenderer != &renderer) {
+				result = std::make_shared<FTDistanceFieldAtlas>(renderer);
+				atlas = result;
+				atlasRenderer = &renderer;
+			}
+			return result;
+		}
+
 		FTFont::FTFont(client::IRenderer* renderer, std::shared_ptr<FTFontSet> _fontSet,
 					   float height, float lineHeight)
 			: client::IFont(renderer),
@@ -210,7 +498,10 @@ namespace spades {
 			baselineY = std::floor(height * 1.0F);
 			rendererIsLowQuality = dynamic_cast<draw::SWRenderer*>(renderer);
 
-			bins.emplace_back(binSize, binSize, *renderer);
+			if (renderer->SupportsImageDistanceField())
+				atlas = fontSet->GetAtlas(*renderer);
+			else
+				bins.emplace_back(binSize, binSize, *renderer);
 		}
 
 		FTFont::~FTFont() { SPADES_MARK_FUNCTION(); }
@@ -277,6 +568,7 @@ namespace spades {
 		Vector2 FTFont::Measure(const std::string& str) {
 			SPADES_MARK_FUNCTION();
 
+			// only needs the advances; doesn't render glyphs or fill the layout cache
 			float maxWidth = 0.0F;
 			float x = 0.0F;
 			int lines = 1;
@@ -299,6 +591,113 @@ namespace spades {
 			return Vector2(maxWidth, lines * lineHeight);
 		}
 
+		const client::TextLayout& FTFont::GetLayout(const std::string& str,
+		                                             LayoutVariant variant) {
+			// effects are applied at draw time with distance fields
+			if (atlas)
+				variant = LayoutNormal;
+
+			return layoutCache.Get(str, variant, 1.0F, [&](client::TextLayout& layout) {
+				float maxWidth = 0.0F;
+				float x = 0.0F;
+				float y = 0.0F;
+				int lines = 1;
+				float imageScale = atlas ? height / distanceFieldEmSize : 1.0F;
+
+				SplitTextIntoGlyphs(
+				  str,
+				  [&](Glyph& g) {
+					  stmp::optional<GlyphImage>* image;
+					  switch (variant) {
+						  case LayoutBlurred:
+							  RenderBlurGlyph(g);
+							  image = &g.blurImage;
+							  break;
+						  case LayoutOutlined:
+							  RenderOutlineGlyph(g);
+							  image = &g.outlineImage;
+							  break;
+						  default:
+							  if (atlas) {
+								  RenderDistanceFieldGlyph(g);
+								  image = &g.distanceFieldImage;
+							  } else {
+								  RenderGlyph(g);
+								  image = &g.image;
+							  }
+							  break;
+					  }
+
+					  auto& img = **image;
+					  Vector2 size(img.bounds.GetWidth(), img.bounds.GetHeight());
+					  layout.quads.push_back(
+					    {&img.img, Vector2(x, y) + img.offset, size * imageScale, img.bounds});
+
+					  x += (int)roundf(g.advance.x);
+					  y += (int)roundf(g.advance.y);
+					  maxWidth = std::max(x, maxWidth);
+				  },
+				  [&](uint32_t codepoint) {
+					  layout.fallbackGlyphs.push_back({codepoint, Vector2(x, y)});
+					  x += MeasureFallback(codepoint, height);
+					  maxWidth = std::max(x, maxWidth);
+				  },
+				  [&]() {
+					  ++lines;
+					  x = 0.0F;
+					  y += lineHeight;
+				  });
+
+				layout.size = Vector2(maxWidth, lines * lineHeight);
+			});
+		}
+
+		void FTFont::DrawLayout(const client::TextLayout& layout, LayoutVariant variant,
+		                        Vector2 offset, float scale, Vector4 color) {
+			color = Vector4(color.x * color.w, color.y * color.w, color.z * color.w, color.w);
+			renderer->SetColorAlphaPremultiplied(color);
+
+			if (atlas) {
+				// the change of the encoded distance per screen pixel
+				float pixel = distanceFieldEmSize / (height * scale * 2.0F * distanceFieldSpread);
+				float center = 0.5F;
+				float radius = 0.7F; // antialiasing
+				switch (variant) {
+					case LayoutBlurred: radius = 3.0F; break;
+					case LayoutOutlined:
+						// one pixel thick, but it can't exceed the spread
+						center = std::max(center - pixel, 0.1F);
+						break;
+					default: break;
+				}
+				client::ImageDistanceField field;
+				field.low = std::max(center - radius * pixel, 0.0F);
+				field.high = std::min(center + radius * pixel, 1.0F);
+				renderer->SetImageDistanceField(field);
+			}
+
+			for (const auto& quad : layout.quads) {
+				auto srcBounds = quad.source;
+				auto target = offset + quad.position * scale;
+				target = (target + 0.5F).Floor(); // for sharper rendering
+				AABB2 destBounds(target.x, target.y, quad.size.x * scale, quad.size.y * scale);
+
+				if (!rendererIsLowQuality && !atlas) {
+					srcBounds = srcBounds.Inflate(0.5F);
+					destBounds = destBounds.Inflate(0.5F * scale);
+				}
+
+				renderer->DrawImage(quad.image, destBounds, srcBounds);
+			}
+
+			if (atlas)
+				renderer->SetImageDistanceField({});
+
+			for (const auto& glyph : layout.fallbackGlyphs)
+				DrawFallback(glyph.codePoint, offset + glyph.position * scale, height * scale,
+				             color);
+		}
+
 		void FTFont::RenderGlyph(Glyph& g) {
 			if (g.image)
 				return;
@@ -506,134 +905,39 @@ namespace spades {
 			g.outlineImage.reset((*result).image, bounds, offs);
 		}
 
-		void FTFont::Draw(const std::string& str, Vector2 offset, float scale, Vector4 color) {
-			SPADES_MARK_FUNCTION();
-
-			auto lines = SplitIntoLines(str);
-
-			float x = 0.0F;
-			float y = 0.0F;
-
-			color = Vector4(color.x * color.w, color.y * color.w, color.z * color.w, color.w);
+		void FTFont::RenderDistanceFieldGlyph(Glyph& g) {
+			if (g.distanceFieldImage)
+				return;
 
-			renderer->SetColorAlphaPremultiplied(color);
+			auto field = fontSet->GetDistanceField(g.face, g.charIndex);
+			auto result = atlas->Place(*field);
 
-			SplitTextIntoGlyphs(
-			  str,
-			  [&](Glyph& g) {
-				  RenderGlyph(g);
+			AABB2 bounds((float)result.x, (float)result.y, (float)field->width,
+			             (float)field->height);
 
-				  auto& img = *g.image;
-				  auto srcBounds = img.bounds;
-				  auto target = offset + (Vector2(x, y) + img.offset) * scale;
-				  target = (target + 0.5F).Floor(); // for sharper rendering
-				  AABB2 destBounds(target.x, target.y, srcBounds.GetWidth() * scale,
-								   srcBounds.GetHeight() * scale);
+			float imageScale = height / distanceFieldEmSize;
+			Vector2 offs((float)field->left * imageScale,
+			             baselineY + (float)field->top * imageScale);
 
-				  if (!rendererIsLowQuality) {
-					  srcBounds = srcBounds.Inflate(0.5F);
-					  destBounds = destBounds.Inflate(0.5F * scale);
-				  }
+			g.distanceFieldImage.reset(result.image, bounds, offs);
+		}
 
-				  renderer->DrawImage(&img.img, destBounds, srcBounds);
+		void FTFont::Draw(const std::string& str, Vector2 offset, float scale, Vector4 color) {
+			SPADES_MARK_FUNCTION();
 
-				  x += (int)roundf(g.advance.x);
-				  y += (int)roundf(g.advance.y);
-			  },
-			  [&](uint32_t codepoint) {
-				  DrawFallback(codepoint, offset + Vector2(x, y) * scale, height * scale, color);
-				  x += MeasureFallback(codepoint, height);
-			  },
-			  [&]() {
-				  x = 0.0F;
-				  y += lineHeight;
-			  });
+			DrawLayout(GetLayout(str, LayoutNormal), LayoutNormal, offset, scale, color);
 		}
 
 		void FTFont::DrawBlurred(const std::string& str, Vector2 offset, float scale, Vector4 color) {
 			SPADES_MARK_FUNCTION();
 
-			auto lines = SplitIntoLines(str);
-
-			float x = 0.0F;
-			float y = 0.0F;
-
-			color = Vector4(color.x * color.w, color.y * color.w, color.z * color.w, color.w);
-			renderer->SetColorAlphaPremultiplied(color);
-
-			SplitTextIntoGlyphs(
-			  str,
-			  [&](Glyph& g) {
-				  RenderBlurGlyph(g);
-
-				  auto& img = *g.blurImage;
-				  auto srcBounds = img.bounds;
-				  auto target = offset + (Vector2(x, y) + img.offset) * scale;
-				  target = (target + 0.5F).Floor(); // for sharper rendering
-				  AABB2 destBounds(target.x, target.y, srcBounds.GetWidth() * scale,
-								   srcBounds.GetHeight() * scale);
-
-				  if (!rendererIsLowQuality) {
-					  srcBounds = srcBounds.Inflate(0.5F);
-					  destBounds = destBounds.Inflate(0.5F * scale);
-				  }
-
-				  renderer->DrawImage(&img.img, destBounds, srcBounds);
-
-				  x += (int)roundf(g.advance.x);
-				  y += (int)roundf(g.advance.y);
-			  },
-			  [&](uint32_t codepoint) {
-				  DrawFallback(codepoint, offset + Vector2(x, y) * scale, height * scale, color);
-				  x += MeasureFallback(codepoint, height);
-			  },
-			  [&]() {
-				  x = 0.0F;
-				  y += lineHeight;
-			  });
+			DrawLayout(GetLayout(str, LayoutBlurred), LayoutBlurred, offset, scale, color);
 		}
 
 		void FTFont::DrawOutlined(const std::string& str, Vector2 offset, float scale, Vector4 color) {
 			SPADES_MARK_FUNCTION();
 
-			float x = 0.0F;
-			float y = 0.0F;
-
-			color = Vector4(color.x * color.w, color.y * color.w, color.z * color.w, color.w);
-			renderer->SetColorAlphaPremultiplied(color);
-
-			SplitTextIntoGlyphs(
-				str,
-				[&](Glyph &g) {
-					RenderOutlineGlyph(g);
-
-					auto &img = *g.outlineImage;
-					auto srcBounds = img.bounds;
-					auto target = offset + (Vector2(x, y) + img.offset) * scale;
-					target = (target + 0.5F).Floor();
-					AABB2 destBounds(target.x, target.y,
-									 srcBounds.GetWidth() * scale,
-									 srcBounds.GetHeight() * scale);
-
-					if (!rendererIsLowQuality) {
-						srcBounds = srcBounds.Inflate(0.5F);
-						destBounds = destBounds.Inflate(0.5F * scale);
-					}
-
-					renderer->DrawImage(&img.img, destBounds, srcBounds);
-
-					x += (int)roundf(g.advance.x);
-					y += (int)roundf(g.advance.y);
-				},
-				[&](uint32_t codepoint) {
-					DrawFallback(codepoint, offset + Vector2(x, y) * scale, height * scale, color);
-					x += MeasureFallback(codepoint, height);
-				},
-				[&]() {
-					x = 0.0F;
-					y += lineHeight;
-				}
-			);
+			DrawLayout(GetLayout(str, LayoutOutlined), LayoutOutlined, offset, scale, color);
 		}
 
 		void FTFont::DrawShadow(const std::string& text, const Vector2& offset, float scale,
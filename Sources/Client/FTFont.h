@@ -18,11 +18,15 @@
 
  */
 
+#include <atomic>
 #include <list>
 #include <memory>
+#include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include <Client/IFont.h>
+#include <Client/TextLayoutCache.h>
 #include <Core/TMPUtils.h>
 
 struct FT_FaceRec_;
@@ -30,6 +34,7 @@ typedef struct FT_FaceRec_ *FT_Face;
 
 namespace spades {
 	class Bitmap;
+	class ConcurrentDispatch;
 }
 
 namespace spades {
@@ -41,12 +46,41 @@ namespace spades {
 namespace spades {
 	namespace ngclient {
 		struct FTFaceWrapper;
+		struct FTDistanceField;
+		struct FTGlyphBin;
+		class FTDistanceFieldAtlas;
 		class FTFont;
 
+		struct FTGlyphHash {
+			std::size_t operator()(const std::pair<FT_Face, uint32_t> &p) const {
+				return std::hash<FT_Face>()(p.first) ^ std::hash<uint32_t>()(p.second);
+			}
+		};
+
 		class FTFontSet {
 			friend class FTFont;
 			std::list<std::unique_ptr<FTFaceWrapper>> faces;
 
+			/**
+			 * Signed distance fields of glyphs, which are independent of the font size.
+			 * Filled by the background jobs started by `AddFace` and on demand.
+			 */
+			std::unordered_map<std::pair<FT_Face, uint32_t>, std::shared_ptr<FTDistanceField>,
+			                   FTGlyphHash>
+			  distanceFields;
+			std::mutex distanceFieldsMutex;
+
+			std::vector<std::unique_ptr<ConcurrentDispatch>> pregenerationJobs;
+			std::atomic<bool> pregenerationCancelled;
+
+			/** The atlas used by the fonts of the renderer `atlasRenderer`. */
+			std::weak_ptr<FTDistanceFieldAtlas> atlas;
+			client::IRenderer *atlasRenderer;
+
+			void StartPregeneration(FTFaceWrapper &);
+			std::shared_ptr<FTDistanceField> GetDistanceField(FT_Face, uint32_t charIndex);
+			std::shared_ptr<FTDistanceFieldAtlas> GetAtlas(client::IRenderer &);
+
 		public:
 			FTFontSet();
 			FTFontSet(const FTFontSet &) = delete;
@@ -59,6 +93,11 @@ namespace spades {
 		/**
 		 * FreeType2 based font renderer.
 		 *
+		 * If the renderer supports distance field images, glyphs are drawn from signed
+		 * distance fields shared by all sizes of the same `FTFontSet`, and the blur and
+		 * outline effects are applied by the renderer. Otherwise, each glyph is rasterized
+		 * for every size and effect.
+		 *
 		 * Warning: only one thread can access multiple FTFonts sharing the same FTFontSet
 		 *			at the same time.
 		 */
@@ -80,16 +119,11 @@ namespace spades {
 				stmp::optional<GlyphImage> image;
 				stmp::optional<GlyphImage> blurImage;
 				stmp::optional<GlyphImage> outlineImage;
+				stmp::optional<GlyphImage> distanceFieldImage;
 				Handle<Bitmap> bmp;
 			};
 
-			struct GlyphHash {
-				std::size_t operator()(const std::pair<FT_Face, uint32_t> &p) const {
-					return std::hash<FT_Face>()(p.first) ^ std::hash<uint32_t>()(p.second);
-				}
-			};
-
-			std::unordered_map<std::pair<FT_Face, uint32_t>, Glyph, GlyphHash> glyphs;
+			std::unordered_map<std::pair<FT_Face, uint32_t>, Glyph, FTGlyphHash> glyphs;
 			std::unordered_map<uint32_t, std::reference_wrapper<Glyph>> glyphMap;
 			float lineHeight;
 			/** em height */
@@ -100,10 +134,20 @@ namespace spades {
 
 			std::shared_ptr<FTFontSet> fontSet;
 
-			struct Bin;
-			std::list<Bin> bins;
+			enum LayoutVariant { LayoutNormal, LayoutBlurred, LayoutOutlined };
+
+			/**
+			 * Glyph positions don't depend on the drawing scale, so layouts are cached
+			 * with the scale fixed to 1 and scaled when drawn.
+			 */
+			client::TextLayoutCache layoutCache;
+
+			std::list<FTGlyphBin> bins;
 			int binSize;
 
+			/** Null if the renderer doesn't support distance field images. */
+			std::shared_ptr<FTDistanceFieldAtlas> atlas;
+
 			stmp::optional<Glyph &> GetGlyph(uint32_t code);
 			template <class T, class T2, class T3>
 			void SplitTextIntoGlyphs(const std::string &, T glyphHandler, T3 fallbackHandler,
@@ -112,6 +156,11 @@ namespace spades {
 			void RenderGlyph(Glyph &);
 			void RenderBlurGlyph(Glyph &);
 			void RenderOutlineGlyph(Glyph &);
+			void RenderDistanceFieldGlyph(Glyph &);
+
+			const client::TextLayout &GetLayout(const std::string &, LayoutVariant);
+			void DrawLayout(const client::TextLayout &, LayoutVariant, Vector2 offset, float scale,
+			                Vector4 color);
 
 		protected:
 			~FTFont();
@@ -190,6 +190,98 @@ namespace spades {
 			return ClipWorld((int)floorf(x), (int)floorf(y), (int)floorf(z));
 		}
 
+		namespace {
+			/**
+			 * Walks the voxels pierced by a line segment starting at `v0`, calling
+			 * `visit` for each of them (excluding the starting voxel) until it
+			 * returns `true`.
+			 */
+			template <class F>
+			bool WalkRay(spades::Vector3 v0, spades::Vector3 v1, float length, F visit) {
+				v1 = v0 + v1 * length;
+
+				Vector3 f, g;
+				IntVector3 a, c, d, p, i;
+				long cnt = 0;
+
+				a = v0.Floor();
+				c = v1.Floor();
+
+				if (c.x < a.x) {
+					d.x = -1;
+					f.x = v0.x - a.x;
+					g.x = (v0.x - v1.x) * 1024;
+					cnt += a.x - c.x;
+				} else if (c.x != a.x) {
+					d.x = 1;
+					f.x = a.x + 1 - v0.x;
+					g.x = (v1.x - v0.x) * 1024;
+					cnt += c.x - a.x;
+				} else {
+					d.x = 0;
+					f.x = g.x = 0.0F;
+				}
+				if (c.y < a.y) {
+					d.y = -1;
+					f.y = v0.y - a.y;
+					g.y = (v0.y - v1.y) * 1024;
+					cnt += a.y - c.y;
+				} else if (c.y != a.y) {
+					d.y = 1;
+					f.y = a.y + 1 - v0.y;
+					g.y = (v1.y - v0.y) * 1024;
+					cnt += c.y - a.y;
+				} else {
+					d.y = 0;
+					f.y = g.y = 0.0F;
+				}
+				if (c.z < a.z) {
+					d.z = -1;
+					f.z = v0.z - a.z;
+					g.z = (v0.z - v1.z) * 1024;
+					cnt += a.z - c.z;
+				} else if (c.z != a.z) {
+					d.z = 1;
+					f.z = a.z + 1 - v0.z;
+					g.z = (v1.z - v0.z) * 1024;
+					cnt += c.z - a.z;
+				} else {
+					d.z = 0;
+					f.z = g.z = 0.0F;
+				}
+
+				Vector3 pp =
+				  MakeVector3(f.x * g.z - f.z * g.x, f.y * g.z - f.z * g.y, f.y * g.x - f.x * g.y);
+				p = pp.Floor();
+				i = g.Floor();
+
+				if (cnt > (long)length)
+					cnt = (long)length;
+
+				while (cnt > 0) {
+					if (((p.x | p.y) >= 0) && (a.z != c.z)) {
+						a.z += d.z;
+						p.x -= i.x;
+						p.y -= i.y;
+					} else if ((p.z >= 0) && (a.x != c.x)) {
+						a.x += d.x;
+						p.x += i.z;
+						p.z -= i.y;
+					} else {
+						a.y += d.y;
+						p.y += i.z;
+						p.z += i.x;
+					}
+
+					if (visit(a))
+						return true;
+					cnt--;
+				}
+
+				return false;
+			}
+		} // namespace
+
 		bool GameMap::CastRay(spades::Vector3 v0, spades::Vector3 v1, float length,
 		                      spades::IntVector3& vOut) const {
 			SPADES_MARK_FUNCTION_DEBUG();
@@ -198,89 +290,27 @@ namespace spades {
 			SPAssert(!v1.IsNaN());
 			SPAssert(!std::isnan(length));
 
-			v1 = v0 + v1 * length;
-
-			Vector3 f, g;
-			IntVector3 a, c, d, p, i;
-			long cnt = 0;
-
-			a = v0.Floor();
-			c = v1.Floor();
-
-			if (c.x < a.x) {
-				d.x = -1;
-				f.x = v0.x - a.x;
-				g.x = (v0.x - v1.x) * 1024;
-				cnt += a.x - c.x;
-			} else if (c.x != a.x) {
-				d.x = 1;
-				f.x = a.x + 1 - v0.x;
-				g.x = (v1.x - v0.x) * 1024;
-				cnt += c.x - a.x;
-			} else {
-				d.x = 0;
-				f.x = g.x = 0.0F;
-			}
-			if (c.y < a.y) {
-				d.y = -1;
-				f.y = v0.y - a.y;
-				g.y = (v0.y - v1.y) * 1024;
-				cnt += a.y - c.y;
-			} else if (c.y != a.y) {
-				d.y = 1;
-				f.y = a.y + 1 - v0.y;
-				g.y = (v1.y - v0.y) * 1024;
-				cnt += c.y - a.y;
-			} else {
-				d.y = 0;
-				f.y = g.y = 0.0F;
-			}
-			if (c.z < a.z) {
-				d.z = -1;
-				f.z = v0.z - a.z;
-				g.z = (v0.z - v1.z) * 1024;
-				cnt += a.z - c.z;
-			} else if (c.z != a.z) {
-				d.z = 1;
-				f.z = a.z + 1 - v0.z;
-				g.z = (v1.z - v0.z) * 1024;
-				cnt += c.z - a.z;
-			} else {
-				d.z = 0;
-				f.z = g.z = 0.0F;
-			}
-
-			Vector3 pp =
-			  MakeVector3(f.x * g.z - f.z * g.x, f.y * g.z - f.z * g.y, f.y * g.x - f.x * g.y);
-			p = pp.Floor();
-			i = g.Floor();
-
-			if (cnt > (long)length)
-				cnt = (long)length;
-
-			while (cnt > 0) {
-				if (((p.x | p.y) >= 0) && (a.z != c.z)) {
-					a.z += d.z;
-					p.x -= i.x;
-					p.y -= i.y;
-				} else if ((p.z >= 0) && (a.x != c.x)) {
-					a.x += d.x;
-					p.x += i.z;
-					p.z -= i.y;
-				} else {
-					a.y += d.y;
-					p.y += i.z;
-					p.z += i.x;
-				}
-
+			return WalkRay(v0, v1, length, [&](const IntVector3& a) {
 				if (IsSolidWrapped(a.x, a.y, a.z)) {
 					vOut = a;
 					return true;
 				}
-				cnt--;
-			}
+				return false;
+			});
+		}
 
-			return false;
+		void GameMap::TraceRay(spades::Vector3 v0, spades::Vector3 v1, float length,
+		                       std::vector<spades::IntVector3>& cells) {
+			SPADES_MARK_FUNCTION_DEBUG();
+
+			SPAssert(!v0.IsNaN());
+			SPAssert(!v1.IsNaN());
+			SPAssert(!std::isnan(length));
+
+			WalkRay(v0, v1, length, [&](const IntVector3& a) {
+				cells.push_back(a);
+				return false;
+			});
 		}
 
 		GameMap::RayCastResult GameMap::CastRay2(spades::Vector3 v0, spades::Vector3 dir,
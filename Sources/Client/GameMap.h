@@ -25,6 +25,7 @@
 #include <functional>
 #include <list>
 #include <mutex>
+#include <vector>
 
 #include <Core/Debug.h>
 #include <Core/Math.h>
@@ -171,6 +172,13 @@ namespace spades {
 			// vanila compat
 			bool CastRay(Vector3 v0, Vector3 v1, float length, IntVector3& vOut) const;
 
+			/**
+			 * Appends the voxels `CastRay` would visit (in order, excluding the
+			 * starting one) to `cells`, regardless of the map contents.
+			 */
+			static void TraceRay(Vector3 v0, Vector3 v1, float length,
+			                     std::vector<IntVector3>& cells);
+
 			// accurate and slow ray casting
 			struct RayCastResult {
 				bool hit;
@@ -93,6 +93,7 @@ namespace spades {
 						IAudioDevice& dev = client->GetAudioDevice();
 						AudioParam param;
 						param.referenceDistance = 0.6F;
+						param.priority = 0.25F;
 						param.pitch = 0.9F + SampleRandomFloat() * 0.2F;
 						dev.Play(waterSound, lastMat.GetOrigin(), param);
 					}
@@ -136,6 +137,7 @@ namespace spades {
 								IAudioDevice& dev = client->GetAudioDevice();
 								AudioParam param;
 								param.referenceDistance = 0.6F;
+								param.priority = 0.25F;
 								dev.Play(dropSound, lastMat.GetOrigin(), param);
 							}
 							dropSound = NULL;
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <Core/Math.h>
 #include <Core/RefCountedObject.h>
 
@@ -32,11 +35,14 @@ namespace spades {
 			float volume;
 			float pitch;
 			float referenceDistance;
+			/** Relative importance of the sound when voices are scarce. */
+			float priority;
 
 			AudioParam() {
 				volume = 1.0F;
 				pitch = 1.0F;
 				referenceDistance = 1.0F;
+				priority = 1.0F;
 			}
 		};
 
@@ -53,6 +59,16 @@ namespace spades {
 			 */
 			virtual void ClearCache() {}
 
+			/**
+			 * Load the specified sounds ahead of time so that later calls to
+			 * `RegisterSound` return immediately. The implementation may decode
+			 * them in parallel.
+			 */
+			virtual void PreloadSounds(const std::vector<std::string>& names) {
+				for (const auto& name : names)
+					RegisterSound(name.c_str());
+			}
+
 			virtual void SetGameMap(GameMap*) = 0;
 
 			virtual void Play(IAudioChunk*, const Vector3& origin, const AudioParam&) = 0;
@@ -21,6 +21,8 @@
 #pragma once
 
 #include <array>
+#include <string>
+#include <vector>
 
 #include "IImage.h"
 #include "IModel.h"
@@ -95,6 +97,16 @@ namespace spades {
 			bool useLensFlare = false;
 		};
 
+		/**
+		 * Describes how `IRenderer::DrawImage` maps the alpha channel of an image storing a
+		 * distance field to the coverage. Alpha values below `low` are transparent, ones
+		 * above `high` are opaque, and ones in between are smoothly interpolated.
+		 */
+		struct ImageDistanceField {
+			float low;
+			float high;
+		};
+
 		class IRenderer : public RefCountedObject {
 		protected:
 			virtual ~IRenderer() {}
@@ -115,6 +127,20 @@ namespace spades {
 			 */
 			virtual void ClearCache() {}
 
+			/**
+			 * Load the specified images and models ahead of time so that later
+			 * calls to `RegisterImage` and `RegisterModel` return immediately.
+			 * The implementation may load them in parallel.
+			 */
+			virtual void PreloadImages(const std::vector<std::string>& filenames) {
+				for (const auto& filename : filenames)
+					RegisterImage(filename.c_str());
+			}
+			virtual void PreloadModels(const std::vector<std::string>& filenames) {
+				for (const auto& filename : filenames)
+					RegisterModel(filename.c_str());
+			}
+
 			virtual Handle<IImage> CreateImage(Bitmap&) = 0;
 			virtual Handle<IModel> CreateModel(VoxelModel&) = 0;
 
@@ -148,6 +174,14 @@ namespace spades {
 			/** Sets color for image drawing. Always alpha premultiplied. */
 			virtual void SetColorAlphaPremultiplied(Vector4) = 0;
 
+			/** @return `true` if `SetImageDistanceField` is supported. */
+			virtual bool SupportsImageDistanceField() = 0;
+			/**
+			 * Makes the following `DrawImage` calls treat the alpha channel of images as a
+			 * distance field. Pass an empty value to draw images normally again.
+			 */
+			virtual void SetImageDistanceField(stmp::optional<ImageDistanceField>) = 0;
+
 			virtual void DrawImage(stmp::optional<IImage&>, const Vector2& outTopLeft) = 0;
 			virtual void DrawImage(stmp::optional<IImage&>, const AABB2& outRect) = 0;
 			virtual void DrawImage(stmp::optional<IImage&>, const Vector2& outTopLeft,
@@ -73,12 +73,24 @@ namespace spades {
 		void Quake3Font::SetGlyphYRange(float yMin, float yMax) {
 			this->yMin = yMin;
 			this->yMax = yMax;
+			layoutCache.Clear();
 		}
 
-		Vector2 Quake3Font::Measure(const std::string& txt) {
-			SPADES_MARK_FUNCTION();
+		const TextLayout& Quake3Font::GetLayout(const std::string& txt, float scale) {
+			if (scale != 1.0F) {
+				// animated scales would fill the cache with layouts used only once
+				scratchLayout.Clear();
+				LayOut(txt, scale, scratchLayout);
+				return scratchLayout;
+			}
+			return layoutCache.Get(txt, 0, 1.0F,
+			                       [&](TextLayout& layout) { LayOut(txt, 1.0F, layout); });
+		}
+
+		void Quake3Font::LayOut(const std::string& txt, float scale, TextLayout& layout) {
+			float x = 0.f, y = 0.f, w = 0.f;
+			float invScale = 1.0F / scale;
 
-			float x = 0.f, w = 0.f, h = (float)glyphHeight;
 			for (size_t i = 0; i < txt.size();) {
 				size_t chrLen = 0;
 				uint32_t ch = GetCodePointFromUTF8String(txt, i, &chrLen);
@@ -90,7 +102,7 @@ namespace spades {
 				if (ch == 13 || ch == 10) {
 					// new line
 					x = 0.0F;
-					h += (float)glyphHeight;
+					y += (float)glyphHeight;
 					continue;
 				}
 
@@ -99,29 +111,38 @@ namespace spades {
 
 					if (info.type == Invalid)
 						goto fallback;
-					else if (info.type == Space)
+					else if (info.type == Space) {
 						x += spaceWidth;
-					else if (info.type == Image)
+					} else if (info.type == Image) {
+						const AABB2& rect = info.imageRect;
+						layout.quads.push_back({tex, MakeVector2(x, y),
+						                        MakeVector2(rect.GetWidth(), rect.GetHeight()),
+						                        rect});
 						x += info.advance;
+					}
 
 					if (x > w)
 						w = x;
 				}
-
 				continue;
 			fallback:
-				x += MeasureFallback(ch, yMax - yMin);
+				layout.fallbackGlyphs.push_back({ch, MakeVector2(x, y + yMin)});
+				x += MeasureFallback(ch, (yMax - yMin) * scale) * invScale;
 				if (x > w)
 					w = x;
 			}
 
-			return MakeVector2(w, h);
+			layout.size = MakeVector2(w, y + (float)glyphHeight);
+		}
+
+		Vector2 Quake3Font::Measure(const std::string& txt) {
+			SPADES_MARK_FUNCTION();
+
+			return GetLayout(txt, 1.0F).size;
 		}
 
 		void Quake3Font::Draw(const std::string& txt, spades::Vector2 offset, float scale,
 		                      spades::Vector4 color) {
-			float x = 0.0F, y = 0.0F;
-
 			if (scale == 1.0F)
 				offset = offset.Floor();
 
@@ -130,44 +151,17 @@ namespace spades {
 			color *= a;
 			renderer->SetColorAlphaPremultiplied(color);
 
-			float invScale = 1.0F / scale;
+			const TextLayout& layout = GetLayout(txt, scale);
 
-			for (size_t i = 0; i < txt.size();) {
-				size_t chrLen = 0;
-				uint32_t ch = GetCodePointFromUTF8String(txt, i, &chrLen);
-				SPAssert(chrLen > 0);
-				i += chrLen;
-				if (ch >= static_cast<uint32_t>(glyphs.size()))
-					goto fallback;
-
-				if (ch == 13 || ch == 10) {
-					// new line
-					x = 0.0F;
-					y += (float)glyphHeight;
-					continue;
-				}
-
-				{
-					const GlyphInfo& info = glyphs[ch];
-
-					if (info.type == Invalid)
-						goto fallback;
-					else if (info.type == Space) {
-						x += spaceWidth;
-					} else if (info.type == Image) {
-						AABB2 rt(x * scale + offset.x, y * scale + offset.y,
-						         info.imageRect.GetWidth() * scale,
-						         info.imageRect.GetHeight() * scale);
-						renderer->DrawImage(tex, rt, info.imageRect);
-						x += info.advance;
-					}
-				}
-				continue;
-			fallback:
-				DrawFallback(ch, MakeVector2(x, y + yMin) * scale + offset, (yMax - yMin) * scale,
-				             color);
-				x += MeasureFallback(ch, (yMax - yMin) * scale) * invScale;
+			for (const auto& quad : layout.quads) {
+				AABB2 rt(quad.position.x * scale + offset.x, quad.position.y * scale + offset.y,
+				         quad.size.x * scale, quad.size.y * scale);
+				renderer->DrawImage(quad.image, rt, quad.source);
 			}
+
+			for (const auto& glyph : layout.fallbackGlyphs)
+				DrawFallback(glyph.codePoint, glyph.position * scale + offset,
+				             (yMax - yMin) * scale, color);
 		}
 	} // namespace client
 } // namespace spades
\ No newline at end of file
@@ -21,6 +21,7 @@
 #pragma once
 
 #include "IFont.h"
+#include "TextLayoutCache.h"
 
 #define PROP_SPACE_WIDTH -2
 
@@ -45,6 +46,20 @@ namespace spades {
 
 			float yMin, yMax;
 
+			/** Layouts at scale 1. */
+			TextLayoutCache layoutCache;
+			/** The last layout at another scale, which isn't cached. */
+			TextLayout scratchLayout;
+
+			/**
+			 * Returns the layout at `scale`. Only the advance of fallback glyphs depends on
+			 * the scale, but that's enough to make layouts at other scales differ, and
+			 * animated scales would never hit the cache. The reference is valid until the
+			 * next call.
+			 */
+			const TextLayout& GetLayout(const std::string&, float scale);
+			void LayOut(const std::string&, float scale, TextLayout&);
+
 		protected:
 			~Quake3Font();
 
@@ -0,0 +1,146 @@
+/*
+ Copyright (c) 2019 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "ScreenshotWriter.h"
+#include <Core/Debug.h>
+#include <Core/IRunnable.h>
+#include <Core/Stopwatch.h>
+#include <Core/TMPUtils.h>
+#include <Core/Thread.h>
+
+namespace spades {
+	namespace client {
+		struct ScreenshotWriter::Worker : public IRunnable {
+			ScreenshotWriter& parent;
+
+			Worker(ScreenshotWriter& parent) : parent{parent} {}
+
+			void Run() override {
+				SPADES_MARK_FUNCTION();
+
+				std::unique_lock<std::mutex> lock{parent.mutex};
+				while (true) {
+					parent.jobAdded.wait(
+					  lock, [this] { return !parent.jobs.empty() || parent.shuttingDown; });
+					if (parent.jobs.empty())
+						break; // shutting down and drained
+
+					Job job = std::move(parent.jobs.front());
+					parent.jobs.pop_front();
+					std::size_t size = GetSize(*job.bitmap);
+
+					lock.unlock();
+					Stopwatch sw;
+					try {
+						job.bitmap->Save(job.path);
+						SPLog("Saved '%s' in %.3f seconds", job.path.c_str(), sw.GetTime());
+					} catch (const std::exception& ex) {
+						SPLog("Failed to save '%s': %s", job.path.c_str(), ex.what());
+						job.error = std::current_exception();
+					}
+					job.bitmap = Handle<Bitmap>{};
+					lock.lock();
+
+					parent.pendingBytes -= size;
+					parent.numPending--;
+					parent.completedJobs.push_back(std::move(job));
+					parent.jobDone.notify_all();
+				}
+			}
+		};
+
+		ScreenshotWriter::ScreenshotWriter(std::size_t memoryBudget)
+		    : memoryBudget{memoryBudget}, pendingBytes{0}, numPending{0}, shuttingDown{false} {
+			SPADES_MARK_FUNCTION();
+
+			workerRunnable = stmp::make_unique<Worker>(*this);
+			workerThread = stmp::make_unique<Thread>(&*workerRunnable);
+			workerThread->Start();
+		}
+
+		ScreenshotWriter::~ScreenshotWriter() {
+			SPADES_MARK_FUNCTION();
+
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				shuttingDown = true;
+			}
+			jobAdded.notify_all();
+
+			workerThread->Join();
+			workerThread.reset();
+		}
+
+		std::size_t ScreenshotWriter::GetSize(Bitmap& bitmap) {
+			return static_cast<std::size_t>(bitmap.GetWidth()) *
+			       static_cast<std::size_t>(bitmap.GetHeight()) * sizeof(uint32_t);
+		}
+
+		void ScreenshotWriter::Enqueue(Handle<Bitmap> bitmap, const std::string& path,
+		                               Callback onComplete) {
+			SPADES_MARK_FUNCTION();
+
+			std::size_t size = GetSize(*bitmap);
+
+			std::unique_lock<std::mutex> lock{mutex};
+
+			// Apply back pressure when the encoder can't keep up (e.g., during
+			// a burst). A single bitmap larger than the budget is still accepted.
+			if (pendingBytes > 0 && pendingBytes + size > memoryBudget) {
+				Stopwatch sw;
+				jobDone.wait(lock, [&] {
+					return pendingBytes == 0 || pendingBytes + size <= memoryBudget;
+				});
+				SPLog("Screenshot queue is full; waited %.3f seconds", sw.GetTime());
+			}
+
+			Job job;
+			job.bitmap = std::move(bitmap);
+			job.path = path;
+			job.onComplete = std::move(onComplete);
+			jobs.push_back(std::move(job));
+			pendingBytes += size;
+			numPending++;
+
+			lock.unlock();
+			jobAdded.notify_one();
+		}
+
+		void ScreenshotWriter::ProcessCompleted() {
+			std::vector<Job> completed;
+			{
+				std::lock_guard<std::mutex> lock{mutex};
+				if (completedJobs.empty())
+					return;
+				completed.swap(completedJobs);
+			}
+
+			for (Job& job : completed) {
+				if (job.onComplete)
+					job.onComplete(job.error);
+			}
+		}
+
+		std::size_t ScreenshotWriter::GetNumPending() {
+			std::lock_guard<std::mutex> lock{mutex};
+			return numPending;
+		}
+	} // namespace client
+} // namespace spades
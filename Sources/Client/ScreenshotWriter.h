@@ -0,0 +1,100 @@
+/*
+ Copyright (c) 2019 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <Core/Bitmap.h>
+
+namespace spades {
+	class Thread;
+	class IRunnable;
+
+	namespace client {
+		/**
+		 * Encodes and saves screenshots on a background thread so that taking
+		 * one doesn't stall the game thread.
+		 */
+		class ScreenshotWriter {
+		public:
+			/** Called on the thread calling `ProcessCompleted`. `error` is
+			 * null on success. */
+			using Callback = std::function<void(std::exception_ptr error)>;
+
+			/**
+			 * @param memoryBudget The maximum number of bytes of bitmaps waiting
+			 *                     to be encoded. `Enqueue` blocks while the
+			 *                     budget is exceeded.
+			 */
+			ScreenshotWriter(std::size_t memoryBudget);
+			/** Saves all queued bitmaps before returning. Pending callbacks
+			 * are discarded. */
+			~ScreenshotWriter();
+
+			ScreenshotWriter(const ScreenshotWriter&) = delete;
+			void operator=(const ScreenshotWriter&) = delete;
+
+			/** Queues `bitmap` to be saved as `path`. The format is chosen
+			 * by the extension as `Bitmap::Save` does. */
+			void Enqueue(Handle<Bitmap> bitmap, const std::string& path, Callback onComplete);
+
+			/** Calls the callbacks of the saved screenshots. */
+			void ProcessCompleted();
+
+			/** Returns the number of screenshots not saved yet. */
+			std::size_t GetNumPending();
+
+		private:
+			struct Worker;
+			struct Job {
+				Handle<Bitmap> bitmap;
+				std::string path;
+				Callback onComplete;
+				std::exception_ptr error;
+			};
+
+			static std::size_t GetSize(Bitmap&);
+
+			std::size_t memoryBudget;
+
+			std::mutex mutex;
+			std::condition_variable jobAdded;
+			std::condition_variable jobDone;
+			std::deque<Job> jobs;
+			std::vector<Job> completedJobs;
+			/** The number of bytes of bitmaps in `jobs` and in progress. */
+			std::size_t pendingBytes;
+			std::size_t numPending;
+			bool shuttingDown;
+
+			std::unique_ptr<IRunnable> workerRunnable;
+			std::unique_ptr<Thread> workerThread;
+		};
+	} // namespace client
+} // namespace spades
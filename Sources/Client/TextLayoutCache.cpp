@@ -0,0 +1,35 @@
+/*
+ Copyright (c) 2019 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+
+#include "TextLayoutCache.h"
+
+namespace spades {
+	namespace client {
+		TextLayoutCache::TextLayoutCache(std::size_t capacity)
+		    : capacity(std::max<std::size_t>(capacity, 1)), numHits(0), numMisses(0) {}
+
+		void TextLayoutCache::Clear() {
+			index.clear();
+			entries.clear();
+		}
+	} // namespace client
+} // namespace spades
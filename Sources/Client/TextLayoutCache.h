@@ -0,0 +1,165 @@
+/*
+ Copyright (c) 2019 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Core/Math.h>
+
+namespace spades {
+	namespace client {
+		class IImage;
+
+		/** A string laid out by a font, in the font's units relative to the origin. */
+		struct TextLayout {
+			struct Quad {
+				IImage* image;
+				/** The top-left corner of the quad. */
+				Vector2 position;
+				Vector2 size;
+				/** The glyph's rectangle in `image`. */
+				AABB2 source;
+			};
+			/** A character that's missing from the font and drawn with a fallback font. */
+			struct FallbackGlyph {
+				uint32_t codePoint;
+				Vector2 position;
+			};
+
+			std::vector<Quad> quads;
+			std::vector<FallbackGlyph> fallbackGlyphs;
+			/** The value of `IFont::Measure`. */
+			Vector2 size;
+
+			void Clear() {
+				quads.clear();
+				fallbackGlyphs.clear();
+				size = MakeVector2(0.0F, 0.0F);
+			}
+		};
+
+		/**
+		 * Keeps the layouts of recently used strings, so drawing the same text every frame
+		 * doesn't decode UTF-8 and look up every glyph again. Each font owns one.
+		 *
+		 * Layouts are keyed by the string, a font-defined variant (e.g. outlined) and the
+		 * scale. The least recently used layout is discarded when the cache is full.
+		 */
+		class TextLayoutCache {
+		public:
+			TextLayoutCache(std::size_t capacity = 1024);
+
+			/**
+			 * Returns the layout of `text`, calling `layout(TextLayout&)` to create it if
+			 * it's not cached. The returned reference is valid until the next call.
+			 */
+			template <class F>
+			const TextLayout& Get(const std::string& text, int variant, float scale, F layout) {
+				if (text.size() > maxCachedLength) {
+					// rare; don't let it evict many short strings
+					scratch.Clear();
+					layout(scratch);
+					numMisses++;
+					return scratch;
+				}
+
+				lookupKey.text = text;
+				lookupKey.variant = variant;
+				lookupKey.scale = scale;
+
+				auto it = index.find(lookupKey);
+				if (it != index.end()) {
+					entries.splice(entries.begin(), entries, it->second);
+					numHits++;
+					return it->second->second;
+				}
+
+				numMisses++;
+
+				// lay out first, so the cache is unchanged if `layout` throws
+				scratch.Clear();
+				layout(scratch);
+				Key key = lookupKey;
+
+				if (entries.size() >= capacity) {
+					auto last = std::prev(entries.end());
+					index.erase(last->first);
+					entries.splice(entries.begin(), entries, last);
+					std::swap(entries.front().first, key);
+				} else {
+					entries.emplace_front(std::move(key), TextLayout());
+				}
+				// the evicted layout's buffers are reused by the next miss
+				std::swap(entries.front().second, scratch);
+
+				try {
+					index.emplace(entries.front().first, entries.begin());
+				} catch (...) {
+					entries.pop_front();
+					throw;
+				}
+				return entries.front().second;
+			}
+
+			void Clear();
+
+			std::size_t GetNumHits() const { return numHits; }
+			std::size_t GetNumMisses() const { return numMisses; }
+
+		private:
+			struct Key {
+				std::string text;
+				int variant;
+				float scale;
+
+				bool operator==(const Key& o) const {
+					return variant == o.variant && scale == o.scale && text == o.text;
+				}
+			};
+			struct KeyHash {
+				std::size_t operator()(const Key& k) const {
+					std::size_t h = std::hash<std::string>()(k.text);
+					h ^= std::hash<float>()(k.scale) + 0x9e3779b9 + (h << 6) + (h >> 2);
+					return h ^ static_cast<std::size_t>(k.variant);
+				}
+			};
+			using EntryList = std::list<std::pair<Key, TextLayout>>;
+
+			/** Longer strings aren't cached. */
+			static constexpr std::size_t maxCachedLength = 512;
+
+			std::size_t capacity;
+			EntryList entries;
+			std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+			Key lookupKey;
+			TextLayout scratch;
+
+			std::size_t numHits;
+			std::size_t numMisses;
+		};
+	} // namespace client
+} // namespace spades
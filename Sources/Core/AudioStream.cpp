@@ -18,6 +18,7 @@
 
  */
 
+#include <memory>
 #include <tuple>
 #include <regex>
 
@@ -27,6 +28,7 @@
 #include "OpusAudioStream.h"
 #include <Core/FileManager.h>
 #include <Core/Exception.h>
+#include <Core/IStream.h>
 
 namespace spades {
 	namespace {
@@ -45,22 +47,27 @@ namespace spades {
 	}
 
 	IAudioStream *OpenAudioStream(const std::string &fileName) {
+		// open error shouldn't be handled here
+		auto stream = FileManager::OpenForReading(fileName.c_str());
+
+		// `stream` is deleted by the returned object, or on failure
+		return OpenAudioStream(stream.release(), fileName, true);
+	}
+
+	IAudioStream *OpenAudioStream(IStream *stream, const std::string &fileName,
+	                              bool autoClose) {
+		std::unique_ptr<IStream> ownedStream{autoClose ? stream : nullptr};
 		std::string errMsg;
 		for (const auto &codec: g_codecs) {
 			if (!std::regex_match(fileName, std::get<2>(codec))) {
 				continue;
 			}
 
-			// give it a try.
-			// open error shouldn't be handled here
-			auto stream = FileManager::OpenForReading(fileName.c_str());
+			// a failed attempt might have consumed some of the stream
+			stream->SetPosition(0);
 			try {
-				auto parsedStream = std::get<1>(codec)(stream.get(), true);
-
-				// The ownership of `stream` moves to `parsedStream` if the load
-				// succeeds
-				stream.release();
-
+				auto parsedStream = std::get<1>(codec)(stream, autoClose);
+				ownedStream.release();
 				return parsedStream;
 			} catch (const std::exception &ex) {
 				errMsg += std::get<0>(codec);
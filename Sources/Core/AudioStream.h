@@ -27,4 +27,12 @@ namespace spades {
 	class IAudioStream;
 
 	IAudioStream *OpenAudioStream(const std::string &fileName);
+
+	/**
+	 * Opens an audio stream that decodes `stream`, which holds the contents of
+	 * `fileName`. The codec is chosen by `fileName`. If `autoClose` is set, `stream`
+	 * is deleted with the returned object, or when this function throws.
+	 */
+	IAudioStream *OpenAudioStream(IStream *stream, const std::string &fileName,
+	                              bool autoClose);
 }
@@ -236,6 +236,14 @@ namespace spades {
 		};
 
 		std::unique_ptr<GlobalDispatchThreadPool> globalThreadPool;
+
+		GlobalDispatchThreadPool &GetGlobalThreadPool() {
+			// should we atomically initialize globalThreadPool? maybe not
+			if (!globalThreadPool) {
+				globalThreadPool.reset(new GlobalDispatchThreadPool());
+			}
+			return *globalThreadPool;
+		}
 	}
 
 	// Cannot define this in an anonymous namespace since this is referred to by
@@ -334,12 +342,8 @@ namespace spades {
 		if (entry) {
 			SPRaise("Attempted to start dispatch '%s' when it's already started", name.c_str());
 		} else {
-			// should we atomically initialize globalThreadPool? maybe not
-			if (!globalThreadPool) {
-				globalThreadPool.reset(new GlobalDispatchThreadPool());
-			}
 			entry = new SyncQueueEntry(this);
-			globalThreadPool->globalQueue.Push(entry);
+			GetGlobalThreadPool().globalQueue.Push(entry);
 		}
 	}
 
@@ -382,4 +386,8 @@ namespace spades {
 		if (runnable)
 			runnable->Run();
 	}
+
+	int ConcurrentDispatch::GetNumWorkerThreads() {
+		return static_cast<int>(GetGlobalThreadPool().threads.size());
+	}
 }
@@ -79,6 +79,9 @@ namespace spades {
 
 		void SetRunnable(IRunnable *r) { runnable = r; }
 		IRunnable *GetRunnable() const { return runnable; }
+
+		/** @return the number of threads serving dispatches started by `Start`. */
+		static int GetNumWorkerThreads();
 	};
 
 	template <class F> class FunctionDispatch : public ConcurrentDispatch {
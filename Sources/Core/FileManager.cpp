@@ -19,6 +19,7 @@
  */
 
 #include <list>
+#include <mutex>
 #include <set>
 
 #include "Debug.h"
@@ -29,8 +30,15 @@
 
 namespace spades {
 	static std::list<IFileSystem*> g_fileSystems;
+
+	// File systems (notably `ZipFileSystem`) are not thread-safe. Streams
+	// returned by `OpenForReading` are independent of each other, so only
+	// the calls to file systems have to be serialized.
+	static std::recursive_mutex g_fileSystemsMutex;
+
 	std::unique_ptr<IStream> FileManager::OpenForReading(const char* fn) {
 		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		if (!fn)
 			SPInvalidArgument("fn");
 		if (fn[0] == 0)
@@ -53,6 +61,7 @@ namespace spades {
 	}
 	std::unique_ptr<IStream> FileManager::OpenForWriting(const char* fn) {
 		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		if (!fn)
 			SPInvalidArgument("fn");
 		if (fn[0] == 0)
@@ -76,6 +85,7 @@ namespace spades {
 	}
 	bool FileManager::FileExists(const char* fn) {
 		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		if (!fn)
 			SPInvalidArgument("fn");
 
@@ -101,6 +111,7 @@ namespace spades {
 
 	void FileManager::AppendFileSystem(spades::IFileSystem* fs) {
 		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		if (!fs)
 			SPInvalidArgument("fs");
 
@@ -108,6 +119,7 @@ namespace spades {
 	}
 	void FileManager::PrependFileSystem(spades::IFileSystem* fs) {
 		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		if (!fs)
 			SPInvalidArgument("fs");
 
@@ -125,6 +137,7 @@ namespace spades {
 	}
 
 	std::vector<std::string> FileManager::EnumFiles(const char* path) {
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		std::vector<std::string> list;
 		std::set<std::string> set;
 		if (!path)
@@ -143,6 +156,7 @@ namespace spades {
 	}
 
 	void FileManager::Close() {
+		std::lock_guard<std::recursive_mutex> lock{g_fileSystemsMutex};
 		for (auto* fs : g_fileSystems)
 			delete fs;
 	}
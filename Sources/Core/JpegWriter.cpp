@@ -18,20 +18,29 @@
 
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
 #include "Bitmap.h"
 #include "Debug.h"
 #include "Exception.h"
 #include "IBitmapCodec.h"
 #include "IStream.h"
+#include "ParallelLoad.h"
 #include "jpge.h"
 #include <Core/Settings.h>
 
 // FIXME: make this changable for every calls for "Save"
 DEFINE_SPADES_SETTING(core_jpegQuality, "95");
+DEFINE_SPADES_SETTING(core_parallelImageEncoding, "1");
 
 namespace spades {
 	class JpegWriter : public IBitmapCodec {
 
+		/** The number of MCU rows in each independently encoded stripe. */
+		static constexpr int stripeMcuRows = 8;
+
 		class OutputStream : public jpge::output_stream {
 			IStream *stream;
 
@@ -49,6 +58,95 @@ namespace spades {
 			}
 		};
 
+		class BufferOutputStream : public jpge::output_stream {
+		public:
+			std::vector<uint8_t> buffer;
+
+			bool put_buf(const void *Pbuf, int len) override {
+				auto *bytes = static_cast<const uint8_t *>(Pbuf);
+				buffer.insert(buffer.end(), bytes, bytes + len);
+				return true;
+			}
+		};
+
+		/** Feeds the rows `[startY, endY)` (counted from the top) of `bmp` to `encoder`. */
+		static void EncodeRows(jpge::jpeg_encoder &encoder, Bitmap &bmp, int startY, int endY) {
+			auto *pixels = bmp.GetPixels();
+			int w = bmp.GetWidth();
+			int h = bmp.GetHeight();
+			for (jpge::uint pass = 0; pass < encoder.get_total_passes(); pass++) {
+				for (int y = startY; y < endY; y++) {
+					// Bitmap rows are stored bottom-up, and each pixel is laid out as RGBA in
+					// memory
+					if (!encoder.process_scanline(pixels + (h - 1 - y) * w)) {
+						SPRaise("JPEG encoder processing failed.");
+					}
+				}
+				if (!encoder.process_scanline(nullptr)) {
+					SPRaise("JPEG encoder processing failed.");
+				}
+			}
+		}
+
+		/**
+		 * Splits the image into stripes separated by restart markers and encodes them on
+		 * the worker threads. The output is identical to encoding the image sequentially
+		 * with the same restart interval.
+		 */
+		static void SaveParallel(IStream *stream, Bitmap *bmp, jpge::params params,
+		                         int stripeHeight, int restartInterval) {
+			SPADES_MARK_FUNCTION();
+
+			int w = bmp->GetWidth();
+			int h = bmp->GetHeight();
+			int numStripes = (h + stripeHeight - 1) / stripeHeight;
+
+			OutputStream outStream(stream);
+
+			// Write the headers (up to SOS)
+			{
+				jpge::params headerParams = params;
+				headerParams.m_restart_interval = restartInterval;
+
+				jpge::jpeg_encoder encoder;
+				if (!encoder.init(&outStream, w, h, 4, headerParams)) {
+					SPRaise("JPEG encoder initialization failed.");
+				}
+			}
+
+			params.m_entropy_coded_data_only_flag = true;
+
+			ParallelLoad<std::vector<uint8_t>>(
+			  static_cast<std::size_t>(numStripes),
+			  [&](std::size_t i) {
+				  int startY = static_cast<int>(i) * stripeHeight;
+				  int endY = std::min(startY + stripeHeight, h);
+
+				  BufferOutputStream segment;
+				  jpge::jpeg_encoder encoder;
+				  if (!encoder.init(&segment, w, endY - startY, 4, params)) {
+					  SPRaise("JPEG encoder initialization failed.");
+				  }
+				  EncodeRows(encoder, *bmp, startY, endY);
+				  encoder.deinit();
+				  return std::move(segment.buffer);
+			  },
+			  [&](std::size_t i, std::vector<uint8_t> segment) {
+				  if (segment.empty()) {
+					  SPRaise("JPEG encoder processing failed.");
+				  }
+				  if (i > 0) {
+					  uint8_t marker[2] = {0xff, static_cast<uint8_t>(0xd0 + ((i - 1) & 7))};
+					  stream->Write(marker, 2);
+				  }
+				  stream->Write(segment.data(), segment.size());
+			  });
+
+			// EOI
+			uint8_t marker[2] = {0xff, 0xd9};
+			stream->Write(marker, 2);
+		}
+
 	public:
 		bool CanLoad() override { return false; }
 		bool CanSave() override { return true; }
@@ -77,35 +175,24 @@ namespace spades {
 				SPRaise("Invalid core_jpegQuality");
 			}
 
+			// The default (H2V2) subsampling uses 16x16 MCUs
+			const int mcuSize = 16;
+			int stripeHeight = mcuSize * stripeMcuRows;
+			int restartInterval = (bmp->GetWidth() + mcuSize - 1) / mcuSize * stripeMcuRows;
+			if (core_parallelImageEncoding && !params.m_two_pass_flag &&
+			    bmp->GetHeight() > stripeHeight && restartInterval <= 0xffff) {
+				SaveParallel(stream, bmp, params, stripeHeight, restartInterval);
+				return;
+			}
+
 			OutputStream outStream(stream);
 			jpge::jpeg_encoder encoder;
 
-			if (!encoder.init(&outStream, bmp->GetWidth(), bmp->GetHeight(), 3, params)) {
+			if (!encoder.init(&outStream, bmp->GetWidth(), bmp->GetHeight(), 4, params)) {
 				SPRaise("JPEG encoder initialization failed.");
 			}
 
-			auto *pixels = bmp->GetPixels();
-			std::vector<uint8_t> lineBuffer;
-			int w = bmp->GetWidth();
-			int h = bmp->GetHeight();
-			lineBuffer.resize(w * 3);
-			for (jpge::uint pass = 0; pass < encoder.get_total_passes(); pass++) {
-				for (int y = 0; y < h; y++) {
-					auto *pix = pixels + (h - 1 - y) * w;
-					for (auto *out = lineBuffer.data(), *end = out + w * 3; out != end;) {
-						auto p = *(pix++);
-						*(out++) = static_cast<uint8_t>(p);
-						*(out++) = static_cast<uint8_t>(p >> 8);
-						*(out++) = static_cast<uint8_t>(p >> 16);
-					}
-					if (!encoder.process_scanline(lineBuffer.data())) {
-						SPRaise("JPEG encoder processing failed.");
-					}
-				}
-				if (!encoder.process_scanline(nullptr)) {
-					SPRaise("JPEG encoder processing failed.");
-				}
-			}
+			EncodeRows(encoder, *bmp, 0, bmp->GetHeight());
 
 			encoder.deinit();
 		}
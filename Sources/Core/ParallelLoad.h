@@ -0,0 +1,96 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "ConcurrentDispatch.h"
+#include "Debug.h"
+
+namespace spades {
+	/**
+	 * Runs `load(i)` for every `i` in `[0, count)` on the worker threads and
+	 * passes each result to `consume(i, result)` on the calling thread in
+	 * index order, as soon as it becomes available.
+	 *
+	 * This lets the calling thread (e.g., the one owning the GL context)
+	 * upload earlier items while later ones are still being loaded. If `load`
+	 * throws, the error is logged and a default-constructed `T` is passed to
+	 * `consume` instead.
+	 */
+	template <class T, class Load, class Consume>
+	void ParallelLoad(std::size_t count, Load load, Consume consume) {
+		if (count == 0)
+			return;
+
+		std::vector<T> results(count);
+		std::vector<char> ready(count, 0);
+		std::atomic<std::size_t> next{0};
+		std::mutex mutex;
+		std::condition_variable cond;
+
+		auto worker = [&]() {
+			while (true) {
+				std::size_t i = next.fetch_add(1);
+				if (i >= count)
+					break;
+
+				T result{};
+				try {
+					result = load(i);
+				} catch (const std::exception& ex) {
+					SPLog("Failed to load an item in background: %s", ex.what());
+				}
+
+				{
+					std::lock_guard<std::mutex> lock{mutex};
+					results[i] = std::move(result);
+					ready[i] = 1;
+				}
+				cond.notify_all();
+			}
+		};
+
+		// declared after the shared state so that workers are joined first
+		std::vector<std::unique_ptr<ConcurrentDispatch>> dispatches;
+		int numThreads = std::max(
+		  std::min(ConcurrentDispatch::GetNumWorkerThreads(), static_cast<int>(count)), 1);
+		for (int i = 0; i < numThreads; i++) {
+			dispatches.emplace_back(new FunctionDispatch<decltype(worker)>(worker));
+			dispatches.back()->Start();
+		}
+
+		for (std::size_t i = 0; i < count; i++) {
+			T result;
+			{
+				std::unique_lock<std::mutex> lock{mutex};
+				cond.wait(lock, [&] { return ready[i] != 0; });
+				result = std::move(results[i]);
+			}
+			consume(i, std::move(result));
+		}
+	}
+} // namespace spades
@@ -18,28 +18,258 @@
 
  */
 
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
 #include <cstring>
+#include <vector>
+
+#include <zlib.h>
 
 #include "Bitmap.h"
+#include "Debug.h"
+#include "Exception.h"
 #include "IBitmapCodec.h"
 #include "IStream.h"
+#include "ParallelLoad.h"
+#include <Core/Settings.h>
 
-#include "pnglite.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENABLE_SSE2 1
+#include <emmintrin.h>
+#else
+#define ENABLE_SSE2 0
+#endif
 
-namespace {
-	unsigned WriteCallback(void* input, std::size_t size, std::size_t numel, void* user_ptr) {
-		auto stream = static_cast<spades::IStream*>(user_ptr);
-		stream->Write(input, size * numel);
-		return static_cast<unsigned>(size * numel);
-	}
-} // namespace
+SPADES_SETTING(core_parallelImageEncoding);
 
 namespace spades {
+	namespace {
+		enum { BytesPerPixel = 4 };
+
+		enum class PngFilter : std::uint8_t { None = 0, Sub = 1, Up = 2, Average = 3 };
+
+		/**
+		 * Applies a PNG filter to a row. `prev` is the unfiltered previous row (all zero for
+		 * the first row of the image).
+		 */
+		template <PngFilter filter>
+		void FilterRow(const std::uint8_t* cur, const std::uint8_t* prev, std::uint8_t* out,
+		               std::size_t len) {
+			std::size_t i = 0;
+
+			// The first pixel doesn't have a left neighbor
+			for (; i < BytesPerPixel; i++) {
+				switch (filter) {
+					case PngFilter::None: out[i] = cur[i]; break;
+					case PngFilter::Sub: out[i] = cur[i]; break;
+					case PngFilter::Up: out[i] = cur[i] - prev[i]; break;
+					case PngFilter::Average: out[i] = cur[i] - (prev[i] >> 1); break;
+				}
+			}
+
+#if ENABLE_SSE2
+			for (; i + 16 <= len; i += 16) {
+				__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i));
+				__m128i a =
+				  _mm_loadu_si128(reinterpret_cast<const __m128i*>(cur + i - BytesPerPixel));
+				__m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(prev + i));
+				__m128i result;
+				switch (filter) {
+					case PngFilter::None: result = c; break;
+					case PngFilter::Sub: result = _mm_sub_epi8(c, a); break;
+					case PngFilter::Up: result = _mm_sub_epi8(c, b); break;
+					case PngFilter::Average: {
+						// `_mm_avg_epu8` rounds up, but PNG needs floor((a + b) / 2)
+						__m128i avg = _mm_avg_epu8(a, b);
+						avg = _mm_sub_epi8(
+						  avg, _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+						result = _mm_sub_epi8(c, avg);
+						break;
+					}
+				}
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), result);
+			}
+#endif
+
+			for (; i < len; i++) {
+				unsigned a = cur[i - BytesPerPixel], b = prev[i];
+				switch (filter) {
+					case PngFilter::None: out[i] = cur[i]; break;
+					case PngFilter::Sub: out[i] = static_cast<std::uint8_t>(cur[i] - a); break;
+					case PngFilter::Up: out[i] = static_cast<std::uint8_t>(cur[i] - b); break;
+					case PngFilter::Average:
+						out[i] = static_cast<std::uint8_t>(cur[i] - ((a + b) >> 1));
+						break;
+				}
+			}
+		}
+
+		/**
+		 * Returns the sum of the absolute values of the filtered bytes interpreted as signed
+		 * integers. This is the heuristic recommended by the PNG specification for choosing
+		 * a filter.
+		 */
+		std::uint64_t FilterCost(const std::uint8_t* data, std::size_t len) {
+			std::uint64_t sum = 0;
+			std::size_t i = 0;
+
+#if ENABLE_SSE2
+			__m128i zero = _mm_setzero_si128();
+			__m128i sums = zero;
+			for (; i + 16 <= len; i += 16) {
+				__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+				// |x| for signed bytes, which fits in an unsigned byte
+				__m128i absX = _mm_min_epu8(x, _mm_sub_epi8(zero, x));
+				sums = _mm_add_epi64(sums, _mm_sad_epu8(absX, zero));
+			}
+			std::uint64_t partialSums[2];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(partialSums), sums);
+			sum = partialSums[0] + partialSums[1];
+#endif
+
+			for (; i < len; i++) {
+				sum += static_cast<std::uint64_t>(std::abs(static_cast<std::int8_t>(data[i])));
+			}
+			return sum;
+		}
+
+		/** An independently compressed horizontal stripe of the image. */
+		struct Stripe {
+			/** Raw deflate data ending at a byte boundary. */
+			std::vector<std::uint8_t> data;
+			/** Adler-32 checksum and length of the uncompressed (filtered) data. */
+			uLong adler;
+			std::size_t length;
+		};
+
+		/**
+		 * Filters and compresses the rows `[startY, endY)` (counted from the top).
+		 *
+		 * Every stripe except the last one ends with a sync flush instead of a final block,
+		 * so the raw deflate streams of consecutive stripes can simply be concatenated.
+		 */
+		Stripe EncodeStripe(Bitmap& bmp, int startY, int endY, bool last) {
+			SPADES_MARK_FUNCTION();
+
+			int w = bmp.GetWidth();
+			int h = bmp.GetHeight();
+			std::size_t rowLength = static_cast<std::size_t>(w) * BytesPerPixel;
+			const std::uint8_t* pixels = reinterpret_cast<const std::uint8_t*>(bmp.GetPixels());
+
+			// Bitmap rows are stored bottom-up
+			auto getRow = [&](int y) {
+				return pixels + static_cast<std::size_t>(h - 1 - y) * rowLength;
+			};
+
+			std::vector<std::uint8_t> zeroRow(rowLength, 0);
+			std::vector<std::uint8_t> candidates[4];
+			for (auto& candidate : candidates) {
+				candidate.resize(rowLength);
+			}
+
+			std::vector<std::uint8_t> filtered;
+			filtered.reserve((rowLength + 1) * static_cast<std::size_t>(endY - startY));
+
+			for (int y = startY; y < endY; y++) {
+				const std::uint8_t* cur = getRow(y);
+				const std::uint8_t* prev = y > 0 ? getRow(y - 1) : zeroRow.data();
+
+				FilterRow<PngFilter::None>(cur, prev, candidates[0].data(), rowLength);
+				FilterRow<PngFilter::Sub>(cur, prev, candidates[1].data(), rowLength);
+				FilterRow<PngFilter::Up>(cur, prev, candidates[2].data(), rowLength);
+				FilterRow<PngFilter::Average>(cur, prev, candidates[3].data(), rowLength);
+
+				int best = 0;
+				std::uint64_t bestCost = FilterCost(candidates[0].data(), rowLength);
+				for (int i = 1; i < 4; i++) {
+					std::uint64_t cost = FilterCost(candidates[i].data(), rowLength);
+					if (cost < bestCost) {
+						best = i;
+						bestCost = cost;
+					}
+				}
+
+				filtered.push_back(static_cast<std::uint8_t>(best));
+				filtered.insert(filtered.end(), candidates[best].begin(), candidates[best].end());
+			}
+
+			Stripe stripe;
+			stripe.length = filtered.size();
+			stripe.adler = adler32(adler32(0L, Z_NULL, 0), filtered.data(),
+			                       static_cast<uInt>(filtered.size()));
+
+			z_stream zs;
+			std::memset(&zs, 0, sizeof(zs));
+			if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+			                 Z_DEFAULT_STRATEGY) != Z_OK) {
+				SPRaise("deflateInit2 failed.");
+			}
+
+			stripe.data.resize(deflateBound(&zs, static_cast<uLong>(filtered.size())) + 16);
+			zs.next_in = filtered.data();
+			zs.avail_in = static_cast<uInt>(filtered.size());
+			int flush = last ? Z_FINISH : Z_SYNC_FLUSH;
+			while (true) {
+				zs.next_out = stripe.data.data() + zs.total_out;
+				zs.avail_out = static_cast<uInt>(stripe.data.size() - zs.total_out);
+
+				int ret = deflate(&zs, flush);
+				if (ret == Z_STREAM_ERROR) {
+					deflateEnd(&zs);
+					SPRaise("deflate failed.");
+				}
+				if (zs.avail_out != 0 && zs.avail_in == 0) {
+					// Everything is flushed
+					break;
+				}
+				stripe.data.resize(stripe.data.size() * 2);
+			}
+			stripe.data.resize(zs.total_out);
+			deflateEnd(&zs);
+
+			return stripe;
+		}
+
+		class ChunkWriter {
+			IStream& stream;
+			uLong crc;
+
+		public:
+			ChunkWriter(IStream& stream, const char* type, std::size_t length)
+			    : stream(stream) {
+				std::uint8_t lengthBytes[4];
+				WriteBE(lengthBytes, static_cast<std::uint32_t>(length));
+				stream.Write(lengthBytes, 4);
+				crc = crc32(0L, Z_NULL, 0);
+				Write(type, 4);
+			}
+
+			void Write(const void* data, std::size_t length) {
+				stream.Write(data, length);
+				crc = crc32(crc, static_cast<const Bytef*>(data), static_cast<uInt>(length));
+			}
+
+			void End() {
+				std::uint8_t crcBytes[4];
+				WriteBE(crcBytes, static_cast<std::uint32_t>(crc));
+				stream.Write(crcBytes, 4);
+			}
+
+			static void WriteBE(std::uint8_t* out, std::uint32_t value) {
+				out[0] = static_cast<std::uint8_t>(value >> 24);
+				out[1] = static_cast<std::uint8_t>(value >> 16);
+				out[2] = static_cast<std::uint8_t>(value >> 8);
+				out[3] = static_cast<std::uint8_t>(value);
+			}
+		};
+	} // namespace
+
 	class PngWriter : public IBitmapCodec {
-	public:
-		PngWriter() : IBitmapCodec() { png_init(nullptr, nullptr); }
+		/** The number of rows in each independently compressed stripe. */
+		static constexpr int stripeHeight = 128;
 
+	public:
 		bool CanLoad() override { return false; }
 		bool CanSave() override { return true; }
 
@@ -48,7 +278,7 @@ namespace spades {
 		}
 
 		std::string GetName() override {
-			static std::string name("libpng exporter");
+			static std::string name("PNG exporter");
 			return name;
 		}
 
@@ -61,30 +291,80 @@ namespace spades {
 		void Save(IStream* stream, Bitmap* bmp) override {
 			SPADES_MARK_FUNCTION();
 
-			int err;
+			int w = bmp->GetWidth();
+			int h = bmp->GetHeight();
 
-			png_t png_s;
-			if ((err = png_open_write(&png_s, &WriteCallback, stream)))
-				SPRaise("Error while png_open_write: %s", png_error_string(err));
+			static const std::uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+			stream->Write(signature, 8);
 
-			// Create flipped buffer
-			std::vector<std::uint8_t> buf(bmp->GetWidth() * bmp->GetHeight() * 4);
 			{
-				std::uint32_t* pixels = bmp->GetPixels();
-				auto width = bmp->GetWidth();
-				auto rowLengthBytes = width * sizeof(std::uint8_t) * 4;
+				std::uint8_t ihdr[13];
+				ChunkWriter::WriteBE(ihdr, static_cast<std::uint32_t>(w));
+				ChunkWriter::WriteBE(ihdr + 4, static_cast<std::uint32_t>(h));
+				ihdr[8] = 8;  // bit depth
+				ihdr[9] = 6;  // color type: truecolor with alpha
+				ihdr[10] = 0; // compression method: deflate
+				ihdr[11] = 0; // filter method: adaptive
+				ihdr[12] = 0; // interlace method: none
+
+				ChunkWriter chunk{*stream, "IHDR", sizeof(ihdr)};
+				chunk.Write(ihdr, sizeof(ihdr));
+				chunk.End();
+			}
+
+			// Each stripe is written as a separate IDAT chunk. The zlib header and the Adler-32
+			// checksum of the whole stream are attached to the first and the last one.
+			int numStripes = 1;
+			if (core_parallelImageEncoding) {
+				numStripes = std::max((h + stripeHeight - 1) / stripeHeight, 1);
+			}
+			uLong adler = adler32(0L, Z_NULL, 0);
 
-				for (long y = bmp->GetHeight() - 1; y >= 0; --y) {
-					std::memcpy(&buf[y * rowLengthBytes], pixels, rowLengthBytes);
-					pixels += width;
+			auto writeStripe = [&](std::size_t i, Stripe stripe) {
+				if (stripe.data.empty()) {
+					SPRaise("Failed to compress the PNG image data.");
 				}
+
+				bool first = i == 0;
+				bool last = i == static_cast<std::size_t>(numStripes) - 1;
+				adler = adler32_combine(adler, stripe.adler, static_cast<z_off_t>(stripe.length));
+
+				static const std::uint8_t zlibHeader[2] = {0x78, 0x9c};
+				std::uint8_t zlibTrailer[4];
+				ChunkWriter::WriteBE(zlibTrailer, static_cast<std::uint32_t>(adler));
+
+				ChunkWriter chunk{*stream, "IDAT",
+				                  stripe.data.size() + (first ? 2 : 0) + (last ? 4 : 0)};
+				if (first) {
+					chunk.Write(zlibHeader, 2);
+				}
+				chunk.Write(stripe.data.data(), stripe.data.size());
+				if (last) {
+					chunk.Write(zlibTrailer, 4);
+				}
+				chunk.End();
+			};
+
+			if (numStripes == 1) {
+				writeStripe(0, EncodeStripe(*bmp, 0, h, true));
+			} else {
+				ParallelLoad<Stripe>(
+				  static_cast<std::size_t>(numStripes),
+				  [&](std::size_t i) {
+					  int startY = static_cast<int>(i) * stripeHeight;
+					  int endY = std::min(startY + stripeHeight, h);
+					  return EncodeStripe(*bmp, startY, endY,
+					                      i == static_cast<std::size_t>(numStripes) - 1);
+				  },
+				  writeStripe);
 			}
-			if ((err = png_set_data(&png_s, bmp->GetWidth(), bmp->GetHeight(), 8,
-			                        PNG_TRUECOLOR_ALPHA, buf.data()))) {
-				SPRaise("Error while png_set_data: %s", png_error_string(err));
+
+			{
+				ChunkWriter chunk{*stream, "IEND", 0};
+				chunk.End();
 			}
 		}
 	};
 
 	static PngWriter sharedCodec;
-} // namespace spades
\ No newline at end of file
+} // namespace spades
@@ -19,6 +19,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JPGE_USE_SSE2 1
+#include <emmintrin.h>
+#else
+#define JPGE_USE_SSE2 0
+#endif
+
 #define JPGE_MAX(a, b) (((a) > (b)) ? (a) : (b))
 #define JPGE_MIN(a, b) (((a) < (b)) ? (a) : (b))
 
@@ -35,6 +42,8 @@ namespace jpge {
 		M_EOI = 0xD9,
 		M_SOS = 0xDA,
 		M_DQT = 0xDB,
+		M_DRI = 0xDD,
+		M_RST0 = 0xD0,
 		M_APP0 = 0xE0
 	};
 	enum {
@@ -125,6 +134,78 @@ namespace jpge {
 		}
 	}
 
+	static void RGBA_to_Y(uint8* pDst, const uint8* pSrc, int num_pixels) {
+		for (; num_pixels; pDst++, pSrc += 4, num_pixels--) {
+			pDst[0] =
+			  static_cast<uint8>((pSrc[0] * YR + pSrc[1] * YG + pSrc[2] * YB + 32768) >> 16);
+		}
+	}
+
+	// Same as RGB_to_YCC, but takes RGBA pixels. Produces the exact same results as the scalar
+	// path when vectorized.
+	static void RGBA_to_YCC(uint8* pDst, const uint8* pSrc, int num_pixels) {
+#if JPGE_USE_SSE2
+		// _mm_madd_epi16 only takes signed 16-bit coefficients, so the coefficients that don't
+		// fit (YG = 32768 + 5702, CB_B = CR_R = 32768) are split into a multiply-add and a
+		// shift.
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i yCoefs = _mm_setr_epi16(YR, YG - 32768, YB, 0, YR, YG - 32768, YB, 0);
+		const __m128i cbCoefs = _mm_setr_epi16(CB_R, CB_G, 0, 0, CB_R, CB_G, 0, 0);
+		const __m128i crCoefs = _mm_setr_epi16(0, CR_G, CR_B, 0, 0, CR_G, CR_B, 0);
+		const __m128i byteMask = _mm_set1_epi32(0xFF);
+		const __m128i rounding = _mm_set1_epi32(32768);
+		const __m128i chromaOffset = _mm_set1_epi32(128);
+
+		// Sums the adjacent pairs of `_mm_madd_epi16` outputs for the pixels 0-1 and 2-3.
+		auto hadd = [](__m128i a, __m128i b) {
+			__m128 fa = _mm_castsi128_ps(a), fb = _mm_castsi128_ps(b);
+			__m128i even = _mm_castps_si128(_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i odd = _mm_castps_si128(_mm_shuffle_ps(fa, fb, _MM_SHUFFLE(3, 1, 3, 1)));
+			return _mm_add_epi32(even, odd);
+		};
+
+		for (; num_pixels >= 4; pDst += 12, pSrc += 16, num_pixels -= 4) {
+			__m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc));
+			__m128i lo = _mm_unpacklo_epi8(pixels, zero);
+			__m128i hi = _mm_unpackhi_epi8(pixels, zero);
+			__m128i r = _mm_and_si128(pixels, byteMask);
+			__m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 8), byteMask);
+			__m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 16), byteMask);
+
+			__m128i y = hadd(_mm_madd_epi16(lo, yCoefs), _mm_madd_epi16(hi, yCoefs));
+			y = _mm_add_epi32(y, _mm_slli_epi32(g, 15));
+			y = _mm_srai_epi32(_mm_add_epi32(y, rounding), 16);
+
+			__m128i cb = hadd(_mm_madd_epi16(lo, cbCoefs), _mm_madd_epi16(hi, cbCoefs));
+			cb = _mm_add_epi32(cb, _mm_slli_epi32(b, 15));
+			cb = _mm_srai_epi32(_mm_add_epi32(cb, rounding), 16);
+			cb = _mm_add_epi32(cb, chromaOffset);
+
+			__m128i cr = hadd(_mm_madd_epi16(lo, crCoefs), _mm_madd_epi16(hi, crCoefs));
+			cr = _mm_add_epi32(cr, _mm_slli_epi32(r, 15));
+			cr = _mm_srai_epi32(_mm_add_epi32(cr, rounding), 16);
+			cr = _mm_add_epi32(cr, chromaOffset);
+
+			// Saturating packs do the clamping
+			__m128i packed =
+			  _mm_packus_epi16(_mm_packs_epi32(y, cb), _mm_packs_epi32(cr, zero));
+			uint8 planar[16];
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(planar), packed);
+			for (int i = 0; i < 4; i++) {
+				pDst[i * 3 + 0] = planar[i];
+				pDst[i * 3 + 1] = planar[i + 4];
+				pDst[i * 3 + 2] = planar[i + 8];
+			}
+		}
+#endif
+		for (; num_pixels; pDst += 3, pSrc += 4, num_pixels--) {
+			const int r = pSrc[0], g = pSrc[1], b = pSrc[2];
+			pDst[0] = static_cast<uint8>((r * YR + g * YG + b * YB + 32768) >> 16);
+			pDst[1] = clamp(128 + ((r * CB_R + g * CB_G + b * CB_B + 32768) >> 16));
+			pDst[2] = clamp(128 + ((r * CR_R + g * CR_G + b * CR_B + 32768) >> 16));
+		}
+	}
+
 	static void Y_to_YCC(uint8* pDst, const uint8* pSrc, int num_pixels) {
 		for (; num_pixels; pDst += 3, pSrc++, num_pixels--) {
 			pDst[0] = pSrc[0];
@@ -453,13 +534,24 @@ namespace jpge {
 		emit_byte(0);
 	}
 
+	// Emit define restart interval
+	void jpeg_encoder::emit_dri() {
+		emit_marker(M_DRI);
+		emit_word(4);
+		emit_word(static_cast<uint>(m_params.m_restart_interval));
+	}
+
 	// Emit all markers at beginning of image file.
 	void jpeg_encoder::emit_markers() {
+		if (m_params.m_entropy_coded_data_only_flag)
+			return;
 		emit_marker(M_SOI);
 		emit_jfif_app0();
 		emit_dqt();
 		emit_sof();
 		emit_dhts();
+		if (m_params.m_restart_interval)
+			emit_dri();
 		emit_sos();
 	}
 
@@ -520,6 +612,8 @@ namespace jpge {
 		memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
 		m_mcu_y_ofs = 0;
 		m_pass_num = 1;
+		m_mcus_to_restart = static_cast<uint>(m_params.m_restart_interval);
+		m_next_restart_num = 0;
 	}
 
 	bool jpeg_encoder::second_pass_init() {
@@ -749,6 +843,29 @@ namespace jpge {
 		}
 	}
 
+	// Terminates the current restart interval and resets the DC predictors.
+	void jpeg_encoder::emit_restart() {
+		if (m_pass_num == 2) {
+			put_bits(0x7F, 7); // pad to a byte boundary with 1-bits
+			m_bit_buffer = 0;
+			m_bits_in = 0;
+			JPGE_PUT_BYTE(0xFF);
+			JPGE_PUT_BYTE(static_cast<uint8>(M_RST0 + m_next_restart_num));
+			m_next_restart_num = (m_next_restart_num + 1) & 7;
+		}
+		memset(m_last_dc_val, 0, 3 * sizeof(m_last_dc_val[0]));
+	}
+
+	void jpeg_encoder::begin_mcu() {
+		if (!m_params.m_restart_interval)
+			return;
+		if (m_mcus_to_restart == 0) {
+			emit_restart();
+			m_mcus_to_restart = static_cast<uint>(m_params.m_restart_interval);
+		}
+		m_mcus_to_restart--;
+	}
+
 	void jpeg_encoder::code_coefficients_pass_one(int component_num) {
 		if (component_num >= 3)
 			return; // just to shut up static analysis
@@ -863,11 +980,13 @@ namespace jpge {
 	void jpeg_encoder::process_mcu_row() {
 		if (m_num_components == 1) {
 			for (int i = 0; i < m_mcus_per_row; i++) {
+				begin_mcu();
 				load_block_8_8_grey(i);
 				code_block(0);
 			}
 		} else if ((m_comp_h_samp[0] == 1) && (m_comp_v_samp[0] == 1)) {
 			for (int i = 0; i < m_mcus_per_row; i++) {
+				begin_mcu();
 				load_block_8_8(i, 0, 0);
 				code_block(0);
 				load_block_8_8(i, 0, 1);
@@ -877,6 +996,7 @@ namespace jpge {
 			}
 		} else if ((m_comp_h_samp[0] == 2) && (m_comp_v_samp[0] == 1)) {
 			for (int i = 0; i < m_mcus_per_row; i++) {
+				begin_mcu();
 				load_block_8_8(i * 2 + 0, 0, 0);
 				code_block(0);
 				load_block_8_8(i * 2 + 1, 0, 0);
@@ -888,6 +1008,7 @@ namespace jpge {
 			}
 		} else if ((m_comp_h_samp[0] == 2) && (m_comp_v_samp[0] == 2)) {
 			for (int i = 0; i < m_mcus_per_row; i++) {
+				begin_mcu();
 				load_block_8_8(i * 2 + 0, 0, 0);
 				code_block(0);
 				load_block_8_8(i * 2 + 1, 0, 0);
@@ -917,7 +1038,8 @@ namespace jpge {
 	bool jpeg_encoder::terminate_pass_two() {
 		put_bits(0x7F, 7);
 		flush_output_buffer();
-		emit_marker(M_EOI);
+		if (!m_params.m_entropy_coded_data_only_flag)
+			emit_marker(M_EOI);
 		m_pass_num++; // purposely bump up m_pass_num, for debugging
 		return true;
 	}
@@ -945,12 +1067,16 @@ namespace jpge {
 		uint8* pDst = m_mcu_lines[m_mcu_y_ofs]; // OK to write up to m_image_bpl_xlt bytes to pDst
 
 		 if (m_num_components == 1) {
-			if (m_image_bpp == 3)
+			if (m_image_bpp == 4)
+				RGBA_to_Y(pDst, Psrc, m_image_x);
+			else if (m_image_bpp == 3)
 				RGB_to_Y(pDst, Psrc, m_image_x);
 			else
 				memcpy(pDst, Psrc, m_image_x);
 		} else {
-			if (m_image_bpp == 3)
+			if (m_image_bpp == 4)
+				RGBA_to_YCC(pDst, Psrc, m_image_x);
+			else if (m_image_bpp == 3)
 				RGB_to_YCC(pDst, Psrc, m_image_x);
 			else
 				Y_to_YCC(pDst, Psrc, m_image_x);
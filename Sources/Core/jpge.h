@@ -22,13 +22,20 @@ namespace jpge {
 		    : m_quality(85),
 		      m_subsampling(H2V2),
 		      m_no_chroma_discrim_flag(false),
-		      m_two_pass_flag(false) {}
+		      m_two_pass_flag(false),
+		      m_restart_interval(0),
+		      m_entropy_coded_data_only_flag(false) {}
 
 		inline bool check() const {
 			if ((m_quality < 1) || (m_quality > 100))
 				return false;
 			if ((uint)m_subsampling > (uint)H2V2)
 				return false;
+			if ((m_restart_interval < 0) || (m_restart_interval > 0xFFFF))
+				return false;
+			// Huffman tables optimized for a part of the image can't be shared
+			if (m_entropy_coded_data_only_flag && m_two_pass_flag)
+				return false;
 			return true;
 		}
 
@@ -47,6 +54,15 @@ namespace jpge {
 		bool m_no_chroma_discrim_flag;
 
 		bool m_two_pass_flag;
+
+		// The number of MCUs between restart markers. 0 disables restart markers.
+		int m_restart_interval;
+
+		// If true, only the entropy-coded data is written (no markers, no padding to a
+		// restart marker). The output of several encoders can then be joined with RSTn
+		// markers to form a single scan, which allows encoding the restart intervals of an
+		// image in parallel. Requires single pass mode.
+		bool m_entropy_coded_data_only_flag;
 	};
 
 	// Writes JPEG image to a file.
@@ -80,11 +96,13 @@ namespace jpge {
 		jpeg_encoder();
 		~jpeg_encoder();
 
-		// Initializes the compressor.
+		// Initializes the compressor. In single pass mode, all markers up to SOS are written
+		// here.
 		// pStream: The stream object to use for writing compressed data.
 		// params - Compression parameters structure, defined above.
 		// width, height  - Image dimensions.
-		// channels - May be 1, or 3. 1 indicates grayscale, 3 indicates RGB source data.
+		// channels - May be 1, 3, or 4. 1 indicates grayscale, 3 indicates RGB source data,
+		//            4 indicates RGBA source data (alpha is ignored).
 		// Returns false on out of memory or if a stream write fails.
 		bool init(output_stream* pStream, int width, int height, int src_channels,
 		          const params& comp_params = params());
@@ -128,6 +146,8 @@ namespace jpge {
 		uint8 m_huff_val[4][256];
 		uint32 m_huff_count[4][256];
 		int m_last_dc_val[3];
+		uint m_mcus_to_restart;
+		uint8 m_next_restart_num;
 		enum { JPGE_OUT_BUF_SIZE = 2048 };
 		uint8 m_out_buf[JPGE_OUT_BUF_SIZE];
 		uint8* m_pOut_buf;
@@ -147,6 +167,9 @@ namespace jpge {
 		void emit_dht(uint8* bits, uint8* val, int index, bool ac_flag);
 		void emit_dhts();
 		void emit_sos();
+		void emit_dri();
+		void emit_restart();
+		void begin_mcu();
 		void emit_markers();
 		void compute_huffman_table(uint* codes, uint8* code_sizes, uint8* bits, uint8* val);
 		void compute_quant_table(int32* dst, int16* src);
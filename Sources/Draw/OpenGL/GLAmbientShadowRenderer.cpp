@@ -18,12 +18,14 @@
 
  */
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
 
 #include "GLAmbientShadowRenderer.h"
 #include "GLProfiler.h"
 #include "GLRenderer.h"
+#include "GLSettings.h"
 #include <Client/GameMap.h>
 
 #include <Core/ConcurrentDispatch.h>
@@ -49,8 +51,29 @@ namespace spades {
 		    : renderer(r), device(r.GetGLDevice()), map(m) {
 			SPADES_MARK_FUNCTION();
 
-			for (auto& rayDir : rays)
-				rayDir = RandomUnitVector();
+			maxRayPathLength = 0;
+			for (int i = 0; i < NumRays; i++) {
+				Vector3 dir = RandomUnitVector();
+
+				unsigned int bits = i & 7;
+				if (bits & 1)
+					dir.x = -dir.x;
+				if (bits & 2)
+					dir.y = -dir.y;
+				if (bits & 4)
+					dir.z = -dir.z;
+
+				std::vector<IntVector3> cells;
+				client::GameMap::TraceRay(MakeVector3(0.5F, 0.5F, 0.5F), dir, (float)RayLength,
+				                          cells);
+
+				for (const IntVector3& cell : cells) {
+					float dist = (float)(cell.x * cell.x + cell.y * cell.y + cell.z * cell.z);
+					float brightness = dist * (1.0F / float((RayLength - 1) * (RayLength - 1)));
+					rayPaths[i].push_back({cell.x, cell.y, cell.z, std::min(brightness, 1.0F)});
+				}
+				maxRayPathLength = std::max(maxRayPathLength, cells.size());
+			}
 
 			w = map->Width();
 			h = map->Height();
@@ -104,16 +127,12 @@ namespace spades {
 			}
 
 			SPLog("Chunk texture initialized");
-
-			dispatch = NULL;
 		}
 
 		GLAmbientShadowRenderer::~GLAmbientShadowRenderer() {
 			SPADES_MARK_FUNCTION();
-			if (dispatch) {
+			for (auto& dispatch : dispatches)
 				dispatch->Join();
-				delete dispatch;
-			}
 			device.DeleteTexture(texture);
 		}
 
@@ -123,30 +142,37 @@ namespace spades {
 		float GLAmbientShadowRenderer::Evaluate(IntVector3 ipos) {
 			SPADES_MARK_FUNCTION_DEBUG();
 
+			// All rays are traced together as a packet, one step at a time.
+			// Each bit of `active` represents a ray that hasn't hit anything yet.
+			static_assert(NumRays <= 32, "too many rays for a packet");
+			std::uint32_t active = (std::uint32_t)((1ULL << NumRays) - 1);
 			float sum = 0.0F;
-			Vector3 pos = MakeVector3(ipos) + 0.5F;
 
-			for (int i = 0; i < NumRays; i++) {
-				Vector3 dir = rays[i];
+			for (std::size_t step = 0; active != 0 && step < maxRayPathLength; step++) {
+				for (int i = 0; i < NumRays; i++) {
+					std::uint32_t bit = 1U << i;
+					if (!(active & bit))
+						continue;
 
-				unsigned int bits = i & 7;
-				if (bits & 1)
-					dir.x = -dir.x;
-				if (bits & 2)
-					dir.y = -dir.y;
-				if (bits & 4)
-					dir.z = -dir.z;
+					const auto& path = rayPaths[i];
+					if (step >= path.size()) {
+						// reached the end without hitting anything
+						sum += 1.0F;
+						active &= ~bit;
+						continue;
+					}
 
-				IntVector3 hitBlock;
-				float brightness = 1.0F;
-				if (map->CastRay(pos, dir, (float)RayLength, hitBlock)) {
-					float dist = ((MakeVector3(hitBlock) + 0.5F) - pos).GetSquaredLength();
-					brightness = dist * (1.0F / float((RayLength - 1) * (RayLength - 1)));
-					if (brightness > 1.0F)
-						brightness = 1.0F;
+					const RayStep& s = path[step];
+					if (map->IsSolidWrapped(ipos.x + s.dx, ipos.y + s.dy, ipos.z + s.dz)) {
+						sum += s.brightness;
+						active &= ~bit;
+					}
 				}
+			}
 
-				sum += brightness;
+			for (int i = 0; i < NumRays; i++) {
+				if (active & (1U << i))
+					sum += 1.0F;
 			}
 
 			sum = std::min(sum * (2.f / (float)NumRays), 1.0f);
@@ -195,6 +221,8 @@ namespace spades {
 						int inMaxY = std::min(maxY - originY, ChunkSize - 1);
 						int inMaxZ = std::min(maxZ - originZ, ChunkSize - 1);
 
+						std::lock_guard<std::mutex> lock(c.dirtyMutex);
+						c.generation++;
 						if (!c.dirty) {
 							c.dirtyMinX = inMinX;
 							c.dirtyMinY = inMinY;
@@ -218,17 +246,25 @@ namespace spades {
 
 		int GLAmbientShadowRenderer::GetNumDirtyChunks() {
 			return (int)std::count_if(chunks.begin(), chunks.end(),
-			                          [](const Chunk& c) { return c.dirty; });
+			                          [](const Chunk& c) { return c.dirty.load(); });
 		}
 
 		void GLAmbientShadowRenderer::Update() {
-			if (GetNumDirtyChunks() > 0 && (dispatch == NULL || dispatch->done)) {
-				if (dispatch) {
+			bool updateDone = std::all_of(
+			  dispatches.begin(), dispatches.end(),
+			  [](const std::unique_ptr<UpdateDispatch>& d) { return d->done.load(); });
+			if (updateDone) {
+				for (auto& dispatch : dispatches)
 					dispatch->Join();
-					delete dispatch;
+				dispatches.clear();
+
+				if (GetNumDirtyChunks() > 0) {
+					StartUpdate();
+				} else if (!bakeDone) {
+					bakeDone = true;
+					SPLog("Ambient occlusion baked in %.3f seconds using %d thread(s)",
+					      bakeStopwatch.GetTime(), ConcurrentDispatch::GetNumWorkerThreads());
 				}
-				dispatch = new UpdateDispatch(*this);
-				dispatch->Start();
 			}
 
 			// Count the number of chunks that need to be uploaded to GPU.
@@ -250,58 +286,60 @@ namespace spades {
 			}
 		}
 
-		void GLAmbientShadowRenderer::UpdateDirtyChunks() {
-			std::array<std::size_t, 256> dirtyChunkIds;
-			std::size_t numDirtyChunks = 0;
+		/**
+		 * Queues the dirty chunks (nearest to the camera first) and starts updating
+		 * them on all worker threads. The workers stop taking new chunks after
+		 * `r_aoUpdateBudget` milliseconds so that chunks are re-prioritized
+		 * every frame as the camera moves.
+		 */
+		void GLAmbientShadowRenderer::StartUpdate() {
+			SPADES_MARK_FUNCTION();
 
-			// first, check only chunks in near range
 			const auto& viewOrigin = renderer.GetSceneDef().viewOrigin;
 			int eyeX = (int)(viewOrigin.x) >> ChunkSizeBits;
 			int eyeY = (int)(viewOrigin.y) >> ChunkSizeBits;
 			int eyeZ = (int)(viewOrigin.z) >> ChunkSizeBits;
 
-			for (size_t i = 0; i < chunks.size(); i++) {
-				Chunk& c = chunks[i];
-				int dx = (c.cx - eyeX) & (chunkW - 1);
-				int dy = (c.cy - eyeY) & (chunkH - 1);
-				int dz = (c.cz - eyeZ);
-				if (dx >= 6 && dx <= chunkW - 6)
-					continue;
-				if (dy >= 6 && dy <= chunkW - 6)
-					continue;
-				if (dz >= 6 || dz <= -6)
-					continue;
-				if (c.dirty) {
-					dirtyChunkIds[numDirtyChunks++] = static_cast<int>(i);
-					if (numDirtyChunks >= dirtyChunkIds.size())
-						break;
-				}
-			}
+			auto distance = [&](std::size_t i) {
+				const Chunk& c = chunks[i];
+				// the map wraps around horizontally
+				int dx = ((c.cx - eyeX + chunkW / 2) & (chunkW - 1)) - chunkW / 2;
+				int dy = ((c.cy - eyeY + chunkH / 2) & (chunkH - 1)) - chunkH / 2;
+				int dz = c.cz - eyeZ;
+				return dx * dx + dy * dy + dz * dz;
+			};
 
-			// far chunks
-			if (numDirtyChunks == 0) {
-				for (size_t i = 0; i < chunks.size(); i++) {
-					Chunk& c = chunks[i];
-					if (c.dirty) {
-						dirtyChunkIds[numDirtyChunks++] = static_cast<int>(i);
-						if (numDirtyChunks >= dirtyChunkIds.size())
-							break;
-					}
-				}
+			updateQueue.clear();
+			for (std::size_t i = 0; i < chunks.size(); i++) {
+				if (chunks[i].dirty)
+					updateQueue.push_back(i);
+			}
+			std::sort(updateQueue.begin(), updateQueue.end(),
+			          [&](std::size_t a, std::size_t b) { return distance(a) < distance(b); });
+
+			updateQueuePos = 0;
+			updateBudget = std::max((float)renderer.GetSettings().r_aoUpdateBudget, 1.0F) * 1.0e-3;
+			updateStopwatch.Reset();
+
+			int numThreads = ConcurrentDispatch::GetNumWorkerThreads();
+			numThreads = std::max(std::min(numThreads, (int)updateQueue.size()), 1);
+			for (int i = 0; i < numThreads; i++) {
+				dispatches.emplace_back(new UpdateDispatch(*this));
+				dispatches.back()->Start();
 			}
+		}
 
-			// limit update count per frame
-			for (int i = 0; i < 8; i++) {
-				if (numDirtyChunks <= 0)
+		void GLAmbientShadowRenderer::UpdateDirtyChunks() {
+			// The first chunk is always processed to guarantee progress
+			for (std::size_t n = 0;; n++) {
+				if (n > 0 && updateStopwatch.GetTime() > updateBudget)
 					break;
-				std::size_t idx = SampleRandomInt(std::size_t{0}, numDirtyChunks - 1);
-				Chunk& c = chunks[dirtyChunkIds[idx]];
 
-				// remove from list (fast)
-				if (idx < numDirtyChunks - 1)
-					std::swap(dirtyChunkIds[idx], dirtyChunkIds[numDirtyChunks - 1]);
-				numDirtyChunks--;
+				std::size_t pos = updateQueuePos.fetch_add(1);
+				if (pos >= updateQueue.size())
+					break;
 
+				Chunk& c = chunks[updateQueue[pos]];
 				UpdateChunk(c.cx, c.cy, c.cz);
 			}
 		}
@@ -311,6 +349,20 @@ namespace spades {
 			if (!c.dirty)
 				return;
 
+			// Take a consistent snapshot; `Invalidate` may widen the region meanwhile
+			unsigned int generation;
+			int dirtyMinX, dirtyMinY, dirtyMinZ, dirtyMaxX, dirtyMaxY, dirtyMaxZ;
+			{
+				std::lock_guard<std::mutex> lock(c.dirtyMutex);
+				generation = c.generation;
+				dirtyMinX = c.dirtyMinX;
+				dirtyMinY = c.dirtyMinY;
+				dirtyMinZ = c.dirtyMinZ;
+				dirtyMaxX = c.dirtyMaxX;
+				dirtyMaxY = c.dirtyMaxY;
+				dirtyMaxZ = c.dirtyMaxZ;
+			}
+
 			int originX = cx * ChunkSize;
 			int originY = cy * ChunkSize;
 			int originZ = cz * ChunkSize;
@@ -322,12 +374,12 @@ namespace spades {
 			int wOriginX = originX - padding;
 			int wOriginY = originY - padding;
 			int wOriginZ = originZ - padding;
-			int wDirtyMinX = c.dirtyMinX;
-			int wDirtyMinY = c.dirtyMinY;
-			int wDirtyMinZ = c.dirtyMinZ;
-			int wDirtyMaxX = c.dirtyMaxX + padding * 2;
-			int wDirtyMaxY = c.dirtyMaxY + padding * 2;
-			int wDirtyMaxZ = c.dirtyMaxZ + padding * 2;
+			int wDirtyMinX = dirtyMinX;
+			int wDirtyMinY = dirtyMinY;
+			int wDirtyMinZ = dirtyMinZ;
+			int wDirtyMaxX = dirtyMaxX + padding * 2;
+			int wDirtyMaxY = dirtyMaxY + padding * 2;
+			int wDirtyMaxZ = dirtyMaxZ + padding * 2;
 
 			auto b = [](int i) -> std::uint8_t { return (std::uint8_t)1 << i; };
 			auto to_b = [](bool b, int i) -> std::uint8_t { return (std::uint8_t)b << i; };
@@ -465,14 +517,19 @@ namespace spades {
 			}
 
 			// Copy the result to `c.data`
-			for (int z = c.dirtyMinZ; z <= c.dirtyMaxZ; z++)
-			for (int y = c.dirtyMinY; y <= c.dirtyMaxY; y++)
-			for (int x = c.dirtyMinX; x <= c.dirtyMaxX; x++) {
+			for (int z = dirtyMinZ; z <= dirtyMaxZ; z++)
+			for (int y = dirtyMinY; y <= dirtyMaxY; y++)
+			for (int x = dirtyMinX; x <= dirtyMaxX; x++) {
 				c.data[z][y][x][0] = wData[z + padding][y + padding][x + padding][0];
 				c.data[z][y][x][1] = wData[z + padding][y + padding][x + padding][1];
 			}
 
-			c.dirty = false;
+			// If the chunk was re-dirtied meanwhile, it has to be computed again
+			{
+				std::lock_guard<std::mutex> lock(c.dirtyMutex);
+				if (c.generation == generation)
+					c.dirty = false;
+			}
 			c.transferDone = false;
 		}
 	} // namespace draw
@@ -22,12 +22,15 @@
 
 #include <array>
 #include <atomic>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "IGLDevice.h"
 #include <Core/Debug.h>
 #include <Core/Math.h>
 #include <Core/RefCountedObject.h>
+#include <Core/Stopwatch.h>
 
 namespace spades {
 	namespace client {
@@ -47,15 +50,36 @@ namespace spades {
 			GLRenderer& renderer;
 			IGLDevice& device;
 			Handle<client::GameMap> map;
-			std::array<Vector3, NumRays> rays;
+
+			/** A voxel visited by a ray, relative to the voxel the ray starts from. */
+			struct RayStep {
+				int dx, dy, dz;
+				/** The value contributed by the ray if it's stopped here. */
+				float brightness;
+			};
+
+			/**
+			 * Since rays always start from a voxel center, the voxels they visit only
+			 * depend on their directions and are computed only once.
+			 */
+			std::array<std::vector<RayStep>, NumRays> rayPaths;
+			std::size_t maxRayPathLength;
 
 			struct Chunk {
 				int cx, cy, cz;
 				float data[ChunkSize][ChunkSize][ChunkSize][2];
-				bool dirty = true;
+				/** Set by `Invalidate`. Cleared by `UpdateChunk` with `dirtyMutex` held. */
+				std::atomic<bool> dirty{true};
+				/**
+				 * Serializes `Invalidate` (main thread) and `UpdateChunk` (update
+				 * dispatches) on the dirty region and `generation`.
+				 */
+				std::mutex dirtyMutex;
 				int dirtyMinX = 0, dirtyMaxX = ChunkSize - 1;
 				int dirtyMinY = 0, dirtyMaxY = ChunkSize - 1;
 				int dirtyMinZ = 0, dirtyMaxZ = ChunkSize - 1;
+				/** Incremented by `Invalidate`. Used to detect re-dirtied chunks. */
+				unsigned int generation = 0;
 
 				std::atomic<bool> transferDone{true};
 			};
@@ -87,8 +111,20 @@ namespace spades {
 			void UpdateChunk(int cx, int cy, int cz);
 			void UpdateDirtyChunks();
 			int GetNumDirtyChunks();
+			void StartUpdate();
+
+			std::vector<std::unique_ptr<UpdateDispatch>> dispatches;
+
+			/** Chunks to be updated by `dispatches`, nearest first. */
+			std::vector<std::size_t> updateQueue;
+			std::atomic<std::size_t> updateQueuePos{0};
+			/** Time given to `dispatches` before the chunks are re-prioritized (seconds). */
+			double updateBudget;
+			Stopwatch updateStopwatch;
 
-			UpdateDispatch* dispatch;
+			/** Measures the initial full-map bake. */
+			Stopwatch bakeStopwatch;
+			bool bakeDone = false;
 
 		public:
 			GLAmbientShadowRenderer(GLRenderer& renderer, client::GameMap& map);
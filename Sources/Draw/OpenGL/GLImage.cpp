@@ -19,6 +19,7 @@
  */
 
 #include "GLImage.h"
+#include "GLTextureAtlas.h"
 #include <Core/Bitmap.h>
 #include <Core/Debug.h>
 
@@ -32,7 +33,8 @@ namespace spades {
 		      height(h),
 		      invWidth(1.0F / w),
 		      invHeight(1.0F / h),
-		      autoDelete(autoDelete) {
+		      autoDelete(autoDelete),
+		      atlas(nullptr) {
 			SPADES_MARK_FUNCTION();
 			valid = true;
 		}
@@ -73,6 +75,8 @@ namespace spades {
 			Bind(IGLDevice::Texture2D);
 			device->TexSubImage2D(IGLDevice::Texture2D, 0, x, y, bmp->GetWidth(), bmp->GetHeight(),
 			                      IGLDevice::RGBA, IGLDevice::UnsignedByte, bmp->GetPixels());
+			if (atlas)
+				atlas->Update(*this, *bmp, x, y);
 		}
 
 		// TODO: Make sure this method is called even for `GLImage`s created via
@@ -84,6 +88,8 @@ namespace spades {
 			MakeSureValid();
 			valid = false;
 
+			if (atlas)
+				atlas->Remove(*this);
 			if (autoDelete)
 				device->DeleteTexture(tex);
 		}
@@ -27,13 +27,18 @@ namespace spades {
 	class Bitmap;
 	namespace draw {
 		class IGLDevice;
+		class GLTextureAtlas;
 		class GLImage : public client::IImage {
+			friend class GLTextureAtlas;
+
 			IGLDevice* device;
 			IGLDevice::UInteger tex;
 			float width, height;
 			float invWidth, invHeight;
 			bool autoDelete;
 			bool valid;
+			/** The atlas holding a copy of this image, if any. */
+			GLTextureAtlas* atlas;
 			void MakeSureValid();
 
 		protected:
@@ -48,8 +53,10 @@ namespace spades {
 			float GetWidth() override { return width; }
 			float GetHeight() override { return height; }
 
-			float GetInvWidth() { return invWidth; }
-			float GetInvHeight() { return invHeight; }
+			float GetInvWidth() const { return invWidth; }
+			float GetInvHeight() const { return invHeight; }
+
+			IGLDevice::UInteger GetTexture() const { return tex; }
 
 			void SubImage(Bitmap* bmp, int x, int y);
 			void Invalidate();
@@ -21,16 +21,23 @@
 #include "GLImageManager.h"
 #include "GLImage.h"
 #include "GLRenderer.h"
+#include "GLTextureAtlas.h"
 #include "IGLDevice.h"
 #include <Core/Bitmap.h>
 #include <Core/Debug.h>
 #include <Core/FileManager.h>
 #include <Core/IStream.h>
+#include <Core/ParallelLoad.h>
+#include <Core/Stopwatch.h>
+#include <set>
 
 namespace spades {
 	namespace draw {
-		GLImageManager::GLImageManager(IGLDevice& dev) : device(dev), whiteImage(nullptr) {
+		GLImageManager::GLImageManager(IGLDevice& dev, bool useAtlas)
+		    : device(dev), whiteImage(nullptr) {
 			SPADES_MARK_FUNCTION();
+			if (useAtlas)
+				atlas.reset(new GLTextureAtlas(dev));
 		}
 
 		GLImageManager::~GLImageManager() {
@@ -59,6 +66,31 @@ namespace spades {
 			return it->second;
 		}
 
+		void GLImageManager::PreloadImages(const std::vector<std::string>& names) {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<std::string> pending;
+			std::set<std::string> seen;
+			for (const std::string& name : names) {
+				if (images.find(name) == images.end() && seen.insert(name).second)
+					pending.push_back(name);
+			}
+			if (pending.empty())
+				return;
+
+			Stopwatch sw;
+			ParallelLoad<Handle<Bitmap>>(
+			  pending.size(), [&](std::size_t i) { return Bitmap::Load(pending[i]); },
+			  [&](std::size_t i, Handle<Bitmap> bmp) {
+				  // On failure, retry synchronously so the error is reported
+				  // the same way as `RegisterImage` does
+				  images[pending[i]] =
+				    bmp ? CreateImage(*bmp).Unmanage() : CreateImage(pending[i]);
+			  });
+			SPLog("Preloaded %d image(s) in %.3f seconds", static_cast<int>(pending.size()),
+			      sw.GetTime());
+		}
+
 		GLImage* GLImageManager::GetWhiteImage() {
 			if (!whiteImage)
 				whiteImage = RegisterImage("Gfx/White.tga");
@@ -69,7 +101,16 @@ namespace spades {
 			SPADES_MARK_FUNCTION();
 
 			Handle<Bitmap> bmp = Bitmap::Load(name);
-			return GLImage::FromBitmap(*bmp, &device).Unmanage();
+			return CreateImage(*bmp).Unmanage();
+		}
+
+		Handle<GLImage> GLImageManager::CreateImage(Bitmap& bmp) {
+			SPADES_MARK_FUNCTION();
+
+			Handle<GLImage> img = GLImage::FromBitmap(bmp, &device);
+			if (atlas && atlas->IsEligible(bmp.GetWidth(), bmp.GetHeight()))
+				atlas->Add(*img, bmp);
+			return img;
 		}
 
 		// draw all imaegs so that all textures are resident
@@ -21,29 +21,45 @@
 #pragma once
 
 #include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
+#include <Core/RefCountedObject.h>
+
 namespace spades {
+	class Bitmap;
 	namespace draw {
 		class IGLDevice;
 		class GLImage;
 		class GLRenderer;
+		class GLTextureAtlas;
 
 		class GLImageManager {
 			IGLDevice &device;
 			std::map<std::string, GLImage *> images;
 			GLImage *whiteImage;
+			std::unique_ptr<GLTextureAtlas> atlas;
 
 			GLImage *CreateImage(const std::string &);
 
 		public:
-			GLImageManager(IGLDevice &);
+			/** If `useAtlas` is set, small images are also stored in a `GLTextureAtlas`. */
+			GLImageManager(IGLDevice &, bool useAtlas);
 			~GLImageManager();
 
+			Handle<GLImage> CreateImage(Bitmap &);
+
 			GLImage *RegisterImage(const std::string &);
+
+			/** Decodes the specified images on the worker threads and
+			 * uploads them as they become ready. */
+			void PreloadImages(const std::vector<std::string> &);
 			GLImage *GetWhiteImage();
 
+			/** Returns `nullptr` if the atlas is disabled. */
+			GLTextureAtlas *GetAtlas() { return atlas.get(); }
+
 			void DrawAllImages(GLRenderer *);
 
 			void ClearCache();
@@ -27,46 +27,40 @@
 
 namespace spades {
 	namespace draw {
+		GLImageRenderer::ProgramBinding::ProgramBinding(GLProgram* program)
+		    : program(program),
+		      positionAttribute("positionAttribute"),
+		      colorAttribute("colorAttribute"),
+		      textureCoordAttribute("textureCoordAttribute"),
+		      screenSize("invScreenSizeFactored"),
+		      textureSize("invTextureSize"),
+		      texture("mainTexture") {
+			positionAttribute(program);
+			colorAttribute(program);
+			textureCoordAttribute(program);
+			screenSize(program);
+			textureSize(program);
+			texture(program);
+		}
+
 		GLImageRenderer::GLImageRenderer(GLRenderer& r)
 		    : renderer(r),
 		      device(r.GetGLDevice()),
 		      invScreenWidthFactored(2.0F / device.ScreenWidth()),
-		      invScreenHeightFactored(-2.0F / device.ScreenHeight()) {
-
+		      invScreenHeightFactored(-2.0F / device.ScreenHeight()),
+		      basicBinding(r.RegisterProgram("Shaders/OpenGL/BasicImage.program")),
+		      distanceFieldBinding(r.RegisterProgram("Shaders/OpenGL/DistanceFieldImage.program")),
+		      distanceFieldRange("distanceFieldRange"),
+		      numBatchesDrawn(0),
+		      numQuadsDrawn(0) {
 			SPADES_MARK_FUNCTION();
-			image = NULL;
-
-			program = renderer.RegisterProgram("Shaders/OpenGL/BasicImage.program");
-
-			program->Use();
-
-			positionAttribute = new GLProgramAttribute("positionAttribute");
-			colorAttribute = new GLProgramAttribute("colorAttribute");
-			textureCoordAttribute = new GLProgramAttribute("textureCoordAttribute");
-			screenSize = new GLProgramUniform("invScreenSizeFactored");
-			textureSize = new GLProgramUniform("invTextureSize");
-			texture = new GLProgramUniform("mainTexture");
-
-			(*positionAttribute)(program);
-			(*colorAttribute)(program);
-			(*textureCoordAttribute)(program);
 
-			(*screenSize)(program);
-			(*textureSize)(program);
-			(*texture)(program);
+			distanceFieldRange(distanceFieldBinding.program);
 		}
 
 		GLImageRenderer::~GLImageRenderer() {
-			if (image != NULL) {
-				image->Release();
-				image = NULL;
-			}
-			delete positionAttribute;
-			delete colorAttribute;
-			delete textureCoordAttribute;
-			delete screenSize;
-			delete textureSize;
-			delete texture;
+			batches.clear();
+			image = nullptr;
 		}
 
 		void GLImageRenderer::Flush() {
@@ -74,63 +68,155 @@ namespace spades {
 				return;
 
 			SPADES_MARK_FUNCTION();
-			SPAssert(image);
-
-			program->Use();
-
-			device.ActiveTexture(0);
-			image->Bind(IGLDevice::Texture2D);
 
-			device.VertexAttribPointer((*positionAttribute)(), 2, IGLDevice::FloatType, false,
-			                           sizeof(ImageVertex), vertices.data());
-			device.VertexAttribPointer((*colorAttribute)(), 4, IGLDevice::FloatType, false,
-			                           sizeof(ImageVertex),
-			                           (const char*)vertices.data() + sizeof(float) * 4);
-			device.VertexAttribPointer((*textureCoordAttribute)(), 2, IGLDevice::FloatType, false,
-			                           sizeof(ImageVertex),
-			                           (const char*)vertices.data() + sizeof(float) * 2);
-
-			device.EnableVertexAttribArray((*positionAttribute)(), true);
-			device.EnableVertexAttribArray((*colorAttribute)(), true);
-			device.EnableVertexAttribArray((*textureCoordAttribute)(), true);
+			// group the indices by batch
+			std::size_t numIndices = 0;
+			for (Batch& batch : batches) {
+				batch.firstIndex = numIndices;
+				numIndices += batch.numQuads * 6;
+				batch.numQuads = 0;
+			}
+			indices.resize(numIndices);
+			for (std::size_t quad = 0; quad < quadBatches.size(); quad++) {
+				Batch& batch = batches[quadBatches[quad]];
+				uint32_t* idx = indices.data() + batch.firstIndex + batch.numQuads * 6;
+				uint32_t v = static_cast<uint32_t>(quad * 4);
+				idx[0] = v;
+				idx[1] = v + 1;
+				idx[2] = v + 2;
+				idx[3] = v;
+				idx[4] = v + 2;
+				idx[5] = v + 3;
+				batch.numQuads++;
+			}
 
-			screenSize->SetValue(invScreenWidthFactored, invScreenHeightFactored);
-			textureSize->SetValue(image->GetInvWidth(), image->GetInvHeight());
-			texture->SetValue(0);
+			ProgramBinding* lastBinding = nullptr;
+			for (const Batch& batch : batches) {
+				ProgramBinding& binding = batch.distanceField ? distanceFieldBinding : basicBinding;
+				if (&binding != lastBinding) {
+					if (lastBinding) {
+						device.EnableVertexAttribArray(lastBinding->positionAttribute(), false);
+						device.EnableVertexAttribArray(lastBinding->colorAttribute(), false);
+						device.EnableVertexAttribArray(lastBinding->textureCoordAttribute(),
+						                               false);
+					}
+
+					binding.program->Use();
+					lastBinding = &binding;
+
+					device.VertexAttribPointer(binding.positionAttribute(), 2,
+					                           IGLDevice::FloatType, false, sizeof(ImageVertex),
+					                           vertices.data());
+					device.VertexAttribPointer(binding.colorAttribute(), 4, IGLDevice::FloatType,
+					                           false, sizeof(ImageVertex),
+					                           (const char*)vertices.data() + sizeof(float) * 4);
+					device.VertexAttribPointer(binding.textureCoordAttribute(), 2,
+					                           IGLDevice::FloatType, false, sizeof(ImageVertex),
+					                           (const char*)vertices.data() + sizeof(float) * 2);
+
+					device.EnableVertexAttribArray(binding.positionAttribute(), true);
+					device.EnableVertexAttribArray(binding.colorAttribute(), true);
+					device.EnableVertexAttribArray(binding.textureCoordAttribute(), true);
+
+					binding.screenSize.SetValue(invScreenWidthFactored, invScreenHeightFactored);
+					binding.texture.SetValue(0);
+				}
+
+				device.ActiveTexture(0);
+				batch.image->Bind(IGLDevice::Texture2D);
+				binding.textureSize.SetValue(batch.image->GetInvWidth(),
+				                             batch.image->GetInvHeight());
+				if (batch.distanceField) {
+					distanceFieldRange.SetValue((*batch.distanceField).low,
+					                            (*batch.distanceField).high);
+				}
+
+				device.DrawElements(IGLDevice::Triangles,
+				                    static_cast<IGLDevice::Sizei>(batch.numQuads * 6),
+				                    IGLDevice::UnsignedInt, indices.data() + batch.firstIndex);
+			}
 
-			device.DrawElements(IGLDevice::Triangles, static_cast<IGLDevice::Sizei>(indices.size()),
-			                    IGLDevice::UnsignedInt, indices.data());
+			device.EnableVertexAttribArray(lastBinding->positionAttribute(), false);
+			device.EnableVertexAttribArray(lastBinding->colorAttribute(), false);
+			device.EnableVertexAttribArray(lastBinding->textureCoordAttribute(), false);
 
-			device.EnableVertexAttribArray((*positionAttribute)(), false);
-			device.EnableVertexAttribArray((*colorAttribute)(), false);
-			device.EnableVertexAttribArray((*textureCoordAttribute)(), false);
+			numBatchesDrawn += batches.size();
+			numQuadsDrawn += quadBatches.size();
 
 			vertices.clear();
+			quadBatches.clear();
 			indices.clear();
-			image->Release();
-			image = NULL;
+			batches.clear();
+			image = nullptr;
 		}
 
-		void GLImageRenderer::SetImage(spades::draw::GLImage* img) {
-			if (img == image)
-				return;
-			Flush();
-			image = img;
-			image->AddRef();
+		void GLImageRenderer::SetImage(spades::draw::GLImage* img) { image = img; }
+
+		void GLImageRenderer::SetDistanceField(
+		  const stmp::optional<client::ImageDistanceField>& field) {
+			distanceField = field;
+		}
+
+		bool GLImageRenderer::IsCompatible(const Batch& batch) const {
+			if (batch.image.GetPointerOrNull() != image.GetPointerOrNull()) {
+				// different images sharing a texture (e.g., pages of an atlas) can be merged
+				if (batch.image->GetTexture() != image->GetTexture() ||
+				    batch.image->GetInvWidth() != image->GetInvWidth() ||
+				    batch.image->GetInvHeight() != image->GetInvHeight())
+					return false;
+			}
+			if (!batch.distanceField || !distanceField)
+				return !batch.distanceField && !distanceField;
+			return (*batch.distanceField).low == (*distanceField).low &&
+			       (*batch.distanceField).high == (*distanceField).high;
 		}
 
 		void GLImageRenderer::Add(float dx1, float dy1, float dx2, float dy2, float dx3, float dy3,
 		                          float dx4, float dy4, float sx1, float sy1, float sx2, float sy2,
 		                          float sx3, float sy3, float sx4, float sy4, float r, float g,
 		                          float b, float a) {
+			SPAssert(image);
+
+			AABB2 bounds(dx1, dy1, 0.0F, 0.0F);
+			bounds += Vector2(dx2, dy2);
+			bounds += Vector2(dx3, dy3);
+			bounds += Vector2(dx4, dy4);
+
+			// find the latest compatible batch we can move this quad to without drawing it
+			// before an overlapping quad
+			std::size_t batchIndex = batches.size();
+			std::size_t lookbackEnd = batches.size() > MaxBatchLookback
+			                            ? batches.size() - MaxBatchLookback
+			                            : 0;
+			for (std::size_t i = batches.size(); i > lookbackEnd;) {
+				--i;
+				if (IsCompatible(batches[i])) {
+					batchIndex = i;
+					break;
+				}
+				if (batches[i].bounds.Intersects(bounds))
+					break;
+			}
+
+			if (batchIndex == batches.size()) {
+				batches.emplace_back();
+				Batch& batch = batches.back();
+				batch.image = image;
+				batch.distanceField = distanceField;
+				batch.bounds = bounds;
+				batch.numQuads = 0;
+			} else {
+				batches[batchIndex].bounds += bounds;
+			}
+			batches[batchIndex].numQuads++;
+			quadBatches.push_back(static_cast<std::uint32_t>(batchIndex));
+
 			ImageVertex v;
 			v.r = r;
 			v.g = g;
 			v.b = b;
 			v.a = a;
 
-			uint32_t idx = (uint32_t)vertices.size();
-
 			v.x = dx1;
 			v.y = dy1;
 			v.u = sx1;
@@ -154,13 +240,6 @@ namespace spades {
 			v.u = sx4;
 			v.v = sy4;
 			vertices.push_back(v);
-
-			indices.push_back(idx);
-			indices.push_back(idx + 1);
-			indices.push_back(idx + 2);
-			indices.push_back(idx);
-			indices.push_back(idx + 2);
-			indices.push_back(idx + 3);
 		}
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -21,53 +21,110 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 #include "GLProgram.h"
 #include "GLProgramAttribute.h"
 #include "GLProgramUniform.h"
+#include <Client/IRenderer.h>
+#include <Core/Math.h>
+#include <Core/RefCountedObject.h>
+#include <Core/TMPUtils.h>
 
 namespace spades {
 	namespace draw {
 		class GLImage;
 		class IGLDevice;
 		class GLRenderer;
+		/**
+		 * Draws 2D images.
+		 *
+		 * Quads are queued until `Flush` and grouped into batches sharing a texture and a
+		 * shader, so interleaved draws of a few images don't cost a draw call each. A quad
+		 * can join an earlier batch only if it doesn't overlap any batch queued after that
+		 * one, so the result is the same as drawing the quads in order.
+		 */
 		class GLImageRenderer {
 			GLRenderer& renderer;
 			IGLDevice& device;
-			GLImage* image;
+			Handle<GLImage> image;
+			stmp::optional<client::ImageDistanceField> distanceField;
 
 			float invScreenWidthFactored;
 			float invScreenHeightFactored;
 
-			GLProgram* program;
-
-			GLProgramAttribute* positionAttribute;
-			GLProgramAttribute* colorAttribute;
-			GLProgramAttribute* textureCoordAttribute;
+			/**
+			 * The binders for one program. Each program has its own so switching between
+			 * them doesn't look up the locations again.
+			 */
+			struct ProgramBinding {
+				GLProgram* program;
+				GLProgramAttribute positionAttribute;
+				GLProgramAttribute colorAttribute;
+				GLProgramAttribute textureCoordAttribute;
+				GLProgramUniform screenSize;
+				GLProgramUniform textureSize;
+				GLProgramUniform texture;
+
+				ProgramBinding(GLProgram*);
+			};
 
-			GLProgramUniform* screenSize;
-			GLProgramUniform* textureSize;
-			GLProgramUniform* texture;
+			ProgramBinding basicBinding;
+			/** Used for images storing a distance field. */
+			ProgramBinding distanceFieldBinding;
+			GLProgramUniform distanceFieldRange;
 
 			struct ImageVertex {
 				float x, y, u, v;
 				float r, g, b, a;
 			};
 
+			struct Batch {
+				Handle<GLImage> image;
+				stmp::optional<client::ImageDistanceField> distanceField;
+				/** The union of the bounding boxes of the quads. */
+				AABB2 bounds;
+				std::size_t numQuads;
+				std::size_t firstIndex;
+			};
+
+			/** The number of the latest batches a quad can be merged into. */
+			enum { MaxBatchLookback = 32 };
+
+			/** Queued quads in the submission order. */
 			std::vector<ImageVertex> vertices;
+			/** The batch of each quad. */
+			std::vector<std::uint32_t> quadBatches;
+			std::vector<Batch> batches;
 			std::vector<uint32_t> indices;
 
+			std::size_t numBatchesDrawn;
+			std::size_t numQuadsDrawn;
+
+			bool IsCompatible(const Batch&) const;
+
 		public:
 			GLImageRenderer(GLRenderer& renderer);
 			~GLImageRenderer();
 
+			/** Draws the queued quads. */
 			void Flush();
 
 			void SetImage(GLImage*);
+			void SetDistanceField(const stmp::optional<client::ImageDistanceField>&);
 
 			void Add(float dx1, float dy1, float dx2, float dy2, float dx3, float dy3, float dx4,
 			         float dy4, float sx1, float sy1, float sx2, float sy2, float sx3, float sy3,
 			         float sx4, float sy4, float r, float g, float b, float a);
+
+			/** @return the number of draw calls issued since the last reset. */
+			std::size_t GetNumBatchesDrawn() const { return numBatchesDrawn; }
+			/** @return the number of quads drawn since the last reset. */
+			std::size_t GetNumQuadsDrawn() const { return numQuadsDrawn; }
+			void ResetStatistics() {
+				numBatchesDrawn = 0;
+				numQuadsDrawn = 0;
+			}
 		};
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -36,15 +36,17 @@
 
 namespace spades {
 	namespace draw {
-		void GLMapRenderer::PreloadShaders(GLRenderer& renderer) {
+		void GLMapRenderer::PreloadShaders(GLRenderer& renderer,
+		                                   std::vector<std::string>& programs,
+		                                   std::vector<std::string>& images) {
 			if (renderer.GetSettings().r_physicalLighting)
-				renderer.RegisterProgram("Shaders/OpenGL/BasicBlockPhys.program");
+				programs.push_back("Shaders/OpenGL/BasicBlockPhys.program");
 			else
-				renderer.RegisterProgram("Shaders/OpenGL/BasicBlock.program");
-			renderer.RegisterProgram("Shaders/OpenGL/BasicBlockDepthOnly.program");
-			renderer.RegisterProgram("Shaders/OpenGL/BasicBlockDynamicLit.program");
-			renderer.RegisterProgram("Shaders/OpenGL/BackFaceBlock.program");
-			renderer.RegisterImage("Gfx/AmbientOcclusion.png");
+				programs.push_back("Shaders/OpenGL/BasicBlock.program");
+			programs.push_back("Shaders/OpenGL/BasicBlockDepthOnly.program");
+			programs.push_back("Shaders/OpenGL/BasicBlockDynamicLit.program");
+			programs.push_back("Shaders/OpenGL/BackFaceBlock.program");
+			images.push_back("Gfx/AmbientOcclusion.png");
 		}
 
 		GLMapRenderer::GLMapRenderer(client::GameMap* m, GLRenderer& r)
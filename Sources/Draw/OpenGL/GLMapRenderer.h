@@ -84,7 +84,9 @@ namespace spades {
 			GLMapRenderer(client::GameMap*, GLRenderer&);
 			virtual ~GLMapRenderer();
 
-			static void PreloadShaders(GLRenderer&);
+			/** Appends the programs and images used by this renderer to the lists. */
+			static void PreloadShaders(GLRenderer&, std::vector<std::string>& programs,
+			                           std::vector<std::string>& images);
 
 			void GameMapChanged(int x, int y, int z, client::GameMap*);
 
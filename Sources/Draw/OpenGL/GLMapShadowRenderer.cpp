@@ -18,12 +18,16 @@
 
  */
 
+#include <algorithm>
+#include <memory>
+
 #include "GLMapShadowRenderer.h"
 #include "GLProfiler.h"
 #include "GLRadiosityRenderer.h"
 #include "GLRenderer.h"
 #include "IGLDevice.h"
 #include <Client/GameMap.h>
+#include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
 
 namespace spades {
@@ -33,9 +37,35 @@ namespace spades {
 			SPADES_MARK_FUNCTION();
 			texture = device.GenTexture();
 			coarseTexture = device.GenTexture();
+
+			w = map->Width();
+			h = map->Height();
+			d = map->Depth();
+
+			updateBitmapPitch = (w + 31) / 32;
+			updateBitmap.resize(updateBitmapPitch * h);
+			std::fill(updateBitmap.begin(), updateBitmap.end(), 0);
+
+			// Generate the whole map now, so the first `Update` only has to deal with
+			// the actual changes
+			bitmap.resize(w * h);
+			{
+				std::vector<size_t> segments(updateBitmap.size());
+				for (size_t i = 0; i < segments.size(); i++)
+					segments[i] = i;
+				GenerateSegments(segments, bitmap.data());
+			}
+
+			coarseBitmap.resize((w * h) >> (CoarseBits * 2));
+			for (size_t i = 0; i < coarseBitmap.size(); i++) {
+				int bx = static_cast<int>(i % (w >> CoarseBits)) << CoarseBits;
+				int by = static_cast<int>(i / (w >> CoarseBits)) << CoarseBits;
+				coarseBitmap[i] = ComputeCoarsePixel(bx, by);
+			}
+
 			device.BindTexture(IGLDevice::Texture2D, texture);
-			device.TexImage2D(IGLDevice::Texture2D, 0, IGLDevice::RGBA, map->Width(), map->Height(),
-			                  0, IGLDevice::RGBA, IGLDevice::UnsignedByte, NULL);
+			device.TexImage2D(IGLDevice::Texture2D, 0, IGLDevice::RGBA, w, h, 0, IGLDevice::RGBA,
+			                  IGLDevice::UnsignedByte, bitmap.data());
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureMagFilter,
 			                    IGLDevice::Nearest);
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureMinFilter,
@@ -44,28 +74,15 @@ namespace spades {
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureWrapT, IGLDevice::Repeat);
 
 			device.BindTexture(IGLDevice::Texture2D, coarseTexture);
-			device.TexImage2D(IGLDevice::Texture2D, 0, IGLDevice::RGBA8, map->Width() / CoarseSize,
-			                  map->Height() / CoarseSize, 0, IGLDevice::BGRA,
-			                  IGLDevice::UnsignedByte, NULL);
+			device.TexImage2D(IGLDevice::Texture2D, 0, IGLDevice::RGBA8, w / CoarseSize,
+			                  h / CoarseSize, 0, IGLDevice::BGRA, IGLDevice::UnsignedByte,
+			                  coarseBitmap.data());
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureMagFilter,
 			                    IGLDevice::Nearest);
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureMinFilter,
 			                    IGLDevice::Nearest);
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureWrapS, IGLDevice::Repeat);
 			device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureWrapT, IGLDevice::Repeat);
-
-			w = map->Width();
-			h = map->Height();
-			d = map->Depth();
-
-			updateBitmapPitch = (w + 31) / 32;
-			updateBitmap.resize(updateBitmapPitch * h);
-
-			coarseBitmap.resize((w * h) >> (CoarseBits * 2));
-
-			bitmap.resize(w * h);
-			std::fill(updateBitmap.begin(), updateBitmap.end(), 0xffffffffUL);
-			std::fill(bitmap.begin(), bitmap.end(), 0xffffffffUL);
 		}
 
 		GLMapShadowRenderer::~GLMapShadowRenderer() {
@@ -85,75 +102,140 @@ namespace spades {
 			coarseUpdateBitmap.resize(coarseBitmap.size());
 			std::fill(coarseUpdateBitmap.begin(), coarseUpdateBitmap.end(), 0);
 
-			device.BindTexture(IGLDevice::Texture2D, texture);
+			std::vector<size_t> segments;
 			for (size_t i = 0; i < updateBitmap.size(); i++) {
+				if (updateBitmap[i] != 0)
+					segments.push_back(i);
+			}
+
+			std::vector<uint32_t> pixels;
+			pixels.resize(segments.size() * SegmentSize);
+			GenerateSegments(segments, pixels.data());
+
+			// The range of the modified pixels in each row (`rowMinX > rowMaxX` if none)
+			std::vector<int> rowMinX(h, w), rowMaxX(h, -1);
+
+			// The region of the radiosity to be invalidated, accumulated for
+			// each column of segments over consecutive rows
+			struct DirtyBox {
+				bool valid = false;
+				int lastRow;
+				int minX, minY, minZ, maxX, maxY, maxZ;
+			};
+			std::vector<DirtyBox> radiosityBoxes;
+			radiosityBoxes.resize(radiosity ? updateBitmapPitch : 0);
+			auto flushRadiosityBox = [&](DirtyBox &box) {
+				if (!box.valid)
+					return;
+				radiosity->ShadowMapChanged(box.minX, box.minY, box.minZ, box.maxX, box.maxY,
+				                            box.maxZ);
+				box.valid = false;
+			};
+
+			for (size_t k = 0; k < segments.size(); k++) {
+				size_t i = segments[k];
+				size_t column = i % updateBitmapPitch;
 				int y = static_cast<int>(i / updateBitmapPitch);
-				int x = static_cast<int>((i - y * updateBitmapPitch) * 32);
-				if (updateBitmap[i] == 0)
-					continue;
+				int x = static_cast<int>(column * SegmentSize);
 
-				size_t bitmapPixelPosBase = i * 32;
+				size_t bitmapPixelPosBase = i * SegmentSize;
+				const uint32_t *segmentPixels = pixels.data() + k * SegmentSize;
 
-				uint32_t pixels[32];
 				bool modified = false;
-				for (int j = 0; j < 32; j++) {
-					pixels[j] = GeneratePixel(x + j, y);
-					if (bitmap[bitmapPixelPosBase + j] != pixels[j]) {
-						if (radiosity) {
-							int dist = pixels[j] >> 24;
-							radiosity->GameMapChanged(x + j, (y + dist) & (h - 1), dist, map);
-
-							dist = bitmap[bitmapPixelPosBase + j] >> 24;
-							radiosity->GameMapChanged(x + j, (y + dist) & (h - 1), dist, map);
+				for (int j = 0; j < SegmentSize; j++) {
+					uint32_t &oldPixel = bitmap[bitmapPixelPosBase + j];
+					uint32_t newPixel = segmentPixels[j];
+					if (oldPixel == newPixel)
+						continue;
+
+					if (radiosity) {
+						DirtyBox &box = radiosityBoxes[column];
+						if (box.valid && box.lastRow < y - 1)
+							flushRadiosityBox(box);
+						box.lastRow = y;
+						for (int dist : {(int)(newPixel >> 24), (int)(oldPixel >> 24)}) {
+							if (!box.valid) {
+								box.valid = true;
+								box.minX = box.maxX = x + j;
+								box.minY = box.maxY = y + dist;
+								box.minZ = box.maxZ = dist;
+							} else {
+								box.minX = std::min(box.minX, x + j);
+								box.maxX = std::max(box.maxX, x + j);
+								box.minY = std::min(box.minY, y + dist);
+								box.maxY = std::max(box.maxY, y + dist);
+								box.minZ = std::min(box.minZ, dist);
+								box.maxZ = std::max(box.maxZ, dist);
+							}
 						}
-						bitmap[bitmapPixelPosBase + j] = pixels[j];
-						modified = true;
 					}
+
+					oldPixel = newPixel;
+					rowMinX[y] = std::min(rowMinX[y], x + j);
+					rowMaxX[y] = std::max(rowMaxX[y], x + j);
+					modified = true;
 				}
 
 				if (modified) {
 					if (!coarseUpdateBitmap[(x >> CoarseBits) +
 					                        (y >> CoarseBits) * (w >> CoarseBits)])
-						for (int j = 0; j < 32; j += CoarseSize)
+						for (int j = 0; j < SegmentSize; j += CoarseSize)
 							coarseUpdateBitmap[((x + j) >> CoarseBits) +
 							                   (y >> CoarseBits) * (w >> CoarseBits)] = 1;
-
-					device.TexSubImage2D(IGLDevice::Texture2D, 0, x, y, 32, 1, IGLDevice::RGBA,
-					                     IGLDevice::UnsignedByte, pixels);
 				}
 
 				updateBitmap[i] = 0;
 			}
 
+			for (DirtyBox &box : radiosityBoxes)
+				flushRadiosityBox(box);
+
+			// Upload the modified rectangles, merging nearby rows into a single upload.
+			// Uploads covering entire rows are sourced directly from `bitmap`.
+			{
+				device.BindTexture(IGLDevice::Texture2D, texture);
+				std::vector<uint32_t> uploadBuffer;
+				for (int y = 0; y < h;) {
+					if (rowMinX[y] > rowMaxX[y]) {
+						y++;
+						continue;
+					}
+
+					int startY = y, endY = y + 1;
+					int minX = rowMinX[y], maxX = rowMaxX[y];
+					for (int y2 = endY; y2 < h && y2 <= endY + MaxUploadGap; y2++) {
+						if (rowMinX[y2] <= rowMaxX[y2]) {
+							endY = y2 + 1;
+							minX = std::min(minX, rowMinX[y2]);
+							maxX = std::max(maxX, rowMaxX[y2]);
+						}
+					}
+
+					int rectWidth = maxX - minX + 1;
+					const uint32_t *src = bitmap.data() + startY * w;
+					if (rectWidth < w) {
+						uploadBuffer.resize(rectWidth * (endY - startY));
+						for (int y2 = startY; y2 < endY; y2++) {
+							const uint32_t *row = bitmap.data() + y2 * w + minX;
+							std::copy(row, row + rectWidth,
+							          uploadBuffer.begin() + (y2 - startY) * rectWidth);
+						}
+						src = uploadBuffer.data();
+					}
+
+					device.TexSubImage2D(IGLDevice::Texture2D, 0, minX, startY, rectWidth,
+					                     endY - startY, IGLDevice::RGBA, IGLDevice::UnsignedByte,
+					                     src);
+					y = endY;
+				}
+			}
+
 			{
 				bool coarseUpdated = false;
 				int bx = 0, by = 0;
 				for (size_t i = 0; i < coarseUpdateBitmap.size(); i++) {
 					if (coarseUpdateBitmap[i]) {
-						int minValue = -1, maxValue = 0;
-
-						uint32_t *bmp = bitmap.data();
-						bmp += bx + by * w;
-						for (int y = 0; y < CoarseSize; y++) {
-							for (int x = 0; x < CoarseSize; x++) {
-								uint32_t value = bmp[x];
-								int depth = (int)(value >> 24);
-								if (minValue == -1) {
-									minValue = maxValue = depth;
-								} else {
-									if (depth < minValue)
-										minValue = depth;
-									if (depth > maxValue)
-										maxValue = depth;
-								}
-							}
-							bmp += w;
-						}
-
-						uint32_t out = minValue << 16;
-						out |= maxValue << 8;
-						coarseBitmap[i] = out;
-
+						coarseBitmap[i] = ComputeCoarsePixel(bx, by);
 						coarseUpdated = true;
 					}
 					bx += CoarseSize;
@@ -174,6 +256,33 @@ namespace spades {
 			}
 		}
 
+		/** Computes the depth range of the block of `bitmap` at (`bx`, `by`). */
+		uint32_t GLMapShadowRenderer::ComputeCoarsePixel(int bx, int by) {
+			int minValue = -1, maxValue = 0;
+
+			const uint32_t *bmp = bitmap.data();
+			bmp += bx + by * w;
+			for (int y = 0; y < CoarseSize; y++) {
+				for (int x = 0; x < CoarseSize; x++) {
+					uint32_t value = bmp[x];
+					int depth = (int)(value >> 24);
+					if (minValue == -1) {
+						minValue = maxValue = depth;
+					} else {
+						if (depth < minValue)
+							minValue = depth;
+						if (depth > maxValue)
+							maxValue = depth;
+					}
+				}
+				bmp += w;
+			}
+
+			uint32_t out = minValue << 16;
+			out |= maxValue << 8;
+			return out;
+		}
+
 		static uint32_t BuildPixel(int distance, uint32_t color, bool side) {
 			int r = (uint8_t)(color);
 			int g = (uint8_t)(color >> 8);
@@ -196,25 +305,123 @@ namespace spades {
 			       (ex3 << 23);
 		}
 
-		uint32_t GLMapShadowRenderer::GeneratePixel(int x, int y) {
-			for (int z = 0; z < d; z++) {
-				// z-plane hit
-				if (map->IsSolid(x, y, z) && z < 63) {
-					return BuildPixel(z, map->GetColor(x, y, z), false);
-					// return (uint8_t)z;
+		static int CountTrailingZeros(uint64_t v) {
+			SPAssert(v != 0);
+#if defined(__GNUC__)
+			return __builtin_ctzll(v);
+#else
+			int n = 0;
+			while (!(v & 1)) {
+				v >>= 1;
+				n++;
+			}
+			return n;
+#endif
+		}
+
+		/**
+		 * Generates `SegmentSize` pixels starting at (`x`, `y`).
+		 *
+		 * A sun ray starting at the pixel (x, y) passes (x, y + z, z) and
+		 * (x, y + z + 1, z) for each depth `z`. Instead of testing these voxels one by
+		 * one, the solid bits are collected into per-pixel bitmasks for all pixels of
+		 * the segment at once, and the first hit is found by a bit scan.
+		 */
+		void GLMapShadowRenderer::GenerateSegment(int x, int y, uint32_t *out) {
+			// Bit `z` is set if the ray hits the z-plane (top face) or the
+			// y-plane (side face) of a voxel at depth `z`.
+			uint64_t zHits[SegmentSize] = {};
+			uint64_t yHits[SegmentSize] = {};
+
+			// Voxels at z >= 63 never cast a shadow
+			const int maxDepth = std::min(d, 63);
+			for (int z = 0; z < maxDepth; z += 8) {
+				for (int z2 = z; z2 < z + 8 && z2 < maxDepth; z2++) {
+					uint64_t bit = 1ULL << z2;
+					int y1 = (y + z2) & (h - 1);
+					int y2 = (y + z2 + 1) & (h - 1);
+					for (int j = 0; j < SegmentSize; j++) {
+						zHits[j] |= map->GetSolidMap(x + j, y1) & bit;
+						yHits[j] |= map->GetSolidMap(x + j, y2) & bit;
+					}
+				}
+
+				bool allHit = true;
+				for (int j = 0; j < SegmentSize; j++)
+					allHit &= (zHits[j] | yHits[j]) != 0;
+				if (allHit)
+					break;
+			}
+
+			for (int j = 0; j < SegmentSize; j++) {
+				uint64_t hits = zHits[j] | yHits[j];
+				if (hits == 0) {
+					out[j] = BuildPixel(64, map->GetColor(x + j, (y + 64) & (h - 1), 63), false);
+					continue;
 				}
 
-				y = y + 1;
-				if (y == h)
-					y = 0;
+				// The z-plane is tested first at the same depth
+				int z = CountTrailingZeros(hits);
+				if (zHits[j] & (1ULL << z)) {
+					out[j] = BuildPixel(z, map->GetColor(x + j, (y + z) & (h - 1), z), false);
+				} else {
+					out[j] =
+					  BuildPixel(z + 1, map->GetColor(x + j, (y + z + 1) & (h - 1), z), true);
+				}
+			}
+		}
 
-				// y-plane hit
-				if (map->IsSolid(x, y, z) && z < 63) {
-					return BuildPixel(z + 1, map->GetColor(x, y, z), true);
-					// return (uint8_t)z + 1;
+		/**
+		 * Generates the pixels of the specified segments (indices into
+		 * `updateBitmap`). Large updates (e.g., the initial generation after
+		 * loading a map) are split by rows and run in parallel.
+		 */
+		void GLMapShadowRenderer::GenerateSegments(const std::vector<size_t> &segments,
+		                                           uint32_t *out) {
+			SPADES_MARK_FUNCTION();
+
+			auto generate = [&](size_t begin, size_t end) {
+				for (size_t k = begin; k < end; k++) {
+					size_t i = segments[k];
+					int y = static_cast<int>(i / updateBitmapPitch);
+					int x = static_cast<int>((i % updateBitmapPitch) * SegmentSize);
+					GenerateSegment(x, y, out + k * SegmentSize);
 				}
+			};
+
+			// Not worth the dispatch overhead for a few blocks
+			const size_t parallelThreshold = updateBitmapPitch * 32;
+			int numThreads = 1;
+			if (segments.size() >= parallelThreshold)
+				numThreads = ConcurrentDispatch::GetNumWorkerThreads();
+			if (numThreads <= 1) {
+				generate(0, segments.size());
+				return;
+			}
+
+			// Split at row boundaries (`segments` is sorted)
+			std::vector<size_t> splits;
+			splits.push_back(0);
+			for (int t = 1; t < numThreads; t++) {
+				size_t k = segments.size() * t / numThreads;
+				k = std::max(k, splits.back());
+				while (k < segments.size() && k > 0 &&
+				       segments[k] / updateBitmapPitch == segments[k - 1] / updateBitmapPitch)
+					k++;
+				splits.push_back(k);
+			}
+			splits.push_back(segments.size());
+
+			std::vector<std::unique_ptr<ConcurrentDispatch>> dispatches;
+			for (int t = 1; t < numThreads; t++) {
+				size_t begin = splits[t], end = splits[t + 1];
+				auto f = [=, &generate]() { generate(begin, end); };
+				dispatches.emplace_back(new FunctionDispatch<decltype(f)>(f));
+				dispatches.back()->Start();
 			}
-			return BuildPixel(64, map->GetColor(x, y == h ? 0 : y, 63), false);
+			generate(splits[0], splits[1]);
+			for (auto &dispatch : dispatches)
+				dispatch->Join();
 		}
 
 		void GLMapShadowRenderer::MarkUpdate(int x, int y) {
@@ -37,6 +37,13 @@ namespace spades {
 			friend class GLRadiosityRenderer;
 
 			enum { CoarseSize = 8, CoarseBits = 3 };
+			/** The number of pixels generated at once by `GenerateSegment`. */
+			enum { SegmentSize = 32 };
+			/**
+			 * Dirty rows closer than this are uploaded together, along with the
+			 * rows in-between.
+			 */
+			enum { MaxUploadGap = 8 };
 
 			GLRenderer& renderer;
 			IGLDevice& device;
@@ -52,8 +59,10 @@ namespace spades {
 			std::vector<uint32_t> bitmap;
 			std::vector<uint32_t> coarseBitmap;
 
-			uint32_t GeneratePixel(int x, int y);
+			void GenerateSegment(int x, int y, uint32_t* out);
+			void GenerateSegments(const std::vector<size_t>& segments, uint32_t* out);
 			void MarkUpdate(int x, int y);
+			uint32_t ComputeCoarsePixel(int bx, int by);
 
 		public:
 			GLMapShadowRenderer(GLRenderer& renderer, client::GameMap* map);
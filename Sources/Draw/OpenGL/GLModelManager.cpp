@@ -19,18 +19,29 @@
  */
 
 #include <memory>
+#include <set>
 
 #include "GLModelManager.h"
 #include "GLOptimizedVoxelModel.h"
 #include "GLRenderer.h"
+#include "GLSettings.h"
 #include <Core/Debug.h>
 #include <Core/IStream.h>
+#include <Core/ParallelLoad.h>
 #include <Core/Settings.h>
+#include <Core/Stopwatch.h>
 #include <Core/VoxelModel.h>
 #include <Core/VoxelModelLoader.h>
 
 namespace spades {
 	namespace draw {
+		namespace {
+			struct LoadedModel {
+				Handle<VoxelModel> voxelModel;
+				std::unique_ptr<GLOptimizedVoxelModel::Mesh> mesh;
+			};
+		} // namespace
+
 		GLModelManager::GLModelManager(GLRenderer& r) : renderer{r} { SPADES_MARK_FUNCTION(); }
 		GLModelManager::~GLModelManager() { SPADES_MARK_FUNCTION(); }
 
@@ -49,8 +60,48 @@ namespace spades {
 		Handle<GLModel> GLModelManager::CreateModel(const char* name) {
 			SPADES_MARK_FUNCTION();
 
+			// Meshing takes long enough to cause a hitch when a model first
+			// appears mid-game, so it's done by a worker thread
 			auto voxelModel = VoxelModelLoader::Load(name);
-			return renderer.CreateModel(*voxelModel).Cast<GLModel>();
+			return GLOptimizedVoxelModel::CreateInBackground(*voxelModel, renderer,
+			                                                 renderer.GetSettings().r_modelMeshCache)
+			  .Cast<GLModel>();
+		}
+
+		void GLModelManager::PreloadModels(const std::vector<std::string>& names) {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<std::string> pending;
+			std::set<std::string> seen;
+			for (const std::string& name : names) {
+				if (models.find(name) == models.end() && seen.insert(name).second)
+					pending.push_back(name);
+			}
+			if (pending.empty())
+				return;
+
+			Stopwatch sw;
+			bool useMeshCache = renderer.GetSettings().r_modelMeshCache;
+			ParallelLoad<LoadedModel>(
+			  pending.size(),
+			  [&](std::size_t i) {
+				  LoadedModel result;
+				  result.voxelModel = VoxelModelLoader::Load(pending[i].c_str());
+				  result.mesh = GLOptimizedVoxelModel::BuildMesh(*result.voxelModel, useMeshCache);
+				  return result;
+			  },
+			  [&](std::size_t i, LoadedModel result) {
+				  // On failure, retry synchronously so the error is reported
+				  // the same way as `RegisterModel` does
+				  models[pending[i]] =
+				    result.mesh ? Handle<GLOptimizedVoxelModel>::New(
+				                    result.voxelModel.GetPointerOrNull(), renderer,
+				                    std::move(result.mesh))
+				                    .Cast<GLModel>()
+				                : CreateModel(pending[i].c_str());
+			  });
+			SPLog("Preloaded %d model(s) in %.3f seconds", static_cast<int>(pending.size()),
+			      sw.GetTime());
 		}
 
 		void GLModelManager::ClearCache() { models.clear(); }
@@ -22,6 +22,7 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <Client/IModel.h>
 #include <Core/RefCountedObject.h>
@@ -40,6 +41,10 @@ namespace spades {
 			~GLModelManager();
 			Handle<GLModel> RegisterModel(const char*);
 
+			/** Loads the specified models on the worker threads and creates
+			 * GL models from them as they become ready. */
+			void PreloadModels(const std::vector<std::string>&);
+
 			void ClearCache();
 		};
 	} // namespace draw
@@ -0,0 +1,238 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <cstring>
+
+#include "GLNullDevice.h"
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace draw {
+		GLNullDevice::GLNullDevice(Integer width, Integer height)
+		    : width(width), height(height), nextName(1) {
+			SPADES_MARK_FUNCTION();
+			SPLog("Using the null OpenGL device (%dx%d); nothing will be displayed", width,
+			      height);
+		}
+
+		GLNullDevice::~GLNullDevice() { SPADES_MARK_FUNCTION(); }
+
+		void GLNullDevice::DepthRange(Float, Float) {}
+		void GLNullDevice::Viewport(Integer, Integer, Sizei, Sizei) {}
+
+		void GLNullDevice::ClearDepth(Float) {}
+		void GLNullDevice::ClearColor(Float, Float, Float, Float) {}
+		void GLNullDevice::Clear(Enum) {}
+
+		void GLNullDevice::Finish() {}
+		void GLNullDevice::Flush() {}
+
+		void GLNullDevice::DepthMask(bool) {}
+		void GLNullDevice::ColorMask(bool, bool, bool, bool) {}
+
+		void GLNullDevice::PolygonMode(Enum, Enum) {}
+		void GLNullDevice::PolygonOffset(Float, Float) {}
+
+		void GLNullDevice::CullFaceMode(Enum) {}
+		void GLNullDevice::FrontFace(Enum) {}
+		void GLNullDevice::Enable(Enum, bool) {}
+
+		IGLDevice::Integer GLNullDevice::GetInteger(Enum) { return 0; }
+
+		const char* GLNullDevice::GetString(Enum type) {
+			switch (type) {
+				case Vendor: return "OpenSpades";
+				case Renderer: return "Null Device";
+				case Version: return "3.3";
+				case ShadingLanguageVersion: return "3.30";
+				default: return "";
+			}
+		}
+		const char* GLNullDevice::GetIndexedString(Enum, UInteger) { return nullptr; }
+
+		void GLNullDevice::BlendEquation(Enum) {}
+		void GLNullDevice::BlendEquation(Enum, Enum) {}
+		void GLNullDevice::BlendFunc(Enum, Enum) {}
+		void GLNullDevice::BlendFunc(Enum, Enum, Enum, Enum) {}
+		void GLNullDevice::BlendColor(Float, Float, Float, Float) {}
+		void GLNullDevice::DepthFunc(Enum) {}
+		void GLNullDevice::LineWidth(Float) {}
+
+		IGLDevice::UInteger GLNullDevice::GenBuffer() { return GenName(); }
+		void GLNullDevice::DeleteBuffer(UInteger buffer) {
+			bufferStorage.erase(buffer);
+			for (auto& binding : boundBuffers) {
+				if (binding.second == buffer)
+					binding.second = 0;
+			}
+		}
+		void GLNullDevice::BindBuffer(Enum target, UInteger buffer) {
+			boundBuffers[target] = buffer;
+		}
+
+		void* GLNullDevice::MapBuffer(Enum target, Enum) {
+			std::vector<char>& storage = bufferStorage[boundBuffers[target]];
+			return storage.empty() ? nullptr : storage.data();
+		}
+		void GLNullDevice::UnmapBuffer(Enum) {}
+
+		void GLNullDevice::BufferData(Enum target, Sizei size, const void* data, Enum) {
+			std::vector<char>& storage = bufferStorage[boundBuffers[target]];
+			storage.resize(size);
+			if (data)
+				std::memcpy(storage.data(), data, size);
+		}
+		void GLNullDevice::BufferSubData(Enum target, Sizei offset, Sizei size,
+		                                 const void* data) {
+			std::vector<char>& storage = bufferStorage[boundBuffers[target]];
+			if (data && offset + size <= storage.size())
+				std::memcpy(storage.data() + offset, data, size);
+		}
+
+		IGLDevice::UInteger GLNullDevice::GenQuery() { return GenName(); }
+		void GLNullDevice::DeleteQuery(UInteger) {}
+		void GLNullDevice::BeginQuery(Enum, UInteger) {}
+		void GLNullDevice::EndQuery(Enum) {}
+		IGLDevice::UInteger GLNullDevice::GetQueryObjectUInteger(UInteger, Enum pname) {
+			// Results are always available immediately
+			return pname == QueryResultAvailable ? 1 : 0;
+		}
+		IGLDevice::UInteger64 GLNullDevice::GetQueryObjectUInteger64(UInteger, Enum pname) {
+			return pname == QueryResultAvailable ? 1 : 0;
+		}
+		void GLNullDevice::BeginConditionalRender(UInteger, Enum) {}
+		void GLNullDevice::EndConditionalRender() {}
+
+		IGLDevice::UInteger GLNullDevice::GenTexture() { return GenName(); }
+		void GLNullDevice::DeleteTexture(UInteger) {}
+
+		void GLNullDevice::ActiveTexture(UInteger) {}
+		void GLNullDevice::BindTexture(Enum, UInteger) {}
+		void GLNullDevice::TexParamater(Enum, Enum, Enum) {}
+		void GLNullDevice::TexParamater(Enum, Enum, float) {}
+		void GLNullDevice::TexImage2D(Enum, Integer, Enum, Sizei, Sizei, Integer, Enum, Enum,
+		                              const void*) {}
+		void GLNullDevice::TexImage3D(Enum, Integer, Enum, Sizei, Sizei, Sizei, Integer, Enum,
+		                              Enum, const void*) {}
+		void GLNullDevice::TexSubImage2D(Enum, Integer, Integer, Integer, Sizei, Sizei, Enum,
+		                                 Enum, const void*) {}
+		void GLNullDevice::TexSubImage3D(Enum, Integer, Integer, Integer, Integer, Sizei, Sizei,
+		                                 Sizei, Enum, Enum, const void*) {}
+		void GLNullDevice::CopyTexSubImage2D(Enum, Integer, Integer, Integer, Integer, Integer,
+		                                     Sizei, Sizei) {}
+		void GLNullDevice::GenerateMipmap(Enum) {}
+
+		void GLNullDevice::VertexAttrib(UInteger, Float) {}
+		void GLNullDevice::VertexAttrib(UInteger, Float, Float) {}
+		void GLNullDevice::VertexAttrib(UInteger, Float, Float, Float) {}
+		void GLNullDevice::VertexAttrib(UInteger, Float, Float, Float, Float) {}
+
+		void GLNullDevice::VertexAttribPointer(UInteger, Integer, Enum, bool, Sizei,
+		                                       const void*) {}
+		void GLNullDevice::VertexAttribIPointer(UInteger, Integer, Enum, Sizei, const void*) {}
+		void GLNullDevice::EnableVertexAttribArray(UInteger, bool) {}
+		void GLNullDevice::VertexAttribDivisor(UInteger, UInteger) {}
+		bool GLNullDevice::SupportsInstancedArrays() { return true; }
+
+		void GLNullDevice::DrawArrays(Enum, Integer, Sizei) {}
+		void GLNullDevice::DrawElements(Enum, Sizei, Enum, const void*) {}
+		void GLNullDevice::DrawArraysInstanced(Enum, Integer, Sizei, Sizei) {}
+		void GLNullDevice::DrawElementsInstanced(Enum, Sizei, Enum, const void*, Sizei) {}
+
+		IGLDevice::UInteger GLNullDevice::CreateShader(Enum) { return GenName(); }
+		void GLNullDevice::ShaderSource(UInteger, Sizei, const char**, const int*) {}
+		void GLNullDevice::CompileShader(UInteger) {}
+		void GLNullDevice::DeleteShader(UInteger) {}
+		IGLDevice::Integer GLNullDevice::GetShaderInteger(UInteger, Enum param) {
+			return param == CompileStatus ? 1 : 0;
+		}
+		void GLNullDevice::GetShaderInfoLog(UInteger, Sizei bufferSize, Sizei* length,
+		                                    char* outString) {
+			if (bufferSize > 0)
+				outString[0] = 0;
+			if (length)
+				*length = 0;
+		}
+		IGLDevice::Integer GLNullDevice::GetProgramInteger(UInteger, Enum param) {
+			return param == LinkStatus || param == ValidateStatus ? 1 : 0;
+		}
+		void GLNullDevice::GetProgramInfoLog(UInteger, Sizei bufferSize, Sizei* length,
+		                                     char* outString) {
+			if (bufferSize > 0)
+				outString[0] = 0;
+			if (length)
+				*length = 0;
+		}
+
+		IGLDevice::UInteger GLNullDevice::CreateProgram() { return GenName(); }
+		void GLNullDevice::AttachShader(UInteger, UInteger) {}
+		void GLNullDevice::DetachShader(UInteger, UInteger) {}
+		void GLNullDevice::LinkProgram(UInteger) {}
+		void GLNullDevice::UseProgram(UInteger) {}
+		void GLNullDevice::DeleteProgram(UInteger) {}
+		void GLNullDevice::ValidateProgram(UInteger) {}
+		bool GLNullDevice::SupportsProgramBinary() { return false; }
+		void GLNullDevice::ProgramBinaryRetrievableHint(UInteger) {}
+		bool GLNullDevice::GetProgramBinary(UInteger, UInteger&, std::vector<char>&) {
+			return false;
+		}
+		bool GLNullDevice::ProgramBinary(UInteger, UInteger, const void*, Sizei) {
+			return false;
+		}
+		bool GLNullDevice::SupportsParallelShaderCompile() { return false; }
+		void GLNullDevice::MaxShaderCompilerThreads(UInteger) {}
+		IGLDevice::Integer GLNullDevice::GetAttribLocation(UInteger, const char*) { return 0; }
+		void GLNullDevice::BindAttribLocation(UInteger, UInteger, const char*) {}
+		IGLDevice::Integer GLNullDevice::GetUniformLocation(UInteger, const char*) { return 0; }
+		void GLNullDevice::Uniform(Integer, Float) {}
+		void GLNullDevice::Uniform(Integer, Float, Float) {}
+		void GLNullDevice::Uniform(Integer, Float, Float, Float) {}
+		void GLNullDevice::Uniform(Integer, Float, Float, Float, Float) {}
+		void GLNullDevice::Uniform(Integer, Integer) {}
+		void GLNullDevice::Uniform(Integer, Integer, Integer) {}
+		void GLNullDevice::Uniform(Integer, Integer, Integer, Integer) {}
+		void GLNullDevice::Uniform(Integer, Integer, Integer, Integer, Integer) {}
+		void GLNullDevice::Uniform(Integer, bool, const Matrix4&) {}
+
+		IGLDevice::UInteger GLNullDevice::GenRenderbuffer() { return GenName(); }
+		void GLNullDevice::DeleteRenderbuffer(UInteger) {}
+		void GLNullDevice::BindRenderbuffer(Enum, UInteger) {}
+		void GLNullDevice::RenderbufferStorage(Enum, Enum, Sizei, Sizei) {}
+		void GLNullDevice::RenderbufferStorage(Enum, Sizei, Enum, Sizei, Sizei) {}
+
+		IGLDevice::UInteger GLNullDevice::GenFramebuffer() { return GenName(); }
+		void GLNullDevice::BindFramebuffer(Enum, UInteger) {}
+		void GLNullDevice::DeleteFramebuffer(UInteger) {}
+		void GLNullDevice::FramebufferTexture2D(Enum, Enum, Enum, UInteger, Integer) {}
+		void GLNullDevice::FramebufferRenderbuffer(Enum, Enum, Enum, UInteger) {}
+		void GLNullDevice::BlitFramebuffer(Integer, Integer, Integer, Integer, Integer, Integer,
+		                                   Integer, Integer, UInteger, Enum) {}
+		IGLDevice::Enum GLNullDevice::CheckFramebufferStatus(Enum) { return FramebufferComplete; }
+
+		void GLNullDevice::ReadPixels(Integer, Integer, Sizei, Sizei, Enum, Enum, void*) {
+			// The contents of the output buffer are left unchanged
+		}
+
+		IGLDevice::Integer GLNullDevice::ScreenWidth() { return width; }
+		IGLDevice::Integer GLNullDevice::ScreenHeight() { return height; }
+
+		void GLNullDevice::Swap() {}
+	} // namespace draw
+} // namespace spades
@@ -18,6 +18,9 @@
 
  */
 
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
 #include <set>
 
 #include "CellToTriangle.h"
@@ -33,29 +36,124 @@
 #include "IGLShadowMapRenderer.h"
 #include <Core/Bitmap.h>
 #include <Core/BitmapAtlasGenerator.h>
+#include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
 #include <Core/Exception.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
 
 namespace spades {
 	namespace draw {
-		void GLOptimizedVoxelModel::PreloadShaders(GLRenderer& renderer) {
+		namespace {
+			const uint32_t MeshCacheMagic = 0x4d565053; // "SPVM"
+			/** Must be bumped whenever the mesh builder's output changes. */
+			const uint32_t MeshCacheFormatVersion = 1;
+
+			/** 64-bit FNV-1a hash. */
+			void HashBytes(uint64_t& hash, const void* data, std::size_t size) {
+				const unsigned char* bytes = static_cast<const unsigned char*>(data);
+				for (std::size_t i = 0; i < size; i++) {
+					hash ^= bytes[i];
+					hash *= 1099511628211ULL;
+				}
+			}
+		} // namespace
+
+		void GLOptimizedVoxelModel::PreloadShaders(GLRenderer& renderer,
+		                                           std::vector<std::string>& programs,
+		                                           std::vector<std::string>& images) {
 			if (renderer.GetSettings().r_physicalLighting)
-				renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelPhys.program");
+				programs.push_back("Shaders/OpenGL/OptimizedVoxelModelPhys.program");
 			else
-				renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModel.program");
-			renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelDynamicLit.program");
-			renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelShadowMap.program");
-			renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelOutlines.program");
-			renderer.RegisterImage("Gfx/AmbientOcclusion.png");
+				programs.push_back("Shaders/OpenGL/OptimizedVoxelModel.program");
+			programs.push_back("Shaders/OpenGL/OptimizedVoxelModelDynamicLit.program");
+			programs.push_back("Shaders/OpenGL/OptimizedVoxelModelShadowMap.program");
+			programs.push_back("Shaders/OpenGL/OptimizedVoxelModelOutlines.program");
+			if (renderer.GetSettings().r_modelInstancing &&
+			    renderer.GetGLDevice().SupportsInstancedArrays()) {
+				if (renderer.GetSettings().r_physicalLighting)
+					programs.push_back("Shaders/OpenGL/OptimizedVoxelModelPhysInstanced.program");
+				else
+					programs.push_back("Shaders/OpenGL/OptimizedVoxelModelInstanced.program");
+				programs.push_back("Shaders/OpenGL/OptimizedVoxelModelShadowMapInstanced.program");
+			}
+			images.push_back("Gfx/AmbientOcclusion.png");
 		}
+		class GLOptimizedVoxelModel::MeshBuilder {
+		public:
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+			std::vector<uint16_t> bmpIndex; // bmp id for vertex (not index)
+			std::vector<Bitmap*> bmps;
+
+			~MeshBuilder() {
+				for (Bitmap* bmp : bmps)
+					bmp->Release();
+			}
+
+			uint8_t calcAOID(VoxelModel*, int x, int y, int z,
+				int ux, int uy, int uz, int vx, int vy, int vz);
+			// v major
+			void EmitSlice(uint8_t* slice, int usize, int vsize, int sx, int sy, int sz, int ux,
+			               int uy, int uz, int vx, int vy, int vz, int mx, int my, int mz,
+			               bool flip, VoxelModel*);
+			void BuildVertices(VoxelModel*);
+			/** Packs the slice bitmaps into an atlas and moves the texture
+			 * coordinates accordingly. */
+			Handle<Bitmap> GenerateTexture();
+		};
+
 		GLOptimizedVoxelModel::GLOptimizedVoxelModel(VoxelModel* m, GLRenderer& r)
 			: renderer{r}, device{r.GetGLDevice()} {
 			SPADES_MARK_FUNCTION();
 
-			BuildVertices(m);
-			GenerateTexture();
+			Initialize(m);
+			UploadMesh(*BuildMesh(*m, false));
+		}
+
+		GLOptimizedVoxelModel::GLOptimizedVoxelModel(VoxelModel* m, GLRenderer& r,
+		                                             std::unique_ptr<Mesh> mesh)
+			: renderer{r}, device{r.GetGLDevice()} {
+			SPADES_MARK_FUNCTION();
+
+			Initialize(m);
+			if (mesh)
+				UploadMesh(*mesh);
+			else
+				meshPending = true;
+		}
+
+		Handle<GLOptimizedVoxelModel>
+		GLOptimizedVoxelModel::CreateInBackground(VoxelModel& m, GLRenderer& r,
+		                                          bool useMeshCache) {
+			SPADES_MARK_FUNCTION();
+
+			auto model = Handle<GLOptimizedVoxelModel>::New(&m, r, nullptr);
+
+			// `*model` joins the dispatch before it's destroyed
+			GLOptimizedVoxelModel* self = model.GetPointerOrNull();
+			Handle<VoxelModel> voxelModel{m};
+			auto build = [self, voxelModel, useMeshCache]() {
+				std::unique_ptr<Mesh> mesh;
+				try {
+					mesh = BuildMesh(*voxelModel, useMeshCache);
+				} catch (const std::exception& ex) {
+					SPLog("Failed to build the mesh of a voxel model: %s", ex.what());
+					// an empty mesh; nothing will be drawn
+					mesh = stmp::make_unique<Mesh>();
+				}
+				self->builtMesh.store(std::move(mesh));
+			};
+			model->meshBuildDispatch.reset(new FunctionDispatch<decltype(build)>(build));
+			model->meshBuildDispatch->Start();
+
+			return model;
+		}
 
-			if (r.GetSettings().r_physicalLighting)
+		void GLOptimizedVoxelModel::Initialize(VoxelModel* m) {
+			SPADES_MARK_FUNCTION();
+
+			if (renderer.GetSettings().r_physicalLighting)
 				program = renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelPhys.program");
 			else
 				program = renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModel.program");
@@ -64,18 +162,26 @@ namespace spades {
 			outlinesProgram = renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelOutlines.program");
 			aoImage = renderer.RegisterImage("Gfx/AmbientOcclusion.png").Cast<GLImage>();
 
-			buffer = device.GenBuffer();
-			device.BindBuffer(IGLDevice::ArrayBuffer, buffer);
-			device.BufferData(IGLDevice::ArrayBuffer,
-							  static_cast<IGLDevice::Sizei>(vertices.size() * sizeof(Vertex)),
-							  vertices.data(), IGLDevice::StaticDraw);
+			instancing = renderer.GetSettings().r_modelInstancing && device.SupportsInstancedArrays();
+			instancedProgram = nullptr;
+			instancedShadowMapProgram = nullptr;
+			instanceBuffer = 0;
+			if (instancing) {
+				if (renderer.GetSettings().r_physicalLighting)
+					instancedProgram = renderer.RegisterProgram(
+					  "Shaders/OpenGL/OptimizedVoxelModelPhysInstanced.program");
+				else
+					instancedProgram =
+					  renderer.RegisterProgram("Shaders/OpenGL/OptimizedVoxelModelInstanced.program");
+				instancedShadowMapProgram = renderer.RegisterProgram(
+				  "Shaders/OpenGL/OptimizedVoxelModelShadowMapInstanced.program");
+				instanceBuffer = device.GenBuffer();
+			}
 
-			idxBuffer = device.GenBuffer();
-			device.BindBuffer(IGLDevice::ArrayBuffer, idxBuffer);
-			device.BufferData(IGLDevice::ArrayBuffer,
-							  static_cast<IGLDevice::Sizei>(indices.size() * sizeof(uint32_t)),
-							  indices.data(), IGLDevice::StaticDraw);
-			device.BindBuffer(IGLDevice::ArrayBuffer, 0);
+			buffer = 0;
+			idxBuffer = 0;
+			numIndices = 0;
+			meshPending = false;
 
 			origin = m->GetOrigin();
 			origin -= 0.5F; // (0,0,0) is center of voxel (0,0,0)
@@ -97,20 +203,186 @@ namespace spades {
 
 			boundingBox.min = minPos;
 			boundingBox.max = maxPos;
+		}
+
+		void GLOptimizedVoxelModel::UploadMesh(Mesh& mesh) {
+			SPADES_MARK_FUNCTION();
+
+			if (!mesh.atlas) {
+				// failed to build
+				numIndices = 0;
+				return;
+			}
+
+			image = renderer.CreateImage(*mesh.atlas).Cast<GLImage>();
+
+			buffer = device.GenBuffer();
+			device.BindBuffer(IGLDevice::ArrayBuffer, buffer);
+			device.BufferData(IGLDevice::ArrayBuffer,
+							  static_cast<IGLDevice::Sizei>(mesh.vertices.size() * sizeof(Vertex)),
+							  mesh.vertices.data(), IGLDevice::StaticDraw);
+
+			idxBuffer = device.GenBuffer();
+			device.BindBuffer(IGLDevice::ArrayBuffer, idxBuffer);
+			device.BufferData(IGLDevice::ArrayBuffer,
+							  static_cast<IGLDevice::Sizei>(mesh.indices.size() * sizeof(uint32_t)),
+							  mesh.indices.data(), IGLDevice::StaticDraw);
+			device.BindBuffer(IGLDevice::ArrayBuffer, 0);
 
-			// clean up
-			numIndices = (unsigned int)indices.size();
-			std::vector<Vertex>().swap(vertices);
-			std::vector<uint32_t>().swap(indices);
+			numIndices = (unsigned int)mesh.indices.size();
 		}
+
+		bool GLOptimizedVoxelModel::PrepareMesh() {
+			if (meshPending) {
+				std::unique_ptr<Mesh> mesh = builtMesh.take();
+				if (!mesh)
+					return false; // still building; draw nothing meanwhile
+
+				meshBuildDispatch->Join();
+				meshBuildDispatch.reset();
+				UploadMesh(*mesh);
+				meshPending = false;
+			}
+			return numIndices > 0;
+		}
+
 		GLOptimizedVoxelModel::~GLOptimizedVoxelModel() {
 			SPADES_MARK_FUNCTION();
 
-			device.DeleteBuffer(idxBuffer);
-			device.DeleteBuffer(buffer);
+			// must be done before `builtMesh` is destroyed
+			meshBuildDispatch.reset();
+
+			if (idxBuffer)
+				device.DeleteBuffer(idxBuffer);
+			if (buffer)
+				device.DeleteBuffer(buffer);
+			if (instanceBuffer)
+				device.DeleteBuffer(instanceBuffer);
+		}
+
+		std::unique_ptr<GLOptimizedVoxelModel::Mesh>
+		GLOptimizedVoxelModel::BuildMesh(VoxelModel& model, bool useCache) {
+			SPADES_MARK_FUNCTION();
+
+			std::string cachePath;
+			if (useCache) {
+				cachePath = GetMeshCachePath(model);
+				std::unique_ptr<Mesh> mesh = LoadCachedMesh(cachePath);
+				if (mesh)
+					return mesh;
+			}
+
+			MeshBuilder builder;
+			builder.BuildVertices(&model);
+
+			auto mesh = stmp::make_unique<Mesh>();
+			mesh->atlas = builder.GenerateTexture();
+			mesh->vertices = std::move(builder.vertices);
+			mesh->indices = std::move(builder.indices);
+
+			if (useCache)
+				SaveCachedMesh(*mesh, cachePath);
+
+			return mesh;
 		}
 
-		void GLOptimizedVoxelModel::GenerateTexture() {
+		std::string GLOptimizedVoxelModel::GetMeshCachePath(VoxelModel& model) {
+			int w = model.GetWidth();
+			int h = model.GetHeight();
+			int d = model.GetDepth();
+
+			uint64_t hash = 14695981039346656037ULL;
+			const uint32_t header[4] = {MeshCacheFormatVersion, static_cast<uint32_t>(w),
+			                            static_cast<uint32_t>(h), static_cast<uint32_t>(d)};
+			HashBytes(hash, header, sizeof(header));
+			for (int y = 0; y < h; y++) {
+				for (int x = 0; x < w; x++) {
+					uint64_t bits = model.GetSolidBitsAt(x, y);
+					HashBytes(hash, &bits, sizeof(bits));
+
+					// colors of empty voxels don't matter
+					for (int z = 0; z < d; z++) {
+						if (bits & (1ULL << z))
+							HashBytes(hash, &model.GetColor(x, y, z), sizeof(uint32_t));
+					}
+				}
+			}
+
+			char buf[64];
+			std::snprintf(buf, sizeof(buf), "Cache/Models/%016llx.bin",
+			              static_cast<unsigned long long>(hash));
+			return buf;
+		}
+
+		std::unique_ptr<GLOptimizedVoxelModel::Mesh>
+		GLOptimizedVoxelModel::LoadCachedMesh(const std::string& path) {
+			SPADES_MARK_FUNCTION();
+
+			if (!FileManager::FileExists(path.c_str()))
+				return nullptr;
+
+			try {
+				auto stream = FileManager::OpenForReading(path.c_str());
+				// magic, version, vertex count, index count, atlas width, atlas height
+				uint32_t header[6];
+				if (stream->Read(header, sizeof(header)) < sizeof(header) ||
+				    header[0] != MeshCacheMagic || header[1] != MeshCacheFormatVersion ||
+				    header[3] % 3 != 0 || header[4] < 1 || header[5] < 1 ||
+				    header[4] > 16384 || header[5] > 16384)
+					return nullptr;
+
+				auto mesh = stmp::make_unique<Mesh>();
+				mesh->vertices.resize(header[2]);
+				mesh->indices.resize(header[3]);
+				Handle<Bitmap> atlas = Handle<Bitmap>::New(static_cast<int>(header[4]),
+				                                           static_cast<int>(header[5]));
+
+				std::size_t vertexBytes = mesh->vertices.size() * sizeof(Vertex);
+				std::size_t indexBytes = mesh->indices.size() * sizeof(uint32_t);
+				std::size_t pixelBytes = header[4] * header[5] * sizeof(uint32_t);
+				if (stream->Read(mesh->vertices.data(), vertexBytes) < vertexBytes ||
+				    stream->Read(mesh->indices.data(), indexBytes) < indexBytes ||
+				    stream->Read(atlas->GetPixels(), pixelBytes) < pixelBytes)
+					return nullptr;
+
+				for (uint32_t index : mesh->indices) {
+					if (index >= header[2])
+						return nullptr;
+				}
+
+				mesh->atlas = std::move(atlas);
+				return mesh;
+			} catch (const std::exception& ex) {
+				SPLog("Failed to read the cached voxel model mesh '%s': %s", path.c_str(),
+				      ex.what());
+				return nullptr;
+			}
+		}
+
+		void GLOptimizedVoxelModel::SaveCachedMesh(const Mesh& mesh, const std::string& path) {
+			SPADES_MARK_FUNCTION();
+
+			try {
+				auto stream = FileManager::OpenForWriting(path.c_str());
+				uint32_t header[6] = {MeshCacheMagic,
+				                      MeshCacheFormatVersion,
+				                      static_cast<uint32_t>(mesh.vertices.size()),
+				                      static_cast<uint32_t>(mesh.indices.size()),
+				                      static_cast<uint32_t>(mesh.atlas->GetWidth()),
+				                      static_cast<uint32_t>(mesh.atlas->GetHeight())};
+				stream->Write(header, sizeof(header));
+				stream->Write(mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex));
+				stream->Write(mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t));
+				stream->Write(mesh.atlas->GetPixels(), static_cast<std::size_t>(
+				                                         mesh.atlas->GetWidth() *
+				                                         mesh.atlas->GetHeight()) *
+				                                         sizeof(uint32_t));
+			} catch (const std::exception& ex) {
+				SPLog("Failed to save the voxel model mesh '%s': %s", path.c_str(), ex.what());
+			}
+		}
+
+		Handle<Bitmap> GLOptimizedVoxelModel::MeshBuilder::GenerateTexture() {
 			BitmapAtlasGenerator atlasGen;
 			std::map<Bitmap*, int> idx;
 			std::vector<IntVector3> poss;
@@ -145,11 +417,12 @@ namespace spades {
 
 			std::vector<uint16_t>().swap(bmpIndex);
 
-			image = renderer.CreateImage(*bmp).Cast<GLImage>();
+			return bmp;
 		}
 
-		uint8_t GLOptimizedVoxelModel::calcAOID(VoxelModel* m, int x, int y, int z, int ux, int uy,
-												int uz, int vx, int vy, int vz) {
+		uint8_t GLOptimizedVoxelModel::MeshBuilder::calcAOID(VoxelModel* m, int x, int y, int z,
+															 int ux, int uy, int uz, int vx,
+															 int vy, int vz) {
 			int v = 0;
 			if (m->IsSolid(x - ux, y - uy, z - uz))
 				v |= 1;
@@ -234,10 +507,11 @@ namespace spades {
 			return (x1 - x3) * (y2 - y1) - (x1 - x2) * (y3 - y1);
 		}
 
-		void GLOptimizedVoxelModel::EmitSlice(uint8_t* slice, int usize, int vsize, int sx, int sy,
-											  int sz, int ux, int uy, int uz, int vx, int vy,
-											  int vz, int mx, int my, int mz, bool flip,
-											  VoxelModel* model) {
+		void GLOptimizedVoxelModel::MeshBuilder::EmitSlice(uint8_t* slice, int usize, int vsize,
+														   int sx, int sy, int sz, int ux,
+														   int uy, int uz, int vx, int vy,
+														   int vz, int mx, int my, int mz,
+														   bool flip, VoxelModel* model) {
 			SPADES_MARK_FUNCTION();
 			int minU = -1, minV = -1, maxU = -1, maxV = -1;
 
@@ -427,7 +701,7 @@ namespace spades {
 			}
 		}
 
-		void GLOptimizedVoxelModel::BuildVertices(spades::VoxelModel* model) {
+		void GLOptimizedVoxelModel::MeshBuilder::BuildVertices(spades::VoxelModel* model) {
 			SPADES_MARK_FUNCTION();
 
 			SPAssert(vertices.empty());
@@ -530,27 +804,106 @@ namespace spades {
 			RenderSunlightPass(params, ghostPass);
 		}
 
+		void GLOptimizedVoxelModel::UploadInstances() {
+			SPADES_MARK_FUNCTION();
+
+			// group instances sharing the same render states so that each group
+			// can be drawn by a single draw call
+			std::stable_sort(instances.begin(), instances.end(),
+			                 [](const Instance& a, const Instance& b) { return a.flags < b.flags; });
+
+			device.BindBuffer(IGLDevice::ArrayBuffer, instanceBuffer);
+			device.BufferData(IGLDevice::ArrayBuffer,
+							  static_cast<IGLDevice::Sizei>(instances.size() * sizeof(Instance)),
+							  instances.data(), IGLDevice::StreamDraw);
+			device.BindBuffer(IGLDevice::ArrayBuffer, 0);
+		}
+
+		void GLOptimizedVoxelModel::DrawInstances(int modelMatrixAttribute, int tintAttribute) {
+			SPADES_MARK_FUNCTION();
+
+			// a `mat4` attribute occupies four consecutive locations (one per column)
+			for (int i = 0; i < 4; i++) {
+				device.VertexAttribDivisor(modelMatrixAttribute + i, 1);
+				device.EnableVertexAttribArray(modelMatrixAttribute + i, true);
+			}
+			if (tintAttribute != -1) {
+				device.VertexAttribDivisor(tintAttribute, 1);
+				device.EnableVertexAttribArray(tintAttribute, true);
+			}
+
+			size_t first = 0;
+			while (first < instances.size()) {
+				uint32_t flags = instances[first].flags;
+				size_t last = first + 1;
+				while (last < instances.size() && instances[last].flags == flags)
+					last++;
+
+				size_t offset = first * sizeof(Instance);
+				device.BindBuffer(IGLDevice::ArrayBuffer, instanceBuffer);
+				for (int i = 0; i < 4; i++)
+					device.VertexAttribPointer(modelMatrixAttribute + i, 4,
+						IGLDevice::FloatType, false, sizeof(Instance),
+						(void*)(offset + offsetof(Instance, modelMatrix) + i * 4 * sizeof(float)));
+				if (tintAttribute != -1)
+					device.VertexAttribPointer(tintAttribute, 4,
+						IGLDevice::FloatType, false, sizeof(Instance),
+						(void*)(offset + offsetof(Instance, tint)));
+				device.BindBuffer(IGLDevice::ArrayBuffer, 0);
+
+				if (flags & InstanceMirrored)
+					device.FrontFace(IGLDevice::CCW);
+
+				if (flags & InstanceDepthHack)
+					device.DepthRange(0.0F, 0.1F);
+
+				device.DrawElementsInstanced(IGLDevice::Triangles, numIndices,
+					IGLDevice::UnsignedInt, (void*)0, static_cast<IGLDevice::Sizei>(last - first));
+
+				if (flags & InstanceMirrored)
+					device.FrontFace(IGLDevice::CW);
+
+				if (flags & InstanceDepthHack)
+					device.DepthRange(0.0F, 1.0F);
+
+				first = last;
+			}
+
+			for (int i = 0; i < 4; i++) {
+				device.EnableVertexAttribArray(modelMatrixAttribute + i, false);
+				device.VertexAttribDivisor(modelMatrixAttribute + i, 0);
+			}
+			if (tintAttribute != -1) {
+				device.EnableVertexAttribArray(tintAttribute, false);
+				device.VertexAttribDivisor(tintAttribute, 0);
+			}
+		}
+
 		void GLOptimizedVoxelModel::RenderShadowMapPass(
 			std::vector<client::ModelRenderParam> params) {
 			SPADES_MARK_FUNCTION();
 
+			if (!PrepareMesh())
+				return;
+
 			device.Enable(IGLDevice::CullFace, true);
 			device.Enable(IGLDevice::DepthTest, true);
 
-			shadowMapProgram->Use();
+			GLProgram* program = instancing ? instancedShadowMapProgram : shadowMapProgram;
+			program->Use();
 
 			static GLShadowMapShader shadowMapShader;
-			shadowMapShader(&renderer, shadowMapProgram, 0);
+			shadowMapShader(&renderer, program, 0);
 
 			static GLProgramUniform modelOrigin("modelOrigin");
-			modelOrigin(shadowMapProgram);
+			modelOrigin(program);
 			modelOrigin.SetValue(origin.x, origin.y, origin.z);
 
 			// setup attributes
 			static GLProgramAttribute positionAttribute("positionAttribute");
 			static GLProgramAttribute normalAttribute("normalAttribute");
-			positionAttribute(shadowMapProgram);
-			normalAttribute(shadowMapProgram);
+			positionAttribute(program);
+			normalAttribute(program);
 
 			device.BindBuffer(IGLDevice::ArrayBuffer, buffer);
 			device.VertexAttribPointer(positionAttribute(), 4,
@@ -566,6 +919,7 @@ namespace spades {
 
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, idxBuffer);
 
+			instances.clear();
 			for (const auto& param : params) {
 				if (param.depthHack || !param.castShadow || param.ghost)
 					continue;
@@ -581,11 +935,23 @@ namespace spades {
 				if (!renderer.GetShadowMapRenderer()->SphereCull(modelOrigin, rad))
 					continue;
 
+				bool isMirrored = Vector3::Dot(Vector3::Cross(axisX, axisY), axisZ) < 0.0F;
+
+				if (instancing) {
+					Instance instance;
+					instance.modelMatrix = modelMatrix;
+					instance.tint = MakeVector4(0.0F, 0.0F, 0.0F, 1.0F);
+					instance.flags = 0;
+					if (isMirrored)
+						instance.flags |= InstanceMirrored;
+					instances.push_back(instance);
+					continue;
+				}
+
 				static GLProgramUniform modelMatrixU("modelMatrix");
-				modelMatrixU(shadowMapProgram);
+				modelMatrixU(program);
 				modelMatrixU.SetValue(modelMatrix);
 
-				bool isMirrored = Vector3::Dot(Vector3::Cross(axisX, axisY), axisZ) < 0.0F;
 				if (isMirrored)
 					device.FrontFace(IGLDevice::CCW);
 
@@ -596,6 +962,14 @@ namespace spades {
 					device.FrontFace(IGLDevice::CW);
 			}
 
+			if (!instances.empty()) {
+				static GLProgramAttribute modelMatrixAttribute("modelMatrixAttribute");
+				modelMatrixAttribute(program);
+
+				UploadInstances();
+				DrawInstances(modelMatrixAttribute(), -1);
+			}
+
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, 0);
 
 			device.EnableVertexAttribArray(positionAttribute(), false);
@@ -610,6 +984,9 @@ namespace spades {
 			std::vector<client::ModelRenderParam> params, bool ghostPass) {
 			SPADES_MARK_FUNCTION();
 
+			if (!PrepareMesh())
+				return;
+
 			bool mirror = renderer.IsRenderingMirror();
 
 			const auto& viewOrigin = renderer.GetSceneDef().viewOrigin;
@@ -631,6 +1008,7 @@ namespace spades {
 			device.Enable(IGLDevice::CullFace, true);
 			device.Enable(IGLDevice::DepthTest, true);
 
+			GLProgram* program = instancing ? instancedProgram : this->program;
 			program->Use();
 
 			static GLShadowShader shadowShader;
@@ -662,6 +1040,12 @@ namespace spades {
 			modelTexture(program);
 			modelTexture.SetValue(1);
 
+			if (instancing) {
+				static GLProgramUniform projectionViewMatrix("projectionViewMatrix");
+				projectionViewMatrix(program);
+				projectionViewMatrix.SetValue(pvMat);
+			}
+
 			static GLProgramUniform viewMatrixU("viewMatrix");
 			viewMatrixU(program);
 			viewMatrixU.SetValue(viewMatrix);
@@ -704,6 +1088,7 @@ namespace spades {
 
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, idxBuffer);
 
+			instances.clear();
 			for (const auto& param : params) {
 				if (mirror && param.depthHack)
 					continue;
@@ -721,6 +1106,22 @@ namespace spades {
 				if (!renderer.SphereFrustrumCull(modelOrigin, rad))
 					continue;
 
+				bool isMirrored = Vector3::Dot(Vector3::Cross(axisX, axisY), axisZ) < 0.0F;
+
+				if (instancing) {
+					Instance instance;
+					instance.modelMatrix = modelMatrix;
+					instance.tint = MakeVector4(param.customColor.x, param.customColor.y,
+					                            param.customColor.z, param.opacity);
+					instance.flags = 0;
+					if (isMirrored)
+						instance.flags |= InstanceMirrored;
+					if (param.depthHack)
+						instance.flags |= InstanceDepthHack;
+					instances.push_back(instance);
+					continue;
+				}
+
 				static GLProgramUniform customColor("customColor");
 				customColor(program);
 				customColor.SetValue(param.customColor.x, param.customColor.y, param.customColor.z);
@@ -741,7 +1142,6 @@ namespace spades {
 				modelOpacity(program);
 				modelOpacity.SetValue(param.opacity);
 
-				bool isMirrored = Vector3::Dot(Vector3::Cross(axisX, axisY), axisZ) < 0.0F;
 				if (isMirrored)
 					device.FrontFace(IGLDevice::CCW);
 
@@ -758,6 +1158,16 @@ namespace spades {
 					device.DepthRange(0.0F, 1.0F);
 			}
 
+			if (!instances.empty()) {
+				static GLProgramAttribute modelMatrixAttribute("modelMatrixAttribute");
+				static GLProgramAttribute modelTintAttribute("modelTintAttribute");
+				modelMatrixAttribute(program);
+				modelTintAttribute(program);
+
+				UploadInstances();
+				DrawInstances(modelMatrixAttribute(), modelTintAttribute());
+			}
+
 			device.BindBuffer(IGLDevice::ElementArrayBuffer, 0);
 
 			device.EnableVertexAttribArray(positionAttribute(), false);
@@ -774,6 +1184,9 @@ namespace spades {
 			std::vector<client::ModelRenderParam> params, std::vector<GLDynamicLight> lights) {
 			SPADES_MARK_FUNCTION();
 
+			if (!PrepareMesh())
+				return;
+
 			bool mirror = renderer.IsRenderingMirror();
 
 			const auto& viewOrigin = renderer.GetSceneDef().viewOrigin;
@@ -911,6 +1324,9 @@ namespace spades {
 			std::vector<client::ModelRenderParam> params) {
 			SPADES_MARK_FUNCTION();
 
+			if (!PrepareMesh())
+				return;
+
 			bool mirror = renderer.IsRenderingMirror();
 
 			const auto& viewOrigin = renderer.GetSceneDef().viewOrigin;
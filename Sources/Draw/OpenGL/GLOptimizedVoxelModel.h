@@ -20,19 +20,26 @@
 
 #pragma once
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "GLModel.h"
 #include "IGLDevice.h"
+#include <Core/Bitmap.h>
+#include <Core/TMPUtils.h>
 #include <Core/VoxelModel.h>
 
 namespace spades {
+	class ConcurrentDispatch;
+
 	namespace draw {
 		class GLRenderer;
 		class GLProgram;
 		class GLImage;
 		class GLOptimizedVoxelModel : public GLModel {
 			class SliceGenerator;
+			class MeshBuilder;
 			struct Vertex {
 				uint8_t x, y, z;
 				uint8_t padding;
@@ -46,6 +53,32 @@ namespace spades {
 				uint8_t padding2;
 			};
 
+		public:
+			/** The mesh and the texture atlas of a model, built without
+			 * touching GL so that it can be done by a worker thread. */
+			struct Mesh {
+				std::vector<Vertex> vertices;
+				std::vector<uint32_t> indices;
+				Handle<Bitmap> atlas;
+			};
+
+		private:
+			enum InstanceFlags : uint32_t {
+				InstanceMirrored = 1 << 0,
+				InstanceDepthHack = 1 << 1
+			};
+
+			/** Per-instance data fed to the instanced programs. */
+			struct Instance {
+				Matrix4 modelMatrix;
+				// [customColor, opacity]
+				Vector4 tint;
+				// render states (`InstanceFlags`) instances are grouped by;
+				// not read by the shaders
+				uint32_t flags;
+				uint32_t padding[3];
+			};
+
 			GLRenderer& renderer;
 			// TODO: `*this` might outlive `GLRenderer`. Needs a safeguard!
 			IGLDevice& device;
@@ -54,15 +87,20 @@ namespace spades {
 			GLProgram* shadowMapProgram;
 			GLProgram* outlinesProgram;
 
+			/** `true` if instances are drawn with one instanced draw call per
+			 * render state (`r_modelInstancing`). */
+			bool instancing;
+			GLProgram* instancedProgram;
+			GLProgram* instancedShadowMapProgram;
+			IGLDevice::UInteger instanceBuffer;
+			/** Scratch list of the instances being drawn by the current pass. */
+			std::vector<Instance> instances;
+
 			Handle<GLImage> image;
 			Handle<GLImage> aoImage;
 
 			IGLDevice::UInteger buffer;
 			IGLDevice::UInteger idxBuffer;
-			std::vector<Vertex> vertices;
-			std::vector<uint32_t> indices;
-			std::vector<uint16_t> bmpIndex; // bmp id for vertex (not index)
-			std::vector<Bitmap*> bmps;
 			unsigned int numIndices;
 
 			Vector3 origin;
@@ -71,22 +109,54 @@ namespace spades {
 
 			AABB3 boundingBox;
 
-			uint8_t calcAOID(VoxelModel*, int x, int y, int z,
-				int ux, int uy, int uz, int vx, int vy, int vz);
-			// v major
-			void EmitSlice(uint8_t* slice, int usize, int vsize, int sx, int sy, int sz, int ux,
-			               int uy, int uz, int vx, int vy, int vz, int mx, int my, int mz,
-			               bool flip, VoxelModel*);
-			void BuildVertices(VoxelModel*);
-			void GenerateTexture();
+			/** `true` until the mesh built by `CreateInBackground` is uploaded. */
+			bool meshPending;
+			std::unique_ptr<ConcurrentDispatch> meshBuildDispatch;
+			/** Receives the mesh from `meshBuildDispatch`. */
+			stmp::atomic_unique_ptr<Mesh> builtMesh;
+
+			static std::string GetMeshCachePath(VoxelModel&);
+			static std::unique_ptr<Mesh> LoadCachedMesh(const std::string& path);
+			static void SaveCachedMesh(const Mesh&, const std::string& path);
+
+			void Initialize(VoxelModel*);
+			void UploadMesh(Mesh&);
+			/** Uploads the mesh built in background if it has arrived.
+			 * @return `true` if the model has anything to draw. */
+			bool PrepareMesh();
+
+			/** Uploads `instances` to `instanceBuffer`, grouped by their flags. */
+			void UploadInstances();
+			/** Draws the uploaded `instances` using one instanced draw call for
+			 * each distinct set of flags. `tintAttribute` may be `-1`. */
+			void DrawInstances(int modelMatrixAttribute, int tintAttribute);
 
 		protected:
 			~GLOptimizedVoxelModel();
 
 		public:
+			/** Builds the mesh synchronously. */
 			GLOptimizedVoxelModel(VoxelModel*, GLRenderer& r);
-
-			static void PreloadShaders(GLRenderer&);
+			/** Uses a mesh made by `BuildMesh`. (A null `mesh` is only used
+			 * internally by `CreateInBackground`.) */
+			GLOptimizedVoxelModel(VoxelModel*, GLRenderer& r, std::unique_ptr<Mesh> mesh);
+
+			/** Creates a model whose mesh is built on a worker thread. The model
+			 * is not drawn until the mesh is ready. */
+			static Handle<GLOptimizedVoxelModel>
+			CreateInBackground(VoxelModel&, GLRenderer& r, bool useMeshCache);
+
+			/**
+			 * Builds the mesh of a voxel model. Can be called from any thread.
+			 *
+			 * If `useCache` is `true`, the mesh is looked up in (and written back
+			 * to) the on-disk cache, which is keyed by the content of the model.
+			 */
+			static std::unique_ptr<Mesh> BuildMesh(VoxelModel&, bool useCache);
+
+			/** Appends the programs and images used by this renderer to the lists. */
+			static void PreloadShaders(GLRenderer&, std::vector<std::string>& programs,
+			                           std::vector<std::string>& images);
 
 			void Prerender(std::vector<client::ModelRenderParam> params, bool ghostPass) override;
 			void RenderShadowMapPass(std::vector<client::ModelRenderParam> params) override;
@@ -31,6 +31,7 @@
 
 #include "GLProfiler.h"
 
+#include "GLRecordingDevice.h"
 #include "GLRenderer.h"
 #include "GLSettings.h"
 #include "IGLDevice.h"
@@ -84,6 +85,7 @@ namespace spades {
 		    : m_settings{renderer.GetSettings()},
 		      m_renderer{renderer},
 		      m_device{renderer.GetGLDevice()},
+		      m_recorder{dynamic_cast<GLRecordingDevice*>(&m_device)},
 		      m_active{false},
 		      m_lastSaveTime{0.0},
 		      m_shouldSaveThisFrame{false},
@@ -551,9 +553,14 @@ namespace spades {
 		}
 
 		GLProfiler::Context::Context(GLProfiler& profiler, const char* format, ...)
-		    : m_profiler{profiler}, m_active{false} {
+		    : m_profiler{profiler}, m_active{false}, m_recording{false} {
 			SPADES_MARK_FUNCTION_DEBUG();
 
+			if (profiler.m_recorder) {
+				profiler.m_recorder->BeginPhase(format);
+				m_recording = true;
+			}
+
 			if (!profiler.m_active)
 				return;
 
@@ -571,10 +578,10 @@ namespace spades {
 		GLProfiler::Context::~Context() {
 			SPADES_MARK_FUNCTION_DEBUG();
 
-			if (!m_active)
-				return;
-
-			m_profiler.EndPhase();
+			if (m_active)
+				m_profiler.EndPhase();
+			if (m_recording)
+				m_profiler.m_recorder->EndPhase();
 		}
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -36,6 +36,7 @@ namespace spades {
 		class GLRenderer;
 		class GLSettings;
 		class GLImage;
+		class GLRecordingDevice;
 
 		class GLProfiler {
 			struct Phase;
@@ -44,6 +45,9 @@ namespace spades {
 			GLSettings& m_settings;
 			GLRenderer& m_renderer;
 			IGLDevice& m_device;
+			/** Non-null if `m_device` is a `GLRecordingDevice`, which is
+			 * notified of the phases regardless of `r_debugTiming`. */
+			GLRecordingDevice* m_recorder;
 			bool m_active;
 			double m_lastSaveTime;
 			bool m_shouldSaveThisFrame;
@@ -89,6 +93,7 @@ namespace spades {
 			class Context {
 				GLProfiler& m_profiler;
 				bool m_active;
+				bool m_recording;
 
 			public:
 				Context(GLProfiler& profiler, const char* format, ...);
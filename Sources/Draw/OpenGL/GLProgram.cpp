@@ -28,7 +28,8 @@
 
 namespace spades {
 	namespace draw {
-		GLProgram::GLProgram(IGLDevice* d, std::string name) : device(d), name(name) {
+		GLProgram::GLProgram(IGLDevice* d, std::string name)
+		    : device(d), linked(false), linkSubmitted(false), name(name) {
 			SPADES_MARK_FUNCTION();
 			handle = device->CreateProgram();
 		}
@@ -47,9 +48,17 @@ namespace spades {
 			device->AttachShader(handle, shader);
 		}
 
-		void GLProgram::Link() {
+		void GLProgram::SubmitLink() {
 			SPADES_MARK_FUNCTION();
+			if (linkSubmitted)
+				return;
 			device->LinkProgram(handle);
+			linkSubmitted = true;
+		}
+
+		void GLProgram::Link() {
+			SPADES_MARK_FUNCTION();
+			SubmitLink();
 
 			std::vector<char> errMsg;
 			errMsg.resize(device->GetProgramInteger(handle, IGLDevice::InfoLogLength) + 1);
@@ -70,6 +79,21 @@ namespace spades {
 			linked = true;
 		}
 
+		bool GLProgram::LoadBinary(IGLDevice::UInteger format, const std::vector<char>& data) {
+			SPADES_MARK_FUNCTION();
+			if (!device->ProgramBinary(handle, format, data.data(),
+			                           static_cast<IGLDevice::Sizei>(data.size())))
+				return false;
+			linked = true;
+			return true;
+		}
+
+		bool GLProgram::GetBinary(IGLDevice::UInteger& outFormat, std::vector<char>& outData) {
+			SPADES_MARK_FUNCTION();
+			SPAssert(linked);
+			return device->GetProgramBinary(handle, outFormat, outData);
+		}
+
 		void GLProgram::Validate() {
 			SPADES_MARK_FUNCTION();
 			device->ValidateProgram(handle);
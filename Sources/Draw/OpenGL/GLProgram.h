@@ -30,6 +30,7 @@ namespace spades {
 			IGLDevice* device;
 			IGLDevice::UInteger handle;
 			bool linked;
+			bool linkSubmitted;
 			std::string name;
 
 		public:
@@ -39,7 +40,16 @@ namespace spades {
 			void Attach(GLShader&);
 			void Attach(IGLDevice::UInteger shader);
 
+			/** Issues the link without waiting for its result. */
+			void SubmitLink();
+			/** Links the program (if not submitted yet) and checks the result. */
 			void Link();
+
+			/** Restores the linked program from a binary retrieved by
+			 * `GetBinary`. Returns `false` if the driver rejected it. */
+			bool LoadBinary(IGLDevice::UInteger format, const std::vector<char>& data);
+			/** Retrieves the driver-specific binary of the linked program. */
+			bool GetBinary(IGLDevice::UInteger& outFormat, std::vector<char>& outData);
 			void Validate();
 
 			bool IsLinked() const { return linked; }
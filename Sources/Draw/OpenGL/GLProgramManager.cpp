@@ -29,15 +29,58 @@
 #include <Core/Debug.h>
 #include <Core/Exception.h>
 #include <Core/FileManager.h>
+#include <Core/IStream.h>
 #include <Core/Math.h>
+#include <Core/ParallelLoad.h>
 #include <Core/Stopwatch.h>
 #include <Core/TMPUtils.h>
+#include <cstdio>
+#include <set>
 
 namespace spades {
 	namespace draw {
+		namespace {
+			const uint32_t ProgramBinaryMagic = 0x42505053; // "SPPB"
+			const uint32_t ProgramBinaryFormatVersion = 2;
+
+			/** 64-bit FNV-1a hash. */
+			void HashBytes(uint64_t& hash, const std::string& data) {
+				for (unsigned char c : data) {
+					hash ^= c;
+					hash *= 1099511628211ULL;
+				}
+				// separator
+				hash ^= 0xff;
+				hash *= 1099511628211ULL;
+			}
+
+			std::string GetDeviceString(IGLDevice& device, IGLDevice::Enum type) {
+				const char* str = device.GetString(type);
+				return str ? str : "";
+			}
+		} // namespace
+
 		GLProgramManager::GLProgramManager(IGLDevice& d, GLSettings& settings)
-		    : device(d), settings(settings) {
+		    : device(d), settings(settings), useBinaryCache(false), parallelCompile(false) {
 			SPADES_MARK_FUNCTION();
+
+			if (settings.r_programBinaryCache) {
+				if (device.SupportsProgramBinary()) {
+					useBinaryCache = true;
+					driverIdentifier = GetDeviceString(device, IGLDevice::Vendor) + "\n" +
+					                   GetDeviceString(device, IGLDevice::Renderer) + "\n" +
+					                   GetDeviceString(device, IGLDevice::Version) + "\n" +
+					                   GetDeviceString(device, IGLDevice::ShadingLanguageVersion);
+				} else {
+					SPLog("GL program binary cache is unavailable: not supported by the driver");
+				}
+			}
+
+			if (device.SupportsParallelShaderCompile()) {
+				device.MaxShaderCompilerThreads(0xffffffff);
+				parallelCompile = true;
+				SPLog("GL driver supports parallel shader compilation");
+			}
 		}
 
 		GLProgramManager::~GLProgramManager() { SPADES_MARK_FUNCTION(); }
@@ -70,14 +113,92 @@ namespace spades {
 			}
 		}
 
+		void GLProgramManager::PreloadPrograms(const std::vector<std::string>& names) {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<std::string> pending;
+			std::set<std::string> seen;
+			for (const std::string& name : names) {
+				if (programs.find(name) == programs.end() && seen.insert(name).second)
+					pending.push_back(name);
+			}
+			if (pending.empty())
+				return;
+
+			Stopwatch sw;
+
+			// Read the program files and the shader files they list on the
+			// worker threads. Special shaders (`*shadow*` etc.) are read later
+			// when they are registered.
+			using SourceList = std::vector<std::pair<std::string, std::string>>;
+			std::vector<PendingProgram> batch;
+			ParallelLoad<SourceList>(
+			  pending.size(),
+			  [&](std::size_t i) {
+				  SourceList sources;
+				  std::string text = FileManager::ReadAllBytes(pending[i].c_str());
+				  for (const auto& line : SplitIntoLines(text)) {
+					  std::string shaderName = TrimSpaces(line);
+					  if (shaderName.empty())
+						  break;
+					  if (shaderName[0] == '*' || shaderName[0] == '#')
+						  continue;
+					  sources.emplace_back(shaderName,
+					                       FileManager::ReadAllBytes(shaderName.c_str()));
+				  }
+				  sources.emplace_back(pending[i], std::move(text));
+				  return sources;
+			  },
+			  [&](std::size_t i, SourceList sources) {
+				  for (auto& source : sources)
+					  prefetchedSources.emplace(std::move(source.first), std::move(source.second));
+
+				  // Submit the compilation right away, without waiting for
+				  // the preceding programs
+				  batch.push_back(BeginProgram(pending[i]));
+				  if (!batch.back().loadedFromCache)
+					  SubmitProgram(batch.back());
+			  });
+			prefetchedSources.clear();
+
+			for (PendingProgram& p : batch)
+				programs[p.name] = FinishProgram(p);
+
+			SPLog("Preloaded %d GLSL program(s) in %.3f seconds (parallel compile: %s)",
+			      static_cast<int>(pending.size()), sw.GetTime(), parallelCompile ? "yes" : "no");
+		}
+
+		std::string GLProgramManager::ReadSource(const std::string& name) {
+			auto it = prefetchedSources.find(name);
+			if (it == prefetchedSources.end())
+				return FileManager::ReadAllBytes(name.c_str());
+
+			std::string text = std::move(it->second);
+			prefetchedSources.erase(it);
+			return text;
+		}
+
 		std::unique_ptr<GLProgram> GLProgramManager::CreateProgram(const std::string& name) {
 			SPADES_MARK_FUNCTION();
 
+			PendingProgram p = BeginProgram(name);
+			if (!p.loadedFromCache)
+				SubmitProgram(p);
+			return FinishProgram(p);
+		}
+
+		GLProgramManager::PendingProgram
+		GLProgramManager::BeginProgram(const std::string& name) {
+			SPADES_MARK_FUNCTION();
+
 			SPLog("Loading GLSL program '%s'", name.c_str());
-			std::string text = FileManager::ReadAllBytes(name.c_str());
+			std::string text = ReadSource(name);
 			std::vector<std::string> lines = SplitIntoLines(text);
 
-			auto p = stmp::make_unique<GLProgram>(&device, name);
+			PendingProgram result;
+			result.name = name;
+			result.program = stmp::make_unique<GLProgram>(&device, name);
+			std::vector<GLShader*>& programShaders = result.shaders;
 
 			for (const auto& line : lines) {
 				std::string text = TrimSpaces(line);
@@ -87,48 +208,175 @@ namespace spades {
 				if (text == "*shadow*") {
 					std::vector<GLShader*> shaders =
 					  GLShadowShader::RegisterShader(this, settings, false);
-					for (const auto& shader : shaders)
-						p->Attach(*shader);
+					programShaders.insert(programShaders.end(), shaders.begin(), shaders.end());
 				} else if (text == "*shadow-lite*") {
 					std::vector<GLShader*> shaders =
 					  GLShadowShader::RegisterShader(this, settings, false, true);
-					for (const auto& shader : shaders)
-						p->Attach(*shader);
+					programShaders.insert(programShaders.end(), shaders.begin(), shaders.end());
 				} else if (text == "*shadow-variance*") {
 					std::vector<GLShader*> shaders =
 					  GLShadowShader::RegisterShader(this, settings, true);
-					for (const auto& shader : shaders)
-						p->Attach(*shader);
+					programShaders.insert(programShaders.end(), shaders.begin(), shaders.end());
 				} else if (text == "*dlight*") {
 					std::vector<GLShader*> shaders = GLDynamicLightShader::RegisterShader(this);
-					for (const auto& shader : shaders)
-						p->Attach(*shader);
+					programShaders.insert(programShaders.end(), shaders.begin(), shaders.end());
 				} else if (text == "*shadowmap*") {
 					std::vector<GLShader*> shaders = GLShadowMapShader::RegisterShader(this);
-					for (const auto& shader : shaders)
-						p->Attach(*shader);
+					programShaders.insert(programShaders.end(), shaders.begin(), shaders.end());
 				} else if (text[0] == '*') {
 					SPRaise("Unknown special shader: %s", text.c_str());
 				} else if (text[0] == '#') {
 					// Comment line
 				} else {
-					auto shader = CreateShader(text);
-					p->Attach(*shader);
+					programShaders.push_back(RegisterShader(text));
+				}
+			}
+
+			// The cache key covers the driver and the final source code of
+			// every shader including the defines derived from `GLSettings`,
+			// so a stale binary is never used. Each program has a single
+			// cache file, which holds the key of its content; a stale binary
+			// is overwritten when the program is rebuilt, so the cache never
+			// grows beyond one file per program.
+			if (useBinaryCache) {
+				result.cachePath = GetBinaryCachePath(name);
+				result.cacheKey = GetBinaryCacheKey(name, programShaders);
+				Stopwatch sw;
+				if (LoadProgramBinary(*result.program, result.cachePath, result.cacheKey)) {
+					SPLog("Loaded GLSL program '%s' from the binary cache in %.3fms",
+					      name.c_str(), sw.GetTime() * 1000.0);
+					result.loadedFromCache = true;
 				}
 			}
+			return result;
+		}
+
+		void GLProgramManager::SubmitProgram(PendingProgram& p) {
+			SPADES_MARK_FUNCTION();
+
+			for (GLShader* shader : p.shaders) {
+				if (!shader->IsCompiled())
+					shader->SubmitCompile();
+				p.program->Attach(*shader);
+			}
+
+			if (useBinaryCache)
+				device.ProgramBinaryRetrievableHint(p.program->GetHandle());
+
+			p.program->SubmitLink();
+		}
+
+		std::unique_ptr<GLProgram> GLProgramManager::FinishProgram(PendingProgram& p) {
+			SPADES_MARK_FUNCTION();
+
+			if (p.loadedFromCache)
+				return std::move(p.program);
+
+			// Check the shaders first so that a compile error is reported
+			// as such rather than as a link error
+			for (GLShader* shader : p.shaders)
+				CompileShader(*shader);
 
 			Stopwatch sw;
-			p->Link();
+			p.program->Link();
 			SPLog("Successfully linked GLSL program '%s' in %.3fms",
-				name.c_str(), sw.GetTime() * 1000.0);
-			return p;
+				p.name.c_str(), sw.GetTime() * 1000.0);
+
+			if (useBinaryCache)
+				SaveProgramBinary(*p.program, p.cachePath, p.cacheKey);
+			return std::move(p.program);
+		}
+
+		uint64_t GLProgramManager::GetBinaryCacheKey(const std::string& name,
+		                                             const std::vector<GLShader*>& shaders) {
+			uint64_t hash = 14695981039346656037ULL;
+			HashBytes(hash, driverIdentifier);
+			HashBytes(hash, name);
+			for (GLShader* shader : shaders) {
+				HashBytes(hash, shader->GetName());
+				for (const std::string& source : shader->GetSources())
+					HashBytes(hash, source);
+			}
+			return hash;
+		}
+
+		std::string GLProgramManager::GetBinaryCachePath(const std::string& name) {
+			uint64_t hash = 14695981039346656037ULL;
+			HashBytes(hash, name);
+
+			char buf[64];
+			std::snprintf(buf, sizeof(buf), "Cache/Shaders/%016llx.bin",
+			              static_cast<unsigned long long>(hash));
+			return buf;
+		}
+
+		bool GLProgramManager::LoadProgramBinary(GLProgram& program, const std::string& path,
+		                                         uint64_t key) {
+			SPADES_MARK_FUNCTION();
+
+			if (!FileManager::FileExists(path.c_str()))
+				return false;
+
+			try {
+				auto stream = FileManager::OpenForReading(path.c_str());
+				// magic, version, key (low, high), binary format, binary length
+				uint32_t header[6];
+				if (stream->Read(header, sizeof(header)) < sizeof(header) ||
+				    header[0] != ProgramBinaryMagic || header[1] != ProgramBinaryFormatVersion)
+					return false;
+				if (header[2] != static_cast<uint32_t>(key) ||
+				    header[3] != static_cast<uint32_t>(key >> 32)) {
+					// Built from other sources or by another driver
+					return false;
+				}
+
+				std::vector<char> data(header[5]);
+				if (data.empty() || stream->Read(data.data(), data.size()) < data.size())
+					return false;
+
+				if (!program.LoadBinary(header[4], data)) {
+					// e.g., the driver was updated without changing the version
+					// string. It'll be overwritten with a new binary.
+					SPLog("GL driver rejected the cached binary of '%s'", path.c_str());
+					return false;
+				}
+				return true;
+			} catch (const std::exception& ex) {
+				SPLog("Failed to read the cached GL program binary '%s': %s", path.c_str(),
+				      ex.what());
+				return false;
+			}
+		}
+
+		void GLProgramManager::SaveProgramBinary(GLProgram& program, const std::string& path,
+		                                         uint64_t key) {
+			SPADES_MARK_FUNCTION();
+
+			IGLDevice::UInteger format;
+			std::vector<char> data;
+			if (!program.GetBinary(format, data) || data.empty())
+				return;
+
+			try {
+				auto stream = FileManager::OpenForWriting(path.c_str());
+				uint32_t header[6] = {ProgramBinaryMagic,
+				                      ProgramBinaryFormatVersion,
+				                      static_cast<uint32_t>(key),
+				                      static_cast<uint32_t>(key >> 32),
+				                      format,
+				                      static_cast<uint32_t>(data.size())};
+				stream->Write(header, sizeof(header));
+				stream->Write(data.data(), data.size());
+			} catch (const std::exception& ex) {
+				SPLog("Failed to save the GL program binary '%s': %s", path.c_str(), ex.what());
+			}
 		}
 
 		std::unique_ptr<GLShader> GLProgramManager::CreateShader(const std::string& name) {
 			SPADES_MARK_FUNCTION();
 
 			SPLog("Loading GLSL shader '%s'", name.c_str());
-			std::string text = FileManager::ReadAllBytes(name.c_str());
+			std::string text = ReadSource(name);
 
 			GLShader::Type type;
 			if (name.find(".fs") != std::string::npos)
@@ -140,7 +388,7 @@ namespace spades {
 			else
 				SPRaise("Failed to determine the type of a shader: %s", name.c_str());
 
-			auto s = stmp::make_unique<GLShader>(device, type);
+			auto s = stmp::make_unique<GLShader>(device, type, name);
 
 			std::string finalSource;
 
@@ -173,11 +421,20 @@ namespace spades {
 
 			s->AddSource(finalSource);
 
+			// Compiled by `SubmitProgram` when a program using this shader is
+			// not found in the binary cache
+			return s;
+		}
+
+		void GLProgramManager::CompileShader(GLShader& shader) {
+			SPADES_MARK_FUNCTION();
+			if (shader.IsCompiled())
+				return;
+
 			Stopwatch sw;
-			s->Compile();
+			shader.Compile();
 			SPLog("Successfully compiled GLSL shader '%s' in %.3fms",
-				name.c_str(), sw.GetTime() * 1000.0);
-			return s;
+				shader.GetName().c_str(), sw.GetTime() * 1000.0);
 		}
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -20,9 +20,11 @@
 
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 namespace spades {
 	namespace draw {
@@ -38,8 +40,43 @@ namespace spades {
 			std::unordered_map<std::string, std::unique_ptr<GLProgram>> programs;
 			std::unordered_map<std::string, std::unique_ptr<GLShader>> shaders;
 
+			/** Whether linked programs are saved to/restored from the disk. */
+			bool useBinaryCache;
+			/** Identifies the driver which produced the cached binaries. */
+			std::string driverIdentifier;
+
+			/** Whether the driver compiles shaders in background. */
+			bool parallelCompile;
+
+			/** Source files read ahead of time by `PreloadPrograms`. */
+			std::unordered_map<std::string, std::string> prefetchedSources;
+
+			/** A program whose shaders might still be being compiled by the driver. */
+			struct PendingProgram {
+				std::string name;
+				std::unique_ptr<GLProgram> program;
+				std::vector<GLShader*> shaders;
+				std::string cachePath;
+				uint64_t cacheKey = 0;
+				bool loadedFromCache = false;
+			};
+
+			std::string ReadSource(const std::string& name);
+			PendingProgram BeginProgram(const std::string& name);
+			void SubmitProgram(PendingProgram&);
+			std::unique_ptr<GLProgram> FinishProgram(PendingProgram&);
+
 			std::unique_ptr<GLProgram> CreateProgram(const std::string& name);
 			std::unique_ptr<GLShader> CreateShader(const std::string& name);
+			void CompileShader(GLShader&);
+
+			/** Identifies the driver and the final source code of a program. */
+			uint64_t GetBinaryCacheKey(const std::string& name,
+			                           const std::vector<GLShader*>& shaders);
+			/** The cache file of a program. It only depends on the name of the program. */
+			std::string GetBinaryCachePath(const std::string& name);
+			bool LoadProgramBinary(GLProgram&, const std::string& path, uint64_t key);
+			void SaveProgramBinary(GLProgram&, const std::string& path, uint64_t key);
 
 		public:
 			GLProgramManager(IGLDevice&, GLSettings& settings);
@@ -47,6 +84,12 @@ namespace spades {
 
 			GLProgram* RegisterProgram(const std::string& name);
 			GLShader* RegisterShader(const std::string& name);
+
+			/** Loads the specified programs in a batch. The source files are
+			 * read by worker threads, and all shaders are submitted to the
+			 * driver before waiting for any of them, so that a driver with
+			 * `GL_KHR_parallel_shader_compile` can compile them concurrently. */
+			void PreloadPrograms(const std::vector<std::string>& names);
 		};
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
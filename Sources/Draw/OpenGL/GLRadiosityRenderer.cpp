@@ -18,6 +18,7 @@
 
  */
 
+#include <algorithm>
 #include <atomic>
 #include <cstdlib>
 
@@ -136,17 +137,15 @@ namespace spades {
 					                     IGLDevice::UnsignedInt2101010Rev, v.data());
 				}
 			}
-			dispatch = NULL;
 
 			SPLog("Chunk texture initialized");
 		}
 
 		GLRadiosityRenderer::~GLRadiosityRenderer() {
 			SPADES_MARK_FUNCTION();
-			if (dispatch) {
+			updateCanceled = true;
+			for (auto& dispatch : dispatches)
 				dispatch->Join();
-				delete dispatch;
-			}
 			SPLog("Releasing textures");
 
 			device.DeleteTexture(textureFlat);
@@ -271,6 +270,13 @@ namespace spades {
 			           z + Envelope);
 		}
 
+		void GLRadiosityRenderer::ShadowMapChanged(int minX, int minY, int minZ, int maxX,
+		                                           int maxY, int maxZ) {
+			SPADES_MARK_FUNCTION_DEBUG();
+			Invalidate(minX - Envelope, minY - Envelope, minZ - Envelope, maxX + Envelope,
+			           maxY + Envelope, maxZ + Envelope);
+		}
+
 		void GLRadiosityRenderer::Invalidate(int minX, int minY, int minZ, int maxX, int maxY, int maxZ) {
 			SPADES_MARK_FUNCTION_DEBUG();
 			if (minZ < 0)
@@ -280,6 +286,8 @@ namespace spades {
 			if (minX > maxX || minY > maxY || minZ > maxZ)
 				return;
 
+			numInvalidations++;
+
 			// these should be floor div
 			int cx1 = minX >> ChunkSizeBits;
 			int cy1 = minY >> ChunkSizeBits;
@@ -288,6 +296,7 @@ namespace spades {
 			int cy2 = maxY >> ChunkSizeBits;
 			int cz2 = maxZ >> ChunkSizeBits;
 
+			std::lock_guard<std::mutex> lock(dirtyMutex);
 			for (int cx = cx1; cx <= cx2; cx++)
 			for (int cy = cy1; cy <= cy2; cy++)
 			for (int cz = cz1; cz <= cz2; cz++) {
@@ -303,6 +312,7 @@ namespace spades {
 				int inMaxY = std::min(maxY - originY, ChunkSize - 1);
 				int inMaxZ = std::min(maxZ - originZ, ChunkSize - 1);
 
+				c.generation++;
 				if (!c.dirty) {
 					c.dirtyMinX = inMinX;
 					c.dirtyMinY = inMinY;
@@ -332,13 +342,30 @@ namespace spades {
 		}
 
 		void GLRadiosityRenderer::Update() {
-			if (GetNumDirtyChunks() > 0 && (dispatch == NULL || dispatch->done.load())) {
-				if (dispatch) {
+			bool updateDone = std::all_of(
+			  dispatches.begin(), dispatches.end(),
+			  [](const std::unique_ptr<UpdateDispatch>& d) { return d->done.load(); });
+			if (updateDone) {
+				for (auto& dispatch : dispatches)
 					dispatch->Join();
-					delete dispatch;
+				dispatches.clear();
+
+				if (GetNumDirtyChunks() > 0) {
+					StartUpdate();
+				} else if (!bakeDone) {
+					bakeDone = true;
+					SPLog("Radiosity computed in %.3f seconds using %d thread(s)",
+					      bakeStopwatch.GetTime(), ConcurrentDispatch::GetNumWorkerThreads());
+				}
+			} else if (!updateCanceled) {
+				// The queued chunks are out of order if the camera has moved to
+				// another chunk or some chunks were re-dirtied. Cancel the
+				// remaining work and build a new queue once the workers stop.
+				IntVector3 eye = GetEyeChunk();
+				if (eye.x != updateEyeChunk.x || eye.y != updateEyeChunk.y ||
+				    eye.z != updateEyeChunk.z || numInvalidations != updateNumInvalidations) {
+					updateCanceled = true;
 				}
-				dispatch = new UpdateDispatch(*this);
-				dispatch->Start();
 			}
 
 			int cnt = 0;
@@ -348,8 +375,13 @@ namespace spades {
 			}
 
 			GLProfiler::Context profiler(renderer.GetGLProfiler(), "Radiosity [>= %d chunk(s)]", cnt);
-			for (size_t i = 0; i < chunks.size(); i++) {
-				Chunk& c = chunks[i];
+
+			// Limit the number of uploads per frame. Scanning resumes where the
+			// previous frame stopped so that no chunk is starved.
+			int numUploads = 0;
+			for (size_t n = 0; n < chunks.size() && numUploads < MaxChunkUploadsPerFrame; n++) {
+				Chunk& c = chunks[uploadCursor];
+				uploadCursor = (uploadCursor + 1) % chunks.size();
 				if (!c.transferDone.exchange(true)) {
 					device.BindTexture(IGLDevice::Texture3D, textureFlat);
 					device.TexSubImage3D(IGLDevice::Texture3D, 0, c.cx * ChunkSize,
@@ -374,63 +406,64 @@ namespace spades {
 					                     c.cy * ChunkSize, c.cz * ChunkSize, ChunkSize, ChunkSize,
 					                     ChunkSize, IGLDevice::BGRA,
 					                     IGLDevice::UnsignedInt2101010Rev, c.dataZ);
+					numUploads++;
 				}
 			}
 		}
 
-		void GLRadiosityRenderer::UpdateDirtyChunks() {
-			int dirtyChunkIds[256];
-			int numDirtyChunks = 0;
-
-			// first, check only chunks in near range
+		IntVector3 GLRadiosityRenderer::GetEyeChunk() {
 			const auto& viewOrigin = renderer.GetSceneDef().viewOrigin;
-			int eyeX = (int)(viewOrigin.x) >> ChunkSizeBits;
-			int eyeY = (int)(viewOrigin.y) >> ChunkSizeBits;
-			int eyeZ = (int)(viewOrigin.z) >> ChunkSizeBits;
-
-			for (size_t i = 0; i < chunks.size(); i++) {
-				Chunk& c = chunks[i];
-				int dx = (c.cx - eyeX) & (chunkW - 1);
-				int dy = (c.cy - eyeY) & (chunkH - 1);
-				int dz = (c.cz - eyeZ);
-				if (dx >= 6 && dx <= chunkW - 6)
-					continue;
-				if (dy >= 6 && dy <= chunkW - 6)
-					continue;
-				if (dz >= 6 || dz <= -6)
-					continue;
-				if (c.dirty) {
-					dirtyChunkIds[numDirtyChunks++] = static_cast<int>(i);
-					if (numDirtyChunks >= 256)
-						break;
-				}
-			}
+			return {(int)(viewOrigin.x) >> ChunkSizeBits, (int)(viewOrigin.y) >> ChunkSizeBits,
+			        (int)(viewOrigin.z) >> ChunkSizeBits};
+		}
 
-			// far chunks
-			if (numDirtyChunks == 0) {
-				for (size_t i = 0; i < chunks.size(); i++) {
-					Chunk& c = chunks[i];
-					if (c.dirty) {
-						dirtyChunkIds[numDirtyChunks++] = static_cast<int>(i);
-						if (numDirtyChunks >= 256)
-							break;
-					}
-				}
+		/**
+		 * Queues the dirty chunks (nearest to the camera first) and starts updating
+		 * them on all worker threads. Each chunk is an independent task; the
+		 * workers take them from the queue until it's exhausted or canceled.
+		 */
+		void GLRadiosityRenderer::StartUpdate() {
+			SPADES_MARK_FUNCTION();
+
+			updateEyeChunk = GetEyeChunk();
+			updateNumInvalidations = numInvalidations;
+
+			const IntVector3& eye = updateEyeChunk;
+			auto distance = [&](std::size_t i) {
+				const Chunk& c = chunks[i];
+				// the map wraps around horizontally
+				int dx = ((c.cx - eye.x + chunkW / 2) & (chunkW - 1)) - chunkW / 2;
+				int dy = ((c.cy - eye.y + chunkH / 2) & (chunkH - 1)) - chunkH / 2;
+				int dz = c.cz - eye.z;
+				return dx * dx + dy * dy + dz * dz;
+			};
+
+			updateQueue.clear();
+			for (std::size_t i = 0; i < chunks.size(); i++) {
+				if (chunks[i].dirty)
+					updateQueue.push_back(i);
 			}
+			std::sort(updateQueue.begin(), updateQueue.end(),
+			          [&](std::size_t a, std::size_t b) { return distance(a) < distance(b); });
 
-			// limit update count per frame
-			for (int i = 0; i < 8; i++) {
-				if (numDirtyChunks <= 0)
-					break;
+			updateQueuePos = 0;
+			updateCanceled = false;
 
-				int idx = SampleRandomInt(0, numDirtyChunks - 1);
-				Chunk& c = chunks[dirtyChunkIds[idx]];
+			int numThreads = ConcurrentDispatch::GetNumWorkerThreads();
+			numThreads = std::max(std::min(numThreads, (int)updateQueue.size()), 1);
+			for (int i = 0; i < numThreads; i++) {
+				dispatches.emplace_back(new UpdateDispatch(*this));
+				dispatches.back()->Start();
+			}
+		}
 
-				// remove from list (fast)
-				if (idx < numDirtyChunks - 1)
-					std::swap(dirtyChunkIds[idx], dirtyChunkIds[numDirtyChunks - 1]);
-				numDirtyChunks--;
+		void GLRadiosityRenderer::UpdateDirtyChunks() {
+			while (!updateCanceled) {
+				std::size_t pos = updateQueuePos.fetch_add(1);
+				if (pos >= updateQueue.size())
+					break;
 
+				Chunk& c = chunks[updateQueue[pos]];
 				UpdateChunk(c.cx, c.cy, c.cz);
 			}
 		}
@@ -501,13 +534,27 @@ namespace spades {
 			if (!c.dirty)
 				return;
 
+			// Take a consistent snapshot; `Invalidate` may widen the region meanwhile
+			unsigned int generation;
+			int minX, minY, minZ, maxX, maxY, maxZ;
+			{
+				std::lock_guard<std::mutex> lock(dirtyMutex);
+				generation = c.generation;
+				minX = c.dirtyMinX;
+				minY = c.dirtyMinY;
+				minZ = c.dirtyMinZ;
+				maxX = c.dirtyMaxX;
+				maxY = c.dirtyMaxY;
+				maxZ = c.dirtyMaxZ;
+			}
+
 			int originX = cx * ChunkSize;
 			int originY = cy * ChunkSize;
 			int originZ = cz * ChunkSize;
 
-			for (int z = c.dirtyMinZ; z <= c.dirtyMaxZ; z++)
-			for (int y = c.dirtyMinY; y <= c.dirtyMaxY; y++)
-			for (int x = c.dirtyMinX; x <= c.dirtyMaxX; x++) {
+			for (int z = minZ; z <= maxZ; z++)
+			for (int y = minY; y <= maxY; y++)
+			for (int x = minX; x <= maxX; x++) {
 				IntVector3 pos;
 				pos.x = (x + originX);
 				pos.y = (y + originY);
@@ -520,7 +567,12 @@ namespace spades {
 				c.dataZ[z][y][x] = EncodeValue(res.z);
 			}
 
-			c.dirty = false;
+			// If the chunk was re-dirtied meanwhile, it has to be computed again
+			{
+				std::lock_guard<std::mutex> lock(dirtyMutex);
+				if (c.generation == generation)
+					c.dirty = false;
+			}
 			c.transferDone = false;
 		}
 	} // namespace draw
@@ -22,11 +22,14 @@
 
 #include <atomic>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "IGLDevice.h"
 #include <Core/Debug.h>
 #include <Core/Math.h>
+#include <Core/Stopwatch.h>
 
 namespace spades {
 	namespace client {
@@ -42,6 +45,8 @@ namespace spades {
 
 			class UpdateDispatch;
 			enum { ChunkSize = 16, ChunkSizeBits = 4, Envelope = 6 };
+			/** The maximum number of chunks uploaded to the textures per frame. */
+			enum { MaxChunkUploadsPerFrame = 64 };
 			GLRenderer &renderer;
 			IGLDevice &device;
 			GLSettings &settings;
@@ -53,11 +58,15 @@ namespace spades {
 				VoxelType dataX[ChunkSize][ChunkSize][ChunkSize];
 				VoxelType dataY[ChunkSize][ChunkSize][ChunkSize];
 				VoxelType dataZ[ChunkSize][ChunkSize][ChunkSize];
-				bool dirty = true;
+				/** Set by `Invalidate`. Cleared by `UpdateChunk` with `dirtyMutex` held. */
+				std::atomic<bool> dirty{true};
+				/** Guarded by `dirtyMutex`. */
 				int dirtyMinX = 0, dirtyMaxX = ChunkSize - 1;
 				int dirtyMinY = 0, dirtyMaxY = ChunkSize - 1;
 				int dirtyMinZ = 0, dirtyMaxZ = ChunkSize - 1;
 
+				/** Incremented by `Invalidate` with `dirtyMutex` held. */
+				std::atomic<unsigned int> generation{0};
 				std::atomic<bool> transferDone{true};
 			};
 
@@ -70,6 +79,11 @@ namespace spades {
 			int chunkW, chunkH, chunkD;
 
 			std::vector<Chunk> chunks;
+			/**
+			 * Serializes `Invalidate` (main thread) and `UpdateChunk` (update dispatches)
+			 * on the chunks' dirty regions.
+			 */
+			std::mutex dirtyMutex;
 
 			inline Chunk &GetChunk(int cx, int cy, int cz) {
 				SPAssert(cx >= 0);
@@ -91,11 +105,31 @@ namespace spades {
 			void UpdateChunk(int cx, int cy, int cz);
 			void UpdateDirtyChunks();
 			int GetNumDirtyChunks();
+			IntVector3 GetEyeChunk();
+			void StartUpdate();
 
 			uint32_t EncodeValue(Vector3 vec);
 			float CompressDynamicRange(float v);
 
-			UpdateDispatch *dispatch;
+			std::vector<std::unique_ptr<UpdateDispatch>> dispatches;
+
+			/** Chunks to be updated by `dispatches`, nearest first. */
+			std::vector<std::size_t> updateQueue;
+			std::atomic<std::size_t> updateQueuePos{0};
+			/** Tells `dispatches` to stop taking new chunks. */
+			std::atomic<bool> updateCanceled{false};
+			/** The chunk containing the camera when `updateQueue` was built. */
+			IntVector3 updateEyeChunk;
+			/** Incremented by `Invalidate`. Used to detect re-dirtied chunks. */
+			std::atomic<unsigned int> numInvalidations{0};
+			unsigned int updateNumInvalidations;
+
+			/** Where the next frame starts looking for chunks to upload. */
+			std::size_t uploadCursor = 0;
+
+			/** Measures the initial full-map computation. */
+			Stopwatch bakeStopwatch;
+			bool bakeDone = false;
 
 		public:
 			struct Result {
@@ -109,6 +143,12 @@ namespace spades {
 
 			void GameMapChanged(int x, int y, int z, client::GameMap *);
 
+			/**
+			 * Called by `GLMapShadowRenderer` when the terrain shadow map pixels
+			 * corresponding to the specified box (in world coordinates) have changed.
+			 */
+			void ShadowMapChanged(int minX, int minY, int minZ, int maxX, int maxY, int maxZ);
+
 			void Update();
 
 			IGLDevice::UInteger GetTextureFlat() { return textureFlat; }
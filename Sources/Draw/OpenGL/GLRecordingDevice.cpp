@@ -0,0 +1,755 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "GLRecordingDevice.h"
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace draw {
+		namespace {
+			std::uint64_t GetPixelSize(IGLDevice::Enum format, IGLDevice::Enum type) {
+				switch (type) {
+					case IGLDevice::UnsignedShort5551:
+					case IGLDevice::UnsignedShort1555Rev: return 2;
+					case IGLDevice::UnsignedInt2101010Rev: return 4;
+					default: break;
+				}
+
+				std::uint64_t numComponents;
+				switch (format) {
+					case IGLDevice::RG: numComponents = 2; break;
+					case IGLDevice::RGB: numComponents = 3; break;
+					case IGLDevice::RGBA:
+					case IGLDevice::BGRA: numComponents = 4; break;
+					default: numComponents = 1; break;
+				}
+
+				switch (type) {
+					case IGLDevice::Byte:
+					case IGLDevice::UnsignedByte: return numComponents;
+					case IGLDevice::Short:
+					case IGLDevice::UnsignedShort: return numComponents * 2;
+					default: return numComponents * 4;
+				}
+			}
+		} // namespace
+
+		GLRecordingDevice::Counters& GLRecordingDevice::Counters::
+		operator+=(const Counters& other) {
+			numCommands += other.numCommands;
+			numDrawCalls += other.numDrawCalls;
+			numVertices += other.numVertices;
+			numBinds += other.numBinds;
+			numRedundantBinds += other.numRedundantBinds;
+			bufferUploadBytes += other.bufferUploadBytes;
+			textureUploadBytes += other.textureUploadBytes;
+			return *this;
+		}
+
+		GLRecordingDevice::GLRecordingDevice(Handle<IGLDevice> base)
+		    : base(std::move(base)),
+		      numReportFrames(0),
+		      reportInterval(0.0),
+		      lastReportTime(0.0),
+		      activeTexture(0),
+		      currentProgram(0),
+		      drawFramebuffer(0),
+		      readFramebuffer(0),
+		      boundRenderbuffer(0) {
+			SPADES_MARK_FUNCTION();
+			SPAssert(this->base);
+
+			phases.emplace_back();
+			phases.back().path = "Frame";
+			reportCounters.emplace_back();
+		}
+
+		GLRecordingDevice::~GLRecordingDevice() { SPADES_MARK_FUNCTION(); }
+
+		void GLRecordingDevice::BeginPhase(const char* name) {
+			std::size_t parent = phaseStack.empty() ? 0 : phaseStack.back();
+			std::string path = phases[parent].path + "/" + name;
+
+			auto it = phaseIndices.find(path);
+			if (it == phaseIndices.end()) {
+				it = phaseIndices.emplace(path, phases.size()).first;
+				phases.emplace_back();
+				phases.back().path = std::move(path);
+				reportCounters.emplace_back();
+			}
+			phaseStack.push_back(it->second);
+		}
+
+		void GLRecordingDevice::EndPhase() {
+			SPAssert(!phaseStack.empty());
+			phaseStack.pop_back();
+		}
+
+		GLRecordingDevice::Counters GLRecordingDevice::GetFrameTotal() const {
+			Counters total;
+			for (const PhaseStatistics& phase : lastFrameStatistics)
+				total += phase.counters;
+			return total;
+		}
+
+		GLRecordingDevice::Counters& GLRecordingDevice::Record(const char* name) {
+			std::size_t phase = phaseStack.empty() ? 0 : phaseStack.back();
+			commandLog.push_back(Command{name, static_cast<std::uint32_t>(phase)});
+
+			Counters& counters = phases[phase].counters;
+			++counters.numCommands;
+			return counters;
+		}
+
+		void GLRecordingDevice::RecordBind(Counters& counters, UInteger& slot, UInteger object) {
+			++counters.numBinds;
+			if (slot == object)
+				++counters.numRedundantBinds;
+			slot = object;
+		}
+
+		void GLRecordingDevice::RecordDraw(Counters& counters, Sizei count, Sizei instances) {
+			++counters.numDrawCalls;
+			counters.numVertices += static_cast<std::uint64_t>(count) * instances;
+		}
+
+		void GLRecordingDevice::RecordTextureUpload(Counters& counters, Sizei width,
+		                                            Sizei height, Sizei depth, Enum format,
+		                                            Enum type, const void* data) {
+			// `data` is an offset if a pixel unpack buffer is bound
+			if (!data && boundBuffers[PixelUnpackBuffer] == 0)
+				return;
+			counters.textureUploadBytes += static_cast<std::uint64_t>(width) * height * depth *
+			                               GetPixelSize(format, type);
+		}
+
+		void GLRecordingDevice::LogReport() {
+			double factor = 1.0 / numReportFrames;
+			SPLog("---- Start of GLRecordingDevice Result ----");
+			SPLog("(%d frame(s). Showing the per-frame average of the calls issued in each "
+			      "phase, not including subphases)",
+			      numReportFrames);
+
+			Counters total;
+			for (const Counters& counters : reportCounters)
+				total += counters;
+
+			auto logCounters = [&](const std::string& name, const Counters& c) {
+				SPLog("%s - %.1f call(s), %.1f draw(s) (%.0f vertices), %.1f bind(s) "
+				      "(%.1f redundant), buffer upload %.1fKiB, texture upload %.1fKiB",
+				      name.c_str(), c.numCommands * factor, c.numDrawCalls * factor,
+				      c.numVertices * factor, c.numBinds * factor, c.numRedundantBinds * factor,
+				      c.bufferUploadBytes * factor / 1024.0,
+				      c.textureUploadBytes * factor / 1024.0);
+			};
+
+			logCounters("Total", total);
+			for (std::size_t i = 0; i < phases.size(); ++i) {
+				if (reportCounters[i].numCommands > 0)
+					logCounters(phases[i].path, reportCounters[i]);
+			}
+
+			// Redundant state changes eliminated by the underlying device
+			StateCacheStatistics cache = base->GetStateCacheStatistics();
+			std::uint64_t numCalls = cache.numCalls - reportStateCacheStatistics.numCalls;
+			std::uint64_t numSkipped = cache.numSkipped - reportStateCacheStatistics.numSkipped;
+			reportStateCacheStatistics = cache;
+			if (numCalls > 0) {
+				SPLog("State cache - %.1f state change(s), %.1f skipped (hit rate %.1f%%)",
+				      numCalls * factor, numSkipped * factor, numSkipped * 100.0 / numCalls);
+			}
+			SPLog("---- End of GLRecordingDevice Result ----");
+		}
+
+		void GLRecordingDevice::DepthRange(Float near, Float far) {
+			Record("DepthRange");
+			base->DepthRange(near, far);
+		}
+		void GLRecordingDevice::Viewport(Integer x, Integer y, Sizei width, Sizei height) {
+			Record("Viewport");
+			base->Viewport(x, y, width, height);
+		}
+
+		void GLRecordingDevice::ClearDepth(Float v) {
+			Record("ClearDepth");
+			base->ClearDepth(v);
+		}
+		void GLRecordingDevice::ClearColor(Float r, Float g, Float b, Float a) {
+			Record("ClearColor");
+			base->ClearColor(r, g, b, a);
+		}
+		void GLRecordingDevice::Clear(Enum bits) {
+			Record("Clear");
+			base->Clear(bits);
+		}
+
+		void GLRecordingDevice::Finish() {
+			Record("Finish");
+			base->Finish();
+		}
+		void GLRecordingDevice::Flush() {
+			Record("Flush");
+			base->Flush();
+		}
+
+		void GLRecordingDevice::DepthMask(bool mask) {
+			Record("DepthMask");
+			base->DepthMask(mask);
+		}
+		void GLRecordingDevice::ColorMask(bool r, bool g, bool b, bool a) {
+			Record("ColorMask");
+			base->ColorMask(r, g, b, a);
+		}
+
+		void GLRecordingDevice::PolygonMode(Enum face, Enum mode) {
+			Record("PolygonMode");
+			base->PolygonMode(face, mode);
+		}
+		void GLRecordingDevice::PolygonOffset(Float factor, Float units) {
+			Record("PolygonOffset");
+			base->PolygonOffset(factor, units);
+		}
+
+		void GLRecordingDevice::CullFaceMode(Enum mode) {
+			Record("CullFaceMode");
+			base->CullFaceMode(mode);
+		}
+		void GLRecordingDevice::FrontFace(Enum mode) {
+			Record("FrontFace");
+			base->FrontFace(mode);
+		}
+		void GLRecordingDevice::Enable(Enum state, bool enabled) {
+			Record("Enable");
+			base->Enable(state, enabled);
+		}
+
+		IGLDevice::Integer GLRecordingDevice::GetInteger(Enum type) {
+			Record("GetInteger");
+			return base->GetInteger(type);
+		}
+
+		const char* GLRecordingDevice::GetString(Enum type) {
+			Record("GetString");
+			return base->GetString(type);
+		}
+		const char* GLRecordingDevice::GetIndexedString(Enum type, UInteger index) {
+			Record("GetIndexedString");
+			return base->GetIndexedString(type, index);
+		}
+
+		void GLRecordingDevice::BlendEquation(Enum mode) {
+			Record("BlendEquation");
+			base->BlendEquation(mode);
+		}
+		void GLRecordingDevice::BlendEquation(Enum rgb, Enum alpha) {
+			Record("BlendEquation");
+			base->BlendEquation(rgb, alpha);
+		}
+		void GLRecordingDevice::BlendFunc(Enum src, Enum dest) {
+			Record("BlendFunc");
+			base->BlendFunc(src, dest);
+		}
+		void GLRecordingDevice::BlendFunc(Enum srcRgb, Enum destRgb, Enum srcAlpha,
+		                                  Enum destAlpha) {
+			Record("BlendFunc");
+			base->BlendFunc(srcRgb, destRgb, srcAlpha, destAlpha);
+		}
+		void GLRecordingDevice::BlendColor(Float r, Float g, Float b, Float a) {
+			Record("BlendColor");
+			base->BlendColor(r, g, b, a);
+		}
+		void GLRecordingDevice::DepthFunc(Enum func) {
+			Record("DepthFunc");
+			base->DepthFunc(func);
+		}
+		void GLRecordingDevice::LineWidth(Float width) {
+			Record("LineWidth");
+			base->LineWidth(width);
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::GenBuffer() {
+			Record("GenBuffer");
+			return base->GenBuffer();
+		}
+		void GLRecordingDevice::DeleteBuffer(UInteger buffer) {
+			Record("DeleteBuffer");
+			bufferSizes.erase(buffer);
+			for (auto& binding : boundBuffers) {
+				if (binding.second == buffer)
+					binding.second = 0;
+			}
+			base->DeleteBuffer(buffer);
+		}
+		void GLRecordingDevice::BindBuffer(Enum target, UInteger buffer) {
+			RecordBind(Record("BindBuffer"), boundBuffers[target], buffer);
+			base->BindBuffer(target, buffer);
+		}
+
+		void* GLRecordingDevice::MapBuffer(Enum target, Enum access) {
+			Counters& counters = Record("MapBuffer");
+			if (access != ReadOnly) {
+				// Assume the whole buffer is written
+				auto it = bufferSizes.find(boundBuffers[target]);
+				if (it != bufferSizes.end())
+					counters.bufferUploadBytes += it->second;
+			}
+			return base->MapBuffer(target, access);
+		}
+		void GLRecordingDevice::UnmapBuffer(Enum target) {
+			Record("UnmapBuffer");
+			base->UnmapBuffer(target);
+		}
+
+		void GLRecordingDevice::BufferData(Enum target, Sizei size, const void* data,
+		                                   Enum usage) {
+			Counters& counters = Record("BufferData");
+			bufferSizes[boundBuffers[target]] = size;
+			if (data)
+				counters.bufferUploadBytes += size;
+			base->BufferData(target, size, data, usage);
+		}
+		void GLRecordingDevice::BufferSubData(Enum target, Sizei offset, Sizei size,
+		                                      const void* data) {
+			Record("BufferSubData").bufferUploadBytes += size;
+			base->BufferSubData(target, offset, size, data);
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::GenQuery() {
+			Record("GenQuery");
+			return base->GenQuery();
+		}
+		void GLRecordingDevice::DeleteQuery(UInteger query) {
+			Record("DeleteQuery");
+			base->DeleteQuery(query);
+		}
+		void GLRecordingDevice::BeginQuery(Enum target, UInteger query) {
+			Record("BeginQuery");
+			base->BeginQuery(target, query);
+		}
+		void GLRecordingDevice::EndQuery(Enum target) {
+			Record("EndQuery");
+			base->EndQuery(target);
+		}
+		IGLDevice::UInteger GLRecordingDevice::GetQueryObjectUInteger(UInteger query,
+		                                                              Enum pname) {
+			Record("GetQueryObjectUInteger");
+			return base->GetQueryObjectUInteger(query, pname);
+		}
+		IGLDevice::UInteger64 GLRecordingDevice::GetQueryObjectUInteger64(UInteger query,
+		                                                                  Enum pname) {
+			Record("GetQueryObjectUInteger64");
+			return base->GetQueryObjectUInteger64(query, pname);
+		}
+		void GLRecordingDevice::BeginConditionalRender(UInteger query, Enum mode) {
+			Record("BeginConditionalRender");
+			base->BeginConditionalRender(query, mode);
+		}
+		void GLRecordingDevice::EndConditionalRender() {
+			Record("EndConditionalRender");
+			base->EndConditionalRender();
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::GenTexture() {
+			Record("GenTexture");
+			return base->GenTexture();
+		}
+		void GLRecordingDevice::DeleteTexture(UInteger texture) {
+			Record("DeleteTexture");
+			for (auto& binding : boundTextures) {
+				if (binding.second == texture)
+					binding.second = 0;
+			}
+			base->DeleteTexture(texture);
+		}
+
+		void GLRecordingDevice::ActiveTexture(UInteger stage) {
+			Record("ActiveTexture");
+			activeTexture = stage;
+			base->ActiveTexture(stage);
+		}
+		void GLRecordingDevice::BindTexture(Enum target, UInteger texture) {
+			RecordBind(Record("BindTexture"), boundTextures[std::make_pair(activeTexture, target)],
+			           texture);
+			base->BindTexture(target, texture);
+		}
+		void GLRecordingDevice::TexParamater(Enum target, Enum paramater, Enum value) {
+			Record("TexParamater");
+			base->TexParamater(target, paramater, value);
+		}
+		void GLRecordingDevice::TexParamater(Enum target, Enum paramater, float value) {
+			Record("TexParamater");
+			base->TexParamater(target, paramater, value);
+		}
+		void GLRecordingDevice::TexImage2D(Enum target, Integer level, Enum internalFormat,
+		                                   Sizei width, Sizei height, Integer border,
+		                                   Enum format, Enum type, const void* data) {
+			RecordTextureUpload(Record("TexImage2D"), width, height, 1, format, type, data);
+			base->TexImage2D(target, level, internalFormat, width, height, border, format, type,
+			                 data);
+		}
+		void GLRecordingDevice::TexImage3D(Enum target, Integer level, Enum internalFormat,
+		                                   Sizei width, Sizei height, Sizei depth,
+		                                   Integer border, Enum format, Enum type,
+		                                   const void* data) {
+			RecordTextureUpload(Record("TexImage3D"), width, height, depth, format, type, data);
+			base->TexImage3D(target, level, internalFormat, width, height, depth, border, format,
+			                 type, data);
+		}
+		void GLRecordingDevice::TexSubImage2D(Enum target, Integer level, Integer x, Integer y,
+		                                      Sizei width, Sizei height, Enum format,
+		                                      Enum type, const void* data) {
+			RecordTextureUpload(Record("TexSubImage2D"), width, height, 1, format, type, data);
+			base->TexSubImage2D(target, level, x, y, width, height, format, type, data);
+		}
+		void GLRecordingDevice::TexSubImage3D(Enum target, Integer level, Integer x, Integer y,
+		                                      Integer z, Sizei width, Sizei height,
+		                                      Sizei depth, Enum format, Enum type,
+		                                      const void* data) {
+			RecordTextureUpload(Record("TexSubImage3D"), width, height, depth, format, type,
+			                    data);
+			base->TexSubImage3D(target, level, x, y, z, width, height, depth, format, type,
+			                    data);
+		}
+		void GLRecordingDevice::CopyTexSubImage2D(Enum target, Integer level,
+		                                          Integer destinationX, Integer destinationY,
+		                                          Integer srcX, Integer srcY, Sizei width,
+		                                          Sizei height) {
+			Record("CopyTexSubImage2D");
+			base->CopyTexSubImage2D(target, level, destinationX, destinationY, srcX, srcY, width,
+			                        height);
+		}
+		void GLRecordingDevice::GenerateMipmap(Enum target) {
+			Record("GenerateMipmap");
+			base->GenerateMipmap(target);
+		}
+
+		void GLRecordingDevice::VertexAttrib(UInteger index, Float x) {
+			Record("VertexAttrib");
+			base->VertexAttrib(index, x);
+		}
+		void GLRecordingDevice::VertexAttrib(UInteger index, Float x, Float y) {
+			Record("VertexAttrib");
+			base->VertexAttrib(index, x, y);
+		}
+		void GLRecordingDevice::VertexAttrib(UInteger index, Float x, Float y, Float z) {
+			Record("VertexAttrib");
+			base->VertexAttrib(index, x, y, z);
+		}
+		void GLRecordingDevice::VertexAttrib(UInteger index, Float x, Float y, Float z,
+		                                     Float w) {
+			Record("VertexAttrib");
+			base->VertexAttrib(index, x, y, z, w);
+		}
+
+		void GLRecordingDevice::VertexAttribPointer(UInteger index, Integer size, Enum type,
+		                                            bool normalized, Sizei stride,
+		                                            const void* ptr) {
+			Record("VertexAttribPointer");
+			base->VertexAttribPointer(index, size, type, normalized, stride, ptr);
+		}
+		void GLRecordingDevice::VertexAttribIPointer(UInteger index, Integer size, Enum type,
+		                                             Sizei stride, const void* ptr) {
+			Record("VertexAttribIPointer");
+			base->VertexAttribIPointer(index, size, type, stride, ptr);
+		}
+		void GLRecordingDevice::EnableVertexAttribArray(UInteger index, bool enabled) {
+			Record("EnableVertexAttribArray");
+			base->EnableVertexAttribArray(index, enabled);
+		}
+		void GLRecordingDevice::VertexAttribDivisor(UInteger index, UInteger divisor) {
+			Record("VertexAttribDivisor");
+			base->VertexAttribDivisor(index, divisor);
+		}
+		bool GLRecordingDevice::SupportsInstancedArrays() {
+			return base->SupportsInstancedArrays();
+		}
+
+		void GLRecordingDevice::DrawArrays(Enum mode, Integer first, Sizei count) {
+			RecordDraw(Record("DrawArrays"), count, 1);
+			base->DrawArrays(mode, first, count);
+		}
+		void GLRecordingDevice::DrawElements(Enum mode, Sizei count, Enum type,
+		                                     const void* indices) {
+			RecordDraw(Record("DrawElements"), count, 1);
+			base->DrawElements(mode, count, type, indices);
+		}
+		void GLRecordingDevice::DrawArraysInstanced(Enum mode, Integer first, Sizei count,
+		                                            Sizei instances) {
+			RecordDraw(Record("DrawArraysInstanced"), count, instances);
+			base->DrawArraysInstanced(mode, first, count, instances);
+		}
+		void GLRecordingDevice::DrawElementsInstanced(Enum mode, Sizei count, Enum type,
+		                                              const void* indices, Sizei instances) {
+			RecordDraw(Record("DrawElementsInstanced"), count, instances);
+			base->DrawElementsInstanced(mode, count, type, indices, instances);
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::CreateShader(Enum type) {
+			Record("CreateShader");
+			return base->CreateShader(type);
+		}
+		void GLRecordingDevice::ShaderSource(UInteger shader, Sizei count, const char** string,
+		                                     const int* len) {
+			Record("ShaderSource");
+			base->ShaderSource(shader, count, string, len);
+		}
+		void GLRecordingDevice::CompileShader(UInteger shader) {
+			Record("CompileShader");
+			base->CompileShader(shader);
+		}
+		void GLRecordingDevice::DeleteShader(UInteger shader) {
+			Record("DeleteShader");
+			base->DeleteShader(shader);
+		}
+		IGLDevice::Integer GLRecordingDevice::GetShaderInteger(UInteger shader, Enum param) {
+			Record("GetShaderInteger");
+			return base->GetShaderInteger(shader, param);
+		}
+		void GLRecordingDevice::GetShaderInfoLog(UInteger shader, Sizei bufferSize,
+		                                         Sizei* length, char* outString) {
+			Record("GetShaderInfoLog");
+			base->GetShaderInfoLog(shader, bufferSize, length, outString);
+		}
+		IGLDevice::Integer GLRecordingDevice::GetProgramInteger(UInteger program, Enum param) {
+			Record("GetProgramInteger");
+			return base->GetProgramInteger(program, param);
+		}
+		void GLRecordingDevice::GetProgramInfoLog(UInteger program, Sizei bufferSize,
+		                                          Sizei* length, char* outString) {
+			Record("GetProgramInfoLog");
+			base->GetProgramInfoLog(program, bufferSize, length, outString);
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::CreateProgram() {
+			Record("CreateProgram");
+			return base->CreateProgram();
+		}
+		void GLRecordingDevice::AttachShader(UInteger program, UInteger shader) {
+			Record("AttachShader");
+			base->AttachShader(program, shader);
+		}
+		void GLRecordingDevice::DetachShader(UInteger program, UInteger shader) {
+			Record("DetachShader");
+			base->DetachShader(program, shader);
+		}
+		void GLRecordingDevice::LinkProgram(UInteger program) {
+			Record("LinkProgram");
+			base->LinkProgram(program);
+		}
+		void GLRecordingDevice::UseProgram(UInteger program) {
+			RecordBind(Record("UseProgram"), currentProgram, program);
+			base->UseProgram(program);
+		}
+		void GLRecordingDevice::DeleteProgram(UInteger program) {
+			Record("DeleteProgram");
+			if (currentProgram == program)
+				currentProgram = 0;
+			base->DeleteProgram(program);
+		}
+		void GLRecordingDevice::ValidateProgram(UInteger program) {
+			Record("ValidateProgram");
+			base->ValidateProgram(program);
+		}
+		bool GLRecordingDevice::SupportsProgramBinary() { return base->SupportsProgramBinary(); }
+		void GLRecordingDevice::ProgramBinaryRetrievableHint(UInteger program) {
+			Record("ProgramBinaryRetrievableHint");
+			base->ProgramBinaryRetrievableHint(program);
+		}
+		bool GLRecordingDevice::GetProgramBinary(UInteger program, UInteger& outFormat,
+		                                         std::vector<char>& outData) {
+			Record("GetProgramBinary");
+			return base->GetProgramBinary(program, outFormat, outData);
+		}
+		bool GLRecordingDevice::ProgramBinary(UInteger program, UInteger format,
+		                                      const void* data, Sizei length) {
+			Record("ProgramBinary");
+			return base->ProgramBinary(program, format, data, length);
+		}
+		bool GLRecordingDevice::SupportsParallelShaderCompile() {
+			return base->SupportsParallelShaderCompile();
+		}
+		void GLRecordingDevice::MaxShaderCompilerThreads(UInteger count) {
+			Record("MaxShaderCompilerThreads");
+			base->MaxShaderCompilerThreads(count);
+		}
+		IGLDevice::Integer GLRecordingDevice::GetAttribLocation(UInteger program,
+		                                                        const char* name) {
+			Record("GetAttribLocation");
+			return base->GetAttribLocation(program, name);
+		}
+		void GLRecordingDevice::BindAttribLocation(UInteger program, UInteger index,
+		                                           const char* name) {
+			Record("BindAttribLocation");
+			base->BindAttribLocation(program, index, name);
+		}
+		IGLDevice::Integer GLRecordingDevice::GetUniformLocation(UInteger program,
+		                                                         const char* name) {
+			Record("GetUniformLocation");
+			return base->GetUniformLocation(program, name);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Float x) {
+			Record("Uniform");
+			base->Uniform(loc, x);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Float x, Float y) {
+			Record("Uniform");
+			base->Uniform(loc, x, y);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Float x, Float y, Float z) {
+			Record("Uniform");
+			base->Uniform(loc, x, y, z);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Float x, Float y, Float z, Float w) {
+			Record("Uniform");
+			base->Uniform(loc, x, y, z, w);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Integer x) {
+			Record("Uniform");
+			base->Uniform(loc, x);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Integer x, Integer y) {
+			Record("Uniform");
+			base->Uniform(loc, x, y);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Integer x, Integer y, Integer z) {
+			Record("Uniform");
+			base->Uniform(loc, x, y, z);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, Integer x, Integer y, Integer z,
+		                                Integer w) {
+			Record("Uniform");
+			base->Uniform(loc, x, y, z, w);
+		}
+		void GLRecordingDevice::Uniform(Integer loc, bool transpose, const Matrix4& mat) {
+			Record("Uniform");
+			base->Uniform(loc, transpose, mat);
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::GenRenderbuffer() {
+			Record("GenRenderbuffer");
+			return base->GenRenderbuffer();
+		}
+		void GLRecordingDevice::DeleteRenderbuffer(UInteger renderbuffer) {
+			Record("DeleteRenderbuffer");
+			if (boundRenderbuffer == renderbuffer)
+				boundRenderbuffer = 0;
+			base->DeleteRenderbuffer(renderbuffer);
+		}
+		void GLRecordingDevice::BindRenderbuffer(Enum target, UInteger renderbuffer) {
+			RecordBind(Record("BindRenderbuffer"), boundRenderbuffer, renderbuffer);
+			base->BindRenderbuffer(target, renderbuffer);
+		}
+		void GLRecordingDevice::RenderbufferStorage(Enum target, Enum internalFormat,
+		                                            Sizei width, Sizei height) {
+			Record("RenderbufferStorage");
+			base->RenderbufferStorage(target, internalFormat, width, height);
+		}
+		void GLRecordingDevice::RenderbufferStorage(Enum target, Sizei samples,
+		                                            Enum internalFormat, Sizei width,
+		                                            Sizei height) {
+			Record("RenderbufferStorage");
+			base->RenderbufferStorage(target, samples, internalFormat, width, height);
+		}
+
+		IGLDevice::UInteger GLRecordingDevice::GenFramebuffer() {
+			Record("GenFramebuffer");
+			return base->GenFramebuffer();
+		}
+		void GLRecordingDevice::BindFramebuffer(Enum target, UInteger framebuffer) {
+			Counters& counters = Record("BindFramebuffer");
+			switch (target) {
+				case ReadFramebuffer: RecordBind(counters, readFramebuffer, framebuffer); break;
+				case DrawFramebuffer: RecordBind(counters, drawFramebuffer, framebuffer); break;
+				default:
+					++counters.numBinds;
+					if (readFramebuffer == framebuffer && drawFramebuffer == framebuffer)
+						++counters.numRedundantBinds;
+					readFramebuffer = drawFramebuffer = framebuffer;
+					break;
+			}
+			base->BindFramebuffer(target, framebuffer);
+		}
+		void GLRecordingDevice::DeleteFramebuffer(UInteger framebuffer) {
+			Record("DeleteFramebuffer");
+			if (readFramebuffer == framebuffer)
+				readFramebuffer = 0;
+			if (drawFramebuffer == framebuffer)
+				drawFramebuffer = 0;
+			base->DeleteFramebuffer(framebuffer);
+		}
+		void GLRecordingDevice::FramebufferTexture2D(Enum target, Enum attachment,
+		                                             Enum texTarget, UInteger texture,
+		                                             Integer level) {
+			Record("FramebufferTexture2D");
+			base->FramebufferTexture2D(target, attachment, texTarget, texture, level);
+		}
+		void GLRecordingDevice::FramebufferRenderbuffer(Enum target, Enum attachment,
+		                                                Enum renderbufferTarget,
+		                                                UInteger renderbuffer) {
+			Record("FramebufferRenderbuffer");
+			base->FramebufferRenderbuffer(target, attachment, renderbufferTarget, renderbuffer);
+		}
+		void GLRecordingDevice::BlitFramebuffer(Integer srcX0, Integer srcY0, Integer srcX1,
+		                                        Integer srcY1, Integer dstX0, Integer dstY0,
+		                                        Integer dstX1, Integer dstY1, UInteger mask,
+		                                        Enum filter) {
+			Record("BlitFramebuffer");
+			base->BlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1, mask,
+			                      filter);
+		}
+		IGLDevice::Enum GLRecordingDevice::CheckFramebufferStatus(Enum target) {
+			Record("CheckFramebufferStatus");
+			return base->CheckFramebufferStatus(target);
+		}
+
+		void GLRecordingDevice::ReadPixels(Integer x, Integer y, Sizei width, Sizei height,
+		                                   Enum format, Enum type, void* data) {
+			Record("ReadPixels");
+			base->ReadPixels(x, y, width, height, format, type, data);
+		}
+
+		IGLDevice::Integer GLRecordingDevice::ScreenWidth() { return base->ScreenWidth(); }
+		IGLDevice::Integer GLRecordingDevice::ScreenHeight() { return base->ScreenHeight(); }
+
+		void GLRecordingDevice::Swap() {
+			Record("Swap");
+			base->Swap();
+
+			// End of the frame
+			lastCommandLog.swap(commandLog);
+			commandLog.clear();
+
+			lastFrameStatistics = phases;
+			for (std::size_t i = 0; i < phases.size(); ++i) {
+				reportCounters[i] += phases[i].counters;
+				phases[i].counters = Counters{};
+			}
+			++numReportFrames;
+
+			if (reportInterval > 0.0 && stopwatch.GetTime() >= lastReportTime + reportInterval) {
+				LogReport();
+				lastReportTime = stopwatch.GetTime();
+				for (Counters& counters : reportCounters)
+					counters = Counters{};
+				numReportFrames = 0;
+			}
+		}
+	} // namespace draw
+} // namespace spades
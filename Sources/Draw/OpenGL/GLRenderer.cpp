@@ -59,6 +59,7 @@
 #include "GLSoftSpriteRenderer.h"
 #include "GLSpriteRenderer.h"
 #include "GLTemporalAAFilter.h"
+#include "GLTextureAtlas.h"
 #include "GLOptimizedVoxelModel.h"
 #include "GLWaterRenderer.h"
 #include "IGLDevice.h"
@@ -113,7 +114,7 @@ namespace spades {
 			UpdateRenderSize();
 
 			programManager = new GLProgramManager(*device, settings);
-			imageManager = new GLImageManager(*device);
+			imageManager = new GLImageManager(*device, settings.r_imageAtlas);
 			imageRenderer = new GLImageRenderer(*this);
 			profiler.reset(new GLProfiler(*this));
 
@@ -175,10 +176,15 @@ namespace spades {
 
 			// preload
 			SPLog("Preloading Assets");
-			GLMapRenderer::PreloadShaders(*this);
-			GLOptimizedVoxelModel::PreloadShaders(*this);
-			if (settings.r_water)
-				GLWaterRenderer::PreloadShaders(*this);
+			{
+				std::vector<std::string> programs, images;
+				GLMapRenderer::PreloadShaders(*this, programs, images);
+				GLOptimizedVoxelModel::PreloadShaders(*this, programs, images);
+				if (settings.r_water)
+					GLWaterRenderer::PreloadShaders(*this, programs, images);
+				PreloadPrograms(programs);
+				PreloadImages(images);
+			}
 
 			if (settings.r_cameraBlur)
 				cameraBlur = new GLCameraBlurFilter(*this);
@@ -265,6 +271,16 @@ namespace spades {
 			return modelManager->RegisterModel(filename).Cast<client::IModel>();
 		}
 
+		void GLRenderer::PreloadImages(const std::vector<std::string>& filenames) {
+			SPADES_MARK_FUNCTION();
+			imageManager->PreloadImages(filenames);
+		}
+
+		void GLRenderer::PreloadModels(const std::vector<std::string>& filenames) {
+			SPADES_MARK_FUNCTION();
+			modelManager->PreloadModels(filenames);
+		}
+
 		void GLRenderer::ClearCache() {
 			SPADES_MARK_FUNCTION();
 			modelManager->ClearCache();
@@ -273,7 +289,7 @@ namespace spades {
 
 		Handle<client::IImage> GLRenderer::CreateImage(spades::Bitmap& bmp) {
 			SPADES_MARK_FUNCTION();
-			return GLImage::FromBitmap(bmp, device.GetPointerOrNull()).Cast<client::IImage>();
+			return imageManager->CreateImage(bmp).Cast<client::IImage>();
 		}
 
 		Handle<client::IModel> GLRenderer::CreateModel(spades::VoxelModel& model) {
@@ -368,6 +384,10 @@ namespace spades {
 			return programManager->RegisterProgram(name);
 		}
 
+		void GLRenderer::PreloadPrograms(const std::vector<std::string>& names) {
+			programManager->PreloadPrograms(names);
+		}
+
 		GLShader* GLRenderer::RegisterShader(const std::string& name) {
 			return programManager->RegisterShader(name);
 		}
@@ -440,6 +460,9 @@ namespace spades {
 				SPRaise("Invalid value of radialBlur.");
 			sceneDef = def;
 
+			// the scene is rendered to a different framebuffer
+			imageRenderer->Flush();
+
 			sceneUsedInThisFrame = true;
 			duringSceneRendering = true;
 
@@ -1111,6 +1134,7 @@ namespace spades {
 				                                  static_cast<float>(handle.GetWidth()),
 				                                  static_cast<float>(handle.GetHeight()), false), false);
 				SetColorAlphaPremultiplied(MakeVector4(1, 1, 1, 1));
+				SetImageDistanceField({});
 				DrawImage(*image, AABB2(0, sh, sw, -sh));
 				imageRenderer->Flush();
 
@@ -1246,6 +1270,20 @@ namespace spades {
 				}
 			}
 
+			// Draw from the atlas if possible so quads with different images are batched.
+			// Pages have no mipmaps, so images minified by more than half along either
+			// axis use their own textures.
+			AABB2 source = inRect;
+			GLTextureAtlas* atlas = imageManager->GetAtlas();
+			bool minified = (outTopRight - outTopLeft).GetLength() * 2.0F <
+			                  std::fabs(inRect.GetWidth()) ||
+			                (outBottomLeft - outTopLeft).GetLength() * 2.0F <
+			                  std::fabs(inRect.GetHeight());
+			if (atlas && !minified) {
+				if (GLImage* page = atlas->Map(*img, source))
+					img = page;
+			}
+
 			imageRenderer->SetImage(img);
 
 			Vector4 col = drawColorAlphaPremultiplied;
@@ -1259,13 +1297,15 @@ namespace spades {
 
 			imageRenderer->Add(outTopLeft.x, outTopLeft.y, outTopRight.x, outTopRight.y,
 			                   outBottomRight.x, outBottomRight.y, outBottomLeft.x, outBottomLeft.y,
-			                   inRect.GetMinX(), inRect.GetMinY(), inRect.GetMaxX(),
-			                   inRect.GetMinY(), inRect.GetMaxX(), inRect.GetMaxY(),
-			                   inRect.GetMinX(), inRect.GetMaxY(), col.x, col.y, col.z, col.w);
+			                   source.GetMinX(), source.GetMinY(), source.GetMaxX(),
+			                   source.GetMinY(), source.GetMaxX(), source.GetMaxY(),
+			                   source.GetMinX(), source.GetMaxY(), col.x, col.y, col.z, col.w);
 		}
 
 		void GLRenderer::UpdateFlatGameMap() {
 			EnsureSceneNotStarted();
+			// queued quads might sample the textures being updated
+			imageRenderer->Flush();
 			if (flatMapRenderer)
 				flatMapRenderer->UpdateChunks();
 		}
@@ -1287,6 +1327,12 @@ namespace spades {
 			drawColorAlphaPremultiplied = col;
 		}
 
+		bool GLRenderer::SupportsImageDistanceField() { return true; }
+
+		void GLRenderer::SetImageDistanceField(stmp::optional<client::ImageDistanceField> field) {
+			imageRenderer->SetDistanceField(field);
+		}
+
 		void GLRenderer::FrameDone() {
 			SPADES_MARK_FUNCTION();
 
@@ -1315,10 +1361,15 @@ namespace spades {
 				auto image = Handle<GLImage>::New(lastColorBufferTexture,
 					device.GetPointerOrNull(), sw, sh, false);
 				SetColorAlphaPremultiplied(MakeVector4(1, 1, 1, 1));
+				SetImageDistanceField({});
 				DrawImage(*image, AABB2(0, sh, sw, -sh));
 				imageRenderer->Flush(); // must flush now because handle is released soon
 			}
 
+			// no quads are queued now
+			if (GLTextureAtlas* atlas = imageManager->GetAtlas())
+				atlas->FrameDone();
+
 			lastTime = sceneDef.time;
 
 			// ready for 2d draw of next frame
@@ -1327,6 +1378,24 @@ namespace spades {
 			profiler->EndFrame();
 
 			++frameNumber;
+
+			if (settings.r_debug2DBatches) {
+				++imageStatisticsFrames;
+				if (imageStatisticsStopwatch.GetTime() >= 1.0) {
+					double frames = static_cast<double>(imageStatisticsFrames);
+					SPLog("2D: %.1f batches, %.1f quads per frame",
+					      imageRenderer->GetNumBatchesDrawn() / frames,
+					      imageRenderer->GetNumQuadsDrawn() / frames);
+					imageRenderer->ResetStatistics();
+					if (GLTextureAtlas* atlas = imageManager->GetAtlas()) {
+						SPLog("2D: %d image(s) in %d atlas page(s), %.0f%% used",
+						      atlas->GetNumResidentImages(), atlas->GetNumPages(),
+						      atlas->GetUsage() * 100.0F);
+					}
+					imageStatisticsFrames = 0;
+					imageStatisticsStopwatch.Reset();
+				}
+			}
 		}
 
 		void GLRenderer::Flip() {
@@ -1350,6 +1419,7 @@ namespace spades {
 		Handle<Bitmap> GLRenderer::ReadBitmap() {
 			SPADES_MARK_FUNCTION();
 			EnsureSceneNotStarted();
+			imageRenderer->Flush();
 			auto bmp = Handle<Bitmap>::New(device->ScreenWidth(), device->ScreenHeight());
 			device->ReadPixels(0, 0, device->ScreenWidth(), device->ScreenHeight(), IGLDevice::RGBA,
 			                   IGLDevice::UnsignedByte, bmp->GetPixels());
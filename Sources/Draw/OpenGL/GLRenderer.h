@@ -30,6 +30,7 @@
 #include <Client/IRenderer.h>
 #include <Client/SceneDefinition.h>
 #include <Core/Math.h>
+#include <Core/Stopwatch.h>
 
 namespace spades {
 	namespace draw {
@@ -134,6 +135,9 @@ namespace spades {
 			unsigned int lastTime;
 			std::uint32_t frameNumber = 0;
 
+			Stopwatch imageStatisticsStopwatch;
+			int imageStatisticsFrames = 0;
+
 			bool duringSceneRendering;
 
 			void BuildProjectionMatrix();
@@ -167,11 +171,15 @@ namespace spades {
 
 			void ClearCache() override;
 
+			void PreloadImages(const std::vector<std::string>& filenames) override;
+			void PreloadModels(const std::vector<std::string>& filenames) override;
+
 			Handle<client::IImage> CreateImage(Bitmap&) override;
 			Handle<client::IModel> CreateModel(VoxelModel&) override;
 
 			GLProgram* RegisterProgram(const std::string& name);
 			GLShader* RegisterShader(const std::string& name);
+			void PreloadPrograms(const std::vector<std::string>& names);
 
 			void SetGameMap(stmp::optional<client::GameMap&>) override;
 			void SetFogColor(Vector3 v) override;
@@ -199,6 +207,9 @@ namespace spades {
 			void SetColor(Vector4) override;
 			void SetColorAlphaPremultiplied(Vector4) override;
 
+			bool SupportsImageDistanceField() override;
+			void SetImageDistanceField(stmp::optional<client::ImageDistanceField>) override;
+
 			void DrawImage(stmp::optional<client::IImage&>, const Vector2& outTopLeft) override;
 			void DrawImage(stmp::optional<client::IImage&>, const AABB2& outRect) override;
 			void DrawImage(stmp::optional<client::IImage&>, const Vector2& outTopLeft,
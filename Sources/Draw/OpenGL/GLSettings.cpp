@@ -22,10 +22,12 @@
 
 #include "GLSettings.h"
 
+DEFINE_SPADES_SETTING(r_aoUpdateBudget, "8");
 DEFINE_SPADES_SETTING(r_blitFramebuffer, "1");
 DEFINE_SPADES_SETTING(r_bloom, "1");
 DEFINE_SPADES_SETTING(r_cameraBlur, "1");
 DEFINE_SPADES_SETTING(r_colorCorrection, "1");
+DEFINE_SPADES_SETTING(r_debug2DBatches, "0");
 DEFINE_SPADES_SETTING(r_debugTiming, "0");
 DEFINE_SPADES_SETTING(r_debugTimingOutputScreen, "1");
 DEFINE_SPADES_SETTING(r_debugTimingOutputLog, "0");
@@ -47,14 +49,18 @@ DEFINE_SPADES_SETTING(r_hdrAutoExposureMax, "0.5");
 DEFINE_SPADES_SETTING(r_hdrAutoExposureSpeed, "1");
 DEFINE_SPADES_SETTING(r_hdrGamma, "2.2");
 DEFINE_SPADES_SETTING(r_highPrec, "1");
+DEFINE_SPADES_SETTING(r_imageAtlas, "1");
 DEFINE_SPADES_SETTING(r_lensFlare, "1");
 DEFINE_SPADES_SETTING(r_lensFlareDynamic, "1");
 DEFINE_SPADES_SETTING(r_maxAnisotropy, "8");
+DEFINE_SPADES_SETTING(r_modelInstancing, "1");
+DEFINE_SPADES_SETTING(r_modelMeshCache, "1");
 DEFINE_SPADES_SETTING(r_modelShadows, "1");
 DEFINE_SPADES_SETTING(r_multisamples, "0");
 DEFINE_SPADES_SETTING(r_occlusionQuery, "0");
 DEFINE_SPADES_SETTING(r_physicalLighting, "0");
 DEFINE_SPADES_SETTING(r_outlines, "0");
+DEFINE_SPADES_SETTING(r_programBinaryCache, "1");
 DEFINE_SPADES_SETTING(r_radiosity, "0");
 DEFINE_SPADES_SETTING(r_saturation, "1");
 DEFINE_SPADES_SETTING(r_scale, "1");
@@ -29,10 +29,12 @@ namespace spades {
 			GLSettings();
 
 			// clang-format off
+			TypedItemHandle<float> r_aoUpdateBudget     { *this, "r_aoUpdateBudget" };
 			TypedItemHandle<bool> r_blitFramebuffer     { *this, "r_blitFramebuffer", ItemFlags::Latch };
 			TypedItemHandle<bool> r_bloom               { *this, "r_bloom", ItemFlags::Latch };
 			TypedItemHandle<float> r_cameraBlur         { *this, "r_cameraBlur" };
 			TypedItemHandle<bool> r_colorCorrection     { *this, "r_colorCorrection" };
+			TypedItemHandle<bool> r_debug2DBatches      { *this, "r_debug2DBatches" };
 			TypedItemHandle<bool> r_debugTiming         { *this, "r_debugTiming" };
 			TypedItemHandle<bool> r_debugTimingOutputScreen { *this, "r_debugTimingOutputScreen" };
 			TypedItemHandle<bool> r_debugTimingOutputLog { *this, "r_debugTimingOutputLog" };
@@ -54,14 +56,18 @@ namespace spades {
 			TypedItemHandle<float> r_hdrAutoExposureSpeed{ *this, "r_hdrAutoExposureSpeed" };
 			TypedItemHandle<float> r_hdrGamma           { *this, "r_hdrGamma" };
 			TypedItemHandle<bool> r_highPrec            { *this, "r_highPrec", ItemFlags::Latch };
+			TypedItemHandle<bool> r_imageAtlas          { *this, "r_imageAtlas", ItemFlags::Latch };
 			TypedItemHandle<bool> r_lensFlare           { *this, "r_lensFlare" };
 			TypedItemHandle<bool> r_lensFlareDynamic    { *this, "r_lensFlareDynamic" };
 			TypedItemHandle<float> r_maxAnisotropy      { *this, "r_maxAnisotropy", ItemFlags::Latch };
+			TypedItemHandle<bool> r_modelInstancing     { *this, "r_modelInstancing", ItemFlags::Latch };
+			TypedItemHandle<bool> r_modelMeshCache      { *this, "r_modelMeshCache" };
 			TypedItemHandle<bool> r_modelShadows        { *this, "r_modelShadows", ItemFlags::Latch };
 			TypedItemHandle<int> r_multisamples         { *this, "r_multisamples", ItemFlags::Latch };
 			TypedItemHandle<bool> r_occlusionQuery      { *this, "r_occlusionQuery" };
 			TypedItemHandle<bool> r_physicalLighting    { *this, "r_physicalLighting", ItemFlags::Latch };
 			TypedItemHandle<bool> r_outlines            { *this, "r_outlines" };
+			TypedItemHandle<bool> r_programBinaryCache  { *this, "r_programBinaryCache", ItemFlags::Latch };
 			TypedItemHandle<int> r_radiosity            { *this, "r_radiosity", ItemFlags::Latch };
 			TypedItemHandle<float> r_saturation         { *this, "r_saturation" };
 			TypedItemHandle<float> r_scale              { *this, "r_scale" };
@@ -26,7 +26,8 @@
 
 namespace spades {
 	namespace draw {
-		GLShader::GLShader(IGLDevice& dev, Type type) : device(dev), compiled(false) {
+		GLShader::GLShader(IGLDevice& dev, Type type, std::string name)
+		    : device(dev), compiled(false), compileSubmitted(false), name(name) {
 			SPADES_MARK_FUNCTION();
 
 			switch (type) {
@@ -48,8 +49,10 @@ namespace spades {
 			sources.push_back(src);
 		}
 
-		void GLShader::Compile() {
+		void GLShader::SubmitCompile() {
 			SPADES_MARK_FUNCTION();
+			if (compileSubmitted)
+				return;
 
 			std::vector<const char*> srcs;
 			std::vector<int> lens;
@@ -61,6 +64,13 @@ namespace spades {
 
 			device.ShaderSource(handle, static_cast<IGLDevice::Sizei>(srcs.size()), srcs.data(), lens.data());
 			device.CompileShader(handle);
+			compileSubmitted = true;
+		}
+
+		void GLShader::Compile() {
+			SPADES_MARK_FUNCTION();
+
+			SubmitCompile();
 
 			if (device.GetShaderInteger(handle, IGLDevice::CompileStatus) == 0) { // error
 				std::vector<char> errMsg;
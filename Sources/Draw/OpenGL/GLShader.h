@@ -31,19 +31,27 @@ namespace spades {
 			IGLDevice::UInteger handle;
 			std::vector<std::string> sources;
 			bool compiled;
+			bool compileSubmitted;
+			std::string name;
 
 		public:
 			enum Type { VertexShader, FragmentShader, GeometryShader };
 
-			GLShader(IGLDevice &, Type);
+			GLShader(IGLDevice &, Type, std::string name = "(unnamed)");
 			~GLShader();
 
 			void AddSource(const std::string &);
+			const std::vector<std::string> &GetSources() const { return sources; }
 
+			/** Issues the compilation without waiting for its result, so that
+			 * the driver can compile several shaders in background. */
+			void SubmitCompile();
+			/** Compiles the shader (if not submitted yet) and checks the result. */
 			void Compile();
 			IGLDevice::UInteger GetHandle() const { return handle; }
 
 			bool IsCompiled() const { return compiled; }
+			const std::string &GetName() const { return name; }
 
 			IGLDevice &GetDevice() const { return device; }
 		};
@@ -0,0 +1,417 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include <algorithm>
+#include <limits>
+
+#include "GLImage.h"
+#include "GLTextureAtlas.h"
+#include "IGLDevice.h"
+#include <Core/Bitmap.h>
+#include <Core/Debug.h>
+
+namespace spades {
+	namespace draw {
+		namespace {
+			constexpr int pageSize = 1024;
+			constexpr std::size_t maxPages = 4;
+			/** Larger images aren't worth the page space. */
+			constexpr int maxImageSize = 64;
+			/**
+			 * The border around an image filled with its edge pixels, so bilinear
+			 * filtering doesn't pick up the neighbors.
+			 */
+			constexpr int gutter = 1;
+			/** Shelf heights are rounded up to a multiple of this for better reuse. */
+			constexpr int shelfGranularity = 8;
+			/** Pages used less than this are repacked when they run out of space. */
+			constexpr float defragmentationThreshold = 0.5F;
+
+			int GetSlotWidth(Bitmap& bmp) { return bmp.GetWidth() + gutter * 2; }
+			int GetSlotHeight(Bitmap& bmp) { return bmp.GetHeight() + gutter * 2; }
+		} // namespace
+
+		GLTextureAtlas::GLTextureAtlas(IGLDevice& device)
+		    : device(device), frameNumber(1), usedArea(0), needsDefragmentation(false) {}
+
+		GLTextureAtlas::~GLTextureAtlas() {
+			SPADES_MARK_FUNCTION();
+			// images created by `GLRenderer::CreateImage` might outlive us
+			for (auto& item : entries)
+				item.first->atlas = nullptr;
+		}
+
+		bool GLTextureAtlas::IsEligible(int width, int height) const {
+			return width > 0 && height > 0 && width <= maxImageSize && height <= maxImageSize;
+		}
+
+		void GLTextureAtlas::Add(GLImage& image, Bitmap& bmp) {
+			SPADES_MARK_FUNCTION();
+			SPAssert(IsEligible(bmp.GetWidth(), bmp.GetHeight()));
+			SPAssert(image.atlas == nullptr);
+
+			Entry& entry = entries[&image];
+			entry.bitmap = bmp.Clone();
+			image.atlas = this;
+
+			// Don't evict images being used just to make room for one that might never
+			// be drawn
+			Allocate(entry, false);
+		}
+
+		void GLTextureAtlas::Remove(GLImage& image) {
+			SPADES_MARK_FUNCTION();
+
+			auto it = entries.find(&image);
+			SPAssert(it != entries.end());
+
+			Entry& entry = it->second;
+			if (entry.page >= 0) {
+				// queued quads might still sample the slot
+				pendingReleases.push_back(Slot{entry.page, entry.shelf,
+				                               GetSlotWidth(*entry.bitmap),
+				                               GetSlotHeight(*entry.bitmap)});
+			}
+			entries.erase(it);
+			image.atlas = nullptr;
+		}
+
+		void GLTextureAtlas::Update(GLImage& image, Bitmap& bmp, int x, int y) {
+			SPADES_MARK_FUNCTION();
+
+			auto it = entries.find(&image);
+			SPAssert(it != entries.end());
+
+			Entry& entry = it->second;
+			Bitmap& dest = *entry.bitmap;
+			int minX = std::max(x, 0), maxX = std::min(x + bmp.GetWidth(), dest.GetWidth());
+			int minY = std::max(y, 0), maxY = std::min(y + bmp.GetHeight(), dest.GetHeight());
+			for (int py = minY; py < maxY; py++) {
+				const std::uint32_t* src = bmp.GetPixels() + (py - y) * bmp.GetWidth() - x;
+				std::uint32_t* out = dest.GetPixels() + py * dest.GetWidth();
+				std::copy(src + minX, src + maxX, out + minX);
+			}
+
+			if (entry.page < 0)
+				return;
+			if (entry.lastUsedFrame == frameNumber) {
+				// queued quads might still sample the slot; draw the image from its own
+				// texture for the rest of the frame
+				if (!entry.stale) {
+					entry.stale = true;
+					staleImages.push_back(&image);
+				}
+				return;
+			}
+			Upload(entry);
+		}
+
+		GLImage* GLTextureAtlas::Map(GLImage& image, AABB2& rect) {
+			if (image.atlas != this)
+				return nullptr;
+
+			Entry& entry = entries.find(&image)->second;
+			Bitmap& bmp = *entry.bitmap;
+
+			// the page can't repeat the image
+			if (std::min(rect.min.x, rect.max.x) < 0.0F ||
+			    std::min(rect.min.y, rect.max.y) < 0.0F ||
+			    std::max(rect.min.x, rect.max.x) > static_cast<float>(bmp.GetWidth()) ||
+			    std::max(rect.min.y, rect.max.y) > static_cast<float>(bmp.GetHeight()))
+				return nullptr;
+
+			if (entry.stale)
+				return nullptr;
+
+			if (entry.page < 0) {
+				// evicted earlier; try once per frame to bring it back
+				if (entry.lastAllocationFrame == frameNumber || !Allocate(entry, true))
+					return nullptr;
+			}
+			entry.lastUsedFrame = frameNumber;
+
+			Vector2 offset = MakeVector2(static_cast<float>(entry.x), static_cast<float>(entry.y));
+			rect.min += offset;
+			rect.max += offset;
+			return pages[entry.page].image.GetPointerOrNull();
+		}
+
+		void GLTextureAtlas::FrameDone() {
+			SPADES_MARK_FUNCTION();
+
+			for (const Slot& slot : pendingReleases)
+				ReleaseSlot(slot);
+			pendingReleases.clear();
+
+			for (GLImage* image : staleImages) {
+				auto it = entries.find(image);
+				if (it == entries.end() || !it->second.stale)
+					continue; // removed, or uploaded on reallocation
+				it->second.stale = false;
+				if (it->second.page >= 0)
+					Upload(it->second);
+			}
+			staleImages.clear();
+
+			if (needsDefragmentation) {
+				needsDefragmentation = false;
+				if (GetUsage() < defragmentationThreshold)
+					Defragment();
+			}
+
+			++frameNumber;
+		}
+
+		int GLTextureAtlas::GetNumResidentImages() const {
+			int count = 0;
+			for (const auto& item : entries)
+				if (item.second.page >= 0)
+					count++;
+			return count;
+		}
+
+		float GLTextureAtlas::GetUsage() const {
+			if (pages.empty())
+				return 0.0F;
+			return static_cast<float>(usedArea) /
+			       (static_cast<float>(pageSize) * pageSize * static_cast<float>(pages.size()));
+		}
+
+		bool GLTextureAtlas::Allocate(Entry& entry, bool allowEviction) {
+			SPADES_MARK_FUNCTION();
+
+			entry.lastAllocationFrame = frameNumber;
+
+			if (!AllocateInShelf(entry) && !AllocateNewShelf(entry)) {
+				if (pages.size() < maxPages) {
+					IGLDevice::UInteger tex = device.GenTexture();
+					device.BindTexture(IGLDevice::Texture2D, tex);
+					device.TexImage2D(IGLDevice::Texture2D, 0, IGLDevice::RGBA, pageSize,
+					                  pageSize, 0, IGLDevice::RGBA, IGLDevice::UnsignedByte,
+					                  NULL);
+					device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureMagFilter,
+					                    IGLDevice::Linear);
+					device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureMinFilter,
+					                    IGLDevice::Linear);
+					device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureWrapS,
+					                    IGLDevice::ClampToEdge);
+					device.TexParamater(IGLDevice::Texture2D, IGLDevice::TextureWrapT,
+					                    IGLDevice::ClampToEdge);
+
+					Page page;
+					page.image = Handle<GLImage>::New(tex, &device, static_cast<float>(pageSize),
+					                                  static_cast<float>(pageSize));
+					page.nextY = 0;
+					pages.push_back(std::move(page));
+					SPLog("Texture atlas page #%d allocated", static_cast<int>(pages.size()));
+
+					AllocateNewShelf(entry);
+				} else {
+					needsDefragmentation = true;
+					if (!allowEviction || !EvictShelf(GetSlotHeight(*entry.bitmap)))
+						return false;
+					if (!AllocateInShelf(entry) && !AllocateNewShelf(entry))
+						return false;
+				}
+			}
+
+			Upload(entry);
+			return true;
+		}
+
+		bool GLTextureAtlas::AllocateInShelf(Entry& entry) {
+			int slotWidth = GetSlotWidth(*entry.bitmap);
+			int slotHeight = GetSlotHeight(*entry.bitmap);
+			int maxHeight = slotHeight + slotHeight / 2 + shelfGranularity;
+
+			// choose the shelf wasting the least height
+			int bestPage = -1;
+			std::size_t bestShelf = 0;
+			int bestHeight = std::numeric_limits<int>::max();
+			for (std::size_t i = 0; i < pages.size(); i++) {
+				const std::vector<Shelf>& shelves = pages[i].shelves;
+				for (std::size_t k = 0; k < shelves.size(); k++) {
+					const Shelf& shelf = shelves[k];
+					if (shelf.height < slotHeight || shelf.height >= bestHeight ||
+					    shelf.nextX + slotWidth > pageSize)
+						continue;
+					if (shelf.height > maxHeight && shelf.numSlots > 0)
+						continue;
+					bestPage = static_cast<int>(i);
+					bestShelf = k;
+					bestHeight = shelf.height;
+				}
+			}
+			if (bestPage < 0)
+				return false;
+
+			Shelf& shelf = pages[bestPage].shelves[bestShelf];
+			entry.page = bestPage;
+			entry.shelf = bestShelf;
+			entry.x = shelf.nextX + gutter;
+			entry.y = shelf.y + gutter;
+			shelf.nextX += slotWidth;
+			shelf.numSlots++;
+			usedArea += static_cast<long>(slotWidth) * slotHeight;
+			return true;
+		}
+
+		bool GLTextureAtlas::AllocateNewShelf(Entry& entry) {
+			int height = GetSlotHeight(*entry.bitmap);
+			height = (height + shelfGranularity - 1) / shelfGranularity * shelfGranularity;
+
+			for (Page& page : pages) {
+				if (page.nextY + height > pageSize)
+					continue;
+				page.shelves.push_back(Shelf{page.nextY, height, 0, 0});
+				page.nextY += height;
+				return AllocateInShelf(entry);
+			}
+			return false;
+		}
+
+		/** Evicts the least recently drawn shelf at least `height` high. */
+		bool GLTextureAtlas::EvictShelf(int height) {
+			SPADES_MARK_FUNCTION();
+
+			struct ShelfUsage {
+				std::uint32_t lastUsedFrame = 0;
+				int numResidents = 0;
+			};
+			std::vector<std::vector<ShelfUsage>> usages(pages.size());
+			for (std::size_t i = 0; i < pages.size(); i++)
+				usages[i].resize(pages[i].shelves.size());
+			for (const auto& item : entries) {
+				const Entry& entry = item.second;
+				if (entry.page < 0)
+					continue;
+				ShelfUsage& usage = usages[entry.page][entry.shelf];
+				usage.lastUsedFrame = std::max(usage.lastUsedFrame, entry.lastUsedFrame);
+				usage.numResidents++;
+			}
+
+			int bestPage = -1;
+			std::size_t bestShelf = 0;
+			std::uint32_t bestFrame = frameNumber;
+			for (std::size_t i = 0; i < pages.size(); i++) {
+				for (std::size_t k = 0; k < pages[i].shelves.size(); k++) {
+					const Shelf& shelf = pages[i].shelves[k];
+					const ShelfUsage& usage = usages[i][k];
+					// Shelves drawn in this frame or with pending releases can't be reused
+					// until the frame ends
+					if (shelf.height < height || usage.numResidents != shelf.numSlots ||
+					    usage.lastUsedFrame >= bestFrame)
+						continue;
+					bestPage = static_cast<int>(i);
+					bestShelf = k;
+					bestFrame = usage.lastUsedFrame;
+				}
+			}
+			if (bestPage < 0)
+				return false;
+
+			for (auto& item : entries) {
+				Entry& entry = item.second;
+				if (entry.page != bestPage || entry.shelf != bestShelf)
+					continue;
+				ReleaseSlot(Slot{entry.page, entry.shelf, GetSlotWidth(*entry.bitmap),
+				                 GetSlotHeight(*entry.bitmap)});
+				entry.page = -1;
+			}
+			return true;
+		}
+
+		void GLTextureAtlas::ReleaseSlot(const Slot& slot) {
+			Page& page = pages[slot.page];
+			Shelf& shelf = page.shelves[slot.shelf];
+			SPAssert(shelf.numSlots > 0);
+
+			usedArea -= static_cast<long>(slot.width) * slot.height;
+			if (--shelf.numSlots > 0)
+				return;
+
+			shelf.nextX = 0;
+
+			// give the space back to the page if it's the bottommost shelf
+			while (!page.shelves.empty() && page.shelves.back().numSlots == 0) {
+				page.nextY = page.shelves.back().y;
+				page.shelves.pop_back();
+			}
+		}
+
+		void GLTextureAtlas::Upload(Entry& entry) {
+			entry.stale = false;
+
+			Bitmap& bmp = *entry.bitmap;
+			int width = bmp.GetWidth(), height = bmp.GetHeight();
+			int slotWidth = GetSlotWidth(bmp), slotHeight = GetSlotHeight(bmp);
+
+			// replicate the edges into the gutter
+			std::vector<std::uint32_t> pixels(static_cast<std::size_t>(slotWidth) * slotHeight);
+			for (int y = 0; y < slotHeight; y++) {
+				int srcY = std::max(std::min(y - gutter, height - 1), 0);
+				const std::uint32_t* src = bmp.GetPixels() + srcY * width;
+				std::uint32_t* out = pixels.data() + y * slotWidth;
+				for (int x = 0; x < slotWidth; x++)
+					out[x] = src[std::max(std::min(x - gutter, width - 1), 0)];
+			}
+
+			pages[entry.page].image->Bind(IGLDevice::Texture2D);
+			device.TexSubImage2D(IGLDevice::Texture2D, 0, entry.x - gutter, entry.y - gutter,
+			                     slotWidth, slotHeight, IGLDevice::RGBA, IGLDevice::UnsignedByte,
+			                     pixels.data());
+		}
+
+		/** Repacks the resident images. Must not be called while quads are queued. */
+		void GLTextureAtlas::Defragment() {
+			SPADES_MARK_FUNCTION();
+
+			std::vector<Entry*> residents;
+			for (auto& item : entries) {
+				if (item.second.page >= 0) {
+					residents.push_back(&item.second);
+					item.second.page = -1;
+				}
+			}
+			for (Page& page : pages) {
+				page.shelves.clear();
+				page.nextY = 0;
+			}
+			usedArea = 0;
+
+			// taller ones first so the shelves are filled evenly
+			std::sort(residents.begin(), residents.end(), [](Entry* a, Entry* b) {
+				int ha = a->bitmap->GetHeight(), hb = b->bitmap->GetHeight();
+				return ha != hb ? ha > hb : a->bitmap->GetWidth() > b->bitmap->GetWidth();
+			});
+
+			int numEvicted = 0;
+			for (Entry* entry : residents) {
+				if (AllocateInShelf(*entry) || AllocateNewShelf(*entry))
+					Upload(*entry);
+				else
+					numEvicted++;
+			}
+
+			SPLog("Texture atlas defragmented: %d image(s), %d evicted, %.0f%% used",
+			      static_cast<int>(residents.size()), numEvicted, GetUsage() * 100.0F);
+		}
+	} // namespace draw
+} // namespace spades
@@ -0,0 +1,143 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <Core/Math.h>
+#include <Core/RefCountedObject.h>
+
+namespace spades {
+	class Bitmap;
+	namespace draw {
+		class IGLDevice;
+		class GLImage;
+
+		/**
+		 * Packs copies of small images into shared textures ("pages") so 2D quads using
+		 * different images can be drawn in one batch.
+		 *
+		 * Each page is divided into shelves (rows) of similar heights, which are filled
+		 * from left to right. A shelf's space is reclaimed when all of its images are
+		 * gone. When every page is full, the least recently drawn shelf is evicted; the
+		 * evicted images are drawn from their own textures and return to the atlas
+		 * when they are drawn again. Pages which are mostly holes are repacked at the end
+		 * of a frame.
+		 *
+		 * The content of a page region is never overwritten during a frame while a queued
+		 * quad might still sample it, so `GLImageRenderer` doesn't have to flush when the
+		 * atlas changes.
+		 */
+		class GLTextureAtlas {
+		public:
+			GLTextureAtlas(IGLDevice&);
+			~GLTextureAtlas();
+
+			/** Whether an image of the specified size is stored in the atlas. */
+			bool IsEligible(int width, int height) const;
+
+			/** Stores a copy of `bmp`, the content of `image`. */
+			void Add(GLImage& image, Bitmap& bmp);
+
+			/** Called by `GLImage` when it's invalidated. */
+			void Remove(GLImage& image);
+
+			/**
+			 * Called by `GLImage` when a part of it is updated. If the image was drawn
+			 * during this frame, the upload is deferred to `FrameDone`, and the image is
+			 * drawn from its own texture until then.
+			 */
+			void Update(GLImage& image, Bitmap& bmp, int x, int y);
+
+			/**
+			 * If `image` is in the atlas and `rect` (in pixels) doesn't extend beyond
+			 * it, translates `rect` to the page's coordinates and returns the page.
+			 * Otherwise, returns `nullptr`.
+			 */
+			GLImage* Map(GLImage& image, AABB2& rect);
+
+			/** Called after the last quad of a frame is drawn. */
+			void FrameDone();
+
+			int GetNumPages() const { return static_cast<int>(pages.size()); }
+			int GetNumResidentImages() const;
+			/** The ratio of the area used by images (including gutters) to the pages'. */
+			float GetUsage() const;
+
+		private:
+			struct Shelf {
+				int y, height;
+				/** The left of the unallocated space. */
+				int nextX;
+				/** The number of slots which are in use or pending release. */
+				int numSlots;
+			};
+			struct Page {
+				Handle<GLImage> image;
+				std::vector<Shelf> shelves;
+				/** The top of the space not occupied by the shelves. */
+				int nextY;
+			};
+			struct Entry {
+				/** The content of the image. */
+				Handle<Bitmap> bitmap;
+				/** The page index, or -1 if it's not resident. */
+				int page = -1;
+				std::size_t shelf;
+				/** The top-left corner of the image (excluding the gutter). */
+				int x, y;
+				std::uint32_t lastUsedFrame = 0;
+				std::uint32_t lastAllocationFrame = 0;
+				/** The slot holds an outdated copy, which is replaced by `FrameDone`. */
+				bool stale = false;
+			};
+			struct Slot {
+				int page;
+				std::size_t shelf;
+				int width, height;
+			};
+
+			IGLDevice& device;
+			std::vector<Page> pages;
+			std::unordered_map<GLImage*, Entry> entries;
+			/** Slots released during the frame. Reclaimed by `FrameDone`. */
+			std::vector<Slot> pendingReleases;
+			/** Images updated while their slots might be sampled. Uploaded by `FrameDone`. */
+			std::vector<GLImage*> staleImages;
+			std::uint32_t frameNumber;
+			/** The sum of the areas of the slots. */
+			long usedArea;
+			bool needsDefragmentation;
+
+			/** Finds a place for `entry` and uploads its content. */
+			bool Allocate(Entry&, bool allowEviction);
+			bool AllocateInShelf(Entry&);
+			bool AllocateNewShelf(Entry&);
+			bool EvictShelf(int height);
+			void ReleaseSlot(const Slot&);
+			void Upload(Entry&);
+			void Defragment();
+		};
+	} // namespace draw
+} // namespace spades
@@ -435,14 +435,16 @@ namespace spades {
 
 #pragma mark - Water Renderer
 
-		void GLWaterRenderer::PreloadShaders(GLRenderer& renderer) {
+		void GLWaterRenderer::PreloadShaders(GLRenderer& renderer,
+		                                     std::vector<std::string>& programs,
+		                                     std::vector<std::string>&) {
 			auto& settings = renderer.GetSettings();
 			if ((int)settings.r_water >= 3)
-				renderer.RegisterProgram("Shaders/OpenGL/Water3.program");
+				programs.push_back("Shaders/OpenGL/Water3.program");
 			else if ((int)settings.r_water >= 2)
-				renderer.RegisterProgram("Shaders/OpenGL/Water2.program");
+				programs.push_back("Shaders/OpenGL/Water2.program");
 			else
-				renderer.RegisterProgram("Shaders/OpenGL/Water.program");
+				programs.push_back("Shaders/OpenGL/Water.program");
 		}
 
 		GLWaterRenderer::GLWaterRenderer(GLRenderer& renderer, client::GameMap* map)
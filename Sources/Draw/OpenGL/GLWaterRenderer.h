@@ -76,7 +76,9 @@ namespace spades {
 			GLWaterRenderer(GLRenderer &, client::GameMap *map);
 			~GLWaterRenderer();
 
-			static void PreloadShaders(GLRenderer &);
+			/** Appends the programs and images used by this renderer to the lists. */
+			static void PreloadShaders(GLRenderer &, std::vector<std::string> &programs,
+			                           std::vector<std::string> &images);
 
 			void Render();
 
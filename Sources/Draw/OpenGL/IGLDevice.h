@@ -20,7 +20,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstdlib> // for integer types
+#include <vector>
 
 #include <Core/Math.h>
 #include <Core/RefCountedObject.h>
@@ -353,6 +355,9 @@ namespace spades {
 			                                  const void*) = 0;
 			virtual void EnableVertexAttribArray(UInteger index, bool) = 0;
 			virtual void VertexAttribDivisor(UInteger index, UInteger divisor) = 0;
+			/** Returns `true` if `VertexAttribDivisor` and the instanced draw calls
+			 * are available. */
+			virtual bool SupportsInstancedArrays() = 0;
 
 			virtual void DrawArrays(Enum mode, Integer first, Sizei count) = 0;
 			virtual void DrawElements(Enum mode, Sizei count, Enum type, const void* indices) = 0;
@@ -380,6 +385,29 @@ namespace spades {
 			virtual void UseProgram(UInteger program) = 0;
 			virtual void DeleteProgram(UInteger program) = 0;
 			virtual void ValidateProgram(UInteger program) = 0;
+
+			/** Returns `true` if linked programs can be saved and restored
+			 * as driver-specific binaries (`GL_ARB_get_program_binary`). */
+			virtual bool SupportsProgramBinary() = 0;
+			/** Asks the driver to keep the binary of the program retrievable.
+			 * Must be called before `LinkProgram`. */
+			virtual void ProgramBinaryRetrievableHint(UInteger program) = 0;
+			/** Retrieves the binary of a linked program.
+			 * @return `false` if the binary is not available. */
+			virtual bool GetProgramBinary(UInteger program, UInteger& outFormat,
+			                              std::vector<char>& outData) = 0;
+			/** Loads a program from a binary retrieved by `GetProgramBinary`.
+			 * @return `false` if the driver rejected the binary (for example,
+			 *         because the driver was updated). The program has to be
+			 *         built from the source in this case. */
+			virtual bool ProgramBinary(UInteger program, UInteger format, const void* data,
+			                           Sizei length) = 0;
+			/** Returns `true` if the driver compiles shaders and links programs
+			 * in background (`GL_KHR_parallel_shader_compile`). */
+			virtual bool SupportsParallelShaderCompile() = 0;
+			/** Sets the number of background compiler threads. `0xffffffff`
+			 * lets the driver decide. */
+			virtual void MaxShaderCompilerThreads(UInteger count) = 0;
 			virtual Integer GetAttribLocation(UInteger program, const char* name) = 0;
 			virtual void BindAttribLocation(UInteger program, UInteger index, const char* name) = 0;
 			virtual Integer GetUniformLocation(UInteger program, const char* name) = 0;
@@ -421,6 +449,17 @@ namespace spades {
 			virtual Integer ScreenHeight() = 0;
 
 			virtual void Swap() = 0;
+
+			struct StateCacheStatistics {
+				/** The number of state changes checked against the shadowed state. */
+				std::uint64_t numCalls = 0;
+				/** The number of state changes skipped because they had no effect. */
+				std::uint64_t numSkipped = 0;
+			};
+
+			/** Returns the cumulative counters of the redundant state change
+			 * elimination, or zeros if the implementation doesn't have one. */
+			virtual StateCacheStatistics GetStateCacheStatistics() { return {}; }
 		};
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -20,6 +20,9 @@
 
 #include "SWFeatureLevel.h"
 #include <Core/CpuID.h>
+#include <Core/Settings.h>
+
+DEFINE_SPADES_SETTING(r_swDisableAVX2, "0");
 
 namespace spades {
 	namespace draw {
@@ -29,6 +32,10 @@ namespace spades {
 #if ENABLE_SSE2
 		SWFeatureLevel DetectFeatureLevel() {
 			CpuID cpuid;
+#if ENABLE_AVX2
+			if (cpuid.Supports(CpuFeature::AVX2) && !r_swDisableAVX2)
+				return SWFeatureLevel::AVX2;
+#endif
 			if (cpuid.Supports(CpuFeature::SSE2))
 				return SWFeatureLevel::SSE2;
 
@@ -40,5 +47,24 @@ namespace spades {
 #else
 		SWFeatureLevel DetectFeatureLevel() { return SWFeatureLevel::None; }
 #endif
+
+		const char* GetFeatureLevelName(SWFeatureLevel level) {
+			switch (level) {
+				case SWFeatureLevel::None: return "None";
+#if ENABLE_MMX
+				case SWFeatureLevel::MMX: return "MMX";
+#endif
+#if ENABLE_SSE
+				case SWFeatureLevel::SSE: return "SSE";
+#endif
+#if ENABLE_SSE2
+				case SWFeatureLevel::SSE2: return "SSE2";
+#endif
+#if ENABLE_AVX2
+				case SWFeatureLevel::AVX2: return "AVX2";
+#endif
+			}
+			return "Unknown";
+		}
 	} // namespace draw
 } // namespace spades
@@ -47,12 +47,31 @@
 #define ENABLE_SSE2 0
 #endif
 
+// AVX2 kernels are compiled for the AVX2 target on a per-function basis
+// (see SPADES_AVX2_TARGET) and only selected when the CPU supports it.
+#if ENABLE_SSE2 && !defined(ENABLE_AVX2)
+#if defined(_MSC_VER)
+#define ENABLE_AVX2 1
+#define SPADES_AVX2_TARGET
+#elif defined(__GNUC__) || defined(__clang__)
+#define ENABLE_AVX2 1
+#define SPADES_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+#endif
+
+#ifndef ENABLE_AVX2
+#define ENABLE_AVX2 0
+#endif
+
 #if ENABLE_SSE
 #include <xmmintrin.h>
 #endif
 #if ENABLE_SSE2
 #include <emmintrin.h>
 #endif
+#if ENABLE_AVX2
+#include <immintrin.h>
+#endif
 
 #include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
@@ -74,6 +93,9 @@ namespace spades {
 #endif
 #if ENABLE_SSE2
 			SSE2,
+#endif
+#if ENABLE_AVX2
+			AVX2,
 #endif
 		};
 
@@ -85,6 +107,7 @@ namespace spades {
 		}
 
 		SWFeatureLevel DetectFeatureLevel();
+		const char *GetFeatureLevelName(SWFeatureLevel);
 
 #if ENABLE_SSE // assume SSE availability (no checks!)
 		static inline float fastDiv(float a, float b) {
@@ -18,32 +18,58 @@
 
  */
 
-#include "SWImageRenderer.h"
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <limits>
+
 #include "SWImage.h"
+#include "SWImageRenderer.h"
+#include "SWUtils.h"
 #include <Core/Bitmap.h>
+#include <Core/Stopwatch.h>
 
 namespace spades {
 	namespace draw {
 		SWImageRenderer::SWImageRenderer(SWFeatureLevel lvl)
-		    : shader(ShaderType::Image), featureLevel(lvl) {}
+		    : depthBuffer(nullptr),
+		      shader(ShaderType::Image),
+		      zNear(0.0F),
+		      featureLevel(lvl),
+		      pixelsDrawn(0),
+		      clipMinY(0),
+		      clipMaxY(0),
+		      stateChanged(true),
+		      polygonsFlushed(0),
+		      tileRefs(0),
+		      flushTime(0.0) {}
 
 		SWImageRenderer::~SWImageRenderer() {}
 
 		void SWImageRenderer::SetFramebuffer(spades::Bitmap* bmp) {
+			// queued polygons belong to the old framebuffer
+			Flush();
+
 			this->frame = bmp;
 			if (bmp) {
 				fbSize4 = MakeVector4(static_cast<float>(bmp->GetWidth()) * 0.5F,
 				                      static_cast<float>(bmp->GetHeight()) * -0.5F, 1.0F, 1.0F);
 				fbCenter4 = MakeVector4(static_cast<float>(bmp->GetWidth()) * 0.5F,
 				                        static_cast<float>(bmp->GetHeight()) * 0.5F, 0.0F, 0.0F);
+				clipMinY = 0;
+				clipMaxY = bmp->GetHeight();
 			}
 		}
 
 		void SWImageRenderer::SetDepthBuffer(float* f) { depthBuffer = f; }
-		void SWImageRenderer::SetShaderType(ShaderType type) { shader = type; }
+		void SWImageRenderer::SetShaderType(ShaderType type) {
+			shader = type;
+			stateChanged = true;
+		}
 		void SWImageRenderer::SetZRange(float zNear, float) {
 			// currently zNear is ignored...
 			this->zNear = zNear;
+			stateChanged = true;
 		}
 
 		struct Interpolator {
@@ -242,16 +268,15 @@ namespace spades {
 
 				Bitmap& fb = *r.frame;
 
-				if (v3.position.y <= 0.f) {
+				if (v3.position.y <= static_cast<float>(r.clipMinY)) {
 					// viewport cull
 					return;
 				}
 
 				const int fbW = fb.GetWidth();
-				const int fbH = fb.GetHeight();
 				uint32_t* const bmp = fb.GetPixels();
 
-				if (v1.position.y >= static_cast<float>(fbH)) {
+				if (v1.position.y >= static_cast<float>(r.clipMaxY)) {
 					// viewport cull
 					return;
 				}
@@ -411,8 +436,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x1, x2, y2 - y1);
 					SWImageGouraudInterpolator<level> shortSpan(v1, v2, y2 - y1);
-					int minY = std::max(0, y1);
-					int maxY = std::min(fbH, y2);
+					int minY = std::max(r.clipMinY, y1);
+					int maxY = std::min(r.clipMaxY, y2);
 					shortSpanX.MoveNext(minY - y1);
 					shortSpan.MoveNext(minY - y1);
 					longSpanX.MoveNext(minY - y1);
@@ -440,8 +465,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x2, x3, y3 - y2);
 					SWImageGouraudInterpolator<level> shortSpan(v2, v3, y3 - y2);
-					int minY = std::max(0, y2);
-					int maxY = std::min(fbH, y3);
+					int minY = std::max(r.clipMinY, y2);
+					int maxY = std::min(r.clipMaxY, y3);
 					shortSpanX.MoveNext(minY - y2);
 					shortSpan.MoveNext(minY - y2);
 					longSpanX.MoveNext(minY - y2);
@@ -504,16 +529,15 @@ namespace spades {
 
 				Bitmap& fb = *r.frame;
 
-				if (v3.position.y <= 0.0F) {
+				if (v3.position.y <= static_cast<float>(r.clipMinY)) {
 					// viewport cull
 					return;
 				}
 
 				const int fbW = fb.GetWidth();
-				const int fbH = fb.GetHeight();
 				uint32_t* const bmp = fb.GetPixels();
 
-				if (v1.position.y >= static_cast<float>(fbH)) {
+				if (v1.position.y >= static_cast<float>(r.clipMaxY)) {
 					// viewport cull
 					return;
 				}
@@ -826,8 +850,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x1, x2, y2 - y1);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v1, v2, y2 - y1);
-					int minY = std::max(0, y1);
-					int maxY = std::min(fbH, y2);
+					int minY = std::max(r.clipMinY, y1);
+					int maxY = std::min(r.clipMaxY, y2);
 					shortSpanX.MoveNext(minY - y1);
 					shortSpan.MoveNext(minY - y1);
 					longSpanX.MoveNext(minY - y1);
@@ -855,8 +879,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x2, x3, y3 - y2);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v2, v3, y3 - y2);
-					int minY = std::max(0, y2);
-					int maxY = std::min(fbH, y3);
+					int minY = std::max(r.clipMinY, y2);
+					int maxY = std::min(r.clipMaxY, y3);
 					shortSpanX.MoveNext(minY - y2);
 					shortSpan.MoveNext(minY - y2);
 					longSpanX.MoveNext(minY - y2);
@@ -905,25 +929,68 @@ namespace spades {
 		};
 
 #pragma mark Solid
+#if ENABLE_AVX2
+		namespace {
+			// Blends the constant color into 8 pixels at once. Returns the number of
+			// pixels processed (a multiple of 8); the caller handles the rest.
+			template <bool depthTest>
+			SPADES_AVX2_TARGET int DrawSolidSpanAVX2(uint32_t* out, const float* depthOut,
+			                                         int count, __m128i mulCol128,
+			                                         __m128i mulInv128, float inDepth) {
+				__m256i mulCol = _mm256_broadcastsi128_si256(mulCol128);
+				__m256i mulInv = _mm256_broadcastsi128_si256(mulInv128);
+				__m256 inDepth8 = _mm256_set1_ps(inDepth);
+				int n = count & ~7;
+				for (int i = 0; i < n; i += 8) {
+					__m256i dcol = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(out + i));
+
+					// same arithmetic as the SSE2 path (unpack works per 128-bit lane)
+					__m256i dcol1 = _mm256_unpacklo_epi8(dcol, _mm256_setzero_si256());
+					__m256i dcol2 = _mm256_unpackhi_epi8(dcol, _mm256_setzero_si256());
+					dcol1 = _mm256_mullo_epi16(dcol1, mulInv);
+					dcol2 = _mm256_mullo_epi16(dcol2, mulInv);
+					dcol1 = _mm256_adds_epu16(dcol1, mulCol);
+					dcol2 = _mm256_adds_epu16(dcol2, mulCol);
+					dcol1 = _mm256_srli_epi16(dcol1, 8);
+					dcol2 = _mm256_srli_epi16(dcol2, 8);
+					__m256i result = _mm256_packus_epi16(dcol1, dcol2);
+
+					if (depthTest) {
+						// write only where `!(inDepth > destDepth)`, like the scalar path (which
+						// skips a pixel if `inDepth > destDepth`); NaN depths are written
+						__m256 destDepth = _mm256_loadu_ps(depthOut + i);
+						__m256i pass =
+						  _mm256_castps_si256(_mm256_cmp_ps(inDepth8, destDepth, _CMP_NGT_UQ));
+						result = _mm256_blendv_epi8(dcol, result, pass);
+					}
+
+					_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), result);
+				}
+				return n;
+			}
+		} // namespace
+#endif
+
 		template <bool depthTest, bool lerp>
 		struct SWImageRenderer::PolygonRenderer<SWFeatureLevel::SSE2, false, false, depthTest, true,
 		                                        lerp> {
 
+			/** `spanLevel` selects the kernel used for the inner part of scanlines. */
+			template <SWFeatureLevel spanLevel = SWFeatureLevel::SSE2>
 			static void DrawPolygonInternalInner(SWImage* img, const Vertex& v1, const Vertex& v2,
 			                                     const Vertex& v3, SWImageRenderer& r) {
 
 				Bitmap& fb = *r.frame;
 
-				if (v3.position.y <= 0.f) {
+				if (v3.position.y <= static_cast<float>(r.clipMinY)) {
 					// viewport cull
 					return;
 				}
 
 				const int fbW = fb.GetWidth();
-				const int fbH = fb.GetHeight();
 				uint32_t* const bmp = fb.GetPixels();
 
-				if (v1.position.y >= static_cast<float>(fbH)) {
+				if (v1.position.y >= static_cast<float>(r.clipMaxY)) {
 					// viewport cull
 					return;
 				}
@@ -1035,7 +1102,8 @@ namespace spades {
 					_mm_store_sd(reinterpret_cast<double*>(dest), _mm_castsi128_pd(dcol));
 				};
 
-				auto drawScanline = [bmp, fbW, depthBuffer, &drawPixel, &drawPixel2, &r](int y, int x1, int x2,
+				auto drawScanline = [bmp, fbW, depthBuffer, mulCol, mulInv, &drawPixel, &drawPixel2,
+				                     &r](int y, int x1, int x2,
 					const SWImageVarying& vary1, const SWImageVarying& vary2, float z1, float z2) {
 					uint32_t* out = bmp + (y * fbW);
 					float* depthOut = nullptr;
@@ -1046,6 +1114,10 @@ namespace spades {
 					// int width = x2 - x1;
 					int minX = std::max(x1, 0);
 					int maxX = std::min(x2, fbW);
+					if (minX >= maxX) {
+						// entirely outside; `reminders` below would still draw a pixel
+						return;
+					}
 					r.pixelsDrawn += maxX - minX;
 					out += minX;
 					if (depthTest) {
@@ -1067,6 +1139,17 @@ namespace spades {
 					}
 					int reminders = maxX & 1;
 					maxX -= reminders;
+#if ENABLE_AVX2
+					if (spanLevel == SWFeatureLevel::AVX2 && maxX > minX) {
+						int done = DrawSolidSpanAVX2<depthTest>(out, depthOut, maxX - minX, mulCol,
+						                                        mulInv, z1);
+						out += done;
+						if (depthTest) {
+							depthOut += done;
+						}
+						minX += done;
+					}
+#endif
 					/* for(int x = minX; x < maxX; x+=2) */
 					if (maxX > minX)
 						for (auto* endPtr = out + (maxX - minX); out != endPtr;) {
@@ -1090,8 +1173,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x1, x2, y2 - y1);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v1, v2, y2 - y1);
-					int minY = std::max(0, y1);
-					int maxY = std::min(fbH, y2);
+					int minY = std::max(r.clipMinY, y1);
+					int maxY = std::min(r.clipMaxY, y2);
 					shortSpanX.MoveNext(minY - y1);
 					shortSpan.MoveNext(minY - y1);
 					longSpanX.MoveNext(minY - y1);
@@ -1119,8 +1202,8 @@ namespace spades {
 				{
 					Interpolator shortSpanX(x2, x3, y3 - y2);
 					SWImageGouraudInterpolator<SWFeatureLevel::SSE2> shortSpan(v2, v3, y3 - y2);
-					int minY = std::max(0, y2);
-					int maxY = std::min(fbH, y3);
+					int minY = std::max(r.clipMinY, y2);
+					int maxY = std::min(r.clipMaxY, y3);
 					shortSpanX.MoveNext(minY - y2);
 					shortSpan.MoveNext(minY - y2);
 					longSpanX.MoveNext(minY - y2);
@@ -1148,28 +1231,51 @@ namespace spades {
 				// polygon, done!
 			}
 
+			template <SWFeatureLevel spanLevel = SWFeatureLevel::SSE2>
 			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
 			                                const Vertex& v3, SWImageRenderer& r) {
 				if (v2.position.y < v1.position.y) {
 					if (v3.position.y < v2.position.y) {
-						DrawPolygonInternalInner(img, v3, v2, v1, r);
+						DrawPolygonInternalInner<spanLevel>(img, v3, v2, v1, r);
 					} else if (v3.position.y < v1.position.y) {
-						DrawPolygonInternalInner(img, v2, v3, v1, r);
+						DrawPolygonInternalInner<spanLevel>(img, v2, v3, v1, r);
 					} else {
-						DrawPolygonInternalInner(img, v2, v1, v3, r);
+						DrawPolygonInternalInner<spanLevel>(img, v2, v1, v3, r);
 					}
 				} else if (v3.position.y < v1.position.y) {
-					DrawPolygonInternalInner(img, v3, v1, v2, r);
+					DrawPolygonInternalInner<spanLevel>(img, v3, v1, v2, r);
 				} else if (v3.position.y < v2.position.y) {
-					DrawPolygonInternalInner(img, v1, v3, v2, r);
+					DrawPolygonInternalInner<spanLevel>(img, v1, v3, v2, r);
 				} else {
-					DrawPolygonInternalInner(img, v1, v2, v3, r);
+					DrawPolygonInternalInner<spanLevel>(img, v1, v2, v3, r);
 				}
 			}
 		};
 
 #endif
 
+#pragma mark - AVX2
+#if ENABLE_AVX2
+
+		// Textured polygons are bound by texel fetches, which AVX2 doesn't speed up.
+		template <bool depthTest, bool lerp>
+		struct SWImageRenderer::PolygonRenderer<SWFeatureLevel::AVX2, false, false, depthTest,
+		                                        false, lerp>
+		    : PolygonRenderer<SWFeatureLevel::SSE2, false, false, depthTest, false, lerp> {};
+
+		template <bool depthTest, bool lerp>
+		struct SWImageRenderer::PolygonRenderer<SWFeatureLevel::AVX2, false, false, depthTest, true,
+		                                        lerp> {
+			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
+			                                const Vertex& v3, SWImageRenderer& r) {
+				PolygonRenderer<SWFeatureLevel::SSE2, false, false, depthTest, true,
+				                lerp>::template DrawPolygonInternal<SWFeatureLevel::AVX2>(img, v1,
+				                                                                          v2, v3, r);
+			}
+		};
+
+#endif
+
 #pragma mark - Intermediates
 
 		template <SWFeatureLevel featureLvl, bool depthTest, bool solidFill, bool lerp>
@@ -1358,6 +1464,13 @@ namespace spades {
 			static void DrawPolygonInternal(SWImage* img, const Vertex& v1, const Vertex& v2,
 			                                const Vertex& v3, SWImageRenderer& r,
 			                                SWFeatureLevel lvl) {
+#if ENABLE_AVX2
+				if (static_cast<int>(lvl) >= static_cast<int>(SWFeatureLevel::AVX2)) {
+					PolygonRenderer3<SWFeatureLevel::AVX2, needTransform, ndc, depthTest,
+					                 lerp>::DrawPolygonInternal(img, v1, v2, v3, r);
+					return;
+				}
+#endif
 #if ENABLE_SSE2
 				if (static_cast<int>(lvl) >= static_cast<int>(SWFeatureLevel::SSE2)) {
 					PolygonRenderer3<SWFeatureLevel::SSE2, needTransform, ndc, depthTest,
@@ -1370,9 +1483,8 @@ namespace spades {
 			}
 		};
 
-		void SWImageRenderer::DrawPolygon(SWImage* img, const Vertex& v1, const Vertex& v2,
-		                                  const Vertex& v3) {
-			SPAssert(frame);
+		void SWImageRenderer::RasterizePolygon(SWImage* img, const Vertex& v1, const Vertex& v2,
+		                                       const Vertex& v3) {
 			switch (shader) {
 				case ShaderType::Sprite:
 					PolygonRenderer2<true, // needs transform
@@ -1390,5 +1502,225 @@ namespace spades {
 					break;
 			}
 		}
+
+#pragma mark - Binning
+
+		void SWImageRenderer::ComputeTileRange(QueuedPolygon& poly) {
+			const RenderState& state = states[poly.state];
+			const int fbH = frame->GetHeight();
+			const int numTiles = (fbH + TileHeight - 1) / TileHeight;
+
+			float minY = std::numeric_limits<float>::infinity();
+			float maxY = -minY;
+			for (const Vertex& v : poly.vertices) {
+				float y = v.position.y;
+				if (state.shader == ShaderType::Sprite) {
+					Vector4 p = state.matrix * v.position;
+					if (p.z < state.zNear || p.w <= 0.0F) {
+						// the polygon will be clipped by the near plane; the clipped
+						// vertices can end up anywhere on the screen
+						poly.minTile = 0;
+						poly.maxTile = numTiles - 1;
+						return;
+					}
+					y = p.y / p.w * fbSize4.y + fbCenter4.y;
+				}
+				minY = std::min(minY, y);
+				maxY = std::max(maxY, y);
+			}
+
+			// be conservative; the rasterizer divides by W using an approximate reciprocal
+			float lo = std::max(minY - 2.0F, 0.0F);
+			float hi = std::min(maxY + 2.0F, static_cast<float>(fbH));
+			if (!(lo < hi)) {
+				// culled (or NaN)
+				poly.minTile = 1;
+				poly.maxTile = 0;
+				return;
+			}
+			poly.minTile = static_cast<int>(lo) / TileHeight;
+			poly.maxTile = std::min(static_cast<int>(hi) / TileHeight, numTiles - 1);
+		}
+
+		void SWImageRenderer::DrawPolygon(SWImage* img, const Vertex& v1, const Vertex& v2,
+		                                  const Vertex& v3) {
+			SPAssert(frame);
+
+			if (stateChanged || states.empty()) {
+				states.push_back(RenderState{shader, matrix, zNear});
+				stateChanged = false;
+			}
+
+			polygons.emplace_back();
+			QueuedPolygon& poly = polygons.back();
+			poly.image = img;
+			poly.vertices[0] = v1;
+			poly.vertices[1] = v2;
+			poly.vertices[2] = v3;
+			poly.state = static_cast<std::uint32_t>(states.size() - 1);
+			ComputeTileRange(poly);
+		}
+
+		void SWImageRenderer::Flush() {
+			SPADES_MARK_FUNCTION();
+
+			if (polygons.empty())
+				return;
+			SPAssert(frame);
+
+			Stopwatch sw;
+
+			const int fbH = frame->GetHeight();
+			const int numTiles = (fbH + TileHeight - 1) / TileHeight;
+
+			tiles.resize(static_cast<std::size_t>(numTiles));
+			for (auto& tile : tiles)
+				tile.clear();
+			for (std::size_t i = 0; i < polygons.size(); i++) {
+				const QueuedPolygon& poly = polygons[i];
+				for (int t = poly.minTile; t <= poly.maxTile; t++)
+					tiles[t].push_back(static_cast<std::uint32_t>(i));
+				if (poly.maxTile >= poly.minTile)
+					tileRefs += static_cast<unsigned long long>(poly.maxTile - poly.minTile + 1);
+			}
+
+			// tiles don't overlap, so each of them can be rasterized by any thread
+			// as long as the polygons within a tile are drawn in submission order.
+			std::atomic<int> nextTile{0};
+			std::array<unsigned long long, 32> threadPixelsDrawn;
+			threadPixelsDrawn.fill(0);
+
+			InvokeParallel2([&](unsigned int threadId, unsigned int) {
+				SWImageRenderer worker{featureLevel};
+				worker.SetFramebuffer(frame.GetPointerOrNull());
+				worker.SetDepthBuffer(depthBuffer);
+
+				int t;
+				while ((t = nextTile.fetch_add(1)) < numTiles) {
+					worker.clipMinY = t * TileHeight;
+					worker.clipMaxY = std::min(fbH, worker.clipMinY + TileHeight);
+					for (std::uint32_t index : tiles[t]) {
+						const QueuedPolygon& poly = polygons[index];
+						const RenderState& state = states[poly.state];
+						worker.shader = state.shader;
+						worker.matrix = state.matrix;
+						worker.zNear = state.zNear;
+						worker.RasterizePolygon(poly.image.GetPointerOrNull(), poly.vertices[0],
+						                        poly.vertices[1], poly.vertices[2]);
+					}
+				}
+
+				threadPixelsDrawn[threadId] = worker.pixelsDrawn;
+			});
+
+			for (unsigned long long n : threadPixelsDrawn)
+				pixelsDrawn += n;
+			polygonsFlushed += polygons.size();
+
+			polygons.clear();
+			states.clear();
+			stateChanged = true;
+
+			flushTime += sw.GetTime();
+		}
+
+#pragma mark - Verification
+
+		bool SWImageRenderer::VerifyFeatureLevel(SWFeatureLevel level, SWFeatureLevel reference,
+		                                         int tolerance) {
+			SPADES_MARK_FUNCTION();
+
+			// odd sizes so spans start and end at every alignment
+			constexpr int width = 67, height = 45;
+			constexpr int numPolygons = 96;
+
+			// solid fills use a white image, like `SWRenderer` does; the scalar path
+			// samples it while the SIMD paths use the solid span kernels
+			auto whiteBmp = Handle<Bitmap>::New(1, 1);
+			whiteBmp->GetPixels()[0] = 0xffffffff;
+			auto whiteImage = Handle<SWImage>::New(*whiteBmp);
+
+			auto render = [&](SWFeatureLevel lvl, std::vector<float>& depth) {
+				std::uint32_t seed = 0x12345678;
+				auto next = [&seed]() {
+					seed ^= seed << 13;
+					seed ^= seed >> 17;
+					seed ^= seed << 5;
+					return seed;
+				};
+				auto nextFloat = [&next](float lo, float hi) {
+					return lo + (hi - lo) * static_cast<float>(next() & 0xffff) / 65535.0F;
+				};
+
+				auto frame = Handle<Bitmap>::New(width, height);
+				for (int i = 0; i < width * height; i++)
+					frame->GetPixels()[i] = next();
+				depth.resize(width * height);
+				for (float& d : depth)
+					d = nextFloat(0.1F, 4.0F);
+
+				SWImageRenderer r{lvl};
+				r.SetFramebuffer(frame.GetPointerOrNull());
+				r.SetDepthBuffer(depth.data());
+				r.SetZRange(0.05F, 100.0F);
+
+				for (int i = 0; i < numPolygons; i++) {
+					// alternate between the blended 2D path and the depth-tested,
+					// interpolated sprite path
+					bool sprite = (i & 1) != 0;
+					r.SetShaderType(sprite ? ShaderType::Sprite : ShaderType::Image);
+
+					Vertex v[3];
+					Vector4 color = MakeVector4(nextFloat(0.0F, 1.0F), nextFloat(0.0F, 1.0F),
+					                            nextFloat(0.0F, 1.0F), 1.0F);
+					switch (next() % 3) {
+						case 0: color.w = 1.0F; break;
+						case 1: color.w = 0.0F; break;
+						default: color.w = nextFloat(0.0F, 1.0F); break;
+					}
+					for (Vertex& vt : v) {
+						if (sprite) {
+							vt.position = MakeVector4(nextFloat(-1.2F, 1.2F),
+							                          nextFloat(-1.2F, 1.2F),
+							                          nextFloat(0.1F, 4.0F), 1.0F);
+						} else {
+							vt.position = MakeVector4(nextFloat(-8.0F, width + 8.0F),
+							                          nextFloat(-8.0F, height + 8.0F), 0.0F,
+							                          1.0F);
+						}
+						vt.color = color;
+						vt.uv = MakeVector2(0.0F, 0.0F);
+					}
+					r.DrawPolygon(whiteImage.GetPointerOrNull(), v[0], v[1], v[2]);
+				}
+				r.Flush();
+				return frame;
+			};
+
+			std::vector<float> depth1, depth2;
+			Handle<Bitmap> frame1 = render(level, depth1);
+			Handle<Bitmap> frame2 = render(reference, depth2);
+
+			int numMismatches = 0;
+			for (int i = 0; i < width * height; i++) {
+				std::uint32_t c1 = frame1->GetPixels()[i];
+				std::uint32_t c2 = frame2->GetPixels()[i];
+				bool match = depth1[i] == depth2[i];
+				// the alpha channel isn't presented
+				for (int shift = 0; shift < 24; shift += 8) {
+					int diff = static_cast<int>((c1 >> shift) & 0xff) -
+					           static_cast<int>((c2 >> shift) & 0xff);
+					if (std::abs(diff) > tolerance)
+						match = false;
+				}
+				if (!match)
+					numMismatches++;
+			}
+			if (numMismatches > 0) {
+				SPLog("%s renders %d of %d pixel(s) differently from %s", GetFeatureLevelName(level),
+				      numMismatches, width * height, GetFeatureLevelName(reference));
+			}
+			return numMismatches == 0;
+		}
 	} // namespace draw
-} // namespace spades
\ No newline at end of file
+} // namespace spades
@@ -20,6 +20,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <vector>
+
 #include "SWFeatureLevel.h"
 #include <Core/Math.h>
 #include <Core/RefCountedObject.h>
@@ -38,7 +41,22 @@ namespace spades {
 			};
 			enum class ShaderType { Image, Sprite };
 
+			/** The height of a screen tile (in pixels) polygons are binned into. */
+			enum { TileHeight = 32 };
+
 		private:
+			struct RenderState {
+				ShaderType shader;
+				Matrix4 matrix;
+				float zNear;
+			};
+			struct QueuedPolygon {
+				Handle<SWImage> image;
+				Vertex vertices[3];
+				std::uint32_t state;
+				int minTile, maxTile;
+			};
+
 			Handle<Bitmap> frame;
 			float *depthBuffer;
 			ShaderType shader;
@@ -48,6 +66,19 @@ namespace spades {
 			Matrix4 matrix;
 			SWFeatureLevel featureLevel;
 			unsigned long long pixelsDrawn;
+			int clipMinY, clipMaxY;
+
+			std::vector<RenderState> states;
+			bool stateChanged;
+			std::vector<QueuedPolygon> polygons;
+			std::vector<std::vector<std::uint32_t>> tiles;
+			unsigned long long polygonsFlushed;
+			unsigned long long tileRefs;
+			double flushTime;
+
+			void ComputeTileRange(QueuedPolygon &);
+			void RasterizePolygon(SWImage *img, const Vertex &v1, const Vertex &v2,
+			                      const Vertex &v3);
 
 			template <SWFeatureLevel, bool, bool, bool, bool, bool> struct PolygonRenderer;
 
@@ -61,15 +92,47 @@ namespace spades {
 			void SetFramebuffer(Bitmap *);
 			void SetDepthBuffer(float *);
 
-			void SetMatrix(const Matrix4 &m) { matrix = m; }
+			void SetMatrix(const Matrix4 &m) {
+				matrix = m;
+				stateChanged = true;
+			}
 			void SetZRange(float zNear, float zFar);
 
 			void SetShaderType(ShaderType);
 
+			/**
+			 * Queues a polygon. Queued polygons are sorted into screen tiles and
+			 * rasterized by `Flush`; polygons sharing a tile are drawn in the
+			 * order they were submitted.
+			 */
 			void DrawPolygon(SWImage *img, const Vertex &v1, const Vertex &v2, const Vertex &v3);
 
+			/** Rasterizes all queued polygons, distributing the tiles among worker threads. */
+			void Flush();
+
+			/**
+			 * Draws a fixed set of solid polygons (with and without depth testing and
+			 * blending) at `level` and `reference` and compares the results pixel by pixel.
+			 * Used to check the SIMD span kernels against the paths they replace.
+			 *
+			 * The SIMD levels should match exactly. The scalar path rounds differently, so
+			 * comparisons against it need a `tolerance` (per color channel).
+			 */
+			static bool VerifyFeatureLevel(SWFeatureLevel level, SWFeatureLevel reference,
+			                               int tolerance = 0);
+
 			unsigned long long GetPixelsDrawn() { return pixelsDrawn; }
-			void ResetPixelStatistics() { pixelsDrawn = 0; }
+			unsigned long long GetPolygonsFlushed() { return polygonsFlushed; }
+			/** @return the sum of the number of tiles each flushed polygon was binned into. */
+			unsigned long long GetTileReferences() { return tileRefs; }
+			/** @return the time spent in `Flush` since the last reset, in seconds. */
+			double GetFlushTime() { return flushTime; }
+			void ResetPixelStatistics() {
+				pixelsDrawn = 0;
+				polygonsFlushed = 0;
+				tileRefs = 0;
+				flushTime = 0.0;
+			}
 		};
 	} // namespace draw
 } // namespace spades
@@ -56,6 +56,7 @@ namespace spades {
 		      drawColorAlphaPremultiplied(MakeVector4(1, 1, 1, 1)),
 		      legacyColorPremultiply(false),
 		      lastTime(0),
+		      fogTime(0.0),
 		      duringSceneRendering(false) {
 
 			SPADES_MARK_FUNCTION();
@@ -63,12 +64,24 @@ namespace spades {
 			SPAssert(port);
 
 			SPLog("---- SWRenderer early initialization started ---");
+			SPLog("feature level: %s", GetFeatureLevelName(featureLevel));
 
 #ifdef FE_DFL_DISABLE_SSE_DENORMS_ENV
 			SPLog("initializing FPU");
 			fesetenv(FE_DFL_DISABLE_SSE_DENORMS_ENV);
 #endif
 
+#if ENABLE_AVX2
+			if (featureLevel == SWFeatureLevel::AVX2) {
+				SPLog("verifying AVX2 span kernels");
+				if (!SWImageRenderer::VerifyFeatureLevel(SWFeatureLevel::AVX2,
+				                                         SWFeatureLevel::SSE2)) {
+					SPLog("AVX2 output doesn't match SSE2; falling back to SSE2");
+					featureLevel = SWFeatureLevel::SSE2;
+				}
+			}
+#endif
+
 			SPLog("creating image manager");
 			imageManager = std::make_shared<SWImageManager>();
 
@@ -517,6 +530,119 @@ namespace spades {
 
 		} // ApplyFog()
 
+#endif
+
+#if ENABLE_AVX2
+
+		namespace {
+			// 8-wide version of the SSE2 fog kernel; processes two 4x4 blocks
+			// at once and produces exactly the same output.
+			SPADES_AVX2_TARGET void ApplyFogRowsAVX2(uint32_t* fb, float* db, int fw,
+			                                         int startY, int endY, float fovX,
+			                                         float vy, float dvx, float dvy,
+			                                         float scale, __m128i fog128) {
+				__m256i fog = _mm256_broadcastsi128_si256(fog128);
+
+				for (int y = startY; y < endY; y += 4) {
+					float vx = fovX;
+
+					for (int x = 0; x < fw; x += 8) {
+						float depthScale1 = (1.0F + vx * vx + vy * vy);
+						depthScale1 *= fastRSqrt(depthScale1) * scale;
+						vx += dvx;
+						float depthScale2 = (1.0F + vx * vx + vy * vy);
+						depthScale2 *= fastRSqrt(depthScale2) * scale;
+						vx += dvx;
+						auto depthScale8 =
+						  _mm256_setr_ps(depthScale1, depthScale1, depthScale1, depthScale1,
+						                 depthScale2, depthScale2, depthScale2, depthScale2);
+
+						auto* fb2 = fb + x;
+						auto* db2 = db + x;
+						for (int by = 0; by < 4; by++) {
+							auto dist = _mm256_loadu_ps(db2);
+							auto color = _mm256_loadu_si256(reinterpret_cast<__m256i*>(fb2));
+
+							dist = _mm256_mul_ps(dist, depthScale8);
+							dist = _mm256_max_ps(dist, _mm256_set1_ps(0.0F));
+							dist = _mm256_min_ps(dist, _mm256_set1_ps(256.0F));
+							auto factorX = _mm256_cvtps_epi32(dist);
+							auto factorY = _mm256_sub_epi32(_mm256_set1_epi32(0x100), factorX);
+
+							factorX = _mm256_shufflelo_epi16(factorX, 0xa0);
+							factorX = _mm256_shufflehi_epi16(factorX, 0xa0);
+							factorY = _mm256_shufflelo_epi16(factorY, 0xa0);
+							factorY = _mm256_shufflehi_epi16(factorY, 0xa0);
+
+							// pixels 0, 1, 4, 5 (unpack works per 128-bit lane)
+							auto color1 = _mm256_unpacklo_epi8(color, _mm256_setzero_si256());
+							auto factor1X = _mm256_shuffle_epi32(factorY, 0x50);
+							auto factor1Y = _mm256_shuffle_epi32(factorX, 0x50);
+							color1 = _mm256_mullo_epi16(color1, factor1X);
+							auto fog1 = _mm256_mullo_epi16(fog, factor1Y);
+							fog1 = _mm256_adds_epu16(fog1, color1);
+							fog1 = _mm256_srli_epi16(fog1, 8);
+
+							// pixels 2, 3, 6, 7
+							auto color2 = _mm256_unpackhi_epi8(color, _mm256_setzero_si256());
+							auto factor2X = _mm256_shuffle_epi32(factorY, 0xfa);
+							auto factor2Y = _mm256_shuffle_epi32(factorX, 0xfa);
+							color2 = _mm256_mullo_epi16(color2, factor2X);
+							auto fog2 = _mm256_mullo_epi16(fog, factor2Y);
+							fog2 = _mm256_adds_epu16(fog2, color2);
+							fog2 = _mm256_srli_epi16(fog2, 8);
+
+							auto pack = _mm256_packus_epi16(fog1, fog2);
+							_mm256_storeu_si256(reinterpret_cast<__m256i*>(fb2), pack);
+
+							fb2 += fw;
+							db2 += fw;
+						}
+					}
+
+					vy += dvy;
+					fb += fw * 4;
+					db += fw * 4;
+				}
+			}
+		} // namespace
+
+		template <> void SWRenderer::ApplyFog<SWFeatureLevel::AVX2>() {
+			int fw = this->fb->GetWidth();
+			int fh = this->fb->GetHeight();
+
+			float fovX = tanf(sceneDef.fovX * 0.5F);
+			float fovY = tanf(sceneDef.fovY * 0.5F);
+
+			float dvx = -fovX * 2.0F / static_cast<float>(fw / 4);
+			float dvy = -fovY * 2.0F / static_cast<float>(fh / 4);
+
+			int fogR = ToFixed8(fogColor.x);
+			int fogG = ToFixed8(fogColor.y);
+			int fogB = ToFixed8(fogColor.z);
+			__m128i fog = _mm_setr_epi16(fogB, fogG, fogR, 0, fogB, fogG, fogR, 0);
+
+			float scale = 255.0F / fogDistance;
+
+			InvokeParallel2([&](unsigned int threadId, unsigned int numThreads) {
+				int startY = fh * threadId / numThreads;
+				int endY = fh * (threadId + 1) / numThreads;
+				startY &= ~3;
+				endY &= ~3;
+
+				float vy = fovY;
+				auto* fb = this->fb->GetPixels();
+				float* db = depthBuffer.data();
+
+				vy += dvy * (startY >> 2);
+				fb += fw * startY;
+				db += fw * startY;
+
+				ApplyFogRowsAVX2(fb, db, fw, startY, endY, fovX, vy, dvx, dvy, scale, fog);
+			});
+
+		} // ApplyFog()
+
 #endif
 
 		void SWRenderer::EnsureSceneStarted() {
@@ -550,6 +676,9 @@ namespace spades {
 			EnsureInitialized();
 			EnsureSceneNotStarted();
 
+			// 2D images drawn so far must reach the framebuffer before it's cleared
+			imageRenderer->Flush();
+
 			sceneDef = def;
 			duringSceneRendering = true;
 
@@ -730,12 +859,19 @@ namespace spades {
 					ApplyDynamicLight<SWFeatureLevel::None>(light);
 				lights.clear();
 
+				Stopwatch fogStopwatch;
+#if ENABLE_AVX2
+				if (static_cast<int>(featureLevel) >= static_cast<int>(SWFeatureLevel::AVX2))
+					ApplyFog<SWFeatureLevel::AVX2>();
+				else
+#endif
 #if ENABLE_SSE2
 				if (static_cast<int>(featureLevel) >= static_cast<int>(SWFeatureLevel::SSE2))
 					ApplyFog<SWFeatureLevel::SSE2>();
 				else
 #endif
 					ApplyFog<SWFeatureLevel::None>();
+				fogTime += fogStopwatch.GetTime();
 
 				// render sprites
 				{
@@ -778,6 +914,7 @@ namespace spades {
 						v3.position = x3;
 						imageRenderer->DrawPolygon(spr.img.GetPointerOrNull(), v1, v2, v3);
 					}
+					imageRenderer->Flush();
 					sprites.clear();
 				}
 			}
@@ -928,6 +1065,14 @@ namespace spades {
 			drawColorAlphaPremultiplied = col;
 		}
 
+		void SWRenderer::SetImageDistanceField(
+		  stmp::optional<client::ImageDistanceField> field) {
+			// the image renderer samples the nearest texel, which would make distance
+			// fields look blocky anyway
+			if (field)
+				SPUnsupported();
+		}
+
 		void SWRenderer::DrawImage(stmp::optional<client::IImage&> image,
 		                           const spades::Vector2& outTopLeft) {
 			SPADES_MARK_FUNCTION();
@@ -1042,6 +1187,8 @@ namespace spades {
 			SPADES_MARK_FUNCTION();
 			EnsureValid();
 			EnsureSceneNotStarted();
+
+			imageRenderer->Flush();
 		}
 
 		void SWRenderer::Flip() {
@@ -1049,14 +1196,25 @@ namespace spades {
 			EnsureValid();
 			EnsureSceneNotStarted();
 
+			imageRenderer->Flush();
+
 			if (r_swStatistics) {
 				double dur = renderStopwatch.GetTime();
+				unsigned long long numPolygons = imageRenderer->GetPolygonsFlushed();
 				SPLog("==== SWRenderer Statistics ====");
 				SPLog("Elapsed Time: %.3fus", dur * 1000000.0);
 				SPLog("Polygon pixels drawn: %llu", imageRenderer->GetPixelsDrawn());
+				SPLog("Polygons rasterized: %llu (%.2f tiles/polygon) in %.3fus using %d thread(s)",
+				      numPolygons,
+				      numPolygons ? static_cast<double>(imageRenderer->GetTileReferences()) /
+				                      static_cast<double>(numPolygons)
+				                  : 0.0,
+				      imageRenderer->GetFlushTime() * 1000000.0, GetNumSWRendererThreads());
+				SPLog("Fog: %.3fus (%s)", fogTime * 1000000.0, GetFeatureLevelName(featureLevel));
 			}
 
 			imageRenderer->ResetPixelStatistics();
+			fogTime = 0.0;
 			renderStopwatch.Reset();
 			port->Swap();
 
@@ -1069,6 +1227,8 @@ namespace spades {
 			EnsureValid();
 			EnsureSceneNotStarted();
 
+			imageRenderer->Flush();
+
 			int w = fb->GetWidth();
 			int h = fb->GetHeight();
 			uint32_t* inPix = fb->GetPixels();
@@ -124,6 +124,7 @@ namespace spades {
 			unsigned int lastTime;
 
 			Stopwatch renderStopwatch;
+			double fogTime;
 
 			bool duringSceneRendering;
 
@@ -184,6 +185,9 @@ namespace spades {
 			void SetColor(Vector4) override;
 			void SetColorAlphaPremultiplied(Vector4) override;
 
+			bool SupportsImageDistanceField() override { return false; }
+			void SetImageDistanceField(stmp::optional<client::ImageDistanceField>) override;
+
 			void DrawImage(stmp::optional<client::IImage &>, const Vector2 &outTopLeft) override;
 			void DrawImage(stmp::optional<client::IImage &>, const AABB2 &outRect) override;
 			void DrawImage(stmp::optional<client::IImage &>, const Vector2 &outTopLeft,
@@ -18,6 +18,8 @@
 
  */
 
+#include <algorithm>
+
 #include "SWUtils.h"
 #include <Core/Settings.h>
 
@@ -25,6 +27,6 @@ SPADES_SETTING(r_swNumThreads);
 
 namespace spades {
 	namespace draw {
-		int GetNumSWRendererThreads() { return r_swNumThreads; }
+		int GetNumSWRendererThreads() { return std::max(std::min((int)r_swNumThreads, 32), 1); }
 	} // namespace draw
 } // namespace spades
\ No newline at end of file
@@ -29,6 +29,7 @@
 
 namespace spades {
 	namespace draw {
+		/** Returns the number of threads `InvokeParallel2` uses (`r_swNumThreads` clamped). */
 		int GetNumSWRendererThreads();
 
 		template <class F> static void InvokeParallel(F f, unsigned int numThreads) {
@@ -48,8 +49,6 @@ namespace spades {
 		template <class F> static void InvokeParallel2(F f) {
 
 			unsigned int numThreads = static_cast<unsigned int>(GetNumSWRendererThreads());
-			numThreads = std::max(numThreads, 1U);
-			numThreads = std::min(numThreads, 32U);
 
 			std::array<std::unique_ptr<ConcurrentDispatch>, 32> disp;
 			for (auto i = 1U; i < numThreads; i++) {
@@ -19,7 +19,9 @@
  */
 #include <ScriptBindings/Config.h>
 #include <ScriptBindings/ScriptFunction.h>
+#include <ScriptBindings/ScriptProfiler.h>
 
+#include <Audio/SWAudioDevice.h>
 #include <Client/Fonts.h>
 
 #include "ConfigConsoleResponder.h"
@@ -223,11 +225,15 @@ namespace spades {
 			constexpr const char* CMD_HELP = "help";
 			constexpr const char* CMD_CLEARGFXCACHE = "cleargfxcache";
 			constexpr const char* CMD_CLEARSFXCACHE = "clearsfxcache";
+			constexpr const char* CMD_SCRIPTPROF = "scriptprof";
+			constexpr const char* CMD_SWAUDIOBENCH = "swaudiobench";
 
 			std::map<std::string, std::string> const g_commands{
 			  {CMD_HELP, ": Display all available commands"},
 			  {CMD_CLEARGFXCACHE, ": Clear the GFX (models and images) cache, forcing reload"},
 			  {CMD_CLEARSFXCACHE, ": Clear the SFX cache, forcing reload"},
+			  {CMD_SCRIPTPROF, ": Profile scripts (start|stop|reset|report [count]|dump [file]|contexts|bench [count])"},
+			  {CMD_SWAUDIOBENCH, ": Time the software mixer and check it against its scalar paths"},
 			};
 		} // namespace
 
@@ -254,10 +260,81 @@ namespace spades {
 				}
 				audioDevice->ClearCache();
 				return true;
+			} else if (command->GetName() == CMD_SCRIPTPROF) {
+				ExecScriptProfilerCommand(command);
+				return true;
+			} else if (command->GetName() == CMD_SWAUDIOBENCH) {
+				if (command->GetNumArguments() != 0) {
+					SPLog("Usage: %s (no arguments)", CMD_SWAUDIOBENCH);
+					return true;
+				}
+				if (audio::SWAudioDevice::VerifyMixer())
+					SPLog("Software mixer output matches the scalar paths");
+				else
+					SPLog("Software mixer output differs from the scalar paths");
+				return true;
 			}
 			return ConfigConsoleResponder::ExecCommand(command) || subview->ExecCommand(command);
 		}
 
+		void ConsoleScreen::ExecScriptProfilerCommand(const Handle<ConsoleCommand>& command) {
+			SPADES_MARK_FUNCTION();
+			ScriptProfiler* profiler = ScriptProfiler::GetInstance();
+			std::string action = command->GetNumArguments() > 0 ? command->GetArgument(0) : "";
+
+			if (action == "start" && command->GetNumArguments() == 1) {
+				profiler->Start();
+				SPLog("Script profiler started");
+			} else if (action == "stop" && command->GetNumArguments() == 1) {
+				profiler->Stop();
+				SPLog("Script profiler stopped");
+			} else if (action == "reset" && command->GetNumArguments() == 1) {
+				profiler->Reset();
+				SPLog("Script profiler statistics cleared");
+			} else if (action == "report" && command->GetNumArguments() <= 2) {
+				int count = 20;
+				if (command->GetNumArguments() == 2) {
+					try {
+						count = std::max(std::stoi(command->GetArgument(1)), 1);
+					} catch (const std::exception&) {
+						SPLog("Invalid count: %s", command->GetArgument(1).c_str());
+						return;
+					}
+				}
+				profiler->PrintReport(static_cast<std::size_t>(count));
+			} else if (action == "dump" && command->GetNumArguments() <= 2) {
+				std::string path = command->GetNumArguments() == 2 ? command->GetArgument(1)
+				                                                   : "ScriptProfile.json";
+				try {
+					profiler->DumpJson(path);
+				} catch (const std::exception& ex) {
+					SPLog("Failed to write the script profile: %s", ex.what());
+				}
+			} else if (action == "contexts" && command->GetNumArguments() == 1) {
+				auto stats = ScriptManager::GetInstance()->GetContextStatistics();
+				SPLog("Script contexts: %llu created, %llu reused, %llu nested call(s)",
+				      (unsigned long long)stats.created, (unsigned long long)stats.reused,
+				      (unsigned long long)stats.nested);
+			} else if (action == "bench" && command->GetNumArguments() <= 2) {
+				int count = 100000;
+				if (command->GetNumArguments() == 2) {
+					try {
+						count = std::max(std::stoi(command->GetArgument(1)), 1);
+					} catch (const std::exception&) {
+						SPLog("Invalid count: %s", command->GetArgument(1).c_str());
+						return;
+					}
+				}
+				double t = ScriptManager::GetInstance()->MeasureCallOverhead(count);
+				SPLog("Native to script call overhead: %.1f ns/call (%d calls)", t * 1.0e+9,
+				      count);
+			} else {
+				SPLog("Usage: %s start|stop|reset|report [count]|dump [file]|contexts|"
+				      "bench [count]",
+				      CMD_SCRIPTPROF);
+			}
+		}
+
 		Handle<ConsoleCommandCandidateIterator>
 		ConsoleScreen::AutocompleteCommandName(const std::string& name) {
 			SPADES_MARK_FUNCTION();
@@ -75,6 +75,9 @@ namespace spades {
 
 			/** Dump all available commands to `SPLog`. */
 			void DumpAllCommands();
+
+			/** Handle the `scriptprof` command which controls `ScriptProfiler`. */
+			void ExecScriptProfilerCommand(const Handle<ConsoleCommand>&);
 		};
 	} // namespace gui
 } // namespace spades
\ No newline at end of file
@@ -18,6 +18,8 @@
 
  */
 
+#include <algorithm>
+
 #include <Imports/OpenGL.h>
 #include <Imports/SDL.h>
 
@@ -37,6 +39,7 @@ using namespace spades::draw;
 #endif
 
 DEFINE_SPADES_SETTING(r_ignoreGLErrors, "1");
+DEFINE_SPADES_SETTING(r_glStateCache, "1");
 
 static uint32_t vertCount = 0;
 static uint32_t drawOps = 0;
@@ -116,9 +119,11 @@ namespace spades {
 		static void ReportMissingFunc(const char* func) { SPRaise("GL function %s missing", func); }
 #endif
 
-		SDLGLDevice::SDLGLDevice(SDL_Window* s) : window(s) {
+		SDLGLDevice::SDLGLDevice(SDL_Window* s) : window(s), useStateCache(r_glStateCache) {
 			SPLog("Starting SDLGLDevice");
 
+			InvalidateStateCache();
+
 			SDL_GetWindowSize(window, &w, &h);
 			context = SDL_GL_CreateContext(s);
 			if (!context) {
@@ -193,6 +198,33 @@ namespace spades {
 
 		SDLGLDevice::~SDLGLDevice() { SDL_GL_DeleteContext(context); }
 
+		void SDLGLDevice::InvalidateStateCache() {
+			currentProgram = UnknownState;
+			boundBuffers.fill(UnknownState);
+			activeTextureUnit = UnknownState;
+			for (auto& unit : boundTextures)
+				unit.fill(UnknownState);
+			enabledStates.fill(UnknownState);
+			enabledVertexAttribs.fill(UnknownState);
+			blendEquation.fill(UnknownState);
+			blendFunc.fill(UnknownState);
+			depthFunc = UnknownState;
+			depthMask = UnknownState;
+		}
+
+		bool SDLGLDevice::SkipStateChange(GLuint* cached, const GLuint* values,
+		                                  std::size_t count) {
+			if (!useStateCache)
+				return false;
+			++stateCacheStatistics.numCalls;
+			if (std::equal(values, values + count, cached)) {
+				++stateCacheStatistics.numSkipped;
+				return true;
+			}
+			std::copy(values, values + count, cached);
+			return false;
+		}
+
 		void SDLGLDevice::DepthRange(Float near, Float far) {
 			CheckExistence(glDepthRange);
 			glDepthRange(near, far);
@@ -259,6 +291,8 @@ namespace spades {
 		}
 
 		void SDLGLDevice::DepthMask(bool b) {
+			if (SkipStateChange(depthMask, b ? GL_TRUE : GL_FALSE))
+				return;
 			CheckExistence(glDepthMask);
 			glDepthMask(b ? GL_TRUE : GL_FALSE);
 			CheckError();
@@ -320,16 +354,19 @@ namespace spades {
 		void SDLGLDevice::Enable(Enum s, bool b) {
 			SPADES_MARK_FUNCTION();
 			GLenum type;
+			std::size_t index;
 			switch (s) {
-				case DepthTest: type = GL_DEPTH_TEST; break;
-				case CullFace: type = GL_CULL_FACE; break;
-				case Blend: type = GL_BLEND; break;
-				case PolygonOffsetLine: type = GL_POLYGON_OFFSET_LINE; break;
-				case Texture2D: type = GL_TEXTURE_2D; break;
-				case Multisample: type = GL_MULTISAMPLE; break;
-				case FramebufferSRGB: type = GL_FRAMEBUFFER_SRGB; break;
+				case DepthTest: type = GL_DEPTH_TEST; index = 0; break;
+				case CullFace: type = GL_CULL_FACE; index = 1; break;
+				case Blend: type = GL_BLEND; index = 2; break;
+				case PolygonOffsetLine: type = GL_POLYGON_OFFSET_LINE; index = 3; break;
+				case Texture2D: type = GL_TEXTURE_2D; index = 4; break;
+				case Multisample: type = GL_MULTISAMPLE; index = 5; break;
+				case FramebufferSRGB: type = GL_FRAMEBUFFER_SRGB; index = 6; break;
 				default: SPInvalidEnum("state", s);
 			}
+			if (SkipStateChange(enabledStates[index], b ? GL_TRUE : GL_FALSE))
+				return;
 			if (b)
 				glEnable(type);
 			else
@@ -404,25 +441,42 @@ namespace spades {
 		}
 
 		void SDLGLDevice::BlendEquation(Enum mode) {
+			GLenum glMode = parseBlendEquation(mode);
+			const GLuint state[] = {glMode, glMode};
+			if (SkipStateChange(blendEquation.data(), state, 2))
+				return;
 			CheckExistence(glBlendEquation);
-			glBlendEquation(parseBlendEquation(mode));
+			glBlendEquation(glMode);
 			CheckError();
 		}
 
 		void SDLGLDevice::BlendEquation(Enum rgb, Enum alpha) {
+			GLenum glRgb = parseBlendEquation(rgb), glAlpha = parseBlendEquation(alpha);
+			const GLuint state[] = {glRgb, glAlpha};
+			if (SkipStateChange(blendEquation.data(), state, 2))
+				return;
 			CheckExistence(glBlendEquationSeparate);
-			glBlendEquationSeparate(parseBlendEquation(rgb), parseBlendEquation(alpha));
+			glBlendEquationSeparate(glRgb, glAlpha);
 			CheckError();
 		}
 		void SDLGLDevice::BlendFunc(Enum src, Enum dest) {
+			GLenum glSrc = parseBlendFunction(src), glDest = parseBlendFunction(dest);
+			const GLuint state[] = {glSrc, glDest, glSrc, glDest};
+			if (SkipStateChange(blendFunc.data(), state, 4))
+				return;
 			CheckExistence(glBlendFunc);
-			glBlendFunc(parseBlendFunction(src), parseBlendFunction(dest));
+			glBlendFunc(glSrc, glDest);
 			CheckError();
 		}
 		void SDLGLDevice::BlendFunc(Enum srcRgb, Enum destRgb, Enum srcAlpha, Enum destAlpha) {
+			GLenum glSrcRgb = parseBlendFunction(srcRgb), glDestRgb = parseBlendFunction(destRgb);
+			GLenum glSrcAlpha = parseBlendFunction(srcAlpha),
+			       glDestAlpha = parseBlendFunction(destAlpha);
+			const GLuint state[] = {glSrcRgb, glDestRgb, glSrcAlpha, glDestAlpha};
+			if (SkipStateChange(blendFunc.data(), state, 4))
+				return;
 			CheckExistence(glBlendFuncSeparate);
-			glBlendFuncSeparate(parseBlendFunction(srcRgb), parseBlendFunction(destRgb),
-								parseBlendFunction(srcAlpha), parseBlendFunction(destAlpha));
+			glBlendFuncSeparate(glSrcRgb, glDestRgb, glSrcAlpha, glDestAlpha);
 			CheckError();
 		}
 		void SDLGLDevice::BlendColor(Float r, Float g, Float b, Float a) {
@@ -438,17 +492,21 @@ namespace spades {
 		void SDLGLDevice::DepthFunc(Enum func) {
 			SPADES_MARK_FUNCTION();
 			CheckExistence(glDepthFunc);
+			GLenum glFunc;
 			switch (func) {
-				case Never: glDepthFunc(GL_NEVER); break;
-				case Always: glDepthFunc(GL_ALWAYS); break;
-				case Less: glDepthFunc(GL_LESS); break;
-				case LessOrEqual: glDepthFunc(GL_LEQUAL); break;
-				case Equal: glDepthFunc(GL_EQUAL); break;
-				case Greater: glDepthFunc(GL_GREATER); break;
-				case GreaterOrEqual: glDepthFunc(GL_GEQUAL); break;
-				case NotEqual: glDepthFunc(GL_NOTEQUAL); break;
+				case Never: glFunc = GL_NEVER; break;
+				case Always: glFunc = GL_ALWAYS; break;
+				case Less: glFunc = GL_LESS; break;
+				case LessOrEqual: glFunc = GL_LEQUAL; break;
+				case Equal: glFunc = GL_EQUAL; break;
+				case Greater: glFunc = GL_GREATER; break;
+				case GreaterOrEqual: glFunc = GL_GEQUAL; break;
+				case NotEqual: glFunc = GL_NOTEQUAL; break;
 				default: SPInvalidEnum("func", func);
 			}
+			if (SkipStateChange(depthFunc, glFunc))
+				return;
+			glDepthFunc(glFunc);
 			CheckError();
 		}
 
@@ -485,6 +543,12 @@ namespace spades {
 			glDeleteBuffers(1, &v);
 #endif
 			CheckError();
+
+			// Deleting a buffer unbinds it
+			for (GLuint& binding : boundBuffers) {
+				if (binding == v)
+					binding = 0;
+			}
 		}
 
 		void* SDLGLDevice::MapBuffer(Enum target, Enum access) {
@@ -527,6 +591,16 @@ namespace spades {
 			CheckError();
 		}
 
+		static std::size_t GetBufferTargetIndex(IGLDevice::Enum v) {
+			switch (v) {
+				case IGLDevice::ArrayBuffer: return 0;
+				case IGLDevice::ElementArrayBuffer: return 1;
+				case IGLDevice::PixelPackBuffer: return 2;
+				case IGLDevice::PixelUnpackBuffer: return 3;
+				default: SPInvalidEnum("v", v);
+			}
+		}
+
 		GLenum SDLGLDevice::parseBufferTarget(Enum v) {
 			SPADES_MARK_FUNCTION_DEBUG();
 			switch (v) {
@@ -539,6 +613,8 @@ namespace spades {
 		}
 
 		void SDLGLDevice::BindBuffer(Enum target, UInteger i) {
+			if (SkipStateChange(boundBuffers[GetBufferTargetIndex(target)], i))
+				return;
 #if GLEW
 			if (glBindBuffer)
 				glBindBuffer(parseBufferTarget(target), (GLuint)i);
@@ -798,6 +874,14 @@ namespace spades {
 			CheckExistence(glDeleteTextures);
 			glDeleteTextures(1, &v);
 			CheckError();
+
+			// Deleting a texture unbinds it from every unit
+			for (auto& unit : boundTextures) {
+				for (GLuint& binding : unit) {
+					if (binding == v)
+						binding = 0;
+				}
+			}
 		}
 
 		GLenum SDLGLDevice::parseTextureTarget(Enum v) {
@@ -811,6 +895,8 @@ namespace spades {
 		}
 
 		void SDLGLDevice::ActiveTexture(UInteger stage) {
+			if (SkipStateChange(activeTextureUnit, stage))
+				return;
 #if GLEW
 			if (glActiveTexture)
 				glActiveTexture(GL_TEXTURE0 + stage);
@@ -826,6 +912,11 @@ namespace spades {
 		}
 
 		void SDLGLDevice::BindTexture(Enum target, UInteger tex) {
+			if (activeTextureUnit < NumCachedTextureUnits) {
+				std::size_t index = target == Texture2D ? 0 : target == Texture3D ? 1 : 2;
+				if (SkipStateChange(boundTextures[activeTextureUnit][index], tex))
+					return;
+			}
 			CheckExistence(glBindTexture);
 			glBindTexture(parseTextureTarget(target), tex);
 			CheckError();
@@ -1192,6 +1283,9 @@ namespace spades {
 		}
 
 		void SDLGLDevice::EnableVertexAttribArray(UInteger index, bool b) {
+			if (index < NumCachedVertexAttribs &&
+			    SkipStateChange(enabledVertexAttribs[index], b ? GL_TRUE : GL_FALSE))
+				return;
 #if GLEW
 			if (glEnableVertexAttribArray) {
 				if (b)
@@ -1222,6 +1316,16 @@ namespace spades {
 			CheckError();
 		}
 
+		bool SDLGLDevice::SupportsInstancedArrays() {
+#if GLEW
+			return glVertexAttribDivisorARB &&
+			       (glDrawElementsInstanced || glDrawElementsInstancedARB ||
+			        glDrawElementsInstancedEXT);
+#else
+			return true;
+#endif
+		}
+
 		void SDLGLDevice::DrawArrays(Enum mode, Integer first, Sizei count) {
 			SPADES_MARK_FUNCTION();
 			GLenum md;
@@ -1602,6 +1706,8 @@ namespace spades {
 		}
 
 		void SDLGLDevice::UseProgram(UInteger program) {
+			if (SkipStateChange(currentProgram, program))
+				return;
 #if GLEW
 			if (glUseProgram)
 				glUseProgram(program);
@@ -1629,6 +1735,10 @@ namespace spades {
 			glDeleteProgram(program);
 #endif
 			CheckError();
+
+			// A current program is only flagged for deletion, but don't rely on it
+			if (currentProgram == program)
+				currentProgram = UnknownState;
 		}
 
 		void SDLGLDevice::ValidateProgram(UInteger program) {
@@ -1646,6 +1756,80 @@ namespace spades {
 			CheckError();
 		}
 
+		bool SDLGLDevice::SupportsProgramBinary() {
+#if GLEW
+			if (!glGetProgramBinary || !glProgramBinary || !glProgramParameteri)
+				return false;
+#endif
+			GLint numFormats = 0;
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &numFormats);
+			CheckError();
+			return numFormats > 0;
+		}
+
+		void SDLGLDevice::ProgramBinaryRetrievableHint(UInteger program) {
+			CheckExistence(glProgramParameteri);
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			CheckError();
+		}
+
+		bool SDLGLDevice::GetProgramBinary(UInteger program, UInteger& outFormat,
+		                                   std::vector<char>& outData) {
+			CheckExistence(glGetProgramBinary);
+			GLint length = 0;
+			glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+			CheckError();
+			if (length <= 0)
+				return false;
+
+			outData.resize(static_cast<std::size_t>(length));
+			GLsizei written = 0;
+			GLenum format = 0;
+			glGetProgramBinary(program, length, &written, &format, outData.data());
+			CheckError();
+			if (written <= 0)
+				return false;
+
+			outData.resize(static_cast<std::size_t>(written));
+			outFormat = format;
+			return true;
+		}
+
+		bool SDLGLDevice::ProgramBinary(UInteger program, UInteger format, const void* data,
+		                                Sizei length) {
+			CheckExistence(glProgramBinary);
+			glProgramBinary(program, format, data, length);
+
+			// An unsupported format raises GL_INVALID_ENUM. This is an expected
+			// failure, so don't report it as an error.
+			while (glGetError() != GL_NO_ERROR)
+				;
+
+			GLint status = GL_FALSE;
+			glGetProgramiv(program, GL_LINK_STATUS, &status);
+			CheckError();
+			return status != GL_FALSE;
+		}
+
+		bool SDLGLDevice::SupportsParallelShaderCompile() {
+#if GLEW && defined(GL_KHR_parallel_shader_compile)
+			return GLEW_KHR_parallel_shader_compile && glMaxShaderCompilerThreadsKHR;
+#else
+			return false;
+#endif
+		}
+
+		void SDLGLDevice::MaxShaderCompilerThreads(UInteger count) {
+#if GLEW && defined(GL_KHR_parallel_shader_compile)
+			CheckExistence(glMaxShaderCompilerThreadsKHR);
+			glMaxShaderCompilerThreadsKHR(count);
+			CheckError();
+#else
+			(void)count;
+			SPUnsupported();
+#endif
+		}
+
 		IGLDevice::Integer SDLGLDevice::GetAttribLocation(UInteger program, const char* name) {
 #if GLEW
 			if (glGetAttribLocation)
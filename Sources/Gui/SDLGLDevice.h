@@ -20,6 +20,8 @@
 
 #pragma once
 
+#include <array>
+
 #include <Imports/OpenGL.h>
 #include <Imports/SDL.h>
 
@@ -33,6 +35,35 @@ namespace spades {
 			SDL_GLContext context;
 			int w, h;
 
+			// Shadowed GL state used to skip redundant state changes.
+			// `UnknownState` forces the next call through.
+			static constexpr GLuint UnknownState = 0xffffffff;
+			static constexpr std::size_t NumCachedTextureUnits = 32;
+			static constexpr std::size_t NumCachedVertexAttribs = 32;
+
+			bool useStateCache;
+			StateCacheStatistics stateCacheStatistics;
+			GLuint currentProgram;
+			/** Indexed in the order of `parseBufferTarget`. */
+			std::array<GLuint, 4> boundBuffers;
+			GLuint activeTextureUnit;
+			/** Indexed by the unit and the order of `parseTextureTarget`. */
+			std::array<std::array<GLuint, 3>, NumCachedTextureUnits> boundTextures;
+			/** Indexed in the order of `Enable`. */
+			std::array<GLuint, 7> enabledStates;
+			std::array<GLuint, NumCachedVertexAttribs> enabledVertexAttribs;
+			std::array<GLuint, 2> blendEquation;
+			std::array<GLuint, 4> blendFunc;
+			GLuint depthFunc;
+			GLuint depthMask;
+
+			void InvalidateStateCache();
+			/** Updates a shadowed state. Returns `true` if the call can be skipped. */
+			bool SkipStateChange(GLuint* cached, const GLuint* values, std::size_t count);
+			bool SkipStateChange(GLuint& cached, GLuint value) {
+				return SkipStateChange(&cached, &value, 1);
+			}
+
 		protected:
 			~SDLGLDevice();
 
@@ -125,6 +156,7 @@ namespace spades {
 			                          const void*) override;
 			void EnableVertexAttribArray(UInteger index, bool) override;
 			void VertexAttribDivisor(UInteger index, UInteger divisor) override;
+			bool SupportsInstancedArrays() override;
 
 			void DrawArrays(Enum mode, Integer first, Sizei count) override;
 			void DrawElements(Enum mode, Sizei count, Enum type, const void* indices) override;
@@ -152,6 +184,14 @@ namespace spades {
 			void UseProgram(UInteger program) override;
 			void DeleteProgram(UInteger program) override;
 			void ValidateProgram(UInteger program) override;
+			bool SupportsProgramBinary() override;
+			void ProgramBinaryRetrievableHint(UInteger program) override;
+			bool GetProgramBinary(UInteger program, UInteger& outFormat,
+			                      std::vector<char>& outData) override;
+			bool ProgramBinary(UInteger program, UInteger format, const void* data,
+			                   Sizei length) override;
+			bool SupportsParallelShaderCompile() override;
+			void MaxShaderCompilerThreads(UInteger count) override;
 			Integer GetAttribLocation(UInteger program, const char* name) override;
 			void BindAttribLocation(UInteger program, UInteger index, const char* name) override;
 			Integer GetUniformLocation(UInteger program, const char* name) override;
@@ -193,6 +233,10 @@ namespace spades {
 
 			void Swap() override;
 
+			StateCacheStatistics GetStateCacheStatistics() override {
+				return stateCacheStatistics;
+			}
+
 		private:
 			static GLenum parseBlendEquation(Enum);
 			static GLenum parseBlendFunction(Enum);
@@ -28,6 +28,7 @@
 #include "SDLGLDevice.h"
 #include <Audio/ALDevice.h>
 #include <Audio/NullDevice.h>
+#include <Audio/SWAudioDevice.h>
 #include <Client/Client.h>
 #include <Core/ConcurrentDispatch.h>
 #include <Core/Debug.h>
@@ -36,6 +37,8 @@
 #include <Core/IStream.h>
 #include <Core/Math.h>
 #include <Core/Settings.h>
+#include <Draw/OpenGL/GLNullDevice.h>
+#include <Draw/OpenGL/GLRecordingDevice.h>
 #include <Draw/OpenGL/GLRenderer.h>
 #include <Draw/SW/SWPort.h>
 #include <Draw/SW/SWRenderer.h>
@@ -47,6 +50,7 @@ DEFINE_SPADES_SETTING(r_fullscreen, "0");
 DEFINE_SPADES_SETTING(r_vsync, "1");
 DEFINE_SPADES_SETTING(r_allowSoftwareRendering, "0");
 DEFINE_SPADES_SETTING(r_renderer, "gl");
+DEFINE_SPADES_SETTING(r_glRecordCalls, "0");
 DEFINE_SPADES_SETTING(s_audioDriver, "openal");
 DEFINE_SPADES_SETTING(cl_fps, "0");
 
@@ -64,6 +68,8 @@ namespace spades {
 				return new audio::ALDevice();
 			} else if (EqualsIgnoringCase(s_audioDriver, "null")) {
 				return new audio::NullDevice();
+			} else if (EqualsIgnoringCase(s_audioDriver, "software")) {
+				return new audio::SWAudioDevice();
 			} else {
 				SPLog("Unknown audio driver: %s, falling back to OpenAL", s_audioDriver.CString());
 				s_audioDriver = "openal";
@@ -330,6 +336,8 @@ namespace spades {
 		auto SDLRunner::GetRendererType() -> RendererType {
 			if (EqualsIgnoringCase(r_renderer, "gl"))
 				return RendererType::GL;
+			else if (EqualsIgnoringCase(r_renderer, "glnull"))
+				return RendererType::GLNull;
 			else if (EqualsIgnoringCase(r_renderer, "sw"))
 				return RendererType::SW;
 			else
@@ -424,8 +432,23 @@ namespace spades {
 		std::tuple<Handle<client::IRenderer>, Handle<Disposable>>
 		SDLRunner::CreateRenderer(SDL_Window* wnd, RendererType type) {
 			switch (type) {
-				case RendererType::GL: {
-					auto glDevice = Handle<SDLGLDevice>::New(wnd).Cast<draw::IGLDevice>();
+				case RendererType::GL:
+				case RendererType::GLNull: {
+					Handle<draw::IGLDevice> glDevice;
+					if (type == RendererType::GLNull) {
+						int w, h;
+						SDL_GetWindowSize(wnd, &w, &h);
+						glDevice = Handle<draw::GLNullDevice>::New(w, h).Cast<draw::IGLDevice>();
+					} else {
+						glDevice = Handle<SDLGLDevice>::New(wnd).Cast<draw::IGLDevice>();
+					}
+					if (r_glRecordCalls) {
+						// Count the GL calls per `GLProfiler` phase and report them
+						// every second
+						auto recorder = Handle<draw::GLRecordingDevice>::New(std::move(glDevice));
+						recorder->SetReportInterval(1.0);
+						glDevice = recorder.Cast<draw::IGLDevice>();
+					}
 					auto dummy = Handle<Disposable>::New(); // FIXME
 					return std::make_tuple(
 					  Handle<draw::GLRenderer>::New(std::move(glDevice)).Cast<client::IRenderer>(),
@@ -471,6 +494,7 @@ namespace spades {
 						if (!r_allowSoftwareRendering)
 							SDL_GL_SetAttribute(SDL_GL_ACCELERATED_VISUAL, 1);
 						break;
+					case RendererType::GLNull:
 					case RendererType::SW: sdlFlags = 0; break;
 				}
 
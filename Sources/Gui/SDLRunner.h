@@ -41,7 +41,8 @@ namespace spades {
 			bool m_hasSystemMenu;
 
 		protected:
-			enum class RendererType { GL, SW };
+			/** `GLNull` runs `GLRenderer` on `draw::GLNullDevice` (no GPU needed). */
+			enum class RendererType { GL, GLNull, SW };
 
 			virtual RendererType GetRendererType();
 
@@ -107,6 +107,9 @@ namespace spades {
 						r = eng->RegisterObjectProperty("AudioParam", "float referenceDistance",
 						                                asOFFSET(AudioParam, referenceDistance));
 						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("AudioParam", "float priority",
+						                                asOFFSET(AudioParam, priority));
+						manager->CheckError(r);
 						break;
 					default: break;
 				}
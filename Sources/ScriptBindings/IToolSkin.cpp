@@ -92,7 +92,28 @@ namespace spades {
 			ctx.ExecuteChecked();
 		}
 
+		ScriptIToolSkin2::ScriptIToolSkin2(asIScriptObject* obj) : obj(obj) {}
+
+		bool ScriptIToolSkin2::ImplementsInterface() {
+			return obj->GetObjectType()->Implements(
+			  obj->GetEngine()->GetTypeInfoByName("IToolSkin2"));
+		}
+
+		void ScriptIToolSkin2::Update(const SkinState& state) {
+			SPADES_MARK_FUNCTION_DEBUG();
+			static ScriptFunction func("IToolSkin2", "void Update(const SkinState& in)");
+			ScriptContextHandle ctx = func.Prepare();
+			int r;
+			r = ctx->SetObject((void*)obj);
+			ScriptManager::CheckError(r);
+			r = ctx->SetArgObject(0, const_cast<SkinState*>(&state));
+			ScriptManager::CheckError(r);
+			ctx.ExecuteChecked();
+		}
+
 		class IToolSkinRegistrar : public ScriptObjectRegistrar {
+			static void SkinStateFactory(SkinState* p) { new (p) SkinState(); }
+
 		public:
 			IToolSkinRegistrar() : ScriptObjectRegistrar("IToolSkin") {}
 			virtual void Register(ScriptManager* manager, Phase phase) {
@@ -103,6 +124,11 @@ namespace spades {
 					case PhaseObjectType:
 						r = eng->RegisterInterface("IToolSkin");
 						manager->CheckError(r);
+						r = eng->RegisterInterface("IToolSkin2");
+						manager->CheckError(r);
+						r = eng->RegisterObjectType("SkinState", sizeof(SkinState),
+						                            asOBJ_VALUE | asOBJ_POD | asOBJ_APP_CLASS_C);
+						manager->CheckError(r);
 						break;
 					case PhaseObjectMember:
 						r = eng->RegisterInterfaceMethod("IToolSkin", "void set_SprintState(float)");
@@ -117,6 +143,56 @@ namespace spades {
 						manager->CheckError(r);
 						r = eng->RegisterInterfaceMethod("IToolSkin", "void AddToScene()");
 						manager->CheckError(r);
+						r = eng->RegisterInterfaceMethod("IToolSkin2",
+						                                 "void Update(const SkinState& in)");
+						manager->CheckError(r);
+
+						r = eng->RegisterObjectBehaviour("SkinState", asBEHAVE_CONSTRUCT, "void f()",
+						                                 asFUNCTION(SkinStateFactory),
+						                                 asCALL_CDECL_OBJLAST);
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float sprintState",
+						                                asOFFSET(SkinState, sprintState));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float raiseState",
+						                                asOFFSET(SkinState, raiseState));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "Vector3 teamColor",
+						                                asOFFSET(SkinState, teamColor));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "bool muted",
+						                                asOFFSET(SkinState, muted));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "SpadeActionType actionType",
+						                                asOFFSET(SkinState, actionType));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float actionProgress",
+						                                asOFFSET(SkinState, actionProgress));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float readyState",
+						                                asOFFSET(SkinState, readyState));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "Vector3 blockColor",
+						                                asOFFSET(SkinState, blockColor));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float cookTime",
+						                                asOFFSET(SkinState, cookTime));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float aimDownSightState",
+						                                asOFFSET(SkinState, aimDownSightState));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "int ammo",
+						                                asOFFSET(SkinState, ammo));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "int clipSize",
+						                                asOFFSET(SkinState, clipSize));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "bool reloading",
+						                                asOFFSET(SkinState, reloading));
+						manager->CheckError(r);
+						r = eng->RegisterObjectProperty("SkinState", "float reloadProgress",
+						                                asOFFSET(SkinState, reloadProgress));
+						manager->CheckError(r);
 						break;
 					default: break;
 				}
@@ -20,12 +20,62 @@
 
 #pragma once
 
+#include "ISpadeSkin.h"
 #include "ScriptFunction.h"
 #include <Core/Math.h>
 
 namespace spades {
 	namespace client {
 
+		/**
+		 * Per-frame parameters of a tool skin. Skins implementing `IToolSkin2`
+		 * receive all of them in a single `Update(const SkinState&in)` call
+		 * instead of one property setter call per parameter.
+		 */
+		struct SkinState {
+			// IToolSkin
+			float sprintState;
+			float raiseState;
+			Vector3 teamColor;
+			bool muted;
+
+			// ISpadeSkin
+			SpadeActionType actionType;
+			float actionProgress;
+
+			// IBlockSkin, IGrenadeSkin, IWeaponSkin
+			float readyState;
+
+			// IBlockSkin
+			Vector3 blockColor;
+
+			// IGrenadeSkin
+			float cookTime;
+
+			// IWeaponSkin
+			float aimDownSightState;
+			int ammo;
+			int clipSize;
+			bool reloading;
+			float reloadProgress;
+
+			SkinState()
+			    : sprintState(0.0F),
+			      raiseState(0.0F),
+			      teamColor(MakeVector3(0, 0, 0)),
+			      muted(false),
+			      actionType(SpadeActionTypeIdle),
+			      actionProgress(0.0F),
+			      readyState(0.0F),
+			      blockColor(MakeVector3(0, 0, 0)),
+			      cookTime(0.0F),
+			      aimDownSightState(0.0F),
+			      ammo(0),
+			      clipSize(0),
+			      reloading(false),
+			      reloadProgress(0.0F) {}
+		};
+
 		class ScriptIToolSkin {
 			asIScriptObject* obj;
 
@@ -38,5 +88,14 @@ namespace spades {
 			void Update(float);
 			void AddToScene();
 		};
+
+		class ScriptIToolSkin2 {
+			asIScriptObject* obj;
+
+		public:
+			ScriptIToolSkin2(asIScriptObject* obj);
+			bool ImplementsInterface();
+			void Update(const SkinState&);
+		};
 	} // namespace client
 } // namespace spades
\ No newline at end of file
@@ -19,15 +19,278 @@
  */
 
 #include "ScriptManager.h"
+#include "ScriptProfiler.h"
 #include <Core/Debug.h>
 #include <Core/Exception.h>
 #include <Core/FileManager.h>
 #include <Core/IStream.h>
+#include <Core/Settings.h>
+#include <Core/Stopwatch.h>
+#include <Core/ThreadLocalStorage.h>
+#include <algorithm>
+#include <memory>
 #include <sstream>
 #include <vector>
 
+DEFINE_SPADES_SETTING(s_scriptBytecodeCache, "1");
+
 namespace spades {
 
+	namespace {
+		const char* const BytecodeCachePath = "Cache/Scripts.asbc";
+		const uint32_t BytecodeCacheMagic = 0x43425341; // "ASBC"
+		const uint32_t BytecodeCacheFormatVersion = 1;
+
+		/** 64-bit FNV-1a hash used to fingerprint script sources and the
+		 * registered script API. */
+		class ContentHasher {
+			uint64_t hash;
+
+		public:
+			ContentHasher() : hash(14695981039346656037ULL) {}
+			void Add(const void* data, size_t len) {
+				const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+				for (size_t i = 0; i < len; i++) {
+					hash ^= bytes[i];
+					hash *= 1099511628211ULL;
+				}
+			}
+			void Add(const std::string& str) {
+				Add(str.data(), str.size());
+				Add("", 1); // separator
+			}
+			void Add(const char* str) { Add(std::string(str ? str : "")); }
+			void Add(int value) { Add(&value, sizeof(value)); }
+			uint64_t Get() const { return hash; }
+		};
+
+		/** A script section that contributed to the module, and the hash of its
+		 * contents at the time it was compiled. */
+		struct ScriptSection {
+			std::string path;
+			uint64_t hash;
+		};
+
+		uint64_t HashString(const std::string& str) {
+			ContentHasher hasher;
+			hasher.Add(str);
+			return hasher.Get();
+		}
+
+		/** Adapts IStream to AngelScript's binary stream interface. */
+		class BytecodeStream : public asIBinaryStream {
+			IStream& stream;
+
+		public:
+			BytecodeStream(IStream& stream) : stream(stream) {}
+
+			int Read(void* ptr, asUINT size) override {
+				if (stream.Read(ptr, size) < size)
+					return -1;
+				return 0;
+			}
+			int Write(const void* ptr, asUINT size) override {
+				stream.Write(ptr, size);
+				return 0;
+			}
+		};
+
+		void WriteUInt32(IStream& stream, uint32_t value) { stream.Write(&value, sizeof(value)); }
+		void WriteUInt64(IStream& stream, uint64_t value) { stream.Write(&value, sizeof(value)); }
+		void WriteString(IStream& stream, const std::string& str) {
+			WriteUInt32(stream, static_cast<uint32_t>(str.size()));
+			stream.Write(str);
+		}
+
+		bool ReadUInt32(IStream& stream, uint32_t& value) {
+			return stream.Read(&value, sizeof(value)) == sizeof(value);
+		}
+		bool ReadUInt64(IStream& stream, uint64_t& value) {
+			return stream.Read(&value, sizeof(value)) == sizeof(value);
+		}
+		bool ReadString(IStream& stream, std::string& str) {
+			uint32_t len;
+			if (!ReadUInt32(stream, len) || len > 4096)
+				return false;
+			str = stream.Read(len);
+			return str.size() == len;
+		}
+
+		void AddFunctionSignature(ContentHasher& hasher, asIScriptFunction* func) {
+			if (!func) {
+				hasher.Add("(null)");
+				return;
+			}
+			hasher.Add(func->GetDeclaration(true, true, false));
+		}
+
+		void AddTypeSignature(ContentHasher& hasher, asITypeInfo* type) {
+			hasher.Add(type->GetNamespace());
+			hasher.Add(type->GetName());
+			hasher.Add(static_cast<int>(type->GetFlags() & 0xffffffffu));
+			hasher.Add(static_cast<int>(type->GetSize()));
+
+			for (asUINT i = 0; i < type->GetFactoryCount(); i++)
+				AddFunctionSignature(hasher, type->GetFactoryByIndex(i));
+			for (asUINT i = 0; i < type->GetBehaviourCount(); i++) {
+				asEBehaviours beh;
+				asIScriptFunction* func = type->GetBehaviourByIndex(i, &beh);
+				hasher.Add(static_cast<int>(beh));
+				AddFunctionSignature(hasher, func);
+			}
+			for (asUINT i = 0; i < type->GetMethodCount(); i++)
+				AddFunctionSignature(hasher, type->GetMethodByIndex(i, false));
+			for (asUINT i = 0; i < type->GetPropertyCount(); i++)
+				hasher.Add(type->GetPropertyDeclaration(i, true));
+		}
+
+		/** Computes a fingerprint of everything the application registered to
+		 * the engine. Bytecode compiled against a different set of APIs must
+		 * not be loaded. */
+		uint64_t ComputeRegistrationSignature(asIScriptEngine* engine) {
+			ContentHasher hasher;
+			hasher.Add(ANGELSCRIPT_VERSION_STRING);
+			hasher.Add(static_cast<int>(sizeof(void*)));
+
+			for (asUINT i = 0; i < engine->GetObjectTypeCount(); i++)
+				AddTypeSignature(hasher, engine->GetObjectTypeByIndex(i));
+
+			for (asUINT i = 0; i < engine->GetGlobalFunctionCount(); i++)
+				AddFunctionSignature(hasher, engine->GetGlobalFunctionByIndex(i));
+
+			for (asUINT i = 0; i < engine->GetGlobalPropertyCount(); i++) {
+				const char* name;
+				const char* ns;
+				int typeId;
+				bool isConst;
+				engine->GetGlobalPropertyByIndex(i, &name, &ns, &typeId, &isConst);
+				hasher.Add(ns);
+				hasher.Add(name);
+				hasher.Add(engine->GetTypeDeclaration(typeId, true));
+				hasher.Add(isConst ? 1 : 0);
+			}
+
+			for (asUINT i = 0; i < engine->GetEnumCount(); i++) {
+				asITypeInfo* type = engine->GetEnumByIndex(i);
+				hasher.Add(type->GetNamespace());
+				hasher.Add(type->GetName());
+				for (asUINT j = 0; j < type->GetEnumValueCount(); j++) {
+					int value;
+					hasher.Add(type->GetEnumValueByIndex(j, &value));
+					hasher.Add(value);
+				}
+			}
+
+			for (asUINT i = 0; i < engine->GetFuncdefCount(); i++)
+				AddFunctionSignature(hasher, engine->GetFuncdefByIndex(i)->GetFuncdefSignature());
+
+			for (asUINT i = 0; i < engine->GetTypedefCount(); i++) {
+				asITypeInfo* type = engine->GetTypedefByIndex(i);
+				hasher.Add(type->GetNamespace());
+				hasher.Add(type->GetName());
+				hasher.Add(engine->GetTypeDeclaration(type->GetTypedefTypeId(), true));
+			}
+
+			return hasher.Get();
+		}
+
+		/** Tries to load the module from the bytecode cache.
+		 * @return true if the module was loaded. On failure, the module is
+		 *         left discarded. */
+		bool LoadBytecodeCache(asIScriptEngine* engine, uint64_t signature) {
+			SPADES_MARK_FUNCTION();
+
+			if (!FileManager::FileExists(BytecodeCachePath))
+				return false;
+
+			try {
+				auto stream = FileManager::OpenForReading(BytecodeCachePath);
+
+				uint32_t magic, version, numSections;
+				uint64_t storedSignature;
+				if (!ReadUInt32(*stream, magic) || magic != BytecodeCacheMagic ||
+				    !ReadUInt32(*stream, version) || version != BytecodeCacheFormatVersion) {
+					SPLog("Script bytecode cache has an unknown format; ignoring");
+					return false;
+				}
+				if (!ReadUInt64(*stream, storedSignature) || storedSignature != signature) {
+					SPLog("Script bytecode cache was built against different APIs; ignoring");
+					return false;
+				}
+
+				if (!ReadUInt32(*stream, numSections) || numSections == 0)
+					return false;
+				for (uint32_t i = 0; i < numSections; i++) {
+					std::string path;
+					uint64_t hash;
+					if (!ReadString(*stream, path) || !ReadUInt64(*stream, hash))
+						return false;
+
+					std::string fn = "Scripts";
+					fn += path;
+					if (!FileManager::FileExists(fn.c_str()) ||
+					    HashString(FileManager::ReadAllBytes(fn.c_str())) != hash) {
+						SPLog("Script bytecode cache is stale ('%s' was modified)", path.c_str());
+						return false;
+					}
+				}
+
+				asIScriptModule* module = engine->GetModule("Client", asGM_ALWAYS_CREATE);
+				if (!module)
+					return false;
+
+				BytecodeStream bcStream(*stream);
+				if (module->LoadByteCode(&bcStream) < 0) {
+					SPLog("Failed to load the script bytecode cache");
+					module->Discard();
+					return false;
+				}
+				return true;
+			} catch (const std::exception& ex) {
+				SPLog("Failed to read the script bytecode cache: %s", ex.what());
+				asIScriptModule* module = engine->GetModule("Client", asGM_ONLY_IF_EXISTS);
+				if (module)
+					module->Discard();
+				return false;
+			}
+		}
+
+		void SaveBytecodeCache(asIScriptEngine* engine, uint64_t signature,
+		                       const std::vector<ScriptSection>& sections) {
+			SPADES_MARK_FUNCTION();
+
+			asIScriptModule* module = engine->GetModule("Client", asGM_ONLY_IF_EXISTS);
+			if (!module)
+				return;
+
+			try {
+				auto stream = FileManager::OpenForWriting(BytecodeCachePath);
+				WriteUInt32(*stream, BytecodeCacheMagic);
+				WriteUInt32(*stream, BytecodeCacheFormatVersion);
+				WriteUInt64(*stream, signature);
+				WriteUInt32(*stream, static_cast<uint32_t>(sections.size()));
+				for (const auto& section : sections) {
+					WriteString(*stream, section.path);
+					WriteUInt64(*stream, section.hash);
+				}
+
+				// keep the debug info so that script exceptions still have
+				// meaningful locations
+				BytecodeStream bcStream(*stream);
+				if (module->SaveByteCode(&bcStream, false) < 0) {
+					SPLog("Failed to serialize the script bytecode");
+					stream.reset();
+					FileManager::OpenForWriting(BytecodeCachePath); // truncate
+					return;
+				}
+				stream->Flush();
+				SPLog("Script bytecode cache saved to '%s'", BytecodeCachePath);
+			} catch (const std::exception& ex) {
+				SPLog("Failed to write the script bytecode cache: %s", ex.what());
+			}
+		}
+	} // namespace
+
 	ScriptManager* ScriptManager::GetInstance() {
 		SPADES_MARK_FUNCTION_DEBUG();
 		static ScriptManager* m = new ScriptManager();
@@ -67,7 +330,8 @@ namespace spades {
 	}
 
 	// Callback function for handling script includes
-	static int IncludeCallback(const char* include, const char* from, CScriptBuilder* builder, void* userParam) {
+	static int IncludeCallback(const char* include, const char* from, CScriptBuilder* builder,
+	                           void* userParam) {
 		SPADES_MARK_FUNCTION();
 
 		std::string includePath = include;
@@ -100,6 +364,10 @@ namespace spades {
 		}
 
 		SPLog("Loading script '%s'", includePath.c_str());
+		if (userParam) {
+			auto& sections = *reinterpret_cast<std::vector<ScriptSection>*>(userParam);
+			sections.push_back(ScriptSection{includePath, HashString(data)});
+		}
 		return builder->AddSectionFromMemory(includePath.c_str(), data.c_str(), (unsigned int)(data.length()), 0);
 	}
 
@@ -131,21 +399,40 @@ namespace spades {
 			ScriptObjectRegistrar::RegisterAll(this, ScriptObjectRegistrar::PhaseGlobalFunction);
 			ScriptObjectRegistrar::RegisterAll(this, ScriptObjectRegistrar::PhaseObjectMember);
 
-		SPLog("Loading scripts");
-		engine->SetDefaultNamespace("");
-		CScriptBuilder builder;
-		builder.SetIncludeCallback(IncludeCallback, NULL);
-		if (builder.StartNewModule(engine, "Client") < 0)
-			SPRaise("Failed to create script module.");
-		builder.DefineWord("CLIENT");
-
-		std::string mainScript = FileManager::ReadAllBytes("Scripts/Main.as");
-		if (builder.AddSectionFromMemory("/Main.as", mainScript.c_str(), (unsigned int)(mainScript.length()), 0) < 0)
-			SPRaise("Failed to load '/Main.as'.");
-
-		SPLog("Building");
-		if (builder.BuildModule() < 0)
-			SPRaise("Failed to build at least one of the scripts.");
+			SPLog("Loading scripts");
+			engine->SetDefaultNamespace("");
+			Stopwatch sw;
+			bool useCache = s_scriptBytecodeCache;
+			uint64_t signature = 0;
+			if (useCache) {
+				signature = ComputeRegistrationSignature(engine);
+				if (LoadBytecodeCache(engine, signature)) {
+					SPLog("Scripts loaded from bytecode cache in %.3f seconds (warm)",
+					      sw.GetTime());
+					return;
+				}
+			}
+
+			std::vector<ScriptSection> sections;
+			CScriptBuilder builder;
+			builder.SetIncludeCallback(IncludeCallback, &sections);
+			if (builder.StartNewModule(engine, "Client") < 0)
+				SPRaise("Failed to create script module.");
+			builder.DefineWord("CLIENT");
+
+			std::string mainScript = FileManager::ReadAllBytes("Scripts/Main.as");
+			sections.push_back(ScriptSection{"/Main.as", HashString(mainScript)});
+			if (builder.AddSectionFromMemory("/Main.as", mainScript.c_str(),
+			                                 (unsigned int)(mainScript.length()), 0) < 0)
+				SPRaise("Failed to load '/Main.as'.");
+
+			SPLog("Building");
+			if (builder.BuildModule() < 0)
+				SPRaise("Failed to build at least one of the scripts.");
+			SPLog("Scripts built from source in %.3f seconds (cold)", sw.GetTime());
+
+			if (useCache)
+				SaveBytecodeCache(engine, signature, sections);
 		} catch (...) {
 			engine->Release();
 			throw;
@@ -199,48 +486,134 @@ namespace spades {
 		engine->Release();
 	}
 
+	/** Idle contexts owned by one thread. They are only ever handed out to
+	 * the owning thread, so no locking is required. */
+	struct ScriptManager::ThreadContextCache {
+		std::vector<Context*> freeContexts;
+		/** Spare `Context` records for nested calls. */
+		std::vector<Context*> freeNestedContexts;
+
+		~ThreadContextCache() {
+			for (Context* ctx : freeContexts) {
+				ctx->obj->Release();
+				delete ctx;
+			}
+			for (Context* ctx : freeNestedContexts)
+				delete ctx;
+		}
+	};
+
+	ScriptManager::ThreadContextCache& ScriptManager::GetThreadContextCache() {
+		static AutoDeletedThreadLocalStorage<ThreadContextCache> storage("ScriptContextCache");
+		ThreadContextCache* cache = storage.GetPointer();
+		if (!cache)
+			storage = cache = new ThreadContextCache();
+		return *cache;
+	}
+
 	ScriptContextHandle ScriptManager::GetContext() {
 		SPADES_MARK_FUNCTION_DEBUG();
-		if (contextFreeList.empty()) {
-			std::lock_guard<std::recursive_mutex> _lock{contextMutex};
-			// no free context; create one
-			Context* ctx = new Context();
-			ctx->obj = engine->CreateContext();
+		ThreadContextCache& cache = GetThreadContextCache();
+
+		// Called by a native function which was called by a script?
+		// Borrow the calling context instead of switching to another one.
+		asIScriptContext* active = asGetActiveContext();
+		if (active && active->GetEngine() == engine &&
+		    active->GetState() == asEXECUTION_ACTIVE && active->PushState() >= 0) {
+			Context* ctx;
+			if (cache.freeNestedContexts.empty()) {
+				ctx = new Context();
+			} else {
+				ctx = cache.freeNestedContexts.back();
+				cache.freeNestedContexts.pop_back();
+			}
+			ctx->obj = active;
 			ctx->refCount = 0;
+			ctx->nested = true;
+			numNestedCalls.fetch_add(1, std::memory_order_relaxed);
 			return ScriptContextHandle(ctx, this);
+		}
+
+		Context* ctx;
+		if (cache.freeContexts.empty()) {
+			// no free context; create one
+			ctx = new Context();
+			ctx->obj = engine->CreateContext();
+			ctx->nested = false;
+			numContextsCreated.fetch_add(1, std::memory_order_relaxed);
 		} else {
 			// get one
-			Context* ctx = contextFreeList.front();
-			contextFreeList.pop_front();
-			SPAssert(ctx->refCount == 0);
-			return ScriptContextHandle(ctx, this);
+			ctx = cache.freeContexts.back();
+			cache.freeContexts.pop_back();
+			numContextsReused.fetch_add(1, std::memory_order_relaxed);
+		}
+		ctx->refCount = 0;
+		return ScriptContextHandle(ctx, this);
+	}
+
+	void ScriptManager::ReleaseContext(Context* ctx) {
+		SPAssert(ctx->refCount == 0);
+		ThreadContextCache& cache = GetThreadContextCache();
+		if (ctx->nested) {
+			// this restores the state of the calling script
+			ctx->obj->PopState();
+			ctx->obj = nullptr;
+			cache.freeNestedContexts.push_back(ctx);
+		} else {
+			cache.freeContexts.push_back(ctx);
 		}
 	}
 
+	ScriptManager::ContextStatistics ScriptManager::GetContextStatistics() const {
+		ContextStatistics stats;
+		stats.created = numContextsCreated.load(std::memory_order_relaxed);
+		stats.reused = numContextsReused.load(std::memory_order_relaxed);
+		stats.nested = numNestedCalls.load(std::memory_order_relaxed);
+		return stats;
+	}
+
+	double ScriptManager::MeasureCallOverhead(int iterations) {
+		SPADES_MARK_FUNCTION();
+
+		asIScriptModule* module = engine->GetModule("CallOverheadBenchmark", asGM_ALWAYS_CREATE);
+		asIScriptFunction* func = nullptr;
+		CheckError(module->CompileFunction("benchmark", "void Noop() {}", 0, 0, &func));
+
+		Stopwatch sw;
+		for (int i = 0; i < iterations; i++) {
+			ScriptContextHandle ctx = GetContext();
+			ctx->Prepare(func);
+			ctx.ExecuteChecked();
+		}
+		double elapsed = sw.GetTime();
+
+		func->Release();
+		module->Discard();
+		return elapsed / std::max(iterations, 1);
+	}
+
 	ScriptContextHandle::ScriptContextHandle() : manager(NULL), obj(NULL) {}
 
 	ScriptContextHandle::ScriptContextHandle(ScriptManager::Context* ctx, ScriptManager* manager)
 	    : manager(manager), obj(ctx) {
-		std::lock_guard<std::recursive_mutex> _lock{manager->contextMutex};
 		ctx->refCount++;
 	}
 
 	ScriptContextHandle::ScriptContextHandle(const ScriptContextHandle& h)
 	    : manager(h.manager), obj(h.obj) {
-		std::lock_guard<std::recursive_mutex> _lock{manager->contextMutex};
-		obj->refCount++;
+		if (obj)
+			obj->refCount++;
 	}
 
 	ScriptContextHandle::~ScriptContextHandle() { Release(); }
 
 	void ScriptContextHandle::Release() {
 		if (obj) {
-			std::lock_guard<std::recursive_mutex> _lock{manager->contextMutex};
 			obj->refCount--;
 			if (obj->refCount == 0) {
 				// this context is no longer used;
-				// add to freelist
-				manager->contextFreeList.push_back(obj);
+				// return it to the cache
+				manager->ReleaseContext(obj);
 			}
 
 			obj = NULL;
@@ -255,8 +628,8 @@ namespace spades {
 
 		manager = h.manager;
 		obj = h.obj;
-		std::lock_guard<std::recursive_mutex> _lock{manager->contextMutex};
-		obj->refCount++;
+		if (obj)
+			obj->refCount++;
 	}
 
 	asIScriptContext* ScriptContextHandle::GetContext() const {
@@ -327,7 +700,11 @@ namespace spades {
 
 	void ScriptContextUtils::ExecuteChecked() {
 		SPADES_MARK_FUNCTION();
+		ScriptProfiler* profiler = ScriptProfiler::GetInstance();
+		bool profiling = profiler->IsRunning() && profiler->Attach(context);
 		int r = context->Execute();
+		if (profiling)
+			profiler->Detach(context);
 		ScriptManager::CheckError(r);
 		if (r == asEXECUTION_ABORTED) {
 			SPRaise("Script execution aborted.");
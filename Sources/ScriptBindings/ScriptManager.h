@@ -35,8 +35,8 @@
 #include <AngelScript/addons/scriptmathcomplex.h>
 #include <AngelScript/addons/scriptstdstring.h>
 #include <AngelScript/addons/weakref.h>
-#include <list>
-#include <mutex>
+#include <atomic>
+#include <cstdint>
 
 namespace spades {
 
@@ -47,23 +47,56 @@ namespace spades {
 		struct Context {
 			asIScriptContext* obj;
 			int refCount;
+			/** `true` if this borrows a nested state (`PushState`) of a
+			 * context which is currently calling a native function. */
+			bool nested;
 		};
-		std::recursive_mutex contextMutex;
-		std::list<Context*> contextFreeList;
+		struct ThreadContextCache;
 
 		asIScriptEngine* engine;
 
+		std::atomic<uint64_t> numContextsCreated{0};
+		std::atomic<uint64_t> numContextsReused{0};
+		std::atomic<uint64_t> numNestedCalls{0};
+
 		ScriptManager();
 		~ScriptManager();
 
+		/** Returns the idle contexts owned by the calling thread. */
+		static ThreadContextCache& GetThreadContextCache();
+		void ReleaseContext(Context*);
+
 	public:
+		struct ContextStatistics {
+			/** Number of contexts created by `CreateContext`. */
+			uint64_t created;
+			/** Number of times an idle context was reused. */
+			uint64_t reused;
+			/** Number of calls that borrowed the calling context. */
+			uint64_t nested;
+		};
+
 		static ScriptManager* GetInstance();
 
 		static void CheckError(int);
 
 		asIScriptEngine* GetEngine() const { return engine; }
 
+		/**
+		 * Returns a context to execute a script function with.
+		 *
+		 * When called from a native function that was called by a script,
+		 * the calling context is reused by pushing a nested state. Otherwise,
+		 * an idle context of the calling thread is reused or a new one is
+		 * created. The returned handle must be released by the same thread.
+		 */
 		ScriptContextHandle GetContext();
+
+		ContextStatistics GetContextStatistics() const;
+
+		/** Measures the average time of a native to script call of an empty
+		 * function, in seconds. */
+		double MeasureCallOverhead(int iterations);
 	};
 
 	class ScriptContextUtils {
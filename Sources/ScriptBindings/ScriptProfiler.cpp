@@ -0,0 +1,299 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#include "ScriptProfiler.h"
+#include <AngelScript/include/angelscript.h>
+#include <Core/Debug.h>
+#include <Core/FileManager.h>
+#include <Core/IStream.h>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+
+namespace spades {
+	namespace {
+		double ToSeconds(std::chrono::high_resolution_clock::duration d) {
+			return std::chrono::duration<double>(d).count();
+		}
+
+		std::string EscapeJson(const std::string& str) {
+			std::string out;
+			out.reserve(str.size() + 2);
+			for (char c : str) {
+				switch (c) {
+					case '"': out += "\\\""; break;
+					case '\\': out += "\\\\"; break;
+					case '\n': out += "\\n"; break;
+					case '\r': out += "\\r"; break;
+					case '\t': out += "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20) {
+							char buf[8];
+							std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+							out += buf;
+						} else {
+							out += c;
+						}
+				}
+			}
+			return out;
+		}
+
+		struct SectionStats {
+			std::string section;
+			uint64_t calls = 0;
+			double selfTime = 0.0;
+		};
+
+		std::vector<SectionStats>
+		GetSectionStatistics(const std::vector<ScriptProfiler::FunctionStats>& functions) {
+			std::map<std::string, SectionStats> sections;
+			for (const auto& f : functions) {
+				SectionStats& s = sections[f.section];
+				s.section = f.section;
+				s.calls += f.calls;
+				s.selfTime += f.selfTime;
+			}
+			std::vector<SectionStats> result;
+			for (const auto& item : sections)
+				result.push_back(item.second);
+			std::sort(result.begin(), result.end(),
+			          [](const SectionStats& a, const SectionStats& b) {
+				          return a.selfTime > b.selfTime;
+			          });
+			return result;
+		}
+	} // namespace
+
+	ScriptProfiler* ScriptProfiler::GetInstance() {
+		static ScriptProfiler* p = new ScriptProfiler();
+		return p;
+	}
+
+	ScriptProfiler::ScriptProfiler() : running(false), elapsedTime(0.0) {}
+
+	void ScriptProfiler::Start() {
+		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::mutex> lock{mutex};
+		if (running)
+			return;
+		startTime = Clock::now();
+		running = true;
+	}
+
+	void ScriptProfiler::Stop() {
+		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::mutex> lock{mutex};
+		if (!running)
+			return;
+		elapsedTime += ToSeconds(Clock::now() - startTime);
+		running = false;
+	}
+
+	void ScriptProfiler::Reset() {
+		SPADES_MARK_FUNCTION();
+		std::lock_guard<std::mutex> lock{mutex};
+		functions.clear();
+		elapsedTime = 0.0;
+		startTime = Clock::now();
+
+		// frames that are currently open only contribute the time after
+		// the reset
+		auto now = Clock::now();
+		for (auto& item : contexts) {
+			for (Frame& frame : item.second.stack) {
+				frame.enterTime = now;
+				frame.childTime = 0.0;
+			}
+		}
+	}
+
+	bool ScriptProfiler::Attach(asIScriptContext* ctx) {
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			if (contexts.find(ctx) != contexts.end())
+				return false;
+			contexts[ctx];
+		}
+		ctx->SetLineCallback(asFUNCTION(LineCallback), this, asCALL_CDECL);
+		return true;
+	}
+
+	void ScriptProfiler::Detach(asIScriptContext* ctx) {
+		ctx->ClearLineCallback();
+
+		std::lock_guard<std::mutex> lock{mutex};
+		auto it = contexts.find(ctx);
+		if (it == contexts.end())
+			return;
+		auto now = Clock::now();
+		while (!it->second.stack.empty())
+			PopFrame(it->second, now);
+		contexts.erase(it);
+	}
+
+	void ScriptProfiler::LineCallback(asIScriptContext* ctx, void* param) {
+		reinterpret_cast<ScriptProfiler*>(param)->Update(ctx);
+	}
+
+	ScriptProfiler::FunctionStats& ScriptProfiler::GetFunctionStats(asIScriptFunction* func) {
+		auto it = functions.find(func);
+		if (it != functions.end())
+			return it->second;
+
+		FunctionStats& stats = functions[func];
+		stats.name = func->GetDeclaration(true, true);
+		const char* section = nullptr;
+		func->GetDeclaredAt(&section, nullptr, nullptr);
+		stats.section = section ? section : "(native)";
+		return stats;
+	}
+
+	void ScriptProfiler::PopFrame(ContextState& state, Clock::time_point now) {
+		Frame frame = state.stack.back();
+		state.stack.pop_back();
+
+		double inclusive = ToSeconds(now - frame.enterTime);
+		FunctionStats& stats = GetFunctionStats(frame.function);
+		stats.totalTime += inclusive;
+		stats.selfTime += std::max(inclusive - frame.childTime, 0.0);
+		if (!state.stack.empty())
+			state.stack.back().childTime += inclusive;
+	}
+
+	void ScriptProfiler::Update(asIScriptContext* ctx) {
+		// The callback is also called once when an execution finishes. Open
+		// frames are closed by `Detach` or by the next callback of the outer
+		// execution if this was a nested one.
+		if (ctx->GetState() != asEXECUTION_ACTIVE)
+			return;
+
+		std::lock_guard<std::mutex> lock{mutex};
+		auto it = contexts.find(ctx);
+		if (it == contexts.end())
+			return;
+		ContextState& state = it->second;
+		auto now = Clock::now();
+
+		// Build the current call stack, outermost first. Nested states
+		// (`PushState`) show up as null functions and are skipped.
+		stackBuffer.clear();
+		for (asUINT i = ctx->GetCallstackSize(); i > 0; i--) {
+			asIScriptFunction* func = ctx->GetFunction(i - 1);
+			if (func)
+				stackBuffer.push_back(func);
+		}
+
+		std::size_t common = 0;
+		while (common < state.stack.size() && common < stackBuffer.size() &&
+		       state.stack[common].function == stackBuffer[common])
+			common++;
+
+		while (state.stack.size() > common)
+			PopFrame(state, now);
+
+		for (std::size_t i = common; i < stackBuffer.size(); i++) {
+			GetFunctionStats(stackBuffer[i]).calls++;
+			state.stack.push_back(Frame{stackBuffer[i], now, 0.0});
+		}
+	}
+
+	std::vector<ScriptProfiler::FunctionStats> ScriptProfiler::GetStatistics() {
+		std::lock_guard<std::mutex> lock{mutex};
+		std::vector<FunctionStats> result;
+		result.reserve(functions.size());
+		for (const auto& item : functions)
+			result.push_back(item.second);
+		std::sort(result.begin(), result.end(),
+		          [](const FunctionStats& a, const FunctionStats& b) {
+			          return a.selfTime > b.selfTime;
+		          });
+		return result;
+	}
+
+	void ScriptProfiler::PrintReport(std::size_t maxEntries) {
+		SPADES_MARK_FUNCTION();
+		std::vector<FunctionStats> stats = GetStatistics();
+		double duration;
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			duration = elapsedTime;
+			if (running)
+				duration += ToSeconds(Clock::now() - startTime);
+		}
+
+		SPLog("Script profile (%.3f seconds, %s, %d function(s)):", duration,
+		      running ? "running" : "stopped", (int)stats.size());
+		SPLog("  self [ms]  total [ms]     calls  function");
+		for (std::size_t i = 0; i < stats.size() && i < maxEntries; i++) {
+			const FunctionStats& f = stats[i];
+			SPLog("%11.3f %11.3f %9llu  %s (%s)", f.selfTime * 1000.0, f.totalTime * 1000.0,
+			      (unsigned long long)f.calls, f.name.c_str(), f.section.c_str());
+		}
+
+		SPLog("  self [ms]     calls  section");
+		for (const SectionStats& s : GetSectionStatistics(stats)) {
+			SPLog("%11.3f %9llu  %s", s.selfTime * 1000.0, (unsigned long long)s.calls,
+			      s.section.c_str());
+		}
+	}
+
+	void ScriptProfiler::DumpJson(const std::string& path) {
+		SPADES_MARK_FUNCTION();
+		std::vector<FunctionStats> stats = GetStatistics();
+		double duration;
+		{
+			std::lock_guard<std::mutex> lock{mutex};
+			duration = elapsedTime;
+			if (running)
+				duration += ToSeconds(Clock::now() - startTime);
+		}
+
+		std::string json;
+		char buf[256];
+		std::snprintf(buf, sizeof(buf), "{\n\t\"duration\": %.6f,\n\t\"functions\": [", duration);
+		json += buf;
+		for (std::size_t i = 0; i < stats.size(); i++) {
+			const FunctionStats& f = stats[i];
+			json += i ? ",\n\t\t{" : "\n\t\t{";
+			json += "\"name\": \"" + EscapeJson(f.name) + "\", ";
+			json += "\"section\": \"" + EscapeJson(f.section) + "\", ";
+			std::snprintf(buf, sizeof(buf),
+			              "\"calls\": %llu, \"selfTime\": %.6f, \"totalTime\": %.6f}",
+			              (unsigned long long)f.calls, f.selfTime, f.totalTime);
+			json += buf;
+		}
+		json += "\n\t],\n\t\"sections\": [";
+		std::vector<SectionStats> sections = GetSectionStatistics(stats);
+		for (std::size_t i = 0; i < sections.size(); i++) {
+			const SectionStats& s = sections[i];
+			json += i ? ",\n\t\t{" : "\n\t\t{";
+			json += "\"section\": \"" + EscapeJson(s.section) + "\", ";
+			std::snprintf(buf, sizeof(buf), "\"calls\": %llu, \"selfTime\": %.6f}",
+			              (unsigned long long)s.calls, s.selfTime);
+			json += buf;
+		}
+		json += "\n\t]\n}\n";
+
+		std::unique_ptr<IStream> stream{FileManager::OpenForWriting(path.c_str())};
+		stream->Write(json);
+		SPLog("Script profile written to '%s'", path.c_str());
+	}
+} // namespace spades
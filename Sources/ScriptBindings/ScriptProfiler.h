@@ -0,0 +1,107 @@
+/*
+ Copyright (c) 2013 yvt
+
+ This file is part of OpenSpades.
+
+ OpenSpades is free software: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ OpenSpades is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with OpenSpades.  If not, see <http://www.gnu.org/licenses/>.
+
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class asIScriptContext;
+class asIScriptFunction;
+
+namespace spades {
+	/**
+	 * Instrumenting profiler for script code.
+	 *
+	 * While running, every script execution started by
+	 * `ScriptContextUtils::ExecuteChecked` gets a line callback which tracks
+	 * the call stack of the context and attributes wall-clock time and call
+	 * counts to each script function.
+	 */
+	class ScriptProfiler {
+	public:
+		struct FunctionStats {
+			std::string name;
+			std::string section;
+			uint64_t calls = 0;
+			/** Total time including callees, in seconds. */
+			double totalTime = 0.0;
+			/** Time spent in the function body itself, in seconds. */
+			double selfTime = 0.0;
+		};
+
+		static ScriptProfiler* GetInstance();
+
+		bool IsRunning() const { return running; }
+
+		void Start();
+		void Stop();
+		void Reset();
+
+		/** Installs the profiling line callback to the context.
+		 * @return `false` if the context is already being profiled (nested
+		 *         execution), in which case `Detach` must not be called. */
+		bool Attach(asIScriptContext*);
+		/** Removes the line callback and closes all open frames. */
+		void Detach(asIScriptContext*);
+
+		/** Returns a snapshot of the statistics, sorted by self time. */
+		std::vector<FunctionStats> GetStatistics();
+
+		/** Prints the top `maxEntries` functions and per-section totals to
+		 * the log. */
+		void PrintReport(std::size_t maxEntries);
+		/** Writes the statistics to the given path in JSON format. */
+		void DumpJson(const std::string& path);
+
+	private:
+		using Clock = std::chrono::high_resolution_clock;
+
+		struct Frame {
+			asIScriptFunction* function;
+			Clock::time_point enterTime;
+			double childTime;
+		};
+
+		struct ContextState {
+			std::vector<Frame> stack;
+		};
+
+		ScriptProfiler();
+
+		static void LineCallback(asIScriptContext*, void*);
+		void Update(asIScriptContext*);
+		void PopFrame(ContextState&, Clock::time_point now);
+		FunctionStats& GetFunctionStats(asIScriptFunction*);
+
+		std::atomic<bool> running;
+		std::mutex mutex;
+		std::map<asIScriptContext*, ContextState> contexts;
+		std::map<asIScriptFunction*, FunctionStats> functions;
+		std::vector<asIScriptFunction*> stackBuffer;
+		Clock::time_point startTime;
+		double elapsedTime;
+	};
+} // namespace spades